@@ -1207,6 +1207,51 @@ enum aome_enc_control_id {
    * 0 : off, 1 : on
    */
   AV1E_SET_DISABLE_ML_PARTITION_SPEED_FEATURES = 157,
+
+  /*!\brief Codec control function to update the intra mode entropy models
+   * once per superblock instead of after each symbol, int parameter.
+   * Only effective with the intra entropy experiment.
+   *
+   * 0 : off (default), 1 : on
+   */
+  AV1E_SET_INTRA_ENTROPY_SB_UPDATE = 158,
+
+  /*!\brief Codec control function to let the encoder reference source
+   * images in place instead of copying them into its lookahead buffers,
+   * aom_source_release_cb_t* parameter.
+   *
+   * Once a callback is set, every image that aom_codec_encode() queues is
+   * handed back exactly once through it, with the image's user_priv. Until
+   * then the image data must stay valid and unmodified. Images that cannot be
+   * referenced are copied as usual and released before aom_codec_encode()
+   * returns. Images rejected with an error are not retained.
+   *
+   * To be referenced, an image must be allocated with
+   * aom_img_alloc_with_border() using the stride of the lookahead buffers,
+   * e.g. with align = 32, size_align = 128 and border =
+   * AOM_ENC_ZERO_COPY_BORDER, and must match the configured size and bit
+   * depth. The encoder writes the border on a worker thread. Frame resizing
+   * and superres use larger lookahead borders, so images are copied then.
+   * Passing a NULL release_cb turns the feature off.
+   */
+  AV1E_SET_SOURCE_RELEASE_CB = 159,
+
+  /*!\brief Codec control function to set the size of the hash based trellis
+   * cache, unsigned int parameter. Only effective with the hash trellis
+   * experiment.
+   *
+   * Each encoder thread keeps its own cache of 2^n trellis results, with n
+   * in the range [2, 24]. A cache entry takes about 38 bytes.
+   *
+   * 0 : off (default), n : on with 2^n entries per thread
+   */
+  AV1E_SET_HASH_TRELLIS_SIZE = 160,
+
+  /*!\brief Codec control function to get the hash based trellis cache
+   * statistics, summed over the encoder threads, aom_hash_trellis_stats_t*
+   * parameter. Only available with the hash trellis experiment.
+   */
+  AV1E_GET_HASH_TRELLIS_STATS = 161,
 };
 
 /*!\brief aom 1-D scaling mode
@@ -1247,6 +1292,34 @@ typedef struct aom_roi_map {
   unsigned int static_threshold[AOM_MAX_SEGMENTS];
 } aom_roi_map_t;
 
+/*!\brief Border, in pixels, of images that the encoder can reference in
+ * place (see #AV1E_SET_SOURCE_RELEASE_CB).
+ */
+#define AOM_ENC_ZERO_COPY_BORDER 64
+
+/*!\brief Callback that hands a source image back to the application.
+ *
+ * \param[in] cb_priv    The cb_priv passed with the callback
+ * \param[in] user_priv  The user_priv of the aom_image_t being released
+ */
+typedef void (*aom_release_source_cb_fn_t)(void *cb_priv, void *user_priv);
+
+/*!\brief Source release callback, see #AV1E_SET_SOURCE_RELEASE_CB.
+ */
+typedef struct aom_source_release_cb {
+  aom_release_source_cb_fn_t release_cb; /**< Release callback */
+  void *cb_priv;                         /**< Private data for release_cb */
+} aom_source_release_cb_t;
+
+/*!\brief Hash based trellis cache statistics, see
+ * #AV1E_GET_HASH_TRELLIS_STATS.
+ */
+typedef struct aom_hash_trellis_stats {
+  uint64_t hits;      /**< Lookups that reused a cached result */
+  uint64_t misses;    /**< Lookups that ran the trellis */
+  uint64_t evictions; /**< Entries replaced in a full set */
+} aom_hash_trellis_stats_t;
+
 /*!\brief  aom active region map
  *
  * These defines the data structures for active region map
@@ -1415,6 +1488,18 @@ AOM_CTRL_USE_TYPE(AV1E_SET_TIMING_INFO_TYPE, int) /* aom_timing_info_type_t */
 AOM_CTRL_USE_TYPE(AV1E_SET_DISABLE_ML_PARTITION_SPEED_FEATURES, int)
 #define AOM_CTRL_AV1E_SET_DISABLE_ML_PARTITION_SPEED_FEATURES
 
+AOM_CTRL_USE_TYPE(AV1E_SET_INTRA_ENTROPY_SB_UPDATE, int)
+#define AOM_CTRL_AV1E_SET_INTRA_ENTROPY_SB_UPDATE
+
+AOM_CTRL_USE_TYPE(AV1E_SET_SOURCE_RELEASE_CB, aom_source_release_cb_t *)
+#define AOM_CTRL_AV1E_SET_SOURCE_RELEASE_CB
+
+AOM_CTRL_USE_TYPE(AV1E_SET_HASH_TRELLIS_SIZE, unsigned int)
+#define AOM_CTRL_AV1E_SET_HASH_TRELLIS_SIZE
+
+AOM_CTRL_USE_TYPE(AV1E_GET_HASH_TRELLIS_STATS, aom_hash_trellis_stats_t *)
+#define AOM_CTRL_AV1E_GET_HASH_TRELLIS_STATS
+
 AOM_CTRL_USE_TYPE(AV1E_SET_ENABLE_RECT_PARTITIONS, int)
 #define AOM_CTRL_AV1E_SET_ENABLE_RECT_PARTITIONS
 
@@ -100,6 +100,51 @@ typedef struct av1_ext_ref_frame {
   int num;
 } av1_ext_ref_frame_t;
 
+/*!\brief Structure to hold the memory use of the restoration scratch.
+ *
+ * The scratch holds the buffers of the frame-level restoration tools, MFQE
+ * and the CNN, from one frame to the next. See
+ * AV1D_GET_RESTORATION_SCRATCH_STATS.
+ */
+typedef struct aom_dec_scratch_stats {
+  /*! Bytes held by the scratch between frames, after the last frame. */
+  size_t size;
+  /*! Largest number of bytes held while restoring a frame, since the decoder
+   * was initialized. */
+  size_t peak_size;
+  /*! Number of scratch buffers allocated or grown. */
+  unsigned int num_allocs;
+} aom_dec_scratch_stats_t;
+
+/*!\brief Structure to hold the largest frames the decoder is to decode.
+ *
+ * Defines the frame format that the frame buffer pool of the decoder is
+ * allocated for, up front. See AV1D_SET_FRAME_POOL.
+ */
+typedef struct aom_dec_frame_pool_cfg {
+  /*! Largest frame width, after superres upscaling. */
+  unsigned int max_width;
+  /*! Largest frame height. */
+  unsigned int max_height;
+  /*! Largest bit depth: 8, 10 or 12. */
+  unsigned int max_bit_depth;
+} aom_dec_frame_pool_cfg_t;
+
+/*!\brief Structure to hold the allocation counters of the frame buffer pool.
+ *
+ * Defines a structure to hold the number of allocations the decoder made for
+ * its frames since it was initialized. See AV1D_GET_FRAME_POOL_STATS.
+ */
+typedef struct aom_dec_frame_pool_stats {
+  /*! Number of internal frame buffers allocated or grown. */
+  unsigned int num_frame_buffer_allocs;
+  /*! Number of side buffers of the frames allocated or grown: motion vector
+   * and segmentation maps, 8-bit luma copies and superres scratch frames. */
+  unsigned int num_side_buffer_allocs;
+  /*! Total size in bytes of the internal frame buffers. */
+  size_t frame_buffer_size;
+} aom_dec_frame_pool_stats_t;
+
 /*!\enum aom_dec_control_id
  * \brief AOM decoder control functions
  *
@@ -252,6 +297,50 @@ enum aom_dec_control_id {
    */
   AV1D_SET_SKIP_FILM_GRAIN,
 
+  /** control function to limit the bytes the restoration scratch of the
+   * decoder keeps between frames. Once a restoration tool is done with a
+   * frame, the largest scratch buffers are released until the scratch fits.
+   * The argument is an unsigned int, where 0, the default, means no limit. It
+   * must be set before the first frame is decoded, and returns
+   * AOM_CODEC_ERROR after that.
+   */
+  AV1D_SET_RESTORATION_SCRATCH_LIMIT,
+
+  /** control function to get the memory use of the restoration scratch, in
+   * an aom_dec_scratch_stats_t. Returns AOM_CODEC_INCAPABLE in frame parallel
+   * mode.
+   */
+  AV1D_GET_RESTORATION_SCRATCH_STATS,
+
+  /** control function to enable frame parallel decoding, where the headers
+   * are parsed in decoding order and up to 4 frames are decoded at once, each
+   * as soon as its reference frames are. A value that is equal to 1 enables
+   * it. It only takes effect before the first frame is decoded, with more
+   * than one thread, and not together with large scale tile decoding or
+   * AV1D_SET_OUTPUT_ALL_LAYERS. The frames are output in the same order, a
+   * few temporal units later, and the rest of them once the decoder is
+   * flushed. With film grain, a flush returns up to 8 frames, so it is
+   * repeated until no frame is returned. The controls that query the
+   * decoder state other than that of the last output frame return
+   * AOM_CODEC_INCAPABLE in this mode.
+   */
+  AV1D_SET_FRAME_PARALLEL,
+
+  /** control function to allocate the frame buffer pool up front for frames
+   * of up to the given size and bit depth, in any chroma format. Frame size
+   * changes within these limits then reuse the buffers instead of allocating
+   * them again. The argument is a pointer to an aom_dec_frame_pool_cfg_t. It
+   * has no effect with external frame buffers. It must be set before the
+   * first frame is decoded, and returns AOM_CODEC_ERROR after that.
+   */
+  AV1D_SET_FRAME_POOL,
+
+  /** control function to get the allocation counters of the frame buffer
+   * pool, in an aom_dec_frame_pool_stats_t. A steady state that does not
+   * allocate leaves them unchanged from frame to frame.
+   */
+  AV1D_GET_FRAME_POOL_STATS,
+
   AOM_DECODER_CTRL_ID_MAX,
 };
 
@@ -305,6 +394,16 @@ AOM_CTRL_USE_TYPE(AV1D_SET_ROW_MT, unsigned int)
 #define AOM_CTRL_AV1D_SET_ROW_MT
 AOM_CTRL_USE_TYPE(AV1D_SET_SKIP_FILM_GRAIN, int)
 #define AOM_CTRL_AV1D_SET_SKIP_FILM_GRAIN
+AOM_CTRL_USE_TYPE(AV1D_SET_RESTORATION_SCRATCH_LIMIT, unsigned int)
+#define AOM_CTRL_AV1D_SET_RESTORATION_SCRATCH_LIMIT
+AOM_CTRL_USE_TYPE(AV1D_GET_RESTORATION_SCRATCH_STATS, aom_dec_scratch_stats_t *)
+#define AOM_CTRL_AV1D_GET_RESTORATION_SCRATCH_STATS
+AOM_CTRL_USE_TYPE(AV1D_SET_FRAME_PARALLEL, unsigned int)
+#define AOM_CTRL_AV1D_SET_FRAME_PARALLEL
+AOM_CTRL_USE_TYPE(AV1D_SET_FRAME_POOL, aom_dec_frame_pool_cfg_t *)
+#define AOM_CTRL_AV1D_SET_FRAME_POOL
+AOM_CTRL_USE_TYPE(AV1D_GET_FRAME_POOL_STATS, aom_dec_frame_pool_stats_t *)
+#define AOM_CTRL_AV1D_GET_FRAME_POOL_STATS
 AOM_CTRL_USE_TYPE(AV1D_SET_IS_ANNEXB, unsigned int)
 #define AOM_CTRL_AV1D_SET_IS_ANNEXB
 AOM_CTRL_USE_TYPE(AV1D_SET_OPERATING_POINT, int)
@@ -146,6 +146,12 @@ if(CONFIG_AV1_DECODER)
               "${AOM_ROOT}/aom_dsp/entdec.c" "${AOM_ROOT}/aom_dsp/entdec.h"
               "${AOM_ROOT}/aom_dsp/grain_synthesis.c"
               "${AOM_ROOT}/aom_dsp/grain_synthesis.h")
+
+  list(APPEND AOM_DSP_DECODER_INTRIN_SSE2
+              "${AOM_ROOT}/aom_dsp/x86/entdec_sse2.c")
+
+  list(APPEND AOM_DSP_DECODER_INTRIN_AVX2
+              "${AOM_ROOT}/aom_dsp/x86/grain_synthesis_avx2.c")
 endif()
 
 if(CONFIG_AV1_ENCODER)
@@ -198,6 +204,7 @@ if(CONFIG_AV1_ENCODER)
               "${AOM_ROOT}/aom_dsp/x86/quantize_sse2.c"
               "${AOM_ROOT}/aom_dsp/x86/adaptive_quantize_sse2.c"
               "${AOM_ROOT}/aom_dsp/x86/highbd_adaptive_quantize_sse2.c"
+              "${AOM_ROOT}/aom_dsp/x86/noise_model_sse2.c"
               "${AOM_ROOT}/aom_dsp/x86/quantize_x86.h"
               "${AOM_ROOT}/aom_dsp/x86/sum_squares_sse2.c"
               "${AOM_ROOT}/aom_dsp/x86/variance_sse2.c")
@@ -218,6 +225,7 @@ if(CONFIG_AV1_ENCODER)
               "${AOM_ROOT}/aom_dsp/x86/sad_impl_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/variance_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/highbd_variance_avx2.c"
+              "${AOM_ROOT}/aom_dsp/x86/noise_model_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/sse_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/variance_impl_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/obmc_sad_avx2.c"
@@ -301,6 +309,10 @@ function(setup_aom_dsp_targets)
       add_intrinsics_object_library("-msse2" "sse2" "aom_dsp_encoder"
                                     "AOM_DSP_ENCODER_INTRIN_SSE2" "aom")
     endif()
+    if(CONFIG_AV1_DECODER)
+      add_intrinsics_object_library("-msse2" "sse2" "aom_dsp_decoder"
+                                    "AOM_DSP_DECODER_INTRIN_SSE2" "aom")
+    endif()
   endif()
 
   if(HAVE_SSSE3)
@@ -338,6 +350,10 @@ function(setup_aom_dsp_targets)
   if(HAVE_AVX2)
     add_intrinsics_object_library("-mavx2" "avx2" "aom_dsp_common"
                                   "AOM_DSP_COMMON_INTRIN_AVX2" "aom")
+    if(CONFIG_AV1_DECODER)
+      add_intrinsics_object_library("-mavx2" "avx2" "aom_dsp_decoder"
+                                    "AOM_DSP_DECODER_INTRIN_AVX2" "aom")
+    endif()
     if(CONFIG_AV1_ENCODER)
       add_intrinsics_object_library("-mavx2" "avx2" "aom_dsp_encoder"
                                     "AOM_DSP_ENCODER_INTRIN_AVX2" "aom")
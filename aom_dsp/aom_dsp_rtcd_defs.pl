@@ -19,6 +19,8 @@ print <<EOF
 #include "av1/common/enums.h"
 #include "av1/common/blockd.h"
 
+struct aom_grain_noise_params;
+
 EOF
 }
 forward_decls qw/aom_dsp_forward_decls/;
@@ -541,6 +543,28 @@ specialize qw/aom_highbd_lpf_horizontal_4 sse2/;
 add_proto qw/void aom_highbd_lpf_horizontal_4_dual/, "uint16_t *s, int pitch, const uint8_t *blimit0, const uint8_t *limit0, const uint8_t *thresh0, const uint8_t *blimit1, const uint8_t *limit1, const uint8_t *thresh1, int bd";
 specialize qw/aom_highbd_lpf_horizontal_4_dual sse2 avx2/;
 
+#
+# Entropy decoding
+#
+if (aom_config("CONFIG_AV1_DECODER") eq "yes") {
+  add_proto qw/int aom_ec_find_symbol/, "const uint16_t *icdf, int nsyms, unsigned rng, unsigned c";
+  specialize qw/aom_ec_find_symbol sse2/;
+
+  add_proto qw/void aom_update_cdf/, "uint16_t *cdf, int val, int nsymbs";
+  specialize qw/aom_update_cdf sse2/;
+}  # CONFIG_AV1_DECODER
+
+#
+# Film grain synthesis
+#
+if (aom_config("CONFIG_AV1_DECODER") eq "yes") {
+  add_proto qw/void aom_add_grain_noise/, "uint8_t *dst, int dst_stride, const uint8_t *luma, int luma_stride, const int *grain, int grain_stride, int width, int height, const struct aom_grain_noise_params *p";
+  specialize qw/aom_add_grain_noise avx2/;
+
+  add_proto qw/void aom_highbd_add_grain_noise/, "uint16_t *dst, int dst_stride, const uint16_t *luma, int luma_stride, const int *grain, int grain_stride, int width, int height, const struct aom_grain_noise_params *p";
+  specialize qw/aom_highbd_add_grain_noise avx2/;
+}  # CONFIG_AV1_DECODER
+
 #
 # Encoder functions.
 #
@@ -584,6 +608,13 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes"){
 
     add_proto qw/void aom_ifft32x32_float/, "const float *input, float *temp, float *output";
     specialize qw/aom_ifft32x32_float avx2          sse2/;
+
+    # Block windowing and overlap-add for the Wiener denoiser
+    add_proto qw/void aom_noise_window_block/, "const double *block_d, const double *plane_d, const float *window, float *block, float *plane, int n";
+    specialize qw/aom_noise_window_block avx2       sse2/;
+
+    add_proto qw/void aom_noise_accumulate_block/, "float *result, int result_stride, const float *block, const float *plane, const float *window, int block_size";
+    specialize qw/aom_noise_accumulate_block avx2   sse2/;
 }  # CONFIG_AV1_ENCODER
 
 #
@@ -16,6 +16,7 @@
 #include <limits.h>
 
 #include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
 
 #include "aom/aomdx.h"
 #include "aom/aom_integer.h"
@@ -152,7 +153,14 @@ static INLINE int aom_read_symbol_(aom_reader *r, aom_cdf_prob *cdf,
                                    int nsymbs ACCT_STR_PARAM) {
   int ret;
   ret = aom_read_cdf(r, cdf, nsymbs, ACCT_STR_NAME);
-  if (r->allow_update_cdf) update_cdf(cdf, ret, nsymbs);
+  if (r->allow_update_cdf) {
+    // Small alphabets are not worth a call through the SIMD dispatch.
+    if (nsymbs < 4) {
+      update_cdf(cdf, ret, nsymbs);
+    } else {
+      aom_update_cdf(cdf, ret, nsymbs);
+    }
+  }
   return ret;
 }
 
@@ -163,7 +171,7 @@ static INLINE int aom_read_symbol_nn_(aom_reader *r, aom_cdf_prob *cdf,
   const int ret = aom_read_cdf(r, cdf, nsymbs, ACCT_STR_NAME);
   if (r->allow_update_cdf) {
     av1_nn_backprop_em(nn_model, ret);
-    av1_nn_update_em(nn_model, nn_model->lr);
+    av1_nn_symbol_update_em(nn_model);
   }
   return ret;
 }
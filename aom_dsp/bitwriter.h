@@ -93,7 +93,7 @@ static INLINE void aom_write_symbol_nn(aom_writer *w, int symb,
   aom_write_cdf(w, symb, cdf, nsymbs);
   if (w->allow_update_cdf) {
     av1_nn_backprop_em(nn_model, symb);
-    av1_nn_update_em(nn_model, nn_model->lr);
+    av1_nn_symbol_update_em(nn_model);
   }
 }
 #endif  // CONFIG_INTRA_ENTROPY
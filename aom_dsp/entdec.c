@@ -10,6 +10,7 @@
  */
 
 #include <assert.h>
+#include "config/aom_dsp_rtcd.h"
 #include "aom_dsp/entdec.h"
 #include "aom_dsp/prob.h"
 
@@ -73,6 +74,16 @@
   Even relatively modest values like 100 would work fine.*/
 #define OD_EC_LOTS_OF_BITS (0x4000)
 
+/*Reads sizeof(od_ec_window) bytes from buf as a big-endian value.
+  The compiler turns this into a single unaligned load and byte swap.*/
+static INLINE od_ec_window od_ec_load_be(const unsigned char *buf) {
+  od_ec_window v;
+  size_t i;
+  v = 0;
+  for (i = 0; i < sizeof(v); i++) v = v << 8 | buf[i];
+  return v;
+}
+
 /*The return value of od_ec_dec_tell does not change across an od_ec_dec_refill
    call.*/
 static void od_ec_dec_refill(od_ec_dec *dec) {
@@ -86,6 +97,17 @@ static void od_ec_dec_refill(od_ec_dec *dec) {
   bptr = dec->bptr;
   end = dec->end;
   s = OD_EC_WINDOW_SIZE - 9 - (cnt + 15);
+  if (s >= 0 && end - bptr >= (ptrdiff_t)sizeof(od_ec_window)) {
+    /*Far enough from the end of the buffer: insert all (s >> 3) + 1 bytes the
+       byte loop below would, with a single window-sized load. The top n bytes
+       of the big-endian value land at bits s, s - 8, ..., s & 7 of dif.*/
+    const int n = (s >> 3) + 1;
+    assert(s <= OD_EC_WINDOW_SIZE - 8);
+    dif ^= od_ec_load_be(bptr) >> (OD_EC_WINDOW_SIZE - 8 * n) << (s & 7);
+    bptr += n;
+    cnt += 8 * n;
+    s -= 8 * n;
+  }
   for (; s >= 0 && bptr < end; s -= 8, bptr++) {
     /*Each time a byte is inserted into the window (dif), bptr advances and cnt
        is incremented by 8, so the total number of consumed bits (the return
@@ -143,7 +165,10 @@ static int od_ec_dec_normalize(od_ec_dec *dec, od_ec_window dif, unsigned rng,
 void od_ec_dec_init(od_ec_dec *dec, const unsigned char *buf,
                     uint32_t storage) {
   dec->buf = buf;
-  dec->tell_offs = 10 - (OD_EC_WINDOW_SIZE - 8);
+  /*cnt starts at -15 and grows by 8 for each byte read, so this makes tell
+     start at 1 (the bit reserved for terminating the stream) whatever the
+     window size.*/
+  dec->tell_offs = 1 - 15;
   dec->end = buf + storage;
   dec->bptr = buf;
   dec->dif = ((od_ec_window)1 << (OD_EC_WINDOW_SIZE - 1)) - 1;
@@ -181,6 +206,31 @@ int od_ec_decode_bool_q15(od_ec_dec *dec, unsigned f) {
   return od_ec_dec_normalize(dec, dif, r_new, ret);
 }
 
+/*Returns the part of the range rng that lies below the start of symbol s + 1,
+   i.e., the coded value is below it iff the symbol is greater than s.*/
+static INLINE unsigned od_ec_cdf_threshold(const uint16_t *icdf, int N, int s,
+                                           unsigned rng) {
+  return ((rng >> 8) * (uint32_t)(icdf[s] >> EC_PROB_SHIFT) >>
+          (7 - EC_PROB_SHIFT - CDF_SHIFT)) +
+         EC_MIN_PROB * (N - s);
+}
+
+/*Returns the symbol s whose interval contains the coded value c, given the
+   inverse CDF icdf of an alphabet of nsyms symbols and the range rng.
+  This is the first s for which c is not below its threshold.*/
+int aom_ec_find_symbol_c(const uint16_t *icdf, int nsyms, unsigned rng,
+                         unsigned c) {
+  const int N = nsyms - 1;
+  int s = 0;
+  while (c < od_ec_cdf_threshold(icdf, N, s, rng)) s++;
+  return s;
+}
+
+/*Adapts the CDF of an alphabet of nsymbs symbols to the decoded symbol val.*/
+void aom_update_cdf_c(uint16_t *cdf, int val, int nsymbs) {
+  update_cdf(cdf, val, nsymbs);
+}
+
 /*Decodes a symbol given an inverse cumulative distribution function (CDF)
    table in Q15.
   icdf: CDF_PROB_TOP minus the CDF, such that symbol s falls in the range
@@ -207,14 +257,12 @@ int od_ec_decode_cdf_q15(od_ec_dec *dec, const uint16_t *icdf, int nsyms) {
   assert(32768U <= r);
   assert(7 - EC_PROB_SHIFT - CDF_SHIFT >= 0);
   c = (unsigned)(dif >> (OD_EC_WINDOW_SIZE - 16));
-  v = r;
-  ret = -1;
-  do {
-    u = v;
-    v = ((r >> 8) * (uint32_t)(icdf[++ret] >> EC_PROB_SHIFT) >>
-         (7 - EC_PROB_SHIFT - CDF_SHIFT));
-    v += EC_MIN_PROB * (N - ret);
-  } while (c < v);
+  /*Small alphabets are not worth a call through the SIMD dispatch.*/
+  ret = nsyms < 4 ? aom_ec_find_symbol_c(icdf, nsyms, r, c)
+                  : aom_ec_find_symbol(icdf, nsyms, r, c);
+  u = ret > 0 ? od_ec_cdf_threshold(icdf, N, ret - 1, r) : r;
+  v = od_ec_cdf_threshold(icdf, N, ret, r);
+  assert(v <= c);
   assert(v < u);
   assert(u <= r);
   r = u - v;
@@ -18,6 +18,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include "config/aom_dsp_rtcd.h"
+
 #include "aom_dsp/grain_synthesis.h"
 #include "aom_mem/aom_mem.h"
 
@@ -228,27 +230,68 @@ static const int max_luma_legal_range = 235;
 static const int min_chroma_legal_range = 16;
 static const int max_chroma_legal_range = 240;
 
-static int scaling_lut_y[256];
-static int scaling_lut_cb[256];
-static int scaling_lut_cr[256];
-
 static int grain_min;
 static int grain_max;
 
-static uint16_t random_register = 0;  // random number generator register
+// Frame level state of the grain synthesis, shared by all bands of grain block
+// rows.
+typedef struct {
+  const aom_film_grain_t *params;
+  uint8_t *luma;
+  uint8_t *cb;
+  uint8_t *cr;
+  int height;
+  int width;
+  int luma_stride;
+  int chroma_stride;
+  int use_high_bit_depth;
+  int chroma_subsamp_y;
+  int chroma_subsamp_x;
+
+  int left_pad;
+  int top_pad;
+  int ar_padding;
+
+  int *luma_grain_block;
+  int *cb_grain_block;
+  int *cr_grain_block;
+  int luma_grain_stride;
+  int chroma_grain_stride;
+
+  int apply_y;
+  int apply_cb;
+  int apply_cr;
+  aom_grain_noise_params_t y_noise;
+  aom_grain_noise_params_t cb_noise;
+  aom_grain_noise_params_t cr_noise;
+
+  // The last entry repeats the one before it, see aom_grain_noise_params_t.
+  int scaling_lut_y[257];
+  int scaling_lut_cb[257];
+  int scaling_lut_cr[257];
+} grain_frame_t;
+
+// A band of grain block rows, with its own overlap buffers.
+typedef struct {
+  const grain_frame_t *frame;
+  // Rows in half luma lines, a multiple of luma_subblock_size_y / 2.
+  int row_start;
+  int row_end;
 
-static void init_arrays(const aom_film_grain_t *params, int luma_stride,
-                        int chroma_stride, int ***pred_pos_luma_p,
-                        int ***pred_pos_chroma_p, int **luma_grain_block,
-                        int **cb_grain_block, int **cr_grain_block,
-                        int **y_line_buf, int **cb_line_buf, int **cr_line_buf,
-                        int **y_col_buf, int **cb_col_buf, int **cr_col_buf,
-                        int luma_grain_samples, int chroma_grain_samples,
-                        int chroma_subsamp_y, int chroma_subsamp_x) {
-  memset(scaling_lut_y, 0, sizeof(*scaling_lut_y) * 256);
-  memset(scaling_lut_cb, 0, sizeof(*scaling_lut_cb) * 256);
-  memset(scaling_lut_cr, 0, sizeof(*scaling_lut_cr) * 256);
+  int *y_line_buf;
+  int *cb_line_buf;
+  int *cr_line_buf;
 
+  int *y_col_buf;
+  int *cb_col_buf;
+  int *cr_col_buf;
+} grain_band_t;
+
+static void init_arrays(const aom_film_grain_t *params,
+                        int ***pred_pos_luma_p, int ***pred_pos_chroma_p,
+                        int **luma_grain_block, int **cb_grain_block,
+                        int **cr_grain_block, int luma_grain_samples,
+                        int chroma_grain_samples) {
   int num_pos_luma = 2 * params->ar_coeff_lag * (params->ar_coeff_lag + 1);
   int num_pos_chroma = num_pos_luma;
   if (params->num_y_points > 0) ++num_pos_chroma;
@@ -306,23 +349,6 @@ static void init_arrays(const aom_film_grain_t *params, int luma_stride,
   *pred_pos_luma_p = pred_pos_luma;
   *pred_pos_chroma_p = pred_pos_chroma;
 
-  *y_line_buf = (int *)aom_malloc(sizeof(**y_line_buf) * luma_stride * 2);
-  *cb_line_buf = (int *)aom_malloc(sizeof(**cb_line_buf) * chroma_stride *
-                                   (2 >> chroma_subsamp_y));
-  *cr_line_buf = (int *)aom_malloc(sizeof(**cr_line_buf) * chroma_stride *
-                                   (2 >> chroma_subsamp_y));
-
-  *y_col_buf =
-      (int *)aom_malloc(sizeof(**y_col_buf) * (luma_subblock_size_y + 2) * 2);
-  *cb_col_buf =
-      (int *)aom_malloc(sizeof(**cb_col_buf) *
-                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
-                        (2 >> chroma_subsamp_x));
-  *cr_col_buf =
-      (int *)aom_malloc(sizeof(**cr_col_buf) *
-                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
-                        (2 >> chroma_subsamp_x));
-
   *luma_grain_block =
       (int *)aom_malloc(sizeof(**luma_grain_block) * luma_grain_samples);
   *cb_grain_block =
@@ -333,10 +359,7 @@ static void init_arrays(const aom_film_grain_t *params, int luma_stride,
 
 static void dealloc_arrays(const aom_film_grain_t *params, int ***pred_pos_luma,
                            int ***pred_pos_chroma, int **luma_grain_block,
-                           int **cb_grain_block, int **cr_grain_block,
-                           int **y_line_buf, int **cb_line_buf,
-                           int **cr_line_buf, int **y_col_buf, int **cb_col_buf,
-                           int **cr_col_buf) {
+                           int **cb_grain_block, int **cr_grain_block) {
   int num_pos_luma = 2 * params->ar_coeff_lag * (params->ar_coeff_lag + 1);
   int num_pos_chroma = num_pos_luma;
   if (params->num_y_points > 0) ++num_pos_chroma;
@@ -351,18 +374,6 @@ static void dealloc_arrays(const aom_film_grain_t *params, int ***pred_pos_luma,
   }
   aom_free((*pred_pos_chroma));
 
-  aom_free(*y_line_buf);
-
-  aom_free(*cb_line_buf);
-
-  aom_free(*cr_line_buf);
-
-  aom_free(*y_col_buf);
-
-  aom_free(*cb_col_buf);
-
-  aom_free(*cr_col_buf);
-
   aom_free(*luma_grain_block);
 
   aom_free(*cb_grain_block);
@@ -370,29 +381,66 @@ static void dealloc_arrays(const aom_film_grain_t *params, int ***pred_pos_luma,
   aom_free(*cr_grain_block);
 }
 
+static void alloc_band_bufs(grain_band_t *band, int luma_stride,
+                            int chroma_stride, int chroma_subsamp_y,
+                            int chroma_subsamp_x) {
+  band->y_line_buf =
+      (int *)aom_malloc(sizeof(*band->y_line_buf) * luma_stride * 2);
+  band->cb_line_buf = (int *)aom_malloc(
+      sizeof(*band->cb_line_buf) * chroma_stride * (2 >> chroma_subsamp_y));
+  band->cr_line_buf = (int *)aom_malloc(
+      sizeof(*band->cr_line_buf) * chroma_stride * (2 >> chroma_subsamp_y));
+
+  band->y_col_buf = (int *)aom_malloc(sizeof(*band->y_col_buf) *
+                                      (luma_subblock_size_y + 2) * 2);
+  band->cb_col_buf =
+      (int *)aom_malloc(sizeof(*band->cb_col_buf) *
+                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
+                        (2 >> chroma_subsamp_x));
+  band->cr_col_buf =
+      (int *)aom_malloc(sizeof(*band->cr_col_buf) *
+                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
+                        (2 >> chroma_subsamp_x));
+}
+
+static int band_bufs_allocated(const grain_band_t *band) {
+  return band->y_line_buf && band->cb_line_buf && band->cr_line_buf &&
+         band->y_col_buf && band->cb_col_buf && band->cr_col_buf;
+}
+
+static void dealloc_band_bufs(grain_band_t *band) {
+  aom_free(band->y_line_buf);
+  aom_free(band->cb_line_buf);
+  aom_free(band->cr_line_buf);
+  aom_free(band->y_col_buf);
+  aom_free(band->cb_col_buf);
+  aom_free(band->cr_col_buf);
+}
+
 // get a number between 0 and 2^bits - 1
-static INLINE int get_random_number(int bits) {
+static INLINE int get_random_number(uint16_t *random_register, int bits) {
   uint16_t bit;
-  bit = ((random_register >> 0) ^ (random_register >> 1) ^
-         (random_register >> 3) ^ (random_register >> 12)) &
+  bit = ((*random_register >> 0) ^ (*random_register >> 1) ^
+         (*random_register >> 3) ^ (*random_register >> 12)) &
         1;
-  random_register = (random_register >> 1) | (bit << 15);
-  return (random_register >> (16 - bits)) & ((1 << bits) - 1);
+  *random_register = (*random_register >> 1) | (bit << 15);
+  return (*random_register >> (16 - bits)) & ((1 << bits) - 1);
 }
 
-static void init_random_generator(int luma_line, uint16_t seed) {
+static void init_random_generator(uint16_t *random_register, int luma_line,
+                                  uint16_t seed) {
   // same for the picture
 
   uint16_t msb = (seed >> 8) & 255;
   uint16_t lsb = seed & 255;
 
-  random_register = (msb << 8) + lsb;
+  *random_register = (msb << 8) + lsb;
 
   //  changes for each row
   int luma_num = luma_line >> 5;
 
-  random_register ^= ((luma_num * 37 + 178) & 255) << 8;
-  random_register ^= ((luma_num * 173 + 105) & 255);
+  *random_register ^= ((luma_num * 37 + 178) & 255) << 8;
+  *random_register ^= ((luma_num * 173 + 105) & 255);
 }
 
 // Return 0 for success, -1 for failure
@@ -411,11 +459,12 @@ static int generate_luma_grain_block(
 
   int num_pos_luma = 2 * params->ar_coeff_lag * (params->ar_coeff_lag + 1);
   int rounding_offset = (1 << (params->ar_coeff_shift - 1));
+  uint16_t random_register = params->random_seed;
 
   for (int i = 0; i < luma_block_size_y; i++)
     for (int j = 0; j < luma_block_size_x; j++)
       luma_grain_block[i * luma_grain_stride + j] =
-          (gaussian_sequence[get_random_number(gauss_bits)] +
+          (gaussian_sequence[get_random_number(&random_register, gauss_bits)] +
            ((1 << gauss_sec_shift) >> 1)) >>
           gauss_sec_shift;
 
@@ -451,14 +500,16 @@ static int generate_chroma_grain_blocks(
   if (params->num_y_points > 0) ++num_pos_chroma;
   int rounding_offset = (1 << (params->ar_coeff_shift - 1));
   int chroma_grain_block_size = chroma_block_size_y * chroma_grain_stride;
+  uint16_t random_register;
 
   if (params->num_cb_points || params->chroma_scaling_from_luma) {
-    init_random_generator(7 << 5, params->random_seed);
+    init_random_generator(&random_register, 7 << 5, params->random_seed);
 
     for (int i = 0; i < chroma_block_size_y; i++)
       for (int j = 0; j < chroma_block_size_x; j++)
         cb_grain_block[i * chroma_grain_stride + j] =
-            (gaussian_sequence[get_random_number(gauss_bits)] +
+            (gaussian_sequence[get_random_number(&random_register,
+                                                 gauss_bits)] +
              ((1 << gauss_sec_shift) >> 1)) >>
             gauss_sec_shift;
   } else {
@@ -467,12 +518,13 @@ static int generate_chroma_grain_blocks(
   }
 
   if (params->num_cr_points || params->chroma_scaling_from_luma) {
-    init_random_generator(11 << 5, params->random_seed);
+    init_random_generator(&random_register, 11 << 5, params->random_seed);
 
     for (int i = 0; i < chroma_block_size_y; i++)
       for (int j = 0; j < chroma_block_size_x; j++)
         cr_grain_block[i * chroma_grain_stride + j] =
-            (gaussian_sequence[get_random_number(gauss_bits)] +
+            (gaussian_sequence[get_random_number(&random_register,
+                                                 gauss_bits)] +
              ((1 << gauss_sec_shift) >> 1)) >>
             gauss_sec_shift;
   } else {
@@ -558,7 +610,7 @@ static void init_scaling_function(const int scaling_points[][2], int num_points,
 
 // function that extracts samples from a LUT (and interpolates intemediate
 // frames for 10- and 12-bit video)
-static int scale_LUT(int *scaling_lut, int index, int bit_depth) {
+static int scale_LUT(const int *scaling_lut, int index, int bit_depth) {
   int x = index >> (bit_depth - 8);
 
   if (!(bit_depth - 8) || x == 255)
@@ -570,156 +622,100 @@ static int scale_LUT(int *scaling_lut, int index, int bit_depth) {
                              (bit_depth - 8));
 }
 
-static void add_noise_to_block(const aom_film_grain_t *params, uint8_t *luma,
-                               uint8_t *cb, uint8_t *cr, int luma_stride,
-                               int chroma_stride, int *luma_grain,
-                               int *cb_grain, int *cr_grain,
-                               int luma_grain_stride, int chroma_grain_stride,
-                               int half_luma_height, int half_luma_width,
-                               int bit_depth, int chroma_subsamp_y,
-                               int chroma_subsamp_x, int mc_identity) {
-  int cb_mult = params->cb_mult - 128;            // fixed scale
-  int cb_luma_mult = params->cb_luma_mult - 128;  // fixed scale
-  int cb_offset = params->cb_offset - 256;
-
-  int cr_mult = params->cr_mult - 128;            // fixed scale
-  int cr_luma_mult = params->cr_luma_mult - 128;  // fixed scale
-  int cr_offset = params->cr_offset - 256;
-
-  int rounding_offset = (1 << (params->scaling_shift - 1));
-
-  int apply_y = params->num_y_points > 0 ? 1 : 0;
-  int apply_cb =
-      (params->num_cb_points > 0 || params->chroma_scaling_from_luma) ? 1 : 0;
-  int apply_cr =
-      (params->num_cr_points > 0 || params->chroma_scaling_from_luma) ? 1 : 0;
-
-  if (params->chroma_scaling_from_luma) {
-    cb_mult = 0;        // fixed scale
-    cb_luma_mult = 64;  // fixed scale
-    cb_offset = 0;
-
-    cr_mult = 0;        // fixed scale
-    cr_luma_mult = 64;  // fixed scale
-    cr_offset = 0;
-  }
-
-  int min_luma, max_luma, min_chroma, max_chroma;
-
-  if (params->clip_to_restricted_range) {
-    min_luma = min_luma_legal_range;
-    max_luma = max_luma_legal_range;
+void aom_add_grain_noise_c(uint8_t *dst, int dst_stride, const uint8_t *luma,
+                           int luma_stride, const int *grain, int grain_stride,
+                           int width, int height,
+                           const aom_grain_noise_params_t *p) {
+  const int rounding_offset = (1 << (p->scaling_shift - 1));
 
-    if (mc_identity) {
-      min_chroma = min_luma_legal_range;
-      max_chroma = max_luma_legal_range;
-    } else {
-      min_chroma = min_chroma_legal_range;
-      max_chroma = max_chroma_legal_range;
-    }
-  } else {
-    min_luma = min_chroma = 0;
-    max_luma = max_chroma = 255;
-  }
-
-  for (int i = 0; i < (half_luma_height << (1 - chroma_subsamp_y)); i++) {
-    for (int j = 0; j < (half_luma_width << (1 - chroma_subsamp_x)); j++) {
+  for (int i = 0; i < height; i++) {
+    const uint8_t *luma_row = luma + (i << p->subsamp_y) * luma_stride;
+    for (int j = 0; j < width; j++) {
       int average_luma = 0;
-      if (chroma_subsamp_x) {
-        average_luma = (luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x)] +
-                        luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x) + 1] +
-                        1) >>
-                       1;
+      if (p->subsamp_x) {
+        average_luma = (luma_row[j << 1] + luma_row[(j << 1) + 1] + 1) >> 1;
       } else {
-        average_luma = luma[(i << chroma_subsamp_y) * luma_stride + j];
-      }
-
-      if (apply_cb) {
-        cb[i * chroma_stride + j] = clamp(
-            cb[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cb,
-                            clamp(((average_luma * cb_luma_mult +
-                                    cb_mult * cb[i * chroma_stride + j]) >>
-                                   6) +
-                                      cb_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            8) *
-                      cb_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
-      }
-
-      if (apply_cr) {
-        cr[i * chroma_stride + j] = clamp(
-            cr[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cr,
-                            clamp(((average_luma * cr_luma_mult +
-                                    cr_mult * cr[i * chroma_stride + j]) >>
-                                   6) +
-                                      cr_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            8) *
-                      cr_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
+        average_luma = luma_row[j];
       }
+      const int index = clamp(
+          ((average_luma * p->luma_mult + p->mult * dst[i * dst_stride + j]) >>
+           6) + p->offset,
+          0, 255);
+      dst[i * dst_stride + j] =
+          clamp(dst[i * dst_stride + j] +
+                    ((scale_LUT(p->scaling_lut, index, 8) *
+                          grain[i * grain_stride + j] +
+                      rounding_offset) >>
+                     p->scaling_shift),
+                p->min_value, p->max_value);
     }
   }
+}
 
-  if (apply_y) {
-    for (int i = 0; i < (half_luma_height << 1); i++) {
-      for (int j = 0; j < (half_luma_width << 1); j++) {
-        luma[i * luma_stride + j] =
-            clamp(luma[i * luma_stride + j] +
-                      ((scale_LUT(scaling_lut_y, luma[i * luma_stride + j], 8) *
-                            luma_grain[i * luma_grain_stride + j] +
-                        rounding_offset) >>
-                       params->scaling_shift),
-                  min_luma, max_luma);
+void aom_highbd_add_grain_noise_c(uint16_t *dst, int dst_stride,
+                                  const uint16_t *luma, int luma_stride,
+                                  const int *grain, int grain_stride,
+                                  int width, int height,
+                                  const aom_grain_noise_params_t *p) {
+  const int rounding_offset = (1 << (p->scaling_shift - 1));
+  const int bit_depth = p->bit_depth;
+
+  for (int i = 0; i < height; i++) {
+    const uint16_t *luma_row = luma + (i << p->subsamp_y) * luma_stride;
+    for (int j = 0; j < width; j++) {
+      int average_luma = 0;
+      if (p->subsamp_x) {
+        average_luma = (luma_row[j << 1] + luma_row[(j << 1) + 1] + 1) >> 1;
+      } else {
+        average_luma = luma_row[j];
       }
+      const int index = clamp(
+          ((average_luma * p->luma_mult + p->mult * dst[i * dst_stride + j]) >>
+           6) + p->offset,
+          0, (256 << (bit_depth - 8)) - 1);
+      dst[i * dst_stride + j] =
+          clamp(dst[i * dst_stride + j] +
+                    ((scale_LUT(p->scaling_lut, index, bit_depth) *
+                          grain[i * grain_stride + j] +
+                      rounding_offset) >>
+                     p->scaling_shift),
+                p->min_value, p->max_value);
     }
   }
 }
 
-static void add_noise_to_block_hbd(
-    const aom_film_grain_t *params, uint16_t *luma, uint16_t *cb, uint16_t *cr,
-    int luma_stride, int chroma_stride, int *luma_grain, int *cb_grain,
-    int *cr_grain, int luma_grain_stride, int chroma_grain_stride,
-    int half_luma_height, int half_luma_width, int bit_depth,
-    int chroma_subsamp_y, int chroma_subsamp_x, int mc_identity) {
-  int cb_mult = params->cb_mult - 128;            // fixed scale
-  int cb_luma_mult = params->cb_luma_mult - 128;  // fixed scale
-  // offset value depends on the bit depth
-  int cb_offset = (params->cb_offset << (bit_depth - 8)) - (1 << bit_depth);
-
-  int cr_mult = params->cr_mult - 128;            // fixed scale
-  int cr_luma_mult = params->cr_luma_mult - 128;  // fixed scale
-  // offset value depends on the bit depth
-  int cr_offset = (params->cr_offset << (bit_depth - 8)) - (1 << bit_depth);
-
-  int rounding_offset = (1 << (params->scaling_shift - 1));
-
-  int apply_y = params->num_y_points > 0 ? 1 : 0;
-  int apply_cb =
-      (params->num_cb_points > 0 || params->chroma_scaling_from_luma) > 0 ? 1
-                                                                          : 0;
-  int apply_cr =
-      (params->num_cr_points > 0 || params->chroma_scaling_from_luma) > 0 ? 1
-                                                                          : 0;
+// Sets up the noise blend of all planes, and the scaling functions they use.
+static void init_noise_params(grain_frame_t *f, int mc_identity) {
+  const aom_film_grain_t *params = f->params;
+  const int bit_depth = params->bit_depth;
 
-  if (params->chroma_scaling_from_luma) {
-    cb_mult = 0;        // fixed scale
-    cb_luma_mult = 64;  // fixed scale
-    cb_offset = 0;
+  memset(f->scaling_lut_y, 0, sizeof(f->scaling_lut_y));
+  memset(f->scaling_lut_cb, 0, sizeof(f->scaling_lut_cb));
+  memset(f->scaling_lut_cr, 0, sizeof(f->scaling_lut_cr));
 
-    cr_mult = 0;        // fixed scale
-    cr_luma_mult = 64;  // fixed scale
-    cr_offset = 0;
+  init_scaling_function(params->scaling_points_y, params->num_y_points,
+                        f->scaling_lut_y);
+
+  if (params->chroma_scaling_from_luma) {
+    memcpy(f->scaling_lut_cb, f->scaling_lut_y,
+           sizeof(*f->scaling_lut_y) * 256);
+    memcpy(f->scaling_lut_cr, f->scaling_lut_y,
+           sizeof(*f->scaling_lut_y) * 256);
+  } else {
+    init_scaling_function(params->scaling_points_cb, params->num_cb_points,
+                          f->scaling_lut_cb);
+    init_scaling_function(params->scaling_points_cr, params->num_cr_points,
+                          f->scaling_lut_cr);
   }
+  f->scaling_lut_y[256] = f->scaling_lut_y[255];
+  f->scaling_lut_cb[256] = f->scaling_lut_cb[255];
+  f->scaling_lut_cr[256] = f->scaling_lut_cr[255];
+
+  f->apply_y = params->num_y_points > 0 ? 1 : 0;
+  f->apply_cb =
+      (params->num_cb_points > 0 || params->chroma_scaling_from_luma) ? 1 : 0;
+  f->apply_cr =
+      (params->num_cr_points > 0 || params->chroma_scaling_from_luma) ? 1 : 0;
 
   int min_luma, max_luma, min_chroma, max_chroma;
 
@@ -739,66 +735,92 @@ static void add_noise_to_block_hbd(
     max_luma = max_chroma = (256 << (bit_depth - 8)) - 1;
   }
 
-  for (int i = 0; i < (half_luma_height << (1 - chroma_subsamp_y)); i++) {
-    for (int j = 0; j < (half_luma_width << (1 - chroma_subsamp_x)); j++) {
-      int average_luma = 0;
-      if (chroma_subsamp_x) {
-        average_luma = (luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x)] +
-                        luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x) + 1] +
-                        1) >>
-                       1;
-      } else {
-        average_luma = luma[(i << chroma_subsamp_y) * luma_stride + j];
-      }
-
-      if (apply_cb) {
-        cb[i * chroma_stride + j] = clamp(
-            cb[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cb,
-                            clamp(((average_luma * cb_luma_mult +
-                                    cb_mult * cb[i * chroma_stride + j]) >>
-                                   6) +
-                                      cb_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            bit_depth) *
-                      cb_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
-      }
-      if (apply_cr) {
-        cr[i * chroma_stride + j] = clamp(
-            cr[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cr,
-                            clamp(((average_luma * cr_luma_mult +
-                                    cr_mult * cr[i * chroma_stride + j]) >>
-                                   6) +
-                                      cr_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            bit_depth) *
-                      cr_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
-      }
-    }
+  aom_grain_noise_params_t *y = &f->y_noise;
+  y->scaling_lut = f->scaling_lut_y;
+  y->luma_mult = 64;  // fixed scale
+  y->mult = 0;
+  y->offset = 0;
+  y->scaling_shift = params->scaling_shift;
+  y->min_value = min_luma;
+  y->max_value = max_luma;
+  y->bit_depth = bit_depth;
+  y->subsamp_x = 0;
+  y->subsamp_y = 0;
+
+  aom_grain_noise_params_t *cb = &f->cb_noise;
+  *cb = *y;
+  cb->scaling_lut = f->scaling_lut_cb;
+  cb->min_value = min_chroma;
+  cb->max_value = max_chroma;
+  cb->subsamp_x = f->chroma_subsamp_x;
+  cb->subsamp_y = f->chroma_subsamp_y;
+
+  aom_grain_noise_params_t *cr = &f->cr_noise;
+  *cr = *cb;
+  cr->scaling_lut = f->scaling_lut_cr;
+
+  if (!params->chroma_scaling_from_luma) {
+    cb->mult = params->cb_mult - 128;            // fixed scale
+    cb->luma_mult = params->cb_luma_mult - 128;  // fixed scale
+    // offset value depends on the bit depth
+    cb->offset = (params->cb_offset << (bit_depth - 8)) - (1 << bit_depth);
+
+    cr->mult = params->cr_mult - 128;            // fixed scale
+    cr->luma_mult = params->cr_luma_mult - 128;  // fixed scale
+    // offset value depends on the bit depth
+    cr->offset = (params->cr_offset << (bit_depth - 8)) - (1 << bit_depth);
   }
+}
 
-  if (apply_y) {
-    for (int i = 0; i < (half_luma_height << 1); i++) {
-      for (int j = 0; j < (half_luma_width << 1); j++) {
-        luma[i * luma_stride + j] =
-            clamp(luma[i * luma_stride + j] +
-                      ((scale_LUT(scaling_lut_y, luma[i * luma_stride + j],
-                                  bit_depth) *
-                            luma_grain[i * luma_grain_stride + j] +
-                        rounding_offset) >>
-                       params->scaling_shift),
-                  min_luma, max_luma);
-      }
-    }
+// Adds noise to a block whose top left corner is at (half_y * 2, half_x * 2) in
+// the luma plane. The chroma planes are done first, as they depend on the luma
+// samples without noise.
+static void add_noise_to_block(const grain_frame_t *f, int half_y, int half_x,
+                               const int *luma_grain, const int *cb_grain,
+                               const int *cr_grain, int luma_grain_stride,
+                               int chroma_grain_stride, int half_luma_height,
+                               int half_luma_width) {
+  const int chroma_subsamp_y = f->chroma_subsamp_y;
+  const int chroma_subsamp_x = f->chroma_subsamp_x;
+  const int luma_stride = f->luma_stride;
+  const int chroma_stride = f->chroma_stride;
+  const int luma_pos = (half_y << 1) * luma_stride + (half_x << 1);
+  const int chroma_pos = (half_y << (1 - chroma_subsamp_y)) * chroma_stride +
+                         (half_x << (1 - chroma_subsamp_x));
+  const int chroma_height = half_luma_height << (1 - chroma_subsamp_y);
+  const int chroma_width = half_luma_width << (1 - chroma_subsamp_x);
+
+  if (f->use_high_bit_depth) {
+    uint16_t *luma = (uint16_t *)f->luma + luma_pos;
+    if (f->apply_cb)
+      aom_highbd_add_grain_noise((uint16_t *)f->cb + chroma_pos, chroma_stride,
+                                 luma, luma_stride, cb_grain,
+                                 chroma_grain_stride, chroma_width,
+                                 chroma_height, &f->cb_noise);
+    if (f->apply_cr)
+      aom_highbd_add_grain_noise((uint16_t *)f->cr + chroma_pos, chroma_stride,
+                                 luma, luma_stride, cr_grain,
+                                 chroma_grain_stride, chroma_width,
+                                 chroma_height, &f->cr_noise);
+    if (f->apply_y)
+      aom_highbd_add_grain_noise(luma, luma_stride, luma, luma_stride,
+                                 luma_grain, luma_grain_stride,
+                                 half_luma_width << 1, half_luma_height << 1,
+                                 &f->y_noise);
+  } else {
+    uint8_t *luma = f->luma + luma_pos;
+    if (f->apply_cb)
+      aom_add_grain_noise(f->cb + chroma_pos, chroma_stride, luma, luma_stride,
+                          cb_grain, chroma_grain_stride, chroma_width,
+                          chroma_height, &f->cb_noise);
+    if (f->apply_cr)
+      aom_add_grain_noise(f->cr + chroma_pos, chroma_stride, luma, luma_stride,
+                          cr_grain, chroma_grain_stride, chroma_width,
+                          chroma_height, &f->cr_noise);
+    if (f->apply_y)
+      aom_add_grain_noise(luma, luma_stride, luma, luma_stride, luma_grain,
+                          luma_grain_stride, half_luma_width << 1,
+                          half_luma_height << 1, &f->y_noise);
   }
 }
 
@@ -914,8 +936,417 @@ static void hor_boundary_overlap(int *top_block, int top_stride,
   }
 }
 
-int av1_add_film_grain(const aom_film_grain_t *params, const aom_image_t *src,
-                       aom_image_t *dst) {
+// Adds grain to the row of grain blocks starting at half luma line y. With
+// apply == 0 the frame is left untouched, and only the overlap buffers are
+// filled in for the next row.
+static void add_film_grain_row(const grain_frame_t *f, grain_band_t *band,
+                               int y, int apply) {
+  const aom_film_grain_t *params = f->params;
+  const int height = f->height;
+  const int width = f->width;
+  const int luma_stride = f->luma_stride;
+  const int chroma_stride = f->chroma_stride;
+  const int chroma_subsamp_y = f->chroma_subsamp_y;
+  const int chroma_subsamp_x = f->chroma_subsamp_x;
+  const int left_pad = f->left_pad;
+  const int top_pad = f->top_pad;
+  const int ar_padding = f->ar_padding;
+  int *luma_grain_block = f->luma_grain_block;
+  int *cb_grain_block = f->cb_grain_block;
+  int *cr_grain_block = f->cr_grain_block;
+  const int luma_grain_stride = f->luma_grain_stride;
+  const int chroma_grain_stride = f->chroma_grain_stride;
+  int *y_line_buf = band->y_line_buf;
+  int *cb_line_buf = band->cb_line_buf;
+  int *cr_line_buf = band->cr_line_buf;
+  int *y_col_buf = band->y_col_buf;
+  int *cb_col_buf = band->cb_col_buf;
+  int *cr_col_buf = band->cr_col_buf;
+  const int overlap = params->overlap_flag;
+  uint16_t random_register;
+
+  init_random_generator(&random_register, y * 2, params->random_seed);
+
+  for (int x = 0; x < width / 2; x += (luma_subblock_size_x >> 1)) {
+    int offset_y = get_random_number(&random_register, 8);
+    int offset_x = (offset_y >> 4) & 15;
+    offset_y &= 15;
+
+    int luma_offset_y = left_pad + 2 * ar_padding + (offset_y << 1);
+    int luma_offset_x = top_pad + 2 * ar_padding + (offset_x << 1);
+
+    int chroma_offset_y = top_pad + (2 >> chroma_subsamp_y) * ar_padding +
+                          offset_y * (2 >> chroma_subsamp_y);
+    int chroma_offset_x = left_pad + (2 >> chroma_subsamp_x) * ar_padding +
+                          offset_x * (2 >> chroma_subsamp_x);
+
+    if (overlap && x) {
+      ver_boundary_overlap(
+          y_col_buf, 2,
+          luma_grain_block + luma_offset_y * luma_grain_stride + luma_offset_x,
+          luma_grain_stride, y_col_buf, 2, 2,
+          AOMMIN(luma_subblock_size_y + 2, height - (y << 1)));
+
+      ver_boundary_overlap(
+          cb_col_buf, 2 >> chroma_subsamp_x,
+          cb_grain_block + chroma_offset_y * chroma_grain_stride +
+              chroma_offset_x,
+          chroma_grain_stride, cb_col_buf, 2 >> chroma_subsamp_x,
+          2 >> chroma_subsamp_x,
+          AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+                 (height - (y << 1)) >> chroma_subsamp_y));
+
+      ver_boundary_overlap(
+          cr_col_buf, 2 >> chroma_subsamp_x,
+          cr_grain_block + chroma_offset_y * chroma_grain_stride +
+              chroma_offset_x,
+          chroma_grain_stride, cr_col_buf, 2 >> chroma_subsamp_x,
+          2 >> chroma_subsamp_x,
+          AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+                 (height - (y << 1)) >> chroma_subsamp_y));
+
+      int i = y ? 1 : 0;
+
+      if (apply) {
+        add_noise_to_block(
+            f, y + i, x, y_col_buf + i * 4,
+            cb_col_buf + i * (2 - chroma_subsamp_y) * (2 - chroma_subsamp_x),
+            cr_col_buf + i * (2 - chroma_subsamp_y) * (2 - chroma_subsamp_x),
+            2, (2 - chroma_subsamp_x),
+            AOMMIN(luma_subblock_size_y >> 1, height / 2 - y) - i, 1);
+      }
+    }
+
+    // The line buffers hold the previous row only when the grain is applied.
+    if (overlap && y && apply) {
+      if (x) {
+        hor_boundary_overlap(y_line_buf + (x << 1), luma_stride, y_col_buf, 2,
+                             y_line_buf + (x << 1), luma_stride, 2, 2);
+
+        hor_boundary_overlap(cb_line_buf + x * (2 >> chroma_subsamp_x),
+                             chroma_stride, cb_col_buf, 2 >> chroma_subsamp_x,
+                             cb_line_buf + x * (2 >> chroma_subsamp_x),
+                             chroma_stride, 2 >> chroma_subsamp_x,
+                             2 >> chroma_subsamp_y);
+
+        hor_boundary_overlap(cr_line_buf + x * (2 >> chroma_subsamp_x),
+                             chroma_stride, cr_col_buf, 2 >> chroma_subsamp_x,
+                             cr_line_buf + x * (2 >> chroma_subsamp_x),
+                             chroma_stride, 2 >> chroma_subsamp_x,
+                             2 >> chroma_subsamp_y);
+      }
+
+      hor_boundary_overlap(
+          y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
+          luma_grain_block + luma_offset_y * luma_grain_stride + luma_offset_x +
+              (x ? 2 : 0),
+          luma_grain_stride, y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
+          AOMMIN(luma_subblock_size_x - ((x ? 1 : 0) << 1),
+                 width - ((x ? x + 1 : 0) << 1)),
+          2);
+
+      hor_boundary_overlap(
+          cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+          chroma_stride,
+          cb_grain_block + chroma_offset_y * chroma_grain_stride +
+              chroma_offset_x + ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
+          chroma_grain_stride,
+          cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+          chroma_stride,
+          AOMMIN(chroma_subblock_size_x -
+                     ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
+                 (width - ((x ? x + 1 : 0) << 1)) >> chroma_subsamp_x),
+          2 >> chroma_subsamp_y);
+
+      hor_boundary_overlap(
+          cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+          chroma_stride,
+          cr_grain_block + chroma_offset_y * chroma_grain_stride +
+              chroma_offset_x + ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
+          chroma_grain_stride,
+          cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+          chroma_stride,
+          AOMMIN(chroma_subblock_size_x -
+                     ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
+                 (width - ((x ? x + 1 : 0) << 1)) >> chroma_subsamp_x),
+          2 >> chroma_subsamp_y);
+
+      add_noise_to_block(f, y, x, y_line_buf + (x << 1),
+                         cb_line_buf + (x << (1 - chroma_subsamp_x)),
+                         cr_line_buf + (x << (1 - chroma_subsamp_x)),
+                         luma_stride, chroma_stride, 1,
+                         AOMMIN(luma_subblock_size_x >> 1, width / 2 - x));
+    }
+
+    int i = overlap && y ? 1 : 0;
+    int j = overlap && x ? 1 : 0;
+
+    if (apply) {
+      add_noise_to_block(
+          f, y + i, x + j,
+          luma_grain_block + (luma_offset_y + (i << 1)) * luma_grain_stride +
+              luma_offset_x + (j << 1),
+          cb_grain_block +
+              (chroma_offset_y + (i << (1 - chroma_subsamp_y))) *
+                  chroma_grain_stride +
+              chroma_offset_x + (j << (1 - chroma_subsamp_x)),
+          cr_grain_block +
+              (chroma_offset_y + (i << (1 - chroma_subsamp_y))) *
+                  chroma_grain_stride +
+              chroma_offset_x + (j << (1 - chroma_subsamp_x)),
+          luma_grain_stride, chroma_grain_stride,
+          AOMMIN(luma_subblock_size_y >> 1, height / 2 - y) - i,
+          AOMMIN(luma_subblock_size_x >> 1, width / 2 - x) - j);
+    }
+
+    if (overlap) {
+      if (x) {
+        // Copy overlapped column bufer to line buffer
+        copy_area(y_col_buf + (luma_subblock_size_y << 1), 2,
+                  y_line_buf + (x << 1), luma_stride, 2, 2);
+
+        copy_area(
+            cb_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
+            2 >> chroma_subsamp_x, cb_line_buf + (x << (1 - chroma_subsamp_x)),
+            chroma_stride, 2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
+
+        copy_area(
+            cr_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
+            2 >> chroma_subsamp_x, cr_line_buf + (x << (1 - chroma_subsamp_x)),
+            chroma_stride, 2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
+      }
+
+      // Copy grain to the line buffer for overlap with a bottom block
+      copy_area(
+          luma_grain_block +
+              (luma_offset_y + luma_subblock_size_y) * luma_grain_stride +
+              luma_offset_x + ((x ? 2 : 0)),
+          luma_grain_stride, y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
+          AOMMIN(luma_subblock_size_x, width - (x << 1)) - (x ? 2 : 0), 2);
+
+      copy_area(cb_grain_block +
+                    (chroma_offset_y + chroma_subblock_size_y) *
+                        chroma_grain_stride +
+                    chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
+                chroma_grain_stride,
+                cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+                chroma_stride,
+                AOMMIN(chroma_subblock_size_x,
+                       ((width - (x << 1)) >> chroma_subsamp_x)) -
+                    (x ? 2 >> chroma_subsamp_x : 0),
+                2 >> chroma_subsamp_y);
+
+      copy_area(cr_grain_block +
+                    (chroma_offset_y + chroma_subblock_size_y) *
+                        chroma_grain_stride +
+                    chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
+                chroma_grain_stride,
+                cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+                chroma_stride,
+                AOMMIN(chroma_subblock_size_x,
+                       ((width - (x << 1)) >> chroma_subsamp_x)) -
+                    (x ? 2 >> chroma_subsamp_x : 0),
+                2 >> chroma_subsamp_y);
+
+      // Copy grain to the column buffer for overlap with the next block to
+      // the right
+
+      copy_area(luma_grain_block + luma_offset_y * luma_grain_stride +
+                    luma_offset_x + luma_subblock_size_x,
+                luma_grain_stride, y_col_buf, 2, 2,
+                AOMMIN(luma_subblock_size_y + 2, height - (y << 1)));
+
+      copy_area(cb_grain_block + chroma_offset_y * chroma_grain_stride +
+                    chroma_offset_x + chroma_subblock_size_x,
+                chroma_grain_stride, cb_col_buf, 2 >> chroma_subsamp_x,
+                2 >> chroma_subsamp_x,
+                AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+                       (height - (y << 1)) >> chroma_subsamp_y));
+
+      copy_area(cr_grain_block + chroma_offset_y * chroma_grain_stride +
+                    chroma_offset_x + chroma_subblock_size_x,
+                chroma_grain_stride, cr_col_buf, 2 >> chroma_subsamp_x,
+                2 >> chroma_subsamp_x,
+                AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+                       (height - (y << 1)) >> chroma_subsamp_y));
+    }
+  }
+}
+
+// Adds grain to the rows of a band. The random offsets of a row only depend on
+// its position, so the only state carried over from the row above is in the
+// overlap buffers, which are rebuilt by running through that row first.
+static int add_film_grain_band(void *arg1, void *unused) {
+  grain_band_t *const band = (grain_band_t *)arg1;
+  const grain_frame_t *const f = band->frame;
+  const int row_step = luma_subblock_size_y >> 1;
+  (void)unused;
+
+  if (f->params->overlap_flag && band->row_start > 0)
+    add_film_grain_row(f, band, band->row_start - row_step, 0);
+  for (int y = band->row_start; y < band->row_end; y += row_step)
+    add_film_grain_row(f, band, y, 1);
+  return 1;
+}
+
+// Returns the number of bands the rows of grain blocks are split into. Each
+// band gets at least two rows, as its first row above is processed twice.
+static int get_num_grain_bands(int height, int num_workers) {
+  const int row_step = luma_subblock_size_y >> 1;
+  const int num_rows = (height / 2 + row_step - 1) / row_step;
+  return AOMMAX(1, AOMMIN(num_workers, num_rows / 2));
+}
+
+static int add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
+                              uint8_t *cb, uint8_t *cr, int height, int width,
+                              int luma_stride, int chroma_stride,
+                              int use_high_bit_depth, int chroma_subsamp_y,
+                              int chroma_subsamp_x, int mc_identity,
+                              AVxWorker *workers, int num_workers) {
+  int **pred_pos_luma;
+  int **pred_pos_chroma;
+  int *luma_grain_block;
+  int *cb_grain_block;
+  int *cr_grain_block;
+
+  int left_pad = 3;
+  int right_pad = 3;  // padding to offset for AR coefficients
+  int top_pad = 3;
+  int bottom_pad = 0;
+
+  int ar_padding = 3;  // maximum lag used for stabilization of AR coefficients
+
+  luma_subblock_size_y = 32;
+  luma_subblock_size_x = 32;
+
+  chroma_subblock_size_y = luma_subblock_size_y >> chroma_subsamp_y;
+  chroma_subblock_size_x = luma_subblock_size_x >> chroma_subsamp_x;
+
+  // Initial padding is only needed for generation of
+  // film grain templates (to stabilize the AR process)
+  // Only a 64x64 luma and 32x32 chroma part of a template
+  // is used later for adding grain, padding can be discarded
+
+  int luma_block_size_y =
+      top_pad + 2 * ar_padding + luma_subblock_size_y * 2 + bottom_pad;
+  int luma_block_size_x = left_pad + 2 * ar_padding + luma_subblock_size_x * 2 +
+                          2 * ar_padding + right_pad;
+
+  int chroma_block_size_y = top_pad + (2 >> chroma_subsamp_y) * ar_padding +
+                            chroma_subblock_size_y * 2 + bottom_pad;
+  int chroma_block_size_x = left_pad + (2 >> chroma_subsamp_x) * ar_padding +
+                            chroma_subblock_size_x * 2 +
+                            (2 >> chroma_subsamp_x) * ar_padding + right_pad;
+
+  int luma_grain_stride = luma_block_size_x;
+  int chroma_grain_stride = chroma_block_size_x;
+
+  int bit_depth = params->bit_depth;
+
+  const int grain_center = 128 << (bit_depth - 8);
+  grain_min = 0 - grain_center;
+  grain_max = grain_center - 1;
+
+  init_arrays(params, &pred_pos_luma, &pred_pos_chroma, &luma_grain_block,
+              &cb_grain_block, &cr_grain_block,
+              luma_block_size_y * luma_block_size_x,
+              chroma_block_size_y * chroma_block_size_x);
+
+  if (generate_luma_grain_block(params, pred_pos_luma, luma_grain_block,
+                                luma_block_size_y, luma_block_size_x,
+                                luma_grain_stride, left_pad, top_pad, right_pad,
+                                bottom_pad))
+    return -1;
+
+  if (generate_chroma_grain_blocks(
+          params,
+          //                               pred_pos_luma,
+          pred_pos_chroma, luma_grain_block, cb_grain_block, cr_grain_block,
+          luma_grain_stride, chroma_block_size_y, chroma_block_size_x,
+          chroma_grain_stride, left_pad, top_pad, right_pad, bottom_pad,
+          chroma_subsamp_y, chroma_subsamp_x))
+    return -1;
+
+  grain_frame_t frame;
+  grain_frame_t *const f = &frame;
+  f->params = params;
+  f->luma = luma;
+  f->cb = cb;
+  f->cr = cr;
+  f->height = height;
+  f->width = width;
+  f->luma_stride = luma_stride;
+  f->chroma_stride = chroma_stride;
+  f->use_high_bit_depth = use_high_bit_depth;
+  f->chroma_subsamp_y = chroma_subsamp_y;
+  f->chroma_subsamp_x = chroma_subsamp_x;
+  f->left_pad = left_pad;
+  f->top_pad = top_pad;
+  f->ar_padding = ar_padding;
+  f->luma_grain_block = luma_grain_block;
+  f->cb_grain_block = cb_grain_block;
+  f->cr_grain_block = cr_grain_block;
+  f->luma_grain_stride = luma_grain_stride;
+  f->chroma_grain_stride = chroma_grain_stride;
+  init_noise_params(f, mc_identity);
+
+  const int num_bands = workers ? get_num_grain_bands(height, num_workers) : 1;
+  const int row_step = luma_subblock_size_y >> 1;
+  const int num_rows = (height / 2 + row_step - 1) / row_step;
+  grain_band_t *const bands =
+      (grain_band_t *)aom_calloc(num_bands, sizeof(*bands));
+  int ret = bands ? 0 : -1;
+
+  for (int b = 0; bands && b < num_bands; b++) {
+    grain_band_t *const band = &bands[b];
+    band->frame = f;
+    band->row_start = num_rows * b / num_bands * row_step;
+    band->row_end = num_rows * (b + 1) / num_bands * row_step;
+    alloc_band_bufs(band, luma_stride, chroma_stride, chroma_subsamp_y,
+                    chroma_subsamp_x);
+    if (!band_bufs_allocated(band)) ret = -1;
+  }
+
+  if (!ret) {
+    if (num_bands == 1) {
+      add_film_grain_band(&bands[0], NULL);
+    } else {
+      const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+      for (int b = 0; b < num_bands; b++) {
+        AVxWorker *const worker = &workers[b];
+        worker->hook = add_film_grain_band;
+        worker->data1 = &bands[b];
+        worker->data2 = NULL;
+        if (b == num_bands - 1) {
+          winterface->execute(worker);
+        } else {
+          winterface->launch(worker);
+        }
+      }
+      for (int b = 0; b < num_bands; b++) winterface->sync(&workers[b]);
+    }
+  }
+
+  for (int b = 0; bands && b < num_bands; b++) dealloc_band_bufs(&bands[b]);
+  aom_free(bands);
+  dealloc_arrays(params, &pred_pos_luma, &pred_pos_chroma, &luma_grain_block,
+                 &cb_grain_block, &cr_grain_block);
+  return ret;
+}
+
+int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
+                           uint8_t *cb, uint8_t *cr, int height, int width,
+                           int luma_stride, int chroma_stride,
+                           int use_high_bit_depth, int chroma_subsamp_y,
+                           int chroma_subsamp_x, int mc_identity) {
+  return add_film_grain_run(params, luma, cb, cr, height, width, luma_stride,
+                            chroma_stride, use_high_bit_depth, chroma_subsamp_y,
+                            chroma_subsamp_x, mc_identity, NULL, 0);
+}
+
+int av1_add_film_grain_mt(const aom_film_grain_t *params,
+                          const aom_image_t *src, aom_image_t *dst,
+                          AVxWorker *workers, int num_workers) {
   uint8_t *luma, *cb, *cr;
   int height, width, luma_stride, chroma_stride;
   int use_high_bit_depth = 0;
@@ -1015,394 +1446,13 @@ int av1_add_film_grain(const aom_film_grain_t *params, const aom_image_t *src,
   luma_stride = dst->stride[AOM_PLANE_Y] >> use_high_bit_depth;
   chroma_stride = dst->stride[AOM_PLANE_U] >> use_high_bit_depth;
 
-  return av1_add_film_grain_run(
-      params, luma, cb, cr, height, width, luma_stride, chroma_stride,
-      use_high_bit_depth, chroma_subsamp_y, chroma_subsamp_x, mc_identity);
+  return add_film_grain_run(params, luma, cb, cr, height, width, luma_stride,
+                            chroma_stride, use_high_bit_depth, chroma_subsamp_y,
+                            chroma_subsamp_x, mc_identity, workers,
+                            num_workers);
 }
 
-int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
-                           uint8_t *cb, uint8_t *cr, int height, int width,
-                           int luma_stride, int chroma_stride,
-                           int use_high_bit_depth, int chroma_subsamp_y,
-                           int chroma_subsamp_x, int mc_identity) {
-  int **pred_pos_luma;
-  int **pred_pos_chroma;
-  int *luma_grain_block;
-  int *cb_grain_block;
-  int *cr_grain_block;
-
-  int *y_line_buf;
-  int *cb_line_buf;
-  int *cr_line_buf;
-
-  int *y_col_buf;
-  int *cb_col_buf;
-  int *cr_col_buf;
-
-  random_register = params->random_seed;
-
-  int left_pad = 3;
-  int right_pad = 3;  // padding to offset for AR coefficients
-  int top_pad = 3;
-  int bottom_pad = 0;
-
-  int ar_padding = 3;  // maximum lag used for stabilization of AR coefficients
-
-  luma_subblock_size_y = 32;
-  luma_subblock_size_x = 32;
-
-  chroma_subblock_size_y = luma_subblock_size_y >> chroma_subsamp_y;
-  chroma_subblock_size_x = luma_subblock_size_x >> chroma_subsamp_x;
-
-  // Initial padding is only needed for generation of
-  // film grain templates (to stabilize the AR process)
-  // Only a 64x64 luma and 32x32 chroma part of a template
-  // is used later for adding grain, padding can be discarded
-
-  int luma_block_size_y =
-      top_pad + 2 * ar_padding + luma_subblock_size_y * 2 + bottom_pad;
-  int luma_block_size_x = left_pad + 2 * ar_padding + luma_subblock_size_x * 2 +
-                          2 * ar_padding + right_pad;
-
-  int chroma_block_size_y = top_pad + (2 >> chroma_subsamp_y) * ar_padding +
-                            chroma_subblock_size_y * 2 + bottom_pad;
-  int chroma_block_size_x = left_pad + (2 >> chroma_subsamp_x) * ar_padding +
-                            chroma_subblock_size_x * 2 +
-                            (2 >> chroma_subsamp_x) * ar_padding + right_pad;
-
-  int luma_grain_stride = luma_block_size_x;
-  int chroma_grain_stride = chroma_block_size_x;
-
-  int overlap = params->overlap_flag;
-  int bit_depth = params->bit_depth;
-
-  const int grain_center = 128 << (bit_depth - 8);
-  grain_min = 0 - grain_center;
-  grain_max = grain_center - 1;
-
-  init_arrays(params, luma_stride, chroma_stride, &pred_pos_luma,
-              &pred_pos_chroma, &luma_grain_block, &cb_grain_block,
-              &cr_grain_block, &y_line_buf, &cb_line_buf, &cr_line_buf,
-              &y_col_buf, &cb_col_buf, &cr_col_buf,
-              luma_block_size_y * luma_block_size_x,
-              chroma_block_size_y * chroma_block_size_x, chroma_subsamp_y,
-              chroma_subsamp_x);
-
-  if (generate_luma_grain_block(params, pred_pos_luma, luma_grain_block,
-                                luma_block_size_y, luma_block_size_x,
-                                luma_grain_stride, left_pad, top_pad, right_pad,
-                                bottom_pad))
-    return -1;
-
-  if (generate_chroma_grain_blocks(
-          params,
-          //                               pred_pos_luma,
-          pred_pos_chroma, luma_grain_block, cb_grain_block, cr_grain_block,
-          luma_grain_stride, chroma_block_size_y, chroma_block_size_x,
-          chroma_grain_stride, left_pad, top_pad, right_pad, bottom_pad,
-          chroma_subsamp_y, chroma_subsamp_x))
-    return -1;
-
-  init_scaling_function(params->scaling_points_y, params->num_y_points,
-                        scaling_lut_y);
-
-  if (params->chroma_scaling_from_luma) {
-    memcpy(scaling_lut_cb, scaling_lut_y, sizeof(*scaling_lut_y) * 256);
-    memcpy(scaling_lut_cr, scaling_lut_y, sizeof(*scaling_lut_y) * 256);
-  } else {
-    init_scaling_function(params->scaling_points_cb, params->num_cb_points,
-                          scaling_lut_cb);
-    init_scaling_function(params->scaling_points_cr, params->num_cr_points,
-                          scaling_lut_cr);
-  }
-  for (int y = 0; y < height / 2; y += (luma_subblock_size_y >> 1)) {
-    init_random_generator(y * 2, params->random_seed);
-
-    for (int x = 0; x < width / 2; x += (luma_subblock_size_x >> 1)) {
-      int offset_y = get_random_number(8);
-      int offset_x = (offset_y >> 4) & 15;
-      offset_y &= 15;
-
-      int luma_offset_y = left_pad + 2 * ar_padding + (offset_y << 1);
-      int luma_offset_x = top_pad + 2 * ar_padding + (offset_x << 1);
-
-      int chroma_offset_y = top_pad + (2 >> chroma_subsamp_y) * ar_padding +
-                            offset_y * (2 >> chroma_subsamp_y);
-      int chroma_offset_x = left_pad + (2 >> chroma_subsamp_x) * ar_padding +
-                            offset_x * (2 >> chroma_subsamp_x);
-
-      if (overlap && x) {
-        ver_boundary_overlap(
-            y_col_buf, 2,
-            luma_grain_block + luma_offset_y * luma_grain_stride +
-                luma_offset_x,
-            luma_grain_stride, y_col_buf, 2, 2,
-            AOMMIN(luma_subblock_size_y + 2, height - (y << 1)));
-
-        ver_boundary_overlap(
-            cb_col_buf, 2 >> chroma_subsamp_x,
-            cb_grain_block + chroma_offset_y * chroma_grain_stride +
-                chroma_offset_x,
-            chroma_grain_stride, cb_col_buf, 2 >> chroma_subsamp_x,
-            2 >> chroma_subsamp_x,
-            AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                   (height - (y << 1)) >> chroma_subsamp_y));
-
-        ver_boundary_overlap(
-            cr_col_buf, 2 >> chroma_subsamp_x,
-            cr_grain_block + chroma_offset_y * chroma_grain_stride +
-                chroma_offset_x,
-            chroma_grain_stride, cr_col_buf, 2 >> chroma_subsamp_x,
-            2 >> chroma_subsamp_x,
-            AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                   (height - (y << 1)) >> chroma_subsamp_y));
-
-        int i = y ? 1 : 0;
-
-        if (use_high_bit_depth) {
-          add_noise_to_block_hbd(
-              params,
-              (uint16_t *)luma + ((y + i) << 1) * luma_stride + (x << 1),
-              (uint16_t *)cb +
-                  ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << (1 - chroma_subsamp_x)),
-              (uint16_t *)cr +
-                  ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << (1 - chroma_subsamp_x)),
-              luma_stride, chroma_stride, y_col_buf + i * 4,
-              cb_col_buf + i * (2 - chroma_subsamp_y) * (2 - chroma_subsamp_x),
-              cr_col_buf + i * (2 - chroma_subsamp_y) * (2 - chroma_subsamp_x),
-              2, (2 - chroma_subsamp_x),
-              AOMMIN(luma_subblock_size_y >> 1, height / 2 - y) - i, 1,
-              bit_depth, chroma_subsamp_y, chroma_subsamp_x, mc_identity);
-        } else {
-          add_noise_to_block(
-              params, luma + ((y + i) << 1) * luma_stride + (x << 1),
-              cb + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << (1 - chroma_subsamp_x)),
-              cr + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << (1 - chroma_subsamp_x)),
-              luma_stride, chroma_stride, y_col_buf + i * 4,
-              cb_col_buf + i * (2 - chroma_subsamp_y) * (2 - chroma_subsamp_x),
-              cr_col_buf + i * (2 - chroma_subsamp_y) * (2 - chroma_subsamp_x),
-              2, (2 - chroma_subsamp_x),
-              AOMMIN(luma_subblock_size_y >> 1, height / 2 - y) - i, 1,
-              bit_depth, chroma_subsamp_y, chroma_subsamp_x, mc_identity);
-        }
-      }
-
-      if (overlap && y) {
-        if (x) {
-          hor_boundary_overlap(y_line_buf + (x << 1), luma_stride, y_col_buf, 2,
-                               y_line_buf + (x << 1), luma_stride, 2, 2);
-
-          hor_boundary_overlap(cb_line_buf + x * (2 >> chroma_subsamp_x),
-                               chroma_stride, cb_col_buf, 2 >> chroma_subsamp_x,
-                               cb_line_buf + x * (2 >> chroma_subsamp_x),
-                               chroma_stride, 2 >> chroma_subsamp_x,
-                               2 >> chroma_subsamp_y);
-
-          hor_boundary_overlap(cr_line_buf + x * (2 >> chroma_subsamp_x),
-                               chroma_stride, cr_col_buf, 2 >> chroma_subsamp_x,
-                               cr_line_buf + x * (2 >> chroma_subsamp_x),
-                               chroma_stride, 2 >> chroma_subsamp_x,
-                               2 >> chroma_subsamp_y);
-        }
-
-        hor_boundary_overlap(
-            y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
-            luma_grain_block + luma_offset_y * luma_grain_stride +
-                luma_offset_x + (x ? 2 : 0),
-            luma_grain_stride, y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
-            AOMMIN(luma_subblock_size_x - ((x ? 1 : 0) << 1),
-                   width - ((x ? x + 1 : 0) << 1)),
-            2);
-
-        hor_boundary_overlap(
-            cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-            chroma_stride,
-            cb_grain_block + chroma_offset_y * chroma_grain_stride +
-                chroma_offset_x + ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
-            chroma_grain_stride,
-            cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-            chroma_stride,
-            AOMMIN(chroma_subblock_size_x -
-                       ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
-                   (width - ((x ? x + 1 : 0) << 1)) >> chroma_subsamp_x),
-            2 >> chroma_subsamp_y);
-
-        hor_boundary_overlap(
-            cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-            chroma_stride,
-            cr_grain_block + chroma_offset_y * chroma_grain_stride +
-                chroma_offset_x + ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
-            chroma_grain_stride,
-            cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-            chroma_stride,
-            AOMMIN(chroma_subblock_size_x -
-                       ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
-                   (width - ((x ? x + 1 : 0) << 1)) >> chroma_subsamp_x),
-            2 >> chroma_subsamp_y);
-
-        if (use_high_bit_depth) {
-          add_noise_to_block_hbd(
-              params, (uint16_t *)luma + (y << 1) * luma_stride + (x << 1),
-              (uint16_t *)cb + (y << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << ((1 - chroma_subsamp_x))),
-              (uint16_t *)cr + (y << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << ((1 - chroma_subsamp_x))),
-              luma_stride, chroma_stride, y_line_buf + (x << 1),
-              cb_line_buf + (x << (1 - chroma_subsamp_x)),
-              cr_line_buf + (x << (1 - chroma_subsamp_x)), luma_stride,
-              chroma_stride, 1,
-              AOMMIN(luma_subblock_size_x >> 1, width / 2 - x), bit_depth,
-              chroma_subsamp_y, chroma_subsamp_x, mc_identity);
-        } else {
-          add_noise_to_block(
-              params, luma + (y << 1) * luma_stride + (x << 1),
-              cb + (y << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << ((1 - chroma_subsamp_x))),
-              cr + (y << (1 - chroma_subsamp_y)) * chroma_stride +
-                  (x << ((1 - chroma_subsamp_x))),
-              luma_stride, chroma_stride, y_line_buf + (x << 1),
-              cb_line_buf + (x << (1 - chroma_subsamp_x)),
-              cr_line_buf + (x << (1 - chroma_subsamp_x)), luma_stride,
-              chroma_stride, 1,
-              AOMMIN(luma_subblock_size_x >> 1, width / 2 - x), bit_depth,
-              chroma_subsamp_y, chroma_subsamp_x, mc_identity);
-        }
-      }
-
-      int i = overlap && y ? 1 : 0;
-      int j = overlap && x ? 1 : 0;
-
-      if (use_high_bit_depth) {
-        add_noise_to_block_hbd(
-            params,
-            (uint16_t *)luma + ((y + i) << 1) * luma_stride + ((x + j) << 1),
-            (uint16_t *)cb +
-                ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                ((x + j) << (1 - chroma_subsamp_x)),
-            (uint16_t *)cr +
-                ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                ((x + j) << (1 - chroma_subsamp_x)),
-            luma_stride, chroma_stride,
-            luma_grain_block + (luma_offset_y + (i << 1)) * luma_grain_stride +
-                luma_offset_x + (j << 1),
-            cb_grain_block +
-                (chroma_offset_y + (i << (1 - chroma_subsamp_y))) *
-                    chroma_grain_stride +
-                chroma_offset_x + (j << (1 - chroma_subsamp_x)),
-            cr_grain_block +
-                (chroma_offset_y + (i << (1 - chroma_subsamp_y))) *
-                    chroma_grain_stride +
-                chroma_offset_x + (j << (1 - chroma_subsamp_x)),
-            luma_grain_stride, chroma_grain_stride,
-            AOMMIN(luma_subblock_size_y >> 1, height / 2 - y) - i,
-            AOMMIN(luma_subblock_size_x >> 1, width / 2 - x) - j, bit_depth,
-            chroma_subsamp_y, chroma_subsamp_x, mc_identity);
-      } else {
-        add_noise_to_block(
-            params, luma + ((y + i) << 1) * luma_stride + ((x + j) << 1),
-            cb + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                ((x + j) << (1 - chroma_subsamp_x)),
-            cr + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
-                ((x + j) << (1 - chroma_subsamp_x)),
-            luma_stride, chroma_stride,
-            luma_grain_block + (luma_offset_y + (i << 1)) * luma_grain_stride +
-                luma_offset_x + (j << 1),
-            cb_grain_block +
-                (chroma_offset_y + (i << (1 - chroma_subsamp_y))) *
-                    chroma_grain_stride +
-                chroma_offset_x + (j << (1 - chroma_subsamp_x)),
-            cr_grain_block +
-                (chroma_offset_y + (i << (1 - chroma_subsamp_y))) *
-                    chroma_grain_stride +
-                chroma_offset_x + (j << (1 - chroma_subsamp_x)),
-            luma_grain_stride, chroma_grain_stride,
-            AOMMIN(luma_subblock_size_y >> 1, height / 2 - y) - i,
-            AOMMIN(luma_subblock_size_x >> 1, width / 2 - x) - j, bit_depth,
-            chroma_subsamp_y, chroma_subsamp_x, mc_identity);
-      }
-
-      if (overlap) {
-        if (x) {
-          // Copy overlapped column bufer to line buffer
-          copy_area(y_col_buf + (luma_subblock_size_y << 1), 2,
-                    y_line_buf + (x << 1), luma_stride, 2, 2);
-
-          copy_area(
-              cb_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
-              2 >> chroma_subsamp_x,
-              cb_line_buf + (x << (1 - chroma_subsamp_x)), chroma_stride,
-              2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
-
-          copy_area(
-              cr_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
-              2 >> chroma_subsamp_x,
-              cr_line_buf + (x << (1 - chroma_subsamp_x)), chroma_stride,
-              2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
-        }
-
-        // Copy grain to the line buffer for overlap with a bottom block
-        copy_area(
-            luma_grain_block +
-                (luma_offset_y + luma_subblock_size_y) * luma_grain_stride +
-                luma_offset_x + ((x ? 2 : 0)),
-            luma_grain_stride, y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
-            AOMMIN(luma_subblock_size_x, width - (x << 1)) - (x ? 2 : 0), 2);
-
-        copy_area(cb_grain_block +
-                      (chroma_offset_y + chroma_subblock_size_y) *
-                          chroma_grain_stride +
-                      chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
-                  chroma_grain_stride,
-                  cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-                  chroma_stride,
-                  AOMMIN(chroma_subblock_size_x,
-                         ((width - (x << 1)) >> chroma_subsamp_x)) -
-                      (x ? 2 >> chroma_subsamp_x : 0),
-                  2 >> chroma_subsamp_y);
-
-        copy_area(cr_grain_block +
-                      (chroma_offset_y + chroma_subblock_size_y) *
-                          chroma_grain_stride +
-                      chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
-                  chroma_grain_stride,
-                  cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-                  chroma_stride,
-                  AOMMIN(chroma_subblock_size_x,
-                         ((width - (x << 1)) >> chroma_subsamp_x)) -
-                      (x ? 2 >> chroma_subsamp_x : 0),
-                  2 >> chroma_subsamp_y);
-
-        // Copy grain to the column buffer for overlap with the next block to
-        // the right
-
-        copy_area(luma_grain_block + luma_offset_y * luma_grain_stride +
-                      luma_offset_x + luma_subblock_size_x,
-                  luma_grain_stride, y_col_buf, 2, 2,
-                  AOMMIN(luma_subblock_size_y + 2, height - (y << 1)));
-
-        copy_area(cb_grain_block + chroma_offset_y * chroma_grain_stride +
-                      chroma_offset_x + chroma_subblock_size_x,
-                  chroma_grain_stride, cb_col_buf, 2 >> chroma_subsamp_x,
-                  2 >> chroma_subsamp_x,
-                  AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                         (height - (y << 1)) >> chroma_subsamp_y));
-
-        copy_area(cr_grain_block + chroma_offset_y * chroma_grain_stride +
-                      chroma_offset_x + chroma_subblock_size_x,
-                  chroma_grain_stride, cr_col_buf, 2 >> chroma_subsamp_x,
-                  2 >> chroma_subsamp_x,
-                  AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                         (height - (y << 1)) >> chroma_subsamp_y));
-      }
-    }
-  }
-
-  dealloc_arrays(params, &pred_pos_luma, &pred_pos_chroma, &luma_grain_block,
-                 &cb_grain_block, &cr_grain_block, &y_line_buf, &cb_line_buf,
-                 &cr_line_buf, &y_col_buf, &cb_col_buf, &cr_col_buf);
-  return 0;
+int av1_add_film_grain(const aom_film_grain_t *params, const aom_image_t *src,
+                       aom_image_t *dst) {
+  return av1_add_film_grain_mt(params, src, dst, NULL, 0);
 }
@@ -24,6 +24,7 @@ extern "C" {
 
 #include "aom_dsp/aom_dsp_common.h"
 #include "aom/aom_image.h"
+#include "aom_util/aom_thread.h"
 
 /*!\brief Structure containing film grain synthesis parameters for a frame
  *
@@ -151,6 +152,28 @@ static INLINE int av1_check_grain_params_equiv(
   return 1;
 }
 
+/*!\brief Parameters of the noise blend of one plane
+ *
+ * The scaling function is evaluated at
+ * clamp(((average_luma * luma_mult + mult * sample) >> 6) + offset), where
+ * average_luma is the co-located luma sample, averaged over horizontal pairs
+ * when subsamp_x is set.
+ */
+typedef struct aom_grain_noise_params {
+  // Scaling function with 257 entries, the last one repeating the one before
+  // it, so that 10- and 12-bit samples can be interpolated without a branch.
+  const int *scaling_lut;
+  int luma_mult;
+  int mult;
+  int offset;
+  int scaling_shift;
+  int min_value;
+  int max_value;
+  int bit_depth;
+  int subsamp_x;
+  int subsamp_y;
+} aom_grain_noise_params_t;
+
 /*!\brief Add film grain
  *
  * Add film grain to an image
@@ -185,6 +208,24 @@ int av1_add_film_grain_run(const aom_film_grain_t *grain_params, uint8_t *luma,
 int av1_add_film_grain(const aom_film_grain_t *grain_params,
                        const aom_image_t *src, aom_image_t *dst);
 
+/*!\brief Add film grain using worker threads
+ *
+ * Same as av1_add_film_grain(), with the rows of grain blocks split into bands
+ * that are run on the given workers. The last worker runs on the calling
+ * thread. The output does not depend on the number of workers.
+ *
+ * Returns 0 for success, -1 for failure
+ *
+ * \param[in]    grain_params     Grain parameters
+ * \param[in]    src              Source image
+ * \param[out]   dst              Resulting image with grain
+ * \param[in]    workers          Idle workers, may be NULL
+ * \param[in]    num_workers      Number of workers
+ */
+int av1_add_film_grain_mt(const aom_film_grain_t *grain_params,
+                          const aom_image_t *src, aom_image_t *dst,
+                          AVxWorker *workers, int num_workers);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -14,6 +14,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "config/aom_dsp_rtcd.h"
+
 #include "aom_dsp/aom_dsp_common.h"
 #include "aom_dsp/noise_model.h"
 #include "aom_dsp/noise_util.h"
@@ -552,9 +554,58 @@ static int compare_scores(const void *a, const void *b) {
   return 0;
 }
 
-int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
-                              const uint8_t *const data, int w, int h,
-                              int stride, uint8_t *flat_blocks) {
+// Runs hook() on each job, one job per worker. Jobs are job_size bytes apart.
+// As in the encoder, workers[0] is the calling thread and has no thread of its
+// own, so its job is executed last, after the other workers are launched.
+static void run_worker_jobs(AVxWorkerHook hook, void *jobs, size_t job_size,
+                            int num_jobs, AVxWorker *workers) {
+  if (num_jobs == 1) {
+    hook(jobs, NULL);
+    return;
+  }
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  for (int i = num_jobs - 1; i >= 0; --i) {
+    AVxWorker *const worker = &workers[i];
+    worker->hook = hook;
+    worker->data1 = (uint8_t *)jobs + i * job_size;
+    worker->data2 = NULL;
+    if (i == 0) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
+    }
+  }
+  for (int i = 1; i < num_jobs; ++i) winterface->sync(&workers[i]);
+}
+
+// The block rows scored by one worker: every by_step-th row from by_start.
+typedef struct {
+  const aom_flat_block_finder_t *block_finder;
+  const uint8_t *data;
+  int w;
+  int h;
+  int stride;
+  int num_blocks_w;
+  int num_blocks_h;
+  int by_start;
+  int by_step;
+  double *plane;
+  double *block;
+  uint8_t *flat_blocks;
+  index_and_score_t *scores;
+  int num_flat;
+} flat_block_job_t;
+
+static int find_flat_block_rows(void *arg1, void *unused) {
+  flat_block_job_t *const job = (flat_block_job_t *)arg1;
+  const aom_flat_block_finder_t *block_finder = job->block_finder;
+  const uint8_t *const data = job->data;
+  const int w = job->w, h = job->h, stride = job->stride;
+  const int num_blocks_w = job->num_blocks_w;
+  uint8_t *const flat_blocks = job->flat_blocks;
+  index_and_score_t *const scores = job->scores;
+  double *const plane = job->plane;
+  double *const block = job->block;
   // The gradient-based features used in this code are based on:
   //  A. Kokaram, D. Kelly, H. Denman and A. Crawford, "Measuring noise
   //  correlation for improved video denoising," 2012 19th, ICIP.
@@ -566,27 +617,11 @@ int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
   const double kRatioThreshold = 1.25;
   const double kNormThreshold = 0.08 / (32 * 32);
   const double kVarThreshold = 0.005 / (double)n;
-  const int num_blocks_w = (w + block_size - 1) / block_size;
-  const int num_blocks_h = (h + block_size - 1) / block_size;
   int num_flat = 0;
-  int bx = 0, by = 0;
-  double *plane = (double *)aom_malloc(n * sizeof(*plane));
-  double *block = (double *)aom_malloc(n * sizeof(*block));
-  index_and_score_t *scores = (index_and_score_t *)aom_malloc(
-      num_blocks_w * num_blocks_h * sizeof(*scores));
-  if (plane == NULL || block == NULL || scores == NULL) {
-    fprintf(stderr, "Failed to allocate memory for block of size %d\n", n);
-    aom_free(plane);
-    aom_free(block);
-    aom_free(scores);
-    return -1;
-  }
+  (void)unused;
 
-#ifdef NOISE_MODEL_LOG_SCORE
-  fprintf(stderr, "score = [");
-#endif
-  for (by = 0; by < num_blocks_h; ++by) {
-    for (bx = 0; bx < num_blocks_w; ++bx) {
+  for (int by = job->by_start; by < job->num_blocks_h; by += job->by_step) {
+    for (int bx = 0; bx < num_blocks_w; ++bx) {
       // Compute gradient covariance matrix.
       double Gxx = 0, Gxy = 0, Gyy = 0;
       double var = 0;
@@ -656,6 +691,72 @@ int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
     fprintf(stderr, "\n");
 #endif
   }
+  job->num_flat = num_flat;
+  return 1;
+}
+
+static void free_flat_block_jobs(flat_block_job_t *jobs, int num_jobs) {
+  for (int i = 0; jobs && i < num_jobs; ++i) {
+    aom_free(jobs[i].block);
+    aom_free(jobs[i].plane);
+  }
+  aom_free(jobs);
+}
+
+int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
+                              const uint8_t *const data, int w, int h,
+                              int stride, uint8_t *flat_blocks) {
+  return aom_flat_block_finder_run_mt(block_finder, data, w, h, stride,
+                                      flat_blocks, NULL, 0);
+}
+
+int aom_flat_block_finder_run_mt(const aom_flat_block_finder_t *block_finder,
+                                 const uint8_t *const data, int w, int h,
+                                 int stride, uint8_t *flat_blocks,
+                                 AVxWorker *workers, int num_workers) {
+  const int block_size = block_finder->block_size;
+  const int n = block_size * block_size;
+  const int num_blocks_w = (w + block_size - 1) / block_size;
+  const int num_blocks_h = (h + block_size - 1) / block_size;
+  const int num_jobs = AOMMAX(1, AOMMIN(num_workers, num_blocks_h));
+  int num_flat = 0;
+  int alloc_success = 1;
+  flat_block_job_t *jobs =
+      (flat_block_job_t *)aom_calloc(num_jobs, sizeof(*jobs));
+  index_and_score_t *scores = (index_and_score_t *)aom_malloc(
+      num_blocks_w * num_blocks_h * sizeof(*scores));
+  for (int i = 0; jobs && i < num_jobs; ++i) {
+    jobs[i].plane = (double *)aom_malloc(n * sizeof(*jobs[i].plane));
+    jobs[i].block = (double *)aom_malloc(n * sizeof(*jobs[i].block));
+    alloc_success &= jobs[i].plane != NULL && jobs[i].block != NULL;
+  }
+  if (jobs == NULL || scores == NULL || !alloc_success) {
+    fprintf(stderr, "Failed to allocate memory for block of size %d\n", n);
+    free_flat_block_jobs(jobs, num_jobs);
+    aom_free(scores);
+    return -1;
+  }
+
+#ifdef NOISE_MODEL_LOG_SCORE
+  fprintf(stderr, "score = [");
+#endif
+  for (int i = 0; i < num_jobs; ++i) {
+    flat_block_job_t *const job = &jobs[i];
+    job->block_finder = block_finder;
+    job->data = data;
+    job->w = w;
+    job->h = h;
+    job->stride = stride;
+    job->num_blocks_w = num_blocks_w;
+    job->num_blocks_h = num_blocks_h;
+    job->by_start = i;
+    job->by_step = num_jobs;
+    job->flat_blocks = flat_blocks;
+    job->scores = scores;
+  }
+  run_worker_jobs(find_flat_block_rows, jobs, sizeof(*jobs), num_jobs,
+                  workers);
+  for (int i = 0; i < num_jobs; ++i) num_flat += jobs[i].num_flat;
 #ifdef NOISE_MODEL_LOG_SCORE
   fprintf(stderr, "];\n");
 #endif
@@ -671,8 +772,7 @@ int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
       flat_blocks[scores[i].index] |= 1;
     }
   }
-  aom_free(block);
-  aom_free(plane);
+  free_flat_block_jobs(jobs, num_jobs);
   aom_free(scores);
   return num_flat;
 }
@@ -1279,9 +1379,24 @@ int aom_noise_model_get_grain_parameters(aom_noise_model_t *const noise_model,
   return 1;
 }
 
-static void pointwise_multiply(const float *a, float *b, int n) {
+void aom_noise_window_block_c(const double *block_d, const double *plane_d,
+                              const float *window, float *block, float *plane,
+                              int n) {
   for (int i = 0; i < n; ++i) {
-    b[i] *= a[i];
+    block[i] = (float)block_d[i] * window[i];
+    plane[i] = (float)plane_d[i] * window[i];
+  }
+}
+
+void aom_noise_accumulate_block_c(float *result, int result_stride,
+                                  const float *block, const float *plane,
+                                  const float *window, int block_size) {
+  for (int y = 0; y < block_size; ++y) {
+    for (int x = 0; x < block_size; ++x) {
+      result[y * result_stride + x] +=
+          (block[y * block_size + x] + plane[y * block_size + x]) *
+          window[y * block_size + x];
+    }
   }
 }
 
@@ -1333,19 +1448,131 @@ static float *get_half_cos_window(int block_size) {
 DITHER_AND_QUANTIZE(uint8_t, lowbd);
 DITHER_AND_QUANTIZE(uint16_t, highbd);
 
+// Per-worker buffers for denoising one block at a time.
+typedef struct {
+  float *plane;
+  float *block;
+  double *plane_d;
+  double *block_d;
+  struct aom_noise_tx_t *tx_full;
+  struct aom_noise_tx_t *tx_chroma;
+} denoise_scratch_t;
+
+static int denoise_scratch_alloc(denoise_scratch_t *scratch, int block_size,
+                                 int chroma_sub) {
+  const int n = block_size * block_size;
+  scratch->plane = (float *)aom_malloc(n * sizeof(*scratch->plane));
+  scratch->block = (float *)aom_memalign(32, 2 * n * sizeof(*scratch->block));
+  scratch->plane_d = (double *)aom_malloc(n * sizeof(*scratch->plane_d));
+  scratch->block_d = (double *)aom_malloc(n * sizeof(*scratch->block_d));
+  scratch->tx_full = aom_noise_tx_malloc(block_size);
+  scratch->tx_chroma =
+      chroma_sub ? aom_noise_tx_malloc(block_size >> chroma_sub)
+                 : scratch->tx_full;
+  return scratch->plane != NULL && scratch->block != NULL &&
+         scratch->plane_d != NULL && scratch->block_d != NULL &&
+         scratch->tx_full != NULL && scratch->tx_chroma != NULL;
+}
+
+static void denoise_scratch_free(denoise_scratch_t *scratch) {
+  aom_free(scratch->plane);
+  aom_free(scratch->block);
+  aom_free(scratch->plane_d);
+  aom_free(scratch->block_d);
+  if (scratch->tx_chroma != scratch->tx_full) {
+    aom_noise_tx_free(scratch->tx_chroma);
+  }
+  aom_noise_tx_free(scratch->tx_full);
+}
+
+// One pass of the half-overlapped block grid over a plane. The blocks of a
+// pass do not overlap, so its block rows can be denoised in parallel.
+typedef struct {
+  const aom_flat_block_finder_t *block_finder;
+  const uint8_t *data;
+  int w;
+  int h;
+  int stride;
+  int block_size;
+  int offsx;
+  int offsy;
+  int num_blocks_w;
+  int num_blocks_h;
+  const float *window;
+  const float *noise_psd;
+  int is_chroma;
+  float *result;
+  int result_stride;
+} denoise_pass_t;
+
+// The block rows denoised by one worker: every by_step-th row from by_start.
+typedef struct {
+  const denoise_pass_t *pass;
+  denoise_scratch_t scratch;
+  int by_start;
+  int by_step;
+} denoise_job_t;
+
+static int denoise_block_rows(void *arg1, void *unused) {
+  denoise_job_t *const job = (denoise_job_t *)arg1;
+  const denoise_pass_t *const pass = job->pass;
+  denoise_scratch_t *const scratch = &job->scratch;
+  struct aom_noise_tx_t *tx =
+      pass->is_chroma ? scratch->tx_chroma : scratch->tx_full;
+  const int block_size = pass->block_size;
+  (void)unused;
+
+  // Pad the boundary when processing each block-set.
+  for (int by = job->by_start - 1; by < pass->num_blocks_h;
+       by += job->by_step) {
+    for (int bx = -1; bx < pass->num_blocks_w; ++bx) {
+      aom_flat_block_finder_extract_block(
+          pass->block_finder, pass->data, pass->w, pass->h, pass->stride,
+          bx * block_size + pass->offsx, by * block_size + pass->offsy,
+          scratch->plane_d, scratch->block_d);
+      // Apply the window function to the block, and to the plane
+      // approximation (we will apply it to the sum of plane + block when
+      // composing the results).
+      aom_noise_window_block(scratch->block_d, scratch->plane_d, pass->window,
+                             scratch->block, scratch->plane,
+                             block_size * block_size);
+      aom_noise_tx_forward(tx, scratch->block);
+      aom_noise_tx_filter(tx, pass->noise_psd);
+      aom_noise_tx_inverse(tx, scratch->block);
+
+      aom_noise_accumulate_block(
+          pass->result +
+              ((by + 1) * block_size + pass->offsy) * pass->result_stride +
+              (bx + 1) * block_size + pass->offsx,
+          pass->result_stride, scratch->block, scratch->plane, pass->window,
+          block_size);
+    }
+  }
+  return 1;
+}
+
 int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
                           int w, int h, int stride[3], int chroma_sub[2],
                           float *noise_psd[3], int block_size, int bit_depth,
                           int use_highbd) {
-  float *plane = NULL, *block = NULL, *window_full = NULL,
-        *window_chroma = NULL;
-  double *block_d = NULL, *plane_d = NULL;
-  struct aom_noise_tx_t *tx_full = NULL;
-  struct aom_noise_tx_t *tx_chroma = NULL;
+  return aom_wiener_denoise_2d_mt(data, denoised, w, h, stride, chroma_sub,
+                                  noise_psd, block_size, bit_depth, use_highbd,
+                                  NULL, 0);
+}
+
+int aom_wiener_denoise_2d_mt(const uint8_t *const data[3],
+                             uint8_t *denoised[3], int w, int h, int stride[3],
+                             int chroma_sub[2], float *noise_psd[3],
+                             int block_size, int bit_depth, int use_highbd,
+                             AVxWorker *workers, int num_workers) {
+  float *window_full = NULL, *window_chroma = NULL;
   const int num_blocks_w = (w + block_size - 1) / block_size;
   const int num_blocks_h = (h + block_size - 1) / block_size;
   const int result_stride = (num_blocks_w + 2) * block_size;
   const int result_height = (num_blocks_h + 2) * block_size;
+  // Each pass has num_blocks_h + 1 block rows, including the padding.
+  const int num_jobs = AOMMAX(1, AOMMIN(num_workers, num_blocks_h + 1));
+  denoise_job_t *jobs = NULL;
   float *result = NULL;
   int init_success = 1;
   aom_flat_block_finder_t block_finder_full;
@@ -1361,83 +1588,57 @@ int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
                                              bit_depth, use_highbd);
   result = (float *)aom_malloc((num_blocks_h + 2) * block_size * result_stride *
                                sizeof(*result));
-  plane = (float *)aom_malloc(block_size * block_size * sizeof(*plane));
-  block =
-      (float *)aom_memalign(32, 2 * block_size * block_size * sizeof(*block));
-  block_d = (double *)aom_malloc(block_size * block_size * sizeof(*block_d));
-  plane_d = (double *)aom_malloc(block_size * block_size * sizeof(*plane_d));
   window_full = get_half_cos_window(block_size);
-  tx_full = aom_noise_tx_malloc(block_size);
+  jobs = (denoise_job_t *)aom_calloc(num_jobs, sizeof(*jobs));
+  for (int i = 0; jobs && i < num_jobs; ++i) {
+    init_success &=
+        denoise_scratch_alloc(&jobs[i].scratch, block_size, chroma_sub[0]);
+  }
 
   if (chroma_sub[0] != 0) {
     init_success &= aom_flat_block_finder_init(&block_finder_chroma,
                                                block_size >> chroma_sub[0],
                                                bit_depth, use_highbd);
     window_chroma = get_half_cos_window(block_size >> chroma_sub[0]);
-    tx_chroma = aom_noise_tx_malloc(block_size >> chroma_sub[0]);
   } else {
     window_chroma = window_full;
-    tx_chroma = tx_full;
   }
 
-  init_success &= (tx_full != NULL) && (tx_chroma != NULL) && (plane != NULL) &&
-                  (plane_d != NULL) && (block != NULL) && (block_d != NULL) &&
-                  (window_full != NULL) && (window_chroma != NULL) &&
-                  (result != NULL);
+  init_success &= (jobs != NULL) && (window_full != NULL) &&
+                  (window_chroma != NULL) && (result != NULL);
   for (int c = init_success ? 0 : 3; c < 3; ++c) {
-    float *window_function = c == 0 ? window_full : window_chroma;
-    aom_flat_block_finder_t *block_finder = &block_finder_full;
     const int chroma_sub_h = c > 0 ? chroma_sub[1] : 0;
     const int chroma_sub_w = c > 0 ? chroma_sub[0] : 0;
-    struct aom_noise_tx_t *tx =
-        (c > 0 && chroma_sub[0] > 0) ? tx_chroma : tx_full;
+    denoise_pass_t pass;
     if (!data[c] || !denoised[c]) continue;
-    if (c > 0 && chroma_sub[0] != 0) {
-      block_finder = &block_finder_chroma;
+    pass.block_finder = (c > 0 && chroma_sub[0] != 0) ? &block_finder_chroma
+                                                      : &block_finder_full;
+    pass.data = data[c];
+    pass.w = w >> chroma_sub_w;
+    pass.h = h >> chroma_sub_h;
+    pass.stride = stride[c];
+    pass.block_size = block_size >> chroma_sub_w;
+    pass.num_blocks_w = num_blocks_w;
+    pass.num_blocks_h = num_blocks_h;
+    pass.window = c == 0 ? window_full : window_chroma;
+    pass.noise_psd = noise_psd[c];
+    pass.is_chroma = c > 0 && chroma_sub[0] > 0;
+    pass.result = result;
+    pass.result_stride = result_stride;
+    for (int i = 0; i < num_jobs; ++i) {
+      jobs[i].pass = &pass;
+      jobs[i].by_start = i;
+      jobs[i].by_step = num_jobs;
     }
     memset(result, 0, sizeof(*result) * result_stride * result_height);
-    // Do overlapped block processing (half overlapped). The block rows can
-    // easily be done in parallel
-    for (int offsy = 0; offsy < (block_size >> chroma_sub_h);
-         offsy += (block_size >> chroma_sub_h) / 2) {
-      for (int offsx = 0; offsx < (block_size >> chroma_sub_w);
-           offsx += (block_size >> chroma_sub_w) / 2) {
-        // Pad the boundary when processing each block-set.
-        for (int by = -1; by < num_blocks_h; ++by) {
-          for (int bx = -1; bx < num_blocks_w; ++bx) {
-            const int pixels_per_block =
-                (block_size >> chroma_sub_w) * (block_size >> chroma_sub_h);
-            aom_flat_block_finder_extract_block(
-                block_finder, data[c], w >> chroma_sub_w, h >> chroma_sub_h,
-                stride[c], bx * (block_size >> chroma_sub_w) + offsx,
-                by * (block_size >> chroma_sub_h) + offsy, plane_d, block_d);
-            for (int j = 0; j < pixels_per_block; ++j) {
-              block[j] = (float)block_d[j];
-              plane[j] = (float)plane_d[j];
-            }
-            pointwise_multiply(window_function, block, pixels_per_block);
-            aom_noise_tx_forward(tx, block);
-            aom_noise_tx_filter(tx, noise_psd[c]);
-            aom_noise_tx_inverse(tx, block);
-
-            // Apply window function to the plane approximation (we will apply
-            // it to the sum of plane + block when composing the results).
-            pointwise_multiply(window_function, plane, pixels_per_block);
-
-            for (int y = 0; y < (block_size >> chroma_sub_h); ++y) {
-              const int y_result =
-                  y + (by + 1) * (block_size >> chroma_sub_h) + offsy;
-              for (int x = 0; x < (block_size >> chroma_sub_w); ++x) {
-                const int x_result =
-                    x + (bx + 1) * (block_size >> chroma_sub_w) + offsx;
-                result[y_result * result_stride + x_result] +=
-                    (block[y * (block_size >> chroma_sub_w) + x] +
-                     plane[y * (block_size >> chroma_sub_w) + x]) *
-                    window_function[y * (block_size >> chroma_sub_w) + x];
-              }
-            }
-          }
-        }
+    // Do overlapped block processing (half overlapped). The passes overlap
+    // each other, so they are run one after the other.
+    for (pass.offsy = 0; pass.offsy < pass.block_size;
+         pass.offsy += pass.block_size / 2) {
+      for (pass.offsx = 0; pass.offsx < pass.block_size;
+           pass.offsx += pass.block_size / 2) {
+        run_worker_jobs(denoise_block_rows, jobs, sizeof(*jobs), num_jobs,
+                        workers);
       }
     }
     if (use_highbd) {
@@ -1451,19 +1652,16 @@ int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
     }
   }
   aom_free(result);
-  aom_free(plane);
-  aom_free(block);
-  aom_free(plane_d);
-  aom_free(block_d);
+  for (int i = 0; jobs && i < num_jobs; ++i) {
+    denoise_scratch_free(&jobs[i].scratch);
+  }
+  aom_free(jobs);
   aom_free(window_full);
 
-  aom_noise_tx_free(tx_full);
-
   aom_flat_block_finder_free(&block_finder_full);
   if (chroma_sub[0] != 0) {
     aom_flat_block_finder_free(&block_finder_chroma);
     aom_free(window_chroma);
-    aom_noise_tx_free(tx_chroma);
   }
   return init_success;
 }
@@ -1593,6 +1791,13 @@ static int denoise_and_model_realloc_if_necessary(
 int aom_denoise_and_model_run(struct aom_denoise_and_model_t *ctx,
                               YV12_BUFFER_CONFIG *sd,
                               aom_film_grain_t *film_grain) {
+  return aom_denoise_and_model_run_mt(ctx, sd, film_grain, NULL, 0);
+}
+
+int aom_denoise_and_model_run_mt(struct aom_denoise_and_model_t *ctx,
+                                 YV12_BUFFER_CONFIG *sd,
+                                 aom_film_grain_t *film_grain,
+                                 AVxWorker *workers, int num_workers) {
   const int block_size = ctx->block_size;
   const int use_highbd = (sd->flags & YV12_FLAG_HIGHBITDEPTH) != 0;
   uint8_t *raw_data[3] = {
@@ -1609,12 +1814,14 @@ int aom_denoise_and_model_run(struct aom_denoise_and_model_t *ctx,
     return 0;
   }
 
-  aom_flat_block_finder_run(&ctx->flat_block_finder, data[0], sd->y_width,
-                            sd->y_height, strides[0], ctx->flat_blocks);
+  aom_flat_block_finder_run_mt(&ctx->flat_block_finder, data[0], sd->y_width,
+                               sd->y_height, strides[0], ctx->flat_blocks,
+                               workers, num_workers);
 
-  if (!aom_wiener_denoise_2d(data, ctx->denoised, sd->y_width, sd->y_height,
-                             strides, chroma_sub_log2, ctx->noise_psd,
-                             block_size, ctx->bit_depth, use_highbd)) {
+  if (!aom_wiener_denoise_2d_mt(data, ctx->denoised, sd->y_width, sd->y_height,
+                                strides, chroma_sub_log2, ctx->noise_psd,
+                                block_size, ctx->bit_depth, use_highbd,
+                                workers, num_workers)) {
     fprintf(stderr, "Unable to denoise image\n");
     return 0;
   }
@@ -19,6 +19,7 @@ extern "C" {
 #include <stdint.h>
 #include "aom_dsp/grain_synthesis.h"
 #include "aom_scale/yv12config.h"
+#include "aom_util/aom_thread.h"
 
 /*!\brief Wrapper of data required to represent linear system of eqns and soln.
  */
@@ -157,6 +158,18 @@ int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
                               const uint8_t *const data, int w, int h,
                               int stride, uint8_t *flat_blocks);
 
+/*!\brief Runs the flat block finder on up to num_workers worker threads.
+ *
+ * The block rows are split between the workers. The result is identical to
+ * that of aom_flat_block_finder_run(), which is the same as calling this with
+ * no workers. As with the encoder workers, workers[0] is run on the calling
+ * thread, and the others must have been reset to start their threads.
+ */
+int aom_flat_block_finder_run_mt(const aom_flat_block_finder_t *block_finder,
+                                 const uint8_t *const data, int w, int h,
+                                 int stride, uint8_t *flat_blocks,
+                                 AVxWorker *workers, int num_workers);
+
 // The noise shape indicates the allowed coefficients in the AR model.
 enum {
   AOM_NOISE_SHAPE_DIAMOND = 0,
@@ -282,6 +295,19 @@ int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
                           float *noise_psd[3], int block_size, int bit_depth,
                           int use_highbd);
 
+/*!\brief Wiener filter denoising on up to num_workers worker threads.
+ *
+ * Same as aom_wiener_denoise_2d(), with the blocks of each pass of the
+ * overlapped block grid split between the workers by block row. The
+ * denoised output does not depend on the number of workers. The workers are
+ * used as in aom_flat_block_finder_run_mt().
+ */
+int aom_wiener_denoise_2d_mt(const uint8_t *const data[3],
+                             uint8_t *denoised[3], int w, int h, int stride[3],
+                             int chroma_sub_log2[2], float *noise_psd[3],
+                             int block_size, int bit_depth, int use_highbd,
+                             AVxWorker *workers, int num_workers);
+
 struct aom_denoise_and_model_t;
 
 /*!\brief Denoise the buffer and model the residual noise.
@@ -301,6 +327,14 @@ struct aom_denoise_and_model_t;
 int aom_denoise_and_model_run(struct aom_denoise_and_model_t *ctx,
                               YV12_BUFFER_CONFIG *buf, aom_film_grain_t *grain);
 
+/*!\brief Same as aom_denoise_and_model_run(), but runs the flat block finder
+ * and the denoiser on up to num_workers worker threads.
+ */
+int aom_denoise_and_model_run_mt(struct aom_denoise_and_model_t *ctx,
+                                 YV12_BUFFER_CONFIG *buf,
+                                 aom_film_grain_t *grain, AVxWorker *workers,
+                                 int num_workers);
+
 /*!\brief Allocates a context that can be used for denoising and noise modeling.
  *
  * \param[in]  bit_depth   Bit depth of buffers this will be run on.
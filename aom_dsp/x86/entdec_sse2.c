@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <emmintrin.h>  // SSE2
+
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+#include "aom_dsp/entcode.h"
+#include "aom_dsp/prob.h"
+#include "aom_ports/bitops.h"
+
+#if 7 - EC_PROB_SHIFT - CDF_SHIFT != 1
+#error "ec_thresholds_sse2() assumes the CDF product is shifted by 1."
+#endif
+
+// Tables of 4 to 16 entries are covered with 8 lanes: entries [0, 4) and
+// [n - 4, n) for fewer than 8 entries, and entries [0, 8) and [n - 8, n) in
+// two vectors otherwise. The two parts overlap when n is not 8 or 16.
+
+// Loads entries [0, 4) and [n - 4, n) of a table of 4 <= n < 8 entries.
+static INLINE __m128i load_short_table(const uint16_t *table, int n) {
+  return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)table),
+                            _mm_loadl_epi64((const __m128i *)(table + n - 4)));
+}
+
+// Returns the entry indices of the lanes of load_short_table().
+static INLINE __m128i short_table_index(int n) {
+  return _mm_setr_epi16(0, 1, 2, 3, n - 4, n - 3, n - 2, n - 1);
+}
+
+// Returns the entry indices of the lanes of a vector loaded from table + base.
+static INLINE __m128i table_index(int base) {
+  return _mm_add_epi16(_mm_set1_epi16(base),
+                       _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+// Computes od_ec_cdf_threshold() for the 8 symbols with indices idx.
+static INLINE __m128i ec_thresholds_sse2(__m128i icdf, __m128i idx,
+                                         __m128i rng, __m128i min_prob) {
+  const __m128i p = _mm_srli_epi16(icdf, EC_PROB_SHIFT);
+  // The product has up to 17 bits: shift it right by 1 from both halves.
+  const __m128i lo = _mm_mullo_epi16(p, rng);
+  const __m128i hi = _mm_mulhi_epu16(p, rng);
+  const __m128i v = _mm_or_si128(_mm_srli_epi16(lo, 1), _mm_slli_epi16(hi, 15));
+  return _mm_add_epi16(
+      v, _mm_sub_epi16(min_prob,
+                       _mm_mullo_epi16(idx, _mm_set1_epi16(EC_MIN_PROB))));
+}
+
+// Returns a byte mask of the lanes whose threshold v is not above c.
+static INLINE int not_below_mask(__m128i v, __m128i c) {
+  return _mm_movemask_epi8(
+      _mm_cmpeq_epi16(_mm_subs_epu16(v, c), _mm_setzero_si128()));
+}
+
+// Returns the first lane set in a non-zero mask from not_below_mask().
+static INLINE int first_lane(int mask) {
+  return get_msb((unsigned)(mask & -mask)) >> 1;
+}
+
+int aom_ec_find_symbol_sse2(const uint16_t *icdf, int nsyms, unsigned rng,
+                            unsigned c) {
+  if (nsyms < 4) return aom_ec_find_symbol_c(icdf, nsyms, rng, c);
+  const __m128i r = _mm_set1_epi16((int16_t)(rng >> 8));
+  const __m128i cv = _mm_set1_epi16((int16_t)c);
+  const __m128i min_prob = _mm_set1_epi16(EC_MIN_PROB * (nsyms - 1));
+
+  // The last symbol has a threshold of 0, so some lane is always found.
+  if (nsyms < 8) {
+    const __m128i v =
+        ec_thresholds_sse2(load_short_table(icdf, nsyms),
+                           short_table_index(nsyms), r, min_prob);
+    const int lane = first_lane(not_below_mask(v, cv));
+    return lane < 4 ? lane : lane + nsyms - 8;
+  }
+  const __m128i v_lo =
+      ec_thresholds_sse2(_mm_loadu_si128((const __m128i *)icdf),
+                         table_index(0), r, min_prob);
+  const int mask_lo = not_below_mask(v_lo, cv);
+  if (mask_lo) return first_lane(mask_lo);
+  // Symbols [0, 8) are all ruled out, so the overlap is too.
+  const __m128i v_hi =
+      ec_thresholds_sse2(_mm_loadu_si128((const __m128i *)(icdf + nsyms - 8)),
+                         table_index(nsyms - 8), r, min_prob);
+  return nsyms - 8 + first_lane(not_below_mask(v_hi, cv));
+}
+
+// Adapts the 8 CDF entries with indices idx as update_cdf() does: entries
+// before val move up towards CDF_PROB_TOP, and the others down towards 0.
+static INLINE __m128i update_cdf_sse2(__m128i cdf, __m128i idx, __m128i val,
+                                      __m128i rate) {
+  const __m128i up = _mm_cmplt_epi16(idx, val);
+  const __m128i down = _mm_cmpeq_epi16(up, _mm_setzero_si128());
+  const __m128i dist = _mm_or_si128(
+      _mm_and_si128(
+          up, _mm_sub_epi16(_mm_set1_epi16((int16_t)CDF_PROB_TOP), cdf)),
+      _mm_and_si128(down, cdf));
+  const __m128i step = _mm_srl_epi16(dist, rate);
+  // Negate the step of the entries moving down.
+  return _mm_add_epi16(cdf,
+                       _mm_sub_epi16(_mm_xor_si128(step, down), down));
+}
+
+void aom_update_cdf_sse2(uint16_t *cdf, int val, int nsymbs) {
+  if (nsymbs < 4) {
+    update_cdf(cdf, val, nsymbs);
+    return;
+  }
+  const __m128i rate = _mm_cvtsi32_si128(get_cdf_rate(cdf, nsymbs));
+  const __m128i v = _mm_set1_epi16(val);
+
+  // The last entry is 0 and stays 0, so it can be updated with the others.
+  // The overlapping lanes are computed from the same inputs, so the order of
+  // the stores does not matter.
+  if (nsymbs < 8) {
+    const __m128i out = update_cdf_sse2(load_short_table(cdf, nsymbs),
+                                        short_table_index(nsymbs), v, rate);
+    _mm_storel_epi64((__m128i *)cdf, out);
+    _mm_storel_epi64((__m128i *)(cdf + nsymbs - 4),
+                     _mm_unpackhi_epi64(out, out));
+  } else {
+    const __m128i lo =
+        update_cdf_sse2(_mm_loadu_si128((const __m128i *)cdf),
+                        table_index(0), v, rate);
+    const __m128i hi =
+        update_cdf_sse2(_mm_loadu_si128((const __m128i *)(cdf + nsymbs - 8)),
+                        table_index(nsymbs - 8), v, rate);
+    _mm_storeu_si128((__m128i *)cdf, lo);
+    _mm_storeu_si128((__m128i *)(cdf + nsymbs - 8), hi);
+  }
+  cdf[nsymbs] += (cdf[nsymbs] < 32);
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // AVX2
+
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+#include "aom_dsp/grain_synthesis.h"
+
+// Returns the scaling function index of 8 samples, given their co-located luma.
+static INLINE __m256i grain_index_avx2(__m256i luma, __m256i pix,
+                                       const __m256i *luma_mult,
+                                       const __m256i *mult,
+                                       const __m256i *offset,
+                                       const __m256i *max_index) {
+  __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(luma, *luma_mult),
+                                 _mm256_mullo_epi32(pix, *mult));
+  idx = _mm256_add_epi32(_mm256_srai_epi32(idx, 6), *offset);
+  return _mm256_min_epi32(_mm256_max_epi32(idx, _mm256_setzero_si256()),
+                          *max_index);
+}
+
+// Adds the scaled grain to 8 samples, and clamps the result.
+static INLINE __m256i grain_blend_avx2(__m256i pix, __m256i scale,
+                                       const int *grain, const __m256i *round,
+                                       int shift, const __m256i *min_value,
+                                       const __m256i *max_value) {
+  const __m256i g = _mm256_loadu_si256((const __m256i *)grain);
+  __m256i noise = _mm256_add_epi32(_mm256_mullo_epi32(scale, g), *round);
+  noise = _mm256_srai_epi32(noise, shift);
+  const __m256i out = _mm256_add_epi32(pix, noise);
+  return _mm256_min_epi32(_mm256_max_epi32(out, *min_value), *max_value);
+}
+
+void aom_add_grain_noise_avx2(uint8_t *dst, int dst_stride, const uint8_t *luma,
+                              int luma_stride, const int *grain,
+                              int grain_stride, int width, int height,
+                              const aom_grain_noise_params_t *p) {
+  const int w8 = width & ~7;
+  // The luma plane and chroma scaled from luma index the LUT directly.
+  const int index_is_luma = p->luma_mult == 64 && !p->mult && !p->offset;
+  const __m256i luma_mult = _mm256_set1_epi32(p->luma_mult);
+  const __m256i mult = _mm256_set1_epi32(p->mult);
+  const __m256i offset = _mm256_set1_epi32(p->offset);
+  const __m256i max_index = _mm256_set1_epi32(255);
+  const __m256i round = _mm256_set1_epi32(1 << (p->scaling_shift - 1));
+  const __m256i min_value = _mm256_set1_epi32(p->min_value);
+  const __m256i max_value = _mm256_set1_epi32(p->max_value);
+  const __m256i ones = _mm256_set1_epi16(1);
+  const __m256i one = _mm256_set1_epi32(1);
+
+  for (int i = 0; i < height; i++) {
+    uint8_t *dst_row = dst + i * dst_stride;
+    const uint8_t *luma_row = luma + (i << p->subsamp_y) * luma_stride;
+    const int *grain_row = grain + i * grain_stride;
+    for (int j = 0; j < w8; j += 8) {
+      const __m256i pix = _mm256_cvtepu8_epi32(
+          _mm_loadl_epi64((const __m128i *)(dst_row + j)));
+      __m256i avg;
+      if (p->subsamp_x) {
+        const __m256i l = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)(luma_row + (j << 1))));
+        avg = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(l, ones), one), 1);
+      } else {
+        avg = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)(luma_row + j)));
+      }
+      const __m256i idx =
+          index_is_luma ? avg
+                        : grain_index_avx2(avg, pix, &luma_mult, &mult,
+                                           &offset, &max_index);
+      const __m256i scale = _mm256_i32gather_epi32(p->scaling_lut, idx, 4);
+      const __m256i out =
+          grain_blend_avx2(pix, scale, grain_row + j, &round, p->scaling_shift,
+                           &min_value, &max_value);
+      const __m128i out16 = _mm_packus_epi32(_mm256_castsi256_si128(out),
+                                             _mm256_extracti128_si256(out, 1));
+      _mm_storel_epi64((__m128i *)(dst_row + j),
+                       _mm_packus_epi16(out16, out16));
+    }
+  }
+
+  if (w8 < width) {
+    aom_add_grain_noise_c(dst + w8, dst_stride, luma + (w8 << p->subsamp_x),
+                          luma_stride, grain + w8, grain_stride, width - w8,
+                          height, p);
+  }
+}
+
+void aom_highbd_add_grain_noise_avx2(uint16_t *dst, int dst_stride,
+                                     const uint16_t *luma, int luma_stride,
+                                     const int *grain, int grain_stride,
+                                     int width, int height,
+                                     const aom_grain_noise_params_t *p) {
+  const int w8 = width & ~7;
+  const int index_is_luma = p->luma_mult == 64 && !p->mult && !p->offset;
+  const int bd_shift = p->bit_depth - 8;
+  const __m256i luma_mult = _mm256_set1_epi32(p->luma_mult);
+  const __m256i mult = _mm256_set1_epi32(p->mult);
+  const __m256i offset = _mm256_set1_epi32(p->offset);
+  const __m256i max_index = _mm256_set1_epi32((256 << bd_shift) - 1);
+  const __m256i frac_mask = _mm256_set1_epi32((1 << bd_shift) - 1);
+  const __m256i lut_round =
+      _mm256_set1_epi32(bd_shift ? 1 << (bd_shift - 1) : 0);
+  const __m256i round = _mm256_set1_epi32(1 << (p->scaling_shift - 1));
+  const __m256i min_value = _mm256_set1_epi32(p->min_value);
+  const __m256i max_value = _mm256_set1_epi32(p->max_value);
+  const __m256i ones = _mm256_set1_epi16(1);
+  const __m256i one = _mm256_set1_epi32(1);
+
+  for (int i = 0; i < height; i++) {
+    uint16_t *dst_row = dst + i * dst_stride;
+    const uint16_t *luma_row = luma + (i << p->subsamp_y) * luma_stride;
+    const int *grain_row = grain + i * grain_stride;
+    for (int j = 0; j < w8; j += 8) {
+      const __m256i pix = _mm256_cvtepu16_epi32(
+          _mm_loadu_si128((const __m128i *)(dst_row + j)));
+      __m256i avg;
+      if (p->subsamp_x) {
+        // Samples have at most 12 bits, so the signed pair sums are exact.
+        const __m256i l =
+            _mm256_loadu_si256((const __m256i *)(luma_row + (j << 1)));
+        avg = _mm256_srai_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(l, ones), one), 1);
+      } else {
+        avg = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128((const __m128i *)(luma_row + j)));
+      }
+      const __m256i idx =
+          index_is_luma ? avg
+                        : grain_index_avx2(avg, pix, &luma_mult, &mult,
+                                           &offset, &max_index);
+      // Interpolate between the two nearest LUT entries. The LUT has a 257th
+      // entry, equal to the 256th, for the top of the range.
+      const __m256i x = _mm256_srli_epi32(idx, bd_shift);
+      const __m256i frac = _mm256_and_si256(idx, frac_mask);
+      const __m256i a = _mm256_i32gather_epi32(p->scaling_lut, x, 4);
+      const __m256i b = _mm256_i32gather_epi32(p->scaling_lut + 1, x, 4);
+      __m256i delta = _mm256_mullo_epi32(_mm256_sub_epi32(b, a), frac);
+      delta = _mm256_srai_epi32(_mm256_add_epi32(delta, lut_round), bd_shift);
+      const __m256i scale = _mm256_add_epi32(a, delta);
+      const __m256i out =
+          grain_blend_avx2(pix, scale, grain_row + j, &round, p->scaling_shift,
+                           &min_value, &max_value);
+      _mm_storeu_si128((__m128i *)(dst_row + j),
+                       _mm_packus_epi32(_mm256_castsi256_si128(out),
+                                        _mm256_extracti128_si256(out, 1)));
+    }
+  }
+
+  if (w8 < width) {
+    aom_highbd_add_grain_noise_c(
+        dst + w8, dst_stride, luma + (w8 << p->subsamp_x), luma_stride,
+        grain + w8, grain_stride, width - w8, height, p);
+  }
+}
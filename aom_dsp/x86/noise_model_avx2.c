@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // AVX2
+
+#include "config/aom_dsp_rtcd.h"
+
+// Converts 8 doubles to floats and multiplies them by the window.
+static INLINE __m256 window_8_avx2(const double *src, __m256 w) {
+  const __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(src));
+  const __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(src + 4));
+  return _mm256_mul_ps(_mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1),
+                       w);
+}
+
+void aom_noise_window_block_avx2(const double *block_d, const double *plane_d,
+                                 const float *window, float *block,
+                                 float *plane, int n) {
+  const int n8 = n & ~7;
+  for (int i = 0; i < n8; i += 8) {
+    const __m256 w = _mm256_loadu_ps(window + i);
+    _mm256_storeu_ps(block + i, window_8_avx2(block_d + i, w));
+    _mm256_storeu_ps(plane + i, window_8_avx2(plane_d + i, w));
+  }
+  if (n8 < n) {
+    aom_noise_window_block_sse2(block_d + n8, plane_d + n8, window + n8,
+                                block + n8, plane + n8, n - n8);
+  }
+}
+
+void aom_noise_accumulate_block_avx2(float *result, int result_stride,
+                                     const float *block, const float *plane,
+                                     const float *window, int block_size) {
+  if (block_size & 7) {
+    aom_noise_accumulate_block_sse2(result, result_stride, block, plane,
+                                    window, block_size);
+    return;
+  }
+  // The product is rounded before the sum, as in the C version, so this must
+  // not be contracted into a fused multiply-add.
+  for (int y = 0; y < block_size; ++y) {
+    for (int x = 0; x < block_size; x += 8) {
+      const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(block + x),
+                                       _mm256_loadu_ps(plane + x));
+      const __m256 r =
+          _mm256_add_ps(_mm256_loadu_ps(result + x),
+                        _mm256_mul_ps(sum, _mm256_loadu_ps(window + x)));
+      _mm256_storeu_ps(result + x, r);
+    }
+    result += result_stride;
+    block += block_size;
+    plane += block_size;
+    window += block_size;
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <emmintrin.h>  // SSE2
+
+#include "config/aom_dsp_rtcd.h"
+
+// Converts 4 doubles to floats and multiplies them by the window.
+static INLINE __m128 window_4_sse2(const double *src, __m128 w) {
+  const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src));
+  const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + 2));
+  return _mm_mul_ps(_mm_movelh_ps(lo, hi), w);
+}
+
+void aom_noise_window_block_sse2(const double *block_d, const double *plane_d,
+                                 const float *window, float *block,
+                                 float *plane, int n) {
+  const int n4 = n & ~3;
+  for (int i = 0; i < n4; i += 4) {
+    const __m128 w = _mm_loadu_ps(window + i);
+    _mm_storeu_ps(block + i, window_4_sse2(block_d + i, w));
+    _mm_storeu_ps(plane + i, window_4_sse2(plane_d + i, w));
+  }
+  if (n4 < n) {
+    aom_noise_window_block_c(block_d + n4, plane_d + n4, window + n4,
+                             block + n4, plane + n4, n - n4);
+  }
+}
+
+void aom_noise_accumulate_block_sse2(float *result, int result_stride,
+                                     const float *block, const float *plane,
+                                     const float *window, int block_size) {
+  if (block_size & 3) {
+    aom_noise_accumulate_block_c(result, result_stride, block, plane, window,
+                                 block_size);
+    return;
+  }
+  for (int y = 0; y < block_size; ++y) {
+    for (int x = 0; x < block_size; x += 4) {
+      const __m128 sum = _mm_add_ps(_mm_loadu_ps(block + x),
+                                    _mm_loadu_ps(plane + x));
+      const __m128 r = _mm_add_ps(_mm_loadu_ps(result + x),
+                                  _mm_mul_ps(sum, _mm_loadu_ps(window + x)));
+      _mm_storeu_ps(result + x, r);
+    }
+    result += result_stride;
+    block += block_size;
+    plane += block_size;
+    window += block_size;
+  }
+}
@@ -153,13 +153,19 @@ static int realloc_frame_buffer_aligned(
     ybf->use_external_reference_buffers = 0;
 
     if (use_highbitdepth) {
-      if (ybf->y_buffer_8bit) aom_free(ybf->y_buffer_8bit);
-      ybf->y_buffer_8bit = (uint8_t *)aom_memalign(32, (size_t)yplane_size);
-      if (!ybf->y_buffer_8bit) return AOM_CODEC_MEM_ERROR;
+      // Like buffer_alloc, the 8-bit copy is only reallocated to grow.
+      if (yplane_size > ybf->y_buffer_8bit_sz) {
+        aom_free(ybf->y_buffer_8bit);
+        ybf->y_buffer_8bit_sz = 0;
+        ybf->y_buffer_8bit = (uint8_t *)aom_memalign(32, (size_t)yplane_size);
+        if (!ybf->y_buffer_8bit) return AOM_CODEC_MEM_ERROR;
+        ybf->y_buffer_8bit_sz = (size_t)yplane_size;
+      }
     } else {
       if (ybf->y_buffer_8bit) {
         aom_free(ybf->y_buffer_8bit);
         ybf->y_buffer_8bit = NULL;
+        ybf->y_buffer_8bit_sz = 0;
         ybf->buf_8bit_valid = 0;
       }
     }
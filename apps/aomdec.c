@@ -106,6 +106,10 @@ static const arg_def_t outallarg = ARG_DEF(
     NULL, "all-layers", 0, "Output all decoded frames of a scalable bitstream");
 static const arg_def_t skipfilmgrain =
     ARG_DEF(NULL, "skip-film-grain", 0, "Skip film grain application");
+static const arg_def_t frameparallelarg = ARG_DEF(
+    NULL, "frame-parallel", 0, "Decode several frames at once (needs threads)");
+static const arg_def_t mmaparg = ARG_DEF(
+    NULL, "mmap", 0, "Memory map the input file and decode frames in place");
 
 static const arg_def_t *all_args[] = {
   &help,           &codecarg,   &use_yv12,      &use_i420,
@@ -114,7 +118,7 @@ static const arg_def_t *all_args[] = {
   &outputfile,     &threadsarg, &verbosearg,    &scalearg,
   &fb_arg,         &md5arg,     &framestatsarg, &continuearg,
   &outbitdeptharg, &isannexb,   &oppointarg,    &outallarg,
-  &skipfilmgrain,  NULL
+  &skipfilmgrain,  &frameparallelarg, &mmaparg, NULL
 };
 
 #if CONFIG_LIBYUV
@@ -226,25 +230,51 @@ static int raw_read_frame(FILE *infile, uint8_t **buffer, size_t *bytes_read,
   return 0;
 }
 
+// Reads the next frame into |buf|, or, when the input file is memory mapped,
+// finds it in the mapping. Either way |frame_data| points at the frame.
 static int read_frame(struct AvxDecInputContext *input, uint8_t **buf,
-                      size_t *bytes_in_buffer, size_t *buffer_size) {
+                      size_t *bytes_in_buffer, size_t *buffer_size,
+                      const uint8_t **frame_data) {
+  if (input->aom_input_ctx->mapped_data != NULL) {
+    switch (input->aom_input_ctx->file_type) {
+#if CONFIG_WEBM_IO
+      case FILE_TYPE_WEBM:
+        return webm_read_frame_mapped(input->webm_ctx, input->aom_input_ctx,
+                                      frame_data, bytes_in_buffer);
+#endif
+      case FILE_TYPE_IVF:
+        return ivf_read_frame_mapped(input->aom_input_ctx, frame_data,
+                                     bytes_in_buffer, NULL);
+      case FILE_TYPE_OBU:
+        return obudec_read_temporal_unit_mapped(input->obu_ctx, frame_data,
+                                                bytes_in_buffer);
+      default: return 1;
+    }
+  }
+  int status;
   switch (input->aom_input_ctx->file_type) {
 #if CONFIG_WEBM_IO
     case FILE_TYPE_WEBM:
-      return webm_read_frame(input->webm_ctx, buf, bytes_in_buffer,
-                             buffer_size);
+      status = webm_read_frame(input->webm_ctx, buf, bytes_in_buffer,
+                               buffer_size);
+      break;
 #endif
     case FILE_TYPE_RAW:
-      return raw_read_frame(input->aom_input_ctx->file, buf, bytes_in_buffer,
-                            buffer_size);
+      status = raw_read_frame(input->aom_input_ctx->file, buf,
+                              bytes_in_buffer, buffer_size);
+      break;
     case FILE_TYPE_IVF:
-      return ivf_read_frame(input->aom_input_ctx->file, buf, bytes_in_buffer,
-                            buffer_size, NULL);
+      status = ivf_read_frame(input->aom_input_ctx->file, buf,
+                              bytes_in_buffer, buffer_size, NULL);
+      break;
     case FILE_TYPE_OBU:
-      return obudec_read_temporal_unit(input->obu_ctx, buf, bytes_in_buffer,
-                                       buffer_size);
+      status = obudec_read_temporal_unit(input->obu_ctx, buf, bytes_in_buffer,
+                                         buffer_size);
+      break;
     default: return 1;
   }
+  *frame_data = *buf;
+  return status;
 }
 
 static int file_is_raw(struct AvxInputContext *input) {
@@ -460,6 +490,9 @@ static int main_loop(int argc, const char **argv_) {
   int operating_point = 0;
   int output_all_layers = 0;
   int skip_film_grain = 0;
+  int frame_parallel = 0;
+  int use_mmap = 0;
+  const uint8_t *frame_data = NULL;
   aom_image_t *scaled_img = NULL;
   aom_image_t *img_shifted = NULL;
   int frame_avail, got_data, flush_decoder = 0;
@@ -576,6 +609,10 @@ static int main_loop(int argc, const char **argv_) {
       output_all_layers = 1;
     } else if (arg_match(&arg, &skipfilmgrain, argi)) {
       skip_film_grain = 1;
+    } else if (arg_match(&arg, &frameparallelarg, argi)) {
+      frame_parallel = 1;
+    } else if (arg_match(&arg, &mmaparg, argi)) {
+      use_mmap = 1;
     } else {
       argj++;
     }
@@ -631,6 +668,13 @@ static int main_loop(int argc, const char **argv_) {
     return EXIT_FAILURE;
   }
 
+  // Raw files have no frame sizes to find the frames with, so they are always
+  // read with stdio.
+  if (use_mmap && input.aom_input_ctx->file_type != FILE_TYPE_RAW &&
+      aom_map_input_file(input.aom_input_ctx)) {
+    warn("Failed to memory map the input file, reading it instead.");
+  }
+
   outfile_pattern = outfile_pattern ? outfile_pattern : "-";
   single_file = is_single_file(outfile_pattern);
 
@@ -709,9 +753,18 @@ static int main_loop(int argc, const char **argv_) {
     goto fail;
   }
 
+  if (aom_codec_control(&decoder, AV1D_SET_FRAME_PARALLEL, frame_parallel)) {
+    fprintf(stderr, "Failed to set frame_parallel: %s\n",
+            aom_codec_error(&decoder));
+    goto fail;
+  }
+
   if (arg_skip) fprintf(stderr, "Skipping first %d frames.\n", arg_skip);
   while (arg_skip) {
-    if (read_frame(&input, &buf, &bytes_in_buffer, &buffer_size)) break;
+    if (read_frame(&input, &buf, &bytes_in_buffer, &buffer_size,
+                   &frame_data)) {
+      break;
+    }
     arg_skip--;
   }
 
@@ -742,13 +795,14 @@ static int main_loop(int argc, const char **argv_) {
 
     frame_avail = 0;
     if (!stop_after || frame_in < stop_after) {
-      if (!read_frame(&input, &buf, &bytes_in_buffer, &buffer_size)) {
+      if (!read_frame(&input, &buf, &bytes_in_buffer, &buffer_size,
+                      &frame_data)) {
         frame_avail = 1;
         frame_in++;
 
         aom_usec_timer_start(&timer);
 
-        if (aom_codec_decode(&decoder, buf, bytes_in_buffer, NULL)) {
+        if (aom_codec_decode(&decoder, frame_data, bytes_in_buffer, NULL)) {
           const char *detail = aom_codec_error_detail(&decoder);
           warn("Failed to decode frame %d: %s", frame_in,
                aom_codec_error(&decoder));
@@ -995,6 +1049,7 @@ fail2:
   }
   free(ext_fb_list.ext_fb);
 
+  aom_unmap_input_file(input.aom_input_ctx);
   fclose(infile);
   if (framestats_file) fclose(framestats_file);
 
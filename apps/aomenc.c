@@ -443,6 +443,18 @@ static const arg_def_t disable_ml_partition_speed_features =
     ARG_DEF(NULL, "disable-ml-partition-speed-features", 1,
             "Disable ML partition speed features "
             "(0: false (default), 1: true)");
+#if CONFIG_INTRA_ENTROPY
+static const arg_def_t intra_entropy_sb_update =
+    ARG_DEF(NULL, "intra-entropy-sb-update", 1,
+            "Update the intra mode entropy models once per superblock "
+            "(0: false (default), 1: true)");
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+static const arg_def_t hash_trellis_size =
+    ARG_DEF(NULL, "hash-trellis-size", 1,
+            "Log2 of the number of entries of the hash based trellis cache "
+            "of each thread (0: off (default), 2..24: on)");
+#endif  // CONFIG_HTB_TRELLIS
 static const arg_def_t enable_rect_partitions =
     ARG_DEF(NULL, "enable-rect-partitions", 1,
             "Enable rectangular partitions "
@@ -930,6 +942,12 @@ static const arg_def_t *av1_args[] = { &cpu_used_av1,
                                        &target_seq_level_idx,
                                        &set_tier_mask,
                                        &set_min_cr,
+#if CONFIG_INTRA_ENTROPY
+                                       &intra_entropy_sb_update,
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+                                       &hash_trellis_size,
+#endif  // CONFIG_HTB_TRELLIS
                                        &bitdeptharg,
                                        &inbitdeptharg,
                                        &input_chroma_subsampling_x,
@@ -1042,6 +1060,12 @@ static const int av1_arg_ctrl_map[] = {
   AV1E_SET_TARGET_SEQ_LEVEL_IDX,
   AV1E_SET_TIER_MASK,
   AV1E_SET_MIN_CR,
+#if CONFIG_INTRA_ENTROPY
+  AV1E_SET_INTRA_ENTROPY_SB_UPDATE,
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+  AV1E_SET_HASH_TRELLIS_SIZE,
+#endif  // CONFIG_HTB_TRELLIS
   0
 };
 #endif  // CONFIG_AV1_ENCODER
@@ -73,6 +73,8 @@ list(APPEND AOM_AV1_COMMON_SOURCES
             "${AOM_ROOT}/av1/common/resize.h"
             "${AOM_ROOT}/av1/common/restoration.c"
             "${AOM_ROOT}/av1/common/restoration.h"
+            "${AOM_ROOT}/av1/common/restoration_scratch.c"
+            "${AOM_ROOT}/av1/common/restoration_scratch.h"
             "${AOM_ROOT}/av1/common/scale.c"
             "${AOM_ROOT}/av1/common/scale.h"
             "${AOM_ROOT}/av1/common/scan.c"
@@ -266,10 +268,12 @@ endif()
 
 list(APPEND AOM_AV1_COMMON_INTRIN_SSE2
             "${AOM_ROOT}/av1/common/cdef_block_sse2.c"
+            "${AOM_ROOT}/av1/common/x86/adapt_filter_intra_sse2.c"
             "${AOM_ROOT}/av1/common/x86/cfl_sse2.c"
             "${AOM_ROOT}/av1/common/x86/convolve_2d_sse2.c"
             "${AOM_ROOT}/av1/common/x86/convolve_sse2.c"
             "${AOM_ROOT}/av1/common/x86/highbd_convolve_2d_sse2.c"
+            "${AOM_ROOT}/av1/common/x86/intrabc_sse2.c"
             "${AOM_ROOT}/av1/common/x86/jnt_convolve_sse2.c"
             "${AOM_ROOT}/av1/common/x86/wiener_convolve_sse2.c"
             "${AOM_ROOT}/av1/common/x86/av1_txfm_sse2.h"
@@ -299,6 +303,7 @@ list(APPEND AOM_AV1_COMMON_INTRIN_SSE4_1
             "${AOM_ROOT}/av1/common/x86/highbd_jnt_convolve_sse4.c"
             "${AOM_ROOT}/av1/common/x86/highbd_warp_plane_sse4.c"
             "${AOM_ROOT}/av1/common/x86/intra_edge_sse4.c"
+            "${AOM_ROOT}/av1/common/x86/quant_common_sse4.c"
             "${AOM_ROOT}/av1/common/x86/reconinter_sse4.c"
             "${AOM_ROOT}/av1/common/x86/selfguided_sse4.c"
             "${AOM_ROOT}/av1/common/x86/warp_plane_sse4.c")
@@ -315,6 +320,7 @@ list(APPEND AOM_AV1_COMMON_INTRIN_AVX2
             "${AOM_ROOT}/av1/common/x86/highbd_jnt_convolve_avx2.c"
             "${AOM_ROOT}/av1/common/x86/highbd_wiener_convolve_avx2.c"
             "${AOM_ROOT}/av1/common/x86/jnt_convolve_avx2.c"
+            "${AOM_ROOT}/av1/common/x86/nn_em_avx2.c"
             "${AOM_ROOT}/av1/common/x86/reconinter_avx2.c"
             "${AOM_ROOT}/av1/common/x86/selfguided_avx2.c"
             "${AOM_ROOT}/av1/common/x86/warp_plane_avx2.c"
@@ -409,6 +415,11 @@ if(CONFIG_INTERNAL_STATS)
   list(APPEND AOM_AV1_ENCODER_SOURCES "${AOM_ROOT}/av1/encoder/blockiness.c")
 endif()
 
+if(CONFIG_HTB_TRELLIS)
+  list(APPEND AOM_AV1_ENCODER_SOURCES "${AOM_ROOT}/av1/encoder/hash_trellis.c"
+              "${AOM_ROOT}/av1/encoder/hash_trellis.h")
+endif()
+
 if(CONFIG_CNN_RESTORATION OR CONFIG_LOOP_RESTORE_CNN)
   list(APPEND AOM_AV1_COMMON_SOURCES
               "${AOM_ROOT}/av1/common/cnn_tflite.cc"
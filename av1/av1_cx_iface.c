@@ -24,6 +24,7 @@
 #include "av1/av1_iface_common.h"
 #include "av1/encoder/bitstream.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/encodetxb.h"
 #include "av1/encoder/firstpass.h"
 
 #define MAG_SIZE (4)
@@ -156,6 +157,12 @@ struct av1_extracfg {
   COST_UPDATE_TYPE mode_cost_upd_freq;
   COST_UPDATE_TYPE mv_cost_upd_freq;
   unsigned int sb_multipass_unit_test;
+#if CONFIG_INTRA_ENTROPY
+  int intra_entropy_sb_update;
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+  unsigned int hash_trellis_size;
+#endif  // CONFIG_HTB_TRELLIS
 };
 
 static struct av1_extracfg default_extra_cfg = {
@@ -283,6 +290,12 @@ static struct av1_extracfg default_extra_cfg = {
   COST_UPD_SB,  // mode_cost_upd_freq
   COST_UPD_SB,  // mv_cost_upd_freq
   0,            // sb_multipass_unit_test
+#if CONFIG_INTRA_ENTROPY
+  0,  // intra_entropy_sb_update
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+  0,  // hash_trellis_size
+#endif  // CONFIG_HTB_TRELLIS
 };
 
 struct aom_codec_alg_priv {
@@ -315,6 +328,7 @@ struct aom_codec_alg_priv {
   // Number of stats buffers required for look ahead
   int num_lap_buffers;
   STATS_BUFFER_CTX stats_buf_context;
+  aom_source_release_cb_t source_release_cb;
 };
 
 static INLINE int gcd(int64_t a, int b) {
@@ -434,6 +448,15 @@ static aom_codec_err_t validate_config(aom_codec_alg_priv_t *ctx,
 
   RANGE_CHECK_HI(extra_cfg, motion_vector_unit_test, 2);
   RANGE_CHECK_HI(extra_cfg, sb_multipass_unit_test, 1);
+#if CONFIG_INTRA_ENTROPY
+  RANGE_CHECK_HI(extra_cfg, intra_entropy_sb_update, 1);
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+  if (extra_cfg->hash_trellis_size != 0) {
+    RANGE_CHECK(extra_cfg, hash_trellis_size, HBT_MIN_SIZE_LOG2,
+                HBT_MAX_SIZE_LOG2);
+  }
+#endif  // CONFIG_HTB_TRELLIS
   RANGE_CHECK_HI(extra_cfg, enable_auto_alt_ref, 1);
   RANGE_CHECK_HI(extra_cfg, enable_auto_bwd_ref, 2);
   RANGE_CHECK(extra_cfg, cpu_used, 0, 8);
@@ -614,6 +637,25 @@ static int get_image_bps(const aom_image_t *img) {
   return 0;
 }
 
+// Returns the border of img if its planes are laid out as by
+// aom_img_alloc_with_border(), or 0 otherwise.
+static int get_image_border(const aom_image_t *img) {
+  if (img->img_data == NULL || !(img->fmt & AOM_IMG_FMT_PLANAR) ||
+      img->stride[AOM_PLANE_Y] <= 0)
+    return 0;
+  const int bytes_per_sample = (img->fmt & AOM_IMG_FMT_HIGHBITDEPTH) ? 2 : 1;
+  const ptrdiff_t offset = img->planes[AOM_PLANE_Y] - img->img_data;
+  const int border = (int)(offset / img->stride[AOM_PLANE_Y]);
+  // The top-left pixel is 'border' rows down and 'border' pixels across.
+  const int step = img->stride[AOM_PLANE_Y] + bytes_per_sample;
+  if (offset != (ptrdiff_t)border * step) return 0;
+  aom_image_t expected = *img;
+  if (aom_img_set_rect(&expected, 0, 0, img->d_w, img->d_h, border) ||
+      memcmp(expected.planes, img->planes, sizeof(img->planes)))
+    return 0;
+  return border;
+}
+
 // Set appropriate options to disable frame super-resolution.
 static void disable_superres(AV1EncoderConfig *const oxcf) {
   oxcf->superres_mode = SUPERRES_NONE;
@@ -1049,6 +1091,12 @@ static aom_codec_err_t set_encoder_config(AV1EncoderConfig *oxcf,
   oxcf->frame_periodic_boost = extra_cfg->frame_periodic_boost;
   oxcf->motion_vector_unit_test = extra_cfg->motion_vector_unit_test;
   oxcf->sb_multipass_unit_test = extra_cfg->sb_multipass_unit_test;
+#if CONFIG_INTRA_ENTROPY
+  oxcf->intra_entropy_sb_update = extra_cfg->intra_entropy_sb_update;
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+  oxcf->hash_trellis_size = extra_cfg->hash_trellis_size;
+#endif  // CONFIG_HTB_TRELLIS
 
   oxcf->chroma_subsampling_x = extra_cfg->chroma_subsampling_x;
   oxcf->chroma_subsampling_y = extra_cfg->chroma_subsampling_y;
@@ -1901,6 +1949,25 @@ static aom_codec_err_t ctrl_enable_sb_multipass_unit_test(
   return update_extra_cfg(ctx, &extra_cfg);
 }
 
+#if CONFIG_INTRA_ENTROPY
+static aom_codec_err_t ctrl_set_intra_entropy_sb_update(
+    aom_codec_alg_priv_t *ctx, va_list args) {
+  struct av1_extracfg extra_cfg = ctx->extra_cfg;
+  extra_cfg.intra_entropy_sb_update =
+      CAST(AV1E_SET_INTRA_ENTROPY_SB_UPDATE, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+#endif  // CONFIG_INTRA_ENTROPY
+
+#if CONFIG_HTB_TRELLIS
+static aom_codec_err_t ctrl_set_hash_trellis_size(aom_codec_alg_priv_t *ctx,
+                                                  va_list args) {
+  struct av1_extracfg extra_cfg = ctx->extra_cfg;
+  extra_cfg.hash_trellis_size = CAST(AV1E_SET_HASH_TRELLIS_SIZE, args);
+  return update_extra_cfg(ctx, &extra_cfg);
+}
+#endif  // CONFIG_HTB_TRELLIS
+
 static aom_codec_err_t create_context_and_bufferpool(
     AV1_COMP **p_cpi, BufferPool **p_buffer_pool, AV1EncoderConfig *oxcf,
     struct aom_codec_pkt_list *pkt_list_head, FIRSTPASS_STATS *frame_stats_buf,
@@ -2172,10 +2239,20 @@ static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
                                 subsampling_y);
       }
 
+      struct lookahead_src_ref src_ref;
+      if (ctx->source_release_cb.release_cb != NULL) {
+        src_ref.border = get_image_border(img);
+        src_ref.release_cb = ctx->source_release_cb.release_cb;
+        src_ref.release_cb_priv = ctx->source_release_cb.cb_priv;
+        src_ref.user_priv = img->user_priv;
+      }
+
       // Store the original flags in to the frame buffer. Will extract the
       // key frame flag when we actually encode this frame.
-      if (av1_receive_raw_frame(cpi, flags | ctx->next_frame_flags, &sd,
-                                dst_time_stamp, dst_end_time_stamp)) {
+      if (av1_receive_raw_frame(
+              cpi, flags | ctx->next_frame_flags, &sd, dst_time_stamp,
+              dst_end_time_stamp,
+              ctx->source_release_cb.release_cb != NULL ? &src_ref : NULL)) {
         res = update_error_state(ctx, &cpi->common.error);
       }
       ctx->next_frame_flags = 0;
@@ -2503,6 +2580,16 @@ static aom_codec_err_t ctrl_get_active_map(aom_codec_alg_priv_t *ctx,
   }
 }
 
+static aom_codec_err_t ctrl_set_source_release_cb(aom_codec_alg_priv_t *ctx,
+                                                  va_list args) {
+  const aom_source_release_cb_t *const cb =
+      va_arg(args, aom_source_release_cb_t *);
+
+  if (cb == NULL) return AOM_CODEC_INVALID_PARAM;
+  ctx->source_release_cb = *cb;
+  return AOM_CODEC_OK;
+}
+
 static aom_codec_err_t ctrl_set_scale_mode(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
   aom_scaling_mode_t *const mode = va_arg(args, aom_scaling_mode_t *);
@@ -2623,6 +2710,21 @@ static aom_codec_err_t ctrl_get_seq_level_idx(aom_codec_alg_priv_t *ctx,
   return av1_get_seq_level_idx(ctx->cpi, arg);
 }
 
+#if CONFIG_HTB_TRELLIS
+static aom_codec_err_t ctrl_get_hash_trellis_stats(aom_codec_alg_priv_t *ctx,
+                                                   va_list args) {
+  aom_hash_trellis_stats_t *const arg =
+      va_arg(args, aom_hash_trellis_stats_t *);
+  if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
+  HbtStats stats;
+  av1_get_hbt_stats(ctx->cpi, &stats);
+  arg->hits = stats.hits;
+  arg->misses = stats.misses;
+  arg->evictions = stats.evictions;
+  return AOM_CODEC_OK;
+}
+#endif  // CONFIG_HTB_TRELLIS
+
 static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AV1_COPY_REFERENCE, ctrl_copy_reference },
   { AOME_USE_REFERENCE, ctrl_use_reference },
@@ -2750,6 +2852,13 @@ static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AV1E_SET_TIER_MASK, ctrl_set_tier_mask },
   { AV1E_SET_MIN_CR, ctrl_set_min_cr },
   { AV1E_ENABLE_SB_MULTIPASS_UNIT_TEST, ctrl_enable_sb_multipass_unit_test },
+#if CONFIG_INTRA_ENTROPY
+  { AV1E_SET_INTRA_ENTROPY_SB_UPDATE, ctrl_set_intra_entropy_sb_update },
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+  { AV1E_SET_HASH_TRELLIS_SIZE, ctrl_set_hash_trellis_size },
+#endif  // CONFIG_HTB_TRELLIS
+  { AV1E_SET_SOURCE_RELEASE_CB, ctrl_set_source_release_cb },
 
   // Getters
   { AOME_GET_LAST_QUANTIZER, ctrl_get_quantizer },
@@ -2761,6 +2870,9 @@ static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AV1E_SET_CHROMA_SUBSAMPLING_X, ctrl_set_chroma_subsampling_x },
   { AV1E_SET_CHROMA_SUBSAMPLING_Y, ctrl_set_chroma_subsampling_y },
   { AV1E_GET_SEQ_LEVEL_IDX, ctrl_get_seq_level_idx },
+#if CONFIG_HTB_TRELLIS
+  { AV1E_GET_HASH_TRELLIS_STATS, ctrl_get_hash_trellis_stats },
+#endif  // CONFIG_HTB_TRELLIS
   { -1, NULL },
 };
 
@@ -9,6 +9,7 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -28,6 +29,7 @@
 #include "av1/common/frame_buffers.h"
 #include "av1/common/enums.h"
 #include "av1/common/obu_util.h"
+#include "av1/common/resize.h"
 
 #include "av1/decoder/decoder.h"
 #include "av1/decoder/decodeframe.h"
@@ -35,6 +37,23 @@
 
 #include "av1/av1_iface_common.h"
 
+// Frame parallel decoding keeps up to MAX_FRAME_WORKERS frames in flight. Each
+// of them holds a frame buffer and a reference map, so more would run out of
+// the FRAME_BUFFERS of the pool.
+#define MAX_FRAME_WORKERS 4
+#define FRAME_OUTPUT_QUEUE_SIZE (2 * MAX_FRAME_WORKERS)
+
+// Frame parallel decoding: a shown frame taken from the output queue of a frame
+// worker once the frame worker is done. It holds a reference to buf.
+typedef struct FrameOutput {
+  RefCntBuffer *buf;
+  void *user_priv;
+  unsigned int tu_id;
+  int temporal_id;
+  int spatial_id;
+  int skip_film_grain;
+} FrameOutput;
+
 struct aom_codec_alg_priv {
   aom_codec_priv_t base;
   aom_codec_dec_cfg_t cfg;
@@ -58,16 +77,35 @@ struct aom_codec_alg_priv {
   unsigned int is_annexb;
   int operating_point;
   int output_all_layers;
-
-  // TODO(wtc): This can be simplified. num_frame_workers is always 1, and
-  // next_output_worker_id is always 0. The frame_workers array of size 1 can
-  // be replaced by a single AVxWorker.
+  // Bytes the restoration scratch of each frame worker keeps between frames,
+  // or 0 for no limit.
+  unsigned int rst_scratch_limit;
+  unsigned int frame_parallel;
+  // The largest frames to allocate the frame buffer pool for, if max_width is
+  // not 0.
+  aom_dec_frame_pool_cfg_t frame_pool_cfg;
+
+  // num_frame_workers is 1 unless frame parallel decoding is on. The frame
+  // workers then take the frames in turn: next_submit_worker_id gets the next
+  // frame, and next_output_worker_id has the oldest frame in flight.
   AVxWorker *frame_workers;
   int num_frame_workers;
   int next_output_worker_id;
+  int next_submit_worker_id;
+  // Frame parallel decoding: the header state left by the last parsed frame,
+  // the number of temporal units received, and the shown frames of the frame
+  // workers that are done, in output order. The first num_returned_outputs
+  // of them were returned by decoder_get_frame().
+  AV1DecHeaderState *header_state;
+  unsigned int tu_count;
+  FrameOutput frame_outputs[FRAME_OUTPUT_QUEUE_SIZE];
+  int num_frame_outputs;
+  int num_returned_outputs;
 
   aom_image_t image_with_grain;
-  aom_codec_frame_buffer_t grain_image_frame_buffers[MAX_NUM_SPATIAL_LAYERS];
+  aom_codec_frame_buffer_t
+      grain_image_frame_buffers[AOMMAX(MAX_NUM_SPATIAL_LAYERS,
+                                       FRAME_OUTPUT_QUEUE_SIZE)];
   size_t num_grain_image_frame_buffers;
   int need_resync;  // wait for key/intra-only frame
   // BufferPool that holds all reference frames. Shared by all the FrameWorkers.
@@ -129,6 +167,7 @@ static aom_codec_err_t decoder_destroy(aom_codec_alg_priv_t *ctx) {
       FrameWorkerData *const frame_worker_data =
           (FrameWorkerData *)worker->data1;
       aom_get_worker_interface()->end(worker);
+      aom_free(frame_worker_data->scratch_buffer);
       aom_free(frame_worker_data->pbi->common.tpl_mvs);
       frame_worker_data->pbi->common.tpl_mvs = NULL;
       av1_remove_common(&frame_worker_data->pbi->common);
@@ -138,6 +177,8 @@ static aom_codec_err_t decoder_destroy(aom_codec_alg_priv_t *ctx) {
     }
 #if CONFIG_MULTITHREAD
     pthread_mutex_destroy(&ctx->buffer_pool->pool_mutex);
+    pthread_mutex_destroy(&ctx->buffer_pool->progress_mutex);
+    pthread_cond_destroy(&ctx->buffer_pool->progress_cond);
 #endif
   }
 
@@ -150,6 +191,7 @@ static aom_codec_err_t decoder_destroy(aom_codec_alg_priv_t *ctx) {
     av1_free_internal_frame_buffers(&ctx->buffer_pool->int_frame_buffers);
   }
 
+  aom_free(ctx->header_state);
   aom_free(ctx->frame_workers);
   aom_free(ctx->buffer_pool);
   aom_free(ctx);
@@ -404,7 +446,13 @@ static void init_buffer_callbacks(aom_codec_alg_priv_t *ctx) {
       pool->get_fb_cb = av1_get_frame_buffer;
       pool->release_fb_cb = av1_release_frame_buffer;
 
-      if (av1_alloc_internal_frame_buffers(&pool->int_frame_buffers))
+      // In frame parallel decoding, the frames in flight may take all the
+      // frame buffers of the pool while the queued output frames get their
+      // film grain images.
+      const int num_grain_images =
+          ctx->num_frame_workers > 1 ? FRAME_OUTPUT_QUEUE_SIZE : 0;
+      if (av1_alloc_internal_frame_buffers(&pool->int_frame_buffers,
+                                           num_grain_images))
         aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
                            "Failed to initialize internal frame buffers");
 
@@ -413,6 +461,32 @@ static void init_buffer_callbacks(aom_codec_alg_priv_t *ctx) {
   }
 }
 
+// Allocates the internal frame buffers, and the side buffers of the frames,
+// for the largest frames set by AV1D_SET_FRAME_POOL.
+static aom_codec_err_t reserve_frame_pool(aom_codec_alg_priv_t *ctx) {
+  const aom_dec_frame_pool_cfg_t *const pool_cfg = &ctx->frame_pool_cfg;
+  const int max_width = (int)pool_cfg->max_width;
+  const int max_height = (int)pool_cfg->max_height;
+  const int use_highbitdepth =
+      pool_cfg->max_bit_depth > AOM_BITS_8 || !ctx->cfg.allow_lowbitdepth;
+
+  if (av1_reserve_frame_buffers(ctx->buffer_pool, max_width, max_height,
+                                use_highbitdepth, ctx->byte_alignment)) {
+    set_error_detail(ctx, "Failed to allocate the frame buffer pool");
+    return AOM_CODEC_MEM_ERROR;
+  }
+  for (int i = 0; i < ctx->num_frame_workers; ++i) {
+    FrameWorkerData *const frame_worker_data =
+        (FrameWorkerData *)ctx->frame_workers[i].data1;
+    if (av1_reserve_superres_scratch(frame_worker_data->pbi, max_width,
+                                     max_height, use_highbitdepth)) {
+      set_error_detail(ctx, "Failed to allocate the superres scratch frame");
+      return AOM_CODEC_MEM_ERROR;
+    }
+  }
+  return AOM_CODEC_OK;
+}
+
 static void set_default_ppflags(aom_postproc_cfg_t *cfg) {
   cfg->post_proc_flag = AOM_DEBLOCK | AOM_DEMACROBLOCK;
   cfg->deblocking_level = 4;
@@ -435,14 +509,34 @@ static int frame_worker_hook(void *arg1, void *arg2) {
   return !result;
 }
 
+static int frame_parallel_worker_hook(void *arg1, void *arg2) {
+  FrameWorkerData *const frame_worker_data = (FrameWorkerData *)arg1;
+  (void)arg2;
+  return !av1_decode_deferred_frame(frame_worker_data->pbi);
+}
+
+// Frame parallel decoding needs more than one thread, and is not used in the
+// modes that output more or other than the frames in display order.
+static int use_frame_parallel(const aom_codec_alg_priv_t *ctx) {
+#if CONFIG_INSPECTION
+  if (ctx->inspect_cb != NULL) return 0;
+#endif
+  return ctx->frame_parallel && ctx->cfg.threads > 1 && !ctx->tile_mode &&
+         !ctx->ext_tile_debug && ctx->decode_tile_row < 0 &&
+         ctx->decode_tile_col < 0 && !ctx->output_all_layers;
+}
+
 static aom_codec_err_t init_decoder(aom_codec_alg_priv_t *ctx) {
   int i;
   const AVxWorkerInterface *const winterface = aom_get_worker_interface();
 
   ctx->last_show_frame = NULL;
   ctx->next_output_worker_id = 0;
+  ctx->next_submit_worker_id = 0;
   ctx->need_resync = 1;
   ctx->num_frame_workers = 1;
+  if (use_frame_parallel(ctx))
+    ctx->num_frame_workers = AOMMIN(ctx->cfg.threads, MAX_FRAME_WORKERS);
   if (ctx->num_frame_workers > MAX_DECODE_THREADS)
     ctx->num_frame_workers = MAX_DECODE_THREADS;
   ctx->flushed = 0;
@@ -455,7 +549,15 @@ static aom_codec_err_t init_decoder(aom_codec_alg_priv_t *ctx) {
     set_error_detail(ctx, "Failed to allocate buffer pool mutex");
     return AOM_CODEC_MEM_ERROR;
   }
+  if (pthread_mutex_init(&ctx->buffer_pool->progress_mutex, NULL) ||
+      pthread_cond_init(&ctx->buffer_pool->progress_cond, NULL)) {
+    set_error_detail(ctx, "Failed to allocate frame progress mutex");
+    return AOM_CODEC_MEM_ERROR;
+  }
 #endif
+  // Frames that are not decoded by a frame worker are always complete.
+  for (i = 0; i < FRAME_BUFFERS; ++i)
+    ctx->buffer_pool->frame_bufs[i].decoded_sb_rows = INT_MAX;
 
   ctx->frame_workers = (AVxWorker *)aom_malloc(ctx->num_frame_workers *
                                                sizeof(*ctx->frame_workers));
@@ -483,11 +585,17 @@ static aom_codec_err_t init_decoder(aom_codec_alg_priv_t *ctx) {
     frame_worker_data->worker_id = i;
     frame_worker_data->frame_context_ready = 0;
     frame_worker_data->received_frame = 0;
+    frame_worker_data->tu_id = 0;
+    frame_worker_data->scratch_buffer = NULL;
+    frame_worker_data->scratch_buffer_size = 0;
     frame_worker_data->pbi->allow_lowbitdepth = ctx->cfg.allow_lowbitdepth;
 
     // If decoding in serial mode, FrameWorker thread could create tile worker
-    // thread or loopfilter thread.
-    frame_worker_data->pbi->max_threads = ctx->cfg.threads;
+    // thread or loopfilter thread. In frame parallel mode, the frame workers
+    // share the threads.
+    frame_worker_data->pbi->max_threads =
+        AOMMAX(1, (int)ctx->cfg.threads / ctx->num_frame_workers);
+    frame_worker_data->pbi->frame_parallel = ctx->num_frame_workers > 1;
     frame_worker_data->pbi->inv_tile_order = ctx->invert_tile_order;
     frame_worker_data->pbi->common.large_scale_tile = ctx->tile_mode;
     frame_worker_data->pbi->common.is_annexb = ctx->is_annexb;
@@ -497,15 +605,37 @@ static aom_codec_err_t init_decoder(aom_codec_alg_priv_t *ctx) {
     frame_worker_data->pbi->output_all_layers = ctx->output_all_layers;
     frame_worker_data->pbi->ext_tile_debug = ctx->ext_tile_debug;
     frame_worker_data->pbi->row_mt = ctx->row_mt;
+    frame_worker_data->pbi->common.rst_scratch.limit = ctx->rst_scratch_limit;
 
     worker->hook = frame_worker_hook;
-    // The main thread acts as Frame Worker 0.
-    if (i != 0 && !winterface->reset(worker)) {
+    if (ctx->num_frame_workers > 1) {
+      // The main thread parses the headers of all the frames, and each frame
+      // worker thread decodes the tiles of its frame.
+      worker->hook = frame_parallel_worker_hook;
+      if (!winterface->reset(worker)) {
+        set_error_detail(ctx, "Frame Worker thread creation failed");
+        return AOM_CODEC_MEM_ERROR;
+      }
+    } else if (i != 0 && !winterface->reset(worker)) {
+      // The main thread acts as Frame Worker 0.
       set_error_detail(ctx, "Frame Worker thread creation failed");
       return AOM_CODEC_MEM_ERROR;
     }
   }
 
+  if (ctx->num_frame_workers > 1) {
+    ctx->header_state =
+        (AV1DecHeaderState *)aom_memalign(32, sizeof(*ctx->header_state));
+    if (ctx->header_state == NULL) {
+      set_error_detail(ctx, "Failed to allocate header_state");
+      return AOM_CODEC_MEM_ERROR;
+    }
+    memset(ctx->header_state, 0, sizeof(*ctx->header_state));
+    FrameWorkerData *const frame_worker_data =
+        (FrameWorkerData *)ctx->frame_workers[0].data1;
+    av1_save_header_state(frame_worker_data->pbi, ctx->header_state);
+  }
+
   // If postprocessing was enabled by the application and a
   // configuration has not been provided, default it.
   if (!ctx->postproc_cfg_set && (ctx->base.init_flags & AOM_CODEC_USE_POSTPROC))
@@ -513,6 +643,12 @@ static aom_codec_err_t init_decoder(aom_codec_alg_priv_t *ctx) {
 
   init_buffer_callbacks(ctx);
 
+  // External frame buffers are managed by the application.
+  if (ctx->frame_pool_cfg.max_width > 0 &&
+      ctx->buffer_pool->get_fb_cb == av1_get_frame_buffer) {
+    return reserve_frame_pool(ctx);
+  }
+
   return AOM_CODEC_OK;
 }
 
@@ -524,6 +660,180 @@ static INLINE void check_resync(aom_codec_alg_priv_t *const ctx,
     ctx->need_resync = 0;
 }
 
+// Frame parallel decoding: returns 1 if a frame of temporal unit tu_id is
+// still in flight.
+static int is_tu_in_flight(const aom_codec_alg_priv_t *ctx,
+                           unsigned int tu_id) {
+  for (int i = 0; i < ctx->num_frame_workers; ++i) {
+    const FrameWorkerData *const frame_worker_data =
+        (const FrameWorkerData *)ctx->frame_workers[i].data1;
+    if (frame_worker_data->received_frame && frame_worker_data->tu_id == tu_id)
+      return 1;
+  }
+  return 0;
+}
+
+static int has_frame_in_flight(const aom_codec_alg_priv_t *ctx) {
+  const FrameWorkerData *const frame_worker_data =
+      (const FrameWorkerData *)ctx->frame_workers[ctx->next_output_worker_id]
+          .data1;
+  return frame_worker_data->received_frame;
+}
+
+static int get_num_free_frame_buffers(BufferPool *pool) {
+  int num_free = 0;
+  lock_buffer_pool(pool);
+  for (int i = 0; i < FRAME_BUFFERS; ++i) {
+    if (pool->frame_bufs[i].ref_count == 0) ++num_free;
+  }
+  unlock_buffer_pool(pool);
+  return num_free;
+}
+
+// Frame parallel decoding: waits for the oldest frame in flight, and moves the
+// frames it shows to ctx->frame_outputs.
+static aom_codec_err_t sync_oldest_frame_worker(aom_codec_alg_priv_t *ctx) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  AVxWorker *const worker = &ctx->frame_workers[ctx->next_output_worker_id];
+  FrameWorkerData *const frame_worker_data = (FrameWorkerData *)worker->data1;
+  AV1Decoder *const pbi = frame_worker_data->pbi;
+  BufferPool *const pool = ctx->buffer_pool;
+  aom_codec_err_t res = AOM_CODEC_OK;
+
+  assert(frame_worker_data->received_frame);
+  ctx->next_output_worker_id =
+      (ctx->next_output_worker_id + 1) % ctx->num_frame_workers;
+  frame_worker_data->received_frame = 0;
+  if (winterface->sync(worker)) {
+    check_resync(ctx, pbi);
+  } else {
+    // The frames parsed meanwhile may reference this one.
+    ctx->need_resync = 1;
+    ctx->header_state->need_resync = 1;
+    res = update_error_state(ctx, &pbi->common.error);
+  }
+
+  lock_buffer_pool(pool);
+  for (size_t j = 0; j < pbi->num_output_frames; ++j) {
+    RefCntBuffer *const buf = pbi->output_frames[j];
+    FrameOutput *output = NULL;
+    if (ctx->need_resync) {
+      decrease_ref_count(buf, pool);
+      continue;
+    }
+    if (ctx->num_frame_outputs > 0 &&
+        ctx->frame_outputs[ctx->num_frame_outputs - 1].tu_id ==
+            frame_worker_data->tu_id) {
+      // As in serial decoding, a temporal unit outputs its last shown frame.
+      output = &ctx->frame_outputs[ctx->num_frame_outputs - 1];
+      decrease_ref_count(output->buf, pool);
+    } else if (ctx->num_frame_outputs < FRAME_OUTPUT_QUEUE_SIZE) {
+      output = &ctx->frame_outputs[ctx->num_frame_outputs++];
+    } else {
+      decrease_ref_count(buf, pool);
+      continue;
+    }
+    output->buf = buf;
+    output->user_priv = frame_worker_data->user_priv;
+    output->tu_id = frame_worker_data->tu_id;
+    output->temporal_id = pbi->common.temporal_layer_id;
+    output->spatial_id = pbi->common.spatial_layer_id;
+    output->skip_film_grain = pbi->common.skip_film_grain;
+  }
+  pbi->num_output_frames = 0;
+  unlock_buffer_pool(pool);
+  return res;
+}
+
+// Frame parallel decoding: releases the output frames returned by
+// decoder_get_frame(). A call to decoder_decode() may complete several temporal
+// units, so the other ones are kept for the next calls to decoder_get_frame().
+static void release_returned_frame_outputs(aom_codec_alg_priv_t *ctx) {
+  BufferPool *const pool = ctx->buffer_pool;
+  lock_buffer_pool(pool);
+  for (int i = 0; i < ctx->num_returned_outputs; ++i)
+    decrease_ref_count(ctx->frame_outputs[i].buf, pool);
+  unlock_buffer_pool(pool);
+  ctx->num_frame_outputs -= ctx->num_returned_outputs;
+  memmove(ctx->frame_outputs, ctx->frame_outputs + ctx->num_returned_outputs,
+          ctx->num_frame_outputs * sizeof(ctx->frame_outputs[0]));
+  ctx->num_returned_outputs = 0;
+}
+
+// Frame parallel decoding: parses the headers of the frame on this thread, and
+// lets the next frame worker decode its tiles.
+static aom_codec_err_t decode_one_frame_parallel(aom_codec_alg_priv_t *ctx,
+                                                 const uint8_t **data,
+                                                 size_t data_sz,
+                                                 void *user_priv) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  AVxWorker *const worker = &ctx->frame_workers[ctx->next_submit_worker_id];
+  FrameWorkerData *const frame_worker_data = (FrameWorkerData *)worker->data1;
+  AV1Decoder *const pbi = frame_worker_data->pbi;
+  aom_codec_err_t res = AOM_CODEC_OK;
+
+  // The frame worker is free once its previous frame, the oldest one in
+  // flight, is done. The frame buffers also run out with too many frames in
+  // flight, as their reference maps keep older frames alive.
+  if (frame_worker_data->received_frame) res = sync_oldest_frame_worker(ctx);
+  while (res == AOM_CODEC_OK && has_frame_in_flight(ctx) &&
+         get_num_free_frame_buffers(ctx->buffer_pool) < 2) {
+    res = sync_oldest_frame_worker(ctx);
+  }
+  if (res != AOM_CODEC_OK) return res;
+
+  // The tile groups are decoded after this call returns, so they are read from
+  // a copy of the data.
+  if (frame_worker_data->scratch_buffer_size < data_sz) {
+    aom_free(frame_worker_data->scratch_buffer);
+    frame_worker_data->scratch_buffer_size = 0;
+    frame_worker_data->scratch_buffer = (uint8_t *)aom_malloc(data_sz);
+    if (frame_worker_data->scratch_buffer == NULL) {
+      set_error_detail(ctx, "Failed to allocate scratch_buffer");
+      return AOM_CODEC_MEM_ERROR;
+    }
+    frame_worker_data->scratch_buffer_size = data_sz;
+  }
+  memcpy(frame_worker_data->scratch_buffer, *data, data_sz);
+
+  pbi->row_mt = ctx->row_mt;
+  pbi->ext_refs = ctx->ext_refs;
+  pbi->common.is_annexb = ctx->is_annexb;
+  pbi->common.byte_alignment = ctx->byte_alignment;
+  pbi->common.skip_loop_filter = ctx->skip_loop_filter;
+  pbi->common.skip_film_grain = ctx->skip_film_grain;
+
+  av1_load_header_state(pbi, ctx->header_state);
+  const uint8_t *data_start = frame_worker_data->scratch_buffer;
+  const int result = av1_receive_compressed_data(pbi, data_sz, &data_start);
+  *data += data_start - frame_worker_data->scratch_buffer;
+  if (result != 0) pbi->need_resync = 1;
+  // The failed frames also leave their sequence header and references to the
+  // next ones, as in serial decoding.
+  av1_save_header_state(pbi, ctx->header_state);
+  if (result != 0) {
+    ctx->need_resync = 1;
+    return update_error_state(ctx, &pbi->common.error);
+  }
+
+  frame_worker_data->user_priv = user_priv;
+  frame_worker_data->tu_id = ctx->tu_count;
+  frame_worker_data->received_frame = 1;
+  ctx->next_submit_worker_id =
+      (ctx->next_submit_worker_id + 1) % ctx->num_frame_workers;
+  worker->had_error = 0;
+  if (pbi->num_tile_groups > 0) {
+    // A superres frame only takes its upscaled size, which the headers of the
+    // frames referencing it read, at the end of its decoding. So it is decoded
+    // before the next frame is parsed.
+    if (av1_superres_scaled(&pbi->common))
+      winterface->execute(worker);
+    else
+      winterface->launch(worker);
+  }
+  return AOM_CODEC_OK;
+}
+
 static aom_codec_err_t decode_one(aom_codec_alg_priv_t *ctx,
                                   const uint8_t **data, size_t data_sz,
                                   void *user_priv) {
@@ -542,6 +852,9 @@ static aom_codec_err_t decode_one(aom_codec_alg_priv_t *ctx,
     if (!ctx->si.is_kf && !is_intra_only) return AOM_CODEC_ERROR;
   }
 
+  if (ctx->num_frame_workers > 1)
+    return decode_one_frame_parallel(ctx, data, data_sz, user_priv);
+
   AVxWorker *const worker = ctx->frame_workers;
   FrameWorkerData *const frame_worker_data = (FrameWorkerData *)worker->data1;
   frame_worker_data->data = *data;
@@ -630,8 +943,10 @@ static aom_codec_err_t decoder_decode(aom_codec_alg_priv_t *ctx,
   if (ctx->frame_workers) {
     BufferPool *const pool = ctx->buffer_pool;
     lock_buffer_pool(pool);
-    for (int i = 0; i < ctx->num_frame_workers; ++i) {
-      AVxWorker *const worker = &ctx->frame_workers[i];
+    // In frame parallel decoding, the output frames of the frame workers were
+    // moved to ctx->frame_outputs, or are not final yet.
+    if (ctx->num_frame_workers == 1) {
+      AVxWorker *const worker = ctx->frame_workers;
       FrameWorkerData *const frame_worker_data =
           (FrameWorkerData *)worker->data1;
       struct AV1Decoder *pbi = frame_worker_data->pbi;
@@ -640,7 +955,6 @@ static aom_codec_err_t decoder_decode(aom_codec_alg_priv_t *ctx,
       }
       pbi->num_output_frames = 0;
     }
-    unlock_buffer_pool(pool);
     for (size_t j = 0; j < ctx->num_grain_image_frame_buffers; j++) {
       pool->release_fb_cb(pool->cb_priv, &ctx->grain_image_frame_buffers[j]);
       ctx->grain_image_frame_buffers[j].data = NULL;
@@ -648,6 +962,8 @@ static aom_codec_err_t decoder_decode(aom_codec_alg_priv_t *ctx,
       ctx->grain_image_frame_buffers[j].priv = NULL;
     }
     ctx->num_grain_image_frame_buffers = 0;
+    unlock_buffer_pool(pool);
+    if (ctx->num_frame_workers > 1) release_returned_frame_outputs(ctx);
   }
 
   /* Sanity checks */
@@ -660,6 +976,7 @@ static aom_codec_err_t decoder_decode(aom_codec_alg_priv_t *ctx,
 
   // Reset flushed when receiving a valid frame.
   ctx->flushed = 0;
+  ++ctx->tu_count;
 
   // Initialize the decoder workers on the first frame.
   if (ctx->frame_workers == NULL) {
@@ -729,11 +1046,13 @@ static void *AllocWithGetFrameBufferCb(void *priv, size_t size) {
 }
 
 // If grain_params->apply_grain is false, returns img. Otherwise, adds film
-// grain to img, saves the result in grain_img, and returns grain_img.
+// grain to img, saves the result in grain_img, and returns grain_img. The
+// workers, if any, are idle and are used to add the grain.
 static aom_image_t *add_grain_if_needed(aom_codec_alg_priv_t *ctx,
                                         aom_image_t *img,
                                         aom_image_t *grain_img,
-                                        aom_film_grain_t *grain_params) {
+                                        aom_film_grain_t *grain_params,
+                                        AVxWorker *workers, int num_workers) {
   if (!grain_params->apply_grain) return img;
 
   const int w_even = ALIGN_POWER_OF_TWO(img->d_w, 1);
@@ -745,15 +1064,21 @@ static aom_image_t *add_grain_if_needed(aom_codec_alg_priv_t *ctx,
   AllocCbParam param;
   param.pool = pool;
   param.fb = fb;
-  if (!aom_img_alloc_with_cb(grain_img, img->fmt, w_even, h_even, 16,
-                             AllocWithGetFrameBufferCb, &param)) {
-    return NULL;
-  }
+  // The frame workers may be using the frame buffer callbacks meanwhile.
+  lock_buffer_pool(pool);
+  const aom_image_t *const allocated = aom_img_alloc_with_cb(
+      grain_img, img->fmt, w_even, h_even, 16, AllocWithGetFrameBufferCb,
+      &param);
+  unlock_buffer_pool(pool);
+  if (!allocated) return NULL;
 
   grain_img->user_priv = img->user_priv;
   grain_img->fb_priv = fb->priv;
-  if (av1_add_film_grain(grain_params, img, grain_img)) {
+  if (av1_add_film_grain_mt(grain_params, img, grain_img, workers,
+                            num_workers)) {
+    lock_buffer_pool(pool);
     pool->release_fb_cb(pool->cb_priv, fb);
+    unlock_buffer_pool(pool);
     return NULL;
   }
 
@@ -761,6 +1086,50 @@ static aom_image_t *add_grain_if_needed(aom_codec_alg_priv_t *ctx,
   return grain_img;
 }
 
+// Frame parallel decoding: returns the next frame of the temporal units that
+// are done, or, once flushed, waits for the frames in flight in turn.
+static aom_image_t *get_frame_parallel(aom_codec_alg_priv_t *ctx) {
+  for (;;) {
+    if (ctx->num_returned_outputs < ctx->num_frame_outputs &&
+        !is_tu_in_flight(
+            ctx, ctx->frame_outputs[ctx->num_returned_outputs].tu_id)) {
+      break;
+    }
+    if (!ctx->flushed || !has_frame_in_flight(ctx)) return NULL;
+    // The errors were reported by decoder_decode() already, or have no
+    // caller to go to. Either way, the decoder now waits for a resync.
+    sync_oldest_frame_worker(ctx);
+  }
+
+  const FrameOutput *const output =
+      &ctx->frame_outputs[ctx->num_returned_outputs];
+  RefCntBuffer *const buf = output->buf;
+  aom_film_grain_t *const grain_params = &buf->film_grain_params;
+  if (output->skip_film_grain) grain_params->apply_grain = 0;
+  // The film grain images are kept until the next call to decoder_decode(). A
+  // flush may return more frames than that, so the rest of them wait for the
+  // next flush.
+  if (grain_params->apply_grain &&
+      ctx->num_grain_image_frame_buffers == FRAME_OUTPUT_QUEUE_SIZE) {
+    return NULL;
+  }
+
+  yuvconfig2image(&ctx->img, &buf->buf, output->user_priv);
+  ctx->img.fb_priv = buf->raw_frame_buffer.priv;
+  ctx->img.temporal_id = output->temporal_id;
+  ctx->img.spatial_id = output->spatial_id;
+  aom_image_t *const img = add_grain_if_needed(
+      ctx, &ctx->img, &ctx->image_with_grain, grain_params, NULL, 0);
+  if (img == NULL) {
+    // The frame stays first in the queue.
+    set_error_detail(ctx, "Grain synthesis failed");
+    return NULL;
+  }
+  ctx->last_show_frame = buf;
+  ++ctx->num_returned_outputs;
+  return img;
+}
+
 static aom_image_t *decoder_get_frame(aom_codec_alg_priv_t *ctx,
                                       aom_codec_iter_t *iter) {
   aom_image_t *img = NULL;
@@ -769,6 +1138,9 @@ static aom_image_t *decoder_get_frame(aom_codec_alg_priv_t *ctx,
     return NULL;
   }
 
+  if (ctx->frame_workers != NULL && ctx->num_frame_workers > 1)
+    return get_frame_parallel(ctx);
+
   // To avoid having to allocate any extra storage, treat 'iter' as
   // simply a pointer to an integer index
   uintptr_t *index = (uintptr_t *)iter;
@@ -854,8 +1226,10 @@ static aom_image_t *decoder_get_frame(aom_codec_alg_priv_t *ctx,
           img->temporal_id = cm->temporal_layer_id;
           img->spatial_id = cm->spatial_layer_id;
           if (cm->skip_film_grain) grain_params->apply_grain = 0;
-          aom_image_t *res = add_grain_if_needed(
-              ctx, img, &ctx->image_with_grain, grain_params);
+          aom_image_t *res =
+              add_grain_if_needed(ctx, img, &ctx->image_with_grain,
+                                  grain_params, pbi->tile_workers,
+                                  pbi->num_workers);
           if (!res) {
             aom_internal_error(&pbi->common.error, AOM_CODEC_CORRUPT_FRAME,
                                "Grain systhesis failed\n");
@@ -891,8 +1265,16 @@ static aom_codec_err_t decoder_set_fb_fn(
   return AOM_CODEC_ERROR;
 }
 
+// Frame parallel decoding has several frames in flight, and no decoder state
+// that belongs to the last decoded or output frame.
+static aom_codec_err_t frame_parallel_incapable(aom_codec_alg_priv_t *ctx) {
+  set_error_detail(ctx, "Not supported in frame parallel decoding");
+  return AOM_CODEC_INCAPABLE;
+}
+
 static aom_codec_err_t ctrl_set_reference(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   av1_ref_frame_t *const data = va_arg(args, av1_ref_frame_t *);
 
   if (data) {
@@ -910,6 +1292,7 @@ static aom_codec_err_t ctrl_set_reference(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_copy_reference(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   const av1_ref_frame_t *const frame = va_arg(args, av1_ref_frame_t *);
   if (frame) {
     YV12_BUFFER_CONFIG sd;
@@ -924,6 +1307,7 @@ static aom_codec_err_t ctrl_copy_reference(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_reference(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   av1_ref_frame_t *data = va_arg(args, av1_ref_frame_t *);
   if (data) {
     YV12_BUFFER_CONFIG *fb;
@@ -940,6 +1324,7 @@ static aom_codec_err_t ctrl_get_reference(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_new_frame_image(aom_codec_alg_priv_t *ctx,
                                                 va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   aom_image_t *new_img = va_arg(args, aom_image_t *);
   if (new_img) {
     YV12_BUFFER_CONFIG new_frame;
@@ -959,6 +1344,7 @@ static aom_codec_err_t ctrl_get_new_frame_image(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_copy_new_frame_image(aom_codec_alg_priv_t *ctx,
                                                  va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   aom_image_t *img = va_arg(args, aom_image_t *);
   if (img) {
     YV12_BUFFER_CONFIG new_frame;
@@ -994,6 +1380,7 @@ static aom_codec_err_t ctrl_set_dbg_options(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_last_ref_updates(aom_codec_alg_priv_t *ctx,
                                                  va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   int *const update_info = va_arg(args, int *);
 
   if (update_info) {
@@ -1014,6 +1401,7 @@ static aom_codec_err_t ctrl_get_last_ref_updates(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_last_quantizer(aom_codec_alg_priv_t *ctx,
                                                va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   int *const arg = va_arg(args, int *);
   if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
   *arg =
@@ -1031,7 +1419,8 @@ static aom_codec_err_t ctrl_get_frame_corrupted(aom_codec_alg_priv_t *ctx,
       FrameWorkerData *const frame_worker_data =
           (FrameWorkerData *)worker->data1;
       AV1Decoder *const pbi = frame_worker_data->pbi;
-      if (pbi->seen_frame_header && pbi->num_output_frames == 0)
+      if (ctx->num_frame_workers == 1 && pbi->seen_frame_header &&
+          pbi->num_output_frames == 0)
         return AOM_CODEC_ERROR;
       if (ctx->last_show_frame != NULL)
         *corrupted = ctx->last_show_frame->buf.corrupted;
@@ -1049,6 +1438,13 @@ static aom_codec_err_t ctrl_get_frame_size(aom_codec_alg_priv_t *ctx,
   int *const frame_size = va_arg(args, int *);
 
   if (frame_size) {
+    if (ctx->num_frame_workers > 1) {
+      // The size of the last output frame.
+      if (ctx->last_show_frame == NULL) return AOM_CODEC_ERROR;
+      frame_size[0] = ctx->last_show_frame->buf.y_crop_width;
+      frame_size[1] = ctx->last_show_frame->buf.y_crop_height;
+      return AOM_CODEC_OK;
+    }
     if (ctx->frame_workers) {
       AVxWorker *const worker = ctx->frame_workers;
       FrameWorkerData *const frame_worker_data =
@@ -1067,6 +1463,7 @@ static aom_codec_err_t ctrl_get_frame_size(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_frame_header_info(aom_codec_alg_priv_t *ctx,
                                                   va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   aom_tile_data *const frame_header_info = va_arg(args, aom_tile_data *);
 
   if (frame_header_info) {
@@ -1088,6 +1485,7 @@ static aom_codec_err_t ctrl_get_frame_header_info(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_tile_data(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   aom_tile_data *const tile_data = va_arg(args, aom_tile_data *);
 
   if (tile_data) {
@@ -1130,6 +1528,12 @@ static aom_codec_err_t ctrl_get_render_size(aom_codec_alg_priv_t *ctx,
   int *const render_size = va_arg(args, int *);
 
   if (render_size) {
+    if (ctx->num_frame_workers > 1) {
+      if (ctx->last_show_frame == NULL) return AOM_CODEC_ERROR;
+      render_size[0] = ctx->last_show_frame->buf.render_width;
+      render_size[1] = ctx->last_show_frame->buf.render_height;
+      return AOM_CODEC_OK;
+    }
     if (ctx->frame_workers) {
       AVxWorker *const worker = ctx->frame_workers;
       FrameWorkerData *const frame_worker_data =
@@ -1152,6 +1556,11 @@ static aom_codec_err_t ctrl_get_bit_depth(aom_codec_alg_priv_t *ctx,
   AVxWorker *const worker = &ctx->frame_workers[ctx->next_output_worker_id];
 
   if (bit_depth) {
+    if (ctx->num_frame_workers > 1) {
+      if (ctx->last_show_frame == NULL) return AOM_CODEC_ERROR;
+      *bit_depth = ctx->last_show_frame->buf.bit_depth;
+      return AOM_CODEC_OK;
+    }
     if (worker) {
       FrameWorkerData *const frame_worker_data =
           (FrameWorkerData *)worker->data1;
@@ -1187,6 +1596,13 @@ static aom_codec_err_t ctrl_get_img_format(aom_codec_alg_priv_t *ctx,
   AVxWorker *const worker = &ctx->frame_workers[ctx->next_output_worker_id];
 
   if (img_fmt) {
+    if (ctx->num_frame_workers > 1) {
+      if (ctx->last_show_frame == NULL) return AOM_CODEC_ERROR;
+      const YV12_BUFFER_CONFIG *const buf = &ctx->last_show_frame->buf;
+      *img_fmt = get_img_format(buf->subsampling_x, buf->subsampling_y,
+                                (buf->flags & YV12_FLAG_HIGHBITDEPTH) != 0);
+      return AOM_CODEC_OK;
+    }
     if (worker) {
       FrameWorkerData *const frame_worker_data =
           (FrameWorkerData *)worker->data1;
@@ -1206,6 +1622,7 @@ static aom_codec_err_t ctrl_get_img_format(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_tile_size(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   unsigned int *const tile_size = va_arg(args, unsigned int *);
   AVxWorker *const worker = &ctx->frame_workers[ctx->next_output_worker_id];
 
@@ -1227,6 +1644,7 @@ static aom_codec_err_t ctrl_get_tile_size(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t ctrl_get_tile_count(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   unsigned int *const tile_count = va_arg(args, unsigned int *);
 
   if (tile_count) {
@@ -1263,7 +1681,9 @@ static aom_codec_err_t ctrl_set_byte_alignment(aom_codec_alg_priv_t *ctx,
     return AOM_CODEC_INVALID_PARAM;
 
   ctx->byte_alignment = byte_alignment;
-  if (ctx->frame_workers) {
+  // In frame parallel decoding, the setting applies from the next frame that
+  // is submitted.
+  if (ctx->frame_workers && ctx->num_frame_workers == 1) {
     AVxWorker *const worker = ctx->frame_workers;
     FrameWorkerData *const frame_worker_data = (FrameWorkerData *)worker->data1;
     frame_worker_data->pbi->common.byte_alignment = byte_alignment;
@@ -1275,7 +1695,7 @@ static aom_codec_err_t ctrl_set_skip_loop_filter(aom_codec_alg_priv_t *ctx,
                                                  va_list args) {
   ctx->skip_loop_filter = va_arg(args, int);
 
-  if (ctx->frame_workers) {
+  if (ctx->frame_workers && ctx->num_frame_workers == 1) {
     AVxWorker *const worker = ctx->frame_workers;
     FrameWorkerData *const frame_worker_data = (FrameWorkerData *)worker->data1;
     frame_worker_data->pbi->common.skip_loop_filter = ctx->skip_loop_filter;
@@ -1288,7 +1708,7 @@ static aom_codec_err_t ctrl_set_skip_film_grain(aom_codec_alg_priv_t *ctx,
                                                 va_list args) {
   ctx->skip_film_grain = va_arg(args, int);
 
-  if (ctx->frame_workers) {
+  if (ctx->frame_workers && ctx->num_frame_workers == 1) {
     AVxWorker *const worker = ctx->frame_workers;
     FrameWorkerData *const frame_worker_data = (FrameWorkerData *)worker->data1;
     frame_worker_data->pbi->common.skip_film_grain = ctx->skip_film_grain;
@@ -1304,6 +1724,7 @@ static aom_codec_err_t ctrl_get_accounting(aom_codec_alg_priv_t *ctx,
   (void)args;
   return AOM_CODEC_INCAPABLE;
 #else
+  if (ctx->num_frame_workers > 1) return frame_parallel_incapable(ctx);
   if (ctx->frame_workers) {
     AVxWorker *const worker = ctx->frame_workers;
     FrameWorkerData *const frame_worker_data = (FrameWorkerData *)worker->data1;
@@ -1371,6 +1792,76 @@ static aom_codec_err_t ctrl_ext_tile_debug(aom_codec_alg_priv_t *ctx,
   return AOM_CODEC_OK;
 }
 
+static aom_codec_err_t ctrl_set_restoration_scratch_limit(
+    aom_codec_alg_priv_t *ctx, va_list args) {
+  // The limit is handed to the frame workers when they are created.
+  if (ctx->frame_workers != NULL) return AOM_CODEC_ERROR;
+  ctx->rst_scratch_limit = va_arg(args, unsigned int);
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_get_restoration_scratch_stats(
+    aom_codec_alg_priv_t *ctx, va_list args) {
+  aom_dec_scratch_stats_t *const stats =
+      va_arg(args, aom_dec_scratch_stats_t *);
+  if (stats == NULL) return AOM_CODEC_INVALID_PARAM;
+  if (ctx->frame_workers == NULL) return AOM_CODEC_ERROR;
+  // The frame workers may be restoring a frame meanwhile.
+  if (ctx->num_frame_workers > 1) return AOM_CODEC_INCAPABLE;
+
+  const FrameWorkerData *const frame_worker_data =
+      (FrameWorkerData *)ctx->frame_workers[0].data1;
+  const RestorationScratch *const scratch =
+      &frame_worker_data->pbi->common.rst_scratch;
+  stats->size = scratch->total_size;
+  stats->peak_size = scratch->peak_size;
+  stats->num_allocs = (unsigned int)scratch->num_allocs;
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_set_frame_parallel(aom_codec_alg_priv_t *ctx,
+                                               va_list args) {
+  ctx->frame_parallel = va_arg(args, unsigned int);
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_set_frame_pool(aom_codec_alg_priv_t *ctx,
+                                           va_list args) {
+  const aom_dec_frame_pool_cfg_t *const pool_cfg =
+      va_arg(args, aom_dec_frame_pool_cfg_t *);
+  if (pool_cfg == NULL) return AOM_CODEC_INVALID_PARAM;
+  // The frame buffers are allocated when the decoder is initialized.
+  if (ctx->frame_workers != NULL) return AOM_CODEC_ERROR;
+  // AV1 frame dimensions are at most 16 bits.
+  if (pool_cfg->max_width == 0 || pool_cfg->max_width > 65536 ||
+      pool_cfg->max_height == 0 || pool_cfg->max_height > 65536 ||
+      (pool_cfg->max_bit_depth != AOM_BITS_8 &&
+       pool_cfg->max_bit_depth != AOM_BITS_10 &&
+       pool_cfg->max_bit_depth != AOM_BITS_12)) {
+    return AOM_CODEC_INVALID_PARAM;
+  }
+  ctx->frame_pool_cfg = *pool_cfg;
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_get_frame_pool_stats(aom_codec_alg_priv_t *ctx,
+                                                 va_list args) {
+  aom_dec_frame_pool_stats_t *const stats =
+      va_arg(args, aom_dec_frame_pool_stats_t *);
+  if (stats == NULL) return AOM_CODEC_INVALID_PARAM;
+  if (ctx->buffer_pool == NULL) return AOM_CODEC_ERROR;
+
+  BufferPool *const pool = ctx->buffer_pool;
+  // The frame workers may be allocating meanwhile.
+  lock_buffer_pool(pool);
+  stats->num_frame_buffer_allocs = pool->int_frame_buffers.num_allocs;
+  stats->num_side_buffer_allocs = pool->num_side_allocs;
+  stats->frame_buffer_size =
+      av1_internal_frame_buffers_size(&pool->int_frame_buffers);
+  unlock_buffer_pool(pool);
+  return AOM_CODEC_OK;
+}
+
 static aom_codec_err_t ctrl_set_row_mt(aom_codec_alg_priv_t *ctx,
                                        va_list args) {
   ctx->row_mt = va_arg(args, unsigned int);
@@ -1401,6 +1892,10 @@ static aom_codec_ctrl_fn_map_t decoder_ctrl_maps[] = {
   { AV1D_SET_ROW_MT, ctrl_set_row_mt },
   { AV1D_SET_EXT_REF_PTR, ctrl_set_ext_ref_ptr },
   { AV1D_SET_SKIP_FILM_GRAIN, ctrl_set_skip_film_grain },
+  { AV1D_SET_RESTORATION_SCRATCH_LIMIT, ctrl_set_restoration_scratch_limit },
+
+  { AV1D_SET_FRAME_PARALLEL, ctrl_set_frame_parallel },
+  { AV1D_SET_FRAME_POOL, ctrl_set_frame_pool },
 
   // Getters
   { AOMD_GET_FRAME_CORRUPTED, ctrl_get_frame_corrupted },
@@ -1418,6 +1913,8 @@ static aom_codec_ctrl_fn_map_t decoder_ctrl_maps[] = {
   { AV1_GET_REFERENCE, ctrl_get_reference },
   { AV1D_GET_FRAME_HEADER_INFO, ctrl_get_frame_header_info },
   { AV1D_GET_TILE_DATA, ctrl_get_tile_data },
+  { AV1D_GET_RESTORATION_SCRATCH_STATS, ctrl_get_restoration_scratch_stats },
+  { AV1D_GET_FRAME_POOL_STATS, ctrl_get_frame_pool_stats },
 
   { -1, NULL },
 };
@@ -93,8 +93,11 @@ static aom_codec_err_t image2yuvconfig(const aom_image_t *img,
       img->x_chroma_shift == 1 ? (1 + yv12->y_width) / 2 : yv12->y_width;
   yv12->uv_height =
       img->y_chroma_shift == 1 ? (1 + yv12->y_height) / 2 : yv12->y_height;
-  yv12->uv_crop_width = yv12->uv_width;
-  yv12->uv_crop_height = yv12->uv_height;
+  yv12->uv_crop_width = img->x_chroma_shift == 1 ? (1 + yv12->y_crop_width) / 2
+                                                  : yv12->y_crop_width;
+  yv12->uv_crop_height = img->y_chroma_shift == 1
+                             ? (1 + yv12->y_crop_height) / 2
+                             : yv12->y_crop_height;
 
   yv12->y_stride = img->stride[AOM_PLANE_Y];
   yv12->uv_stride = img->stride[AOM_PLANE_U];
@@ -106,6 +106,8 @@ void av1_free_ref_frame_buffers(BufferPool *pool) {
     pool->frame_bufs[i].mvs = NULL;
     aom_free(pool->frame_bufs[i].seg_map);
     pool->frame_bufs[i].seg_map = NULL;
+    pool->frame_bufs[i].mvs_alloc_size = 0;
+    pool->frame_bufs[i].seg_map_alloc_size = 0;
     aom_free_frame_buffer(&pool->frame_bufs[i].buf);
   }
 }
@@ -180,6 +182,7 @@ void av1_free_restoration_buffers(AV1_COMMON *cm) {
   cm->rst_tmpbuf = NULL;
   aom_free(cm->rlbs);
   cm->rlbs = NULL;
+  av1_rst_scratch_free(&cm->rst_scratch);
   for (p = 0; p < MAX_MB_PLANE; ++p) {
     RestorationStripeBoundaries *boundaries = &cm->rst_info[p].boundaries;
     aom_free(boundaries->stripe_boundary_above);
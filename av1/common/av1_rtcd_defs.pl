@@ -89,6 +89,14 @@ if (aom_config("CONFIG_SUPERRES_EXT") eq "yes") {
   specialize qw/av1_highbd_convolve_horiz_rs sse4_1/;
 }
 
+if (aom_config("CONFIG_EXT_IBC_MODES") eq "yes") {
+  add_proto qw/void av1_intrabc_transform_sb/, "uint16_t *dst, int dst_stride, const uint16_t *src, int src_stride, int width, int height, IBC_MODE mode";
+  specialize qw/av1_intrabc_transform_sb sse2/;
+
+  add_proto qw/void av1_intrabc_transform_all_sb/, "uint16_t *const *dst, int dst_stride, const uint16_t *src, int src_stride, int width, int height, int num_modes";
+  specialize qw/av1_intrabc_transform_all_sb sse2/;
+}
+
 add_proto qw/void av1_wiener_convolve_add_src/,       "const uint8_t *src, ptrdiff_t src_stride, uint8_t *dst, ptrdiff_t dst_stride, const int16_t *filter_x, int x_step_q4, const int16_t *filter_y, int y_step_q4, int w, int h, const ConvolveParams *conv_params";
 
 add_proto qw/void av1_highbd_wiener_convolve_add_src/, "const uint8_t *src, ptrdiff_t src_stride, uint8_t *dst, ptrdiff_t dst_stride, const int16_t *filter_x, int x_step_q4, const int16_t *filter_y, int y_step_q4, int w, int h, const ConvolveParams *conv_params, int bd";
@@ -112,6 +120,19 @@ specialize qw/av1_dr_prediction_z3 avx2/;
 add_proto qw/void av1_filter_intra_predictor/, "uint8_t *dst, ptrdiff_t stride, TX_SIZE tx_size, const uint8_t *above, const uint8_t *left, int mode";
 specialize qw/av1_filter_intra_predictor sse4_1/;
 
+# ADAPT_FILTER_INTRA statistics and predictor functions
+if (aom_config("CONFIG_ADAPT_FILTER_INTRA") eq "yes") {
+  add_proto qw/void av1_adapt_filter_intra_accum/, "const uint8_t *src, int stride, int w, int h, int mode, int64_t *stats";
+  specialize qw/av1_adapt_filter_intra_accum sse2/;
+  add_proto qw/void av1_adapt_filter_intra_accum_hbd/, "const uint16_t *src, int stride, int w, int h, int mode, int64_t *stats";
+  specialize qw/av1_adapt_filter_intra_accum_hbd sse2/;
+
+  add_proto qw/void av1_adapt_filter_intra_pred/, "uint8_t *dst, int stride, TX_SIZE tx_size, const double *filt, const uint8_t *above, const uint8_t *left, int mode";
+  specialize qw/av1_adapt_filter_intra_pred sse2/;
+  add_proto qw/void av1_adapt_filter_intra_pred_hbd/, "uint16_t *dst, int stride, TX_SIZE tx_size, const double *filt, const uint16_t *above, const uint16_t *left, int mode";
+  specialize qw/av1_adapt_filter_intra_pred_hbd sse2/;
+}
+
 # High bitdepth functions
 
 #
@@ -130,6 +151,10 @@ specialize qw/av1_highbd_convolve8_horiz/, "$sse2_x86_64";
 add_proto qw/void av1_highbd_convolve8_vert/, "const uint8_t *src, ptrdiff_t src_stride, uint8_t *dst, ptrdiff_t dst_stride, const int16_t *filter_x, int x_step_q4, const int16_t *filter_y, int y_step_q4, int w, int h, int bps";
 specialize qw/av1_highbd_convolve8_vert/, "$sse2_x86_64";
 
+# dequantization of the coefficients read by the decoder
+add_proto qw/void av1_dequantize_coeffs/, "tran_low_t *coeffs, int n_coeffs, int dqv_dc, int dqv_ac, int shift, int bd";
+specialize qw/av1_dequantize_coeffs sse4_1/;
+
 #inv txfm
 add_proto qw/void av1_inv_txfm_add/, "const tran_low_t *dqcoeff, uint8_t *dst, int stride, const TxfmParam *txfm_param";
 specialize qw/av1_inv_txfm_add ssse3 avx2 neon/;
@@ -345,6 +370,8 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
   # txb
   add_proto qw/void av1_get_nz_map_contexts/, "const uint8_t *const levels, const int16_t *const scan, const uint16_t eob, const TX_SIZE tx_size, const TX_CLASS tx_class, int8_t *const coeff_contexts";
   specialize qw/av1_get_nz_map_contexts sse2/;
+  add_proto qw/void av1_get_br_contexts/, "const uint8_t *const levels, const int16_t *const scan, const uint16_t eob, const TX_SIZE tx_size, const TX_CLASS tx_class, int8_t *const br_contexts";
+  specialize qw/av1_get_br_contexts sse2/;
   add_proto qw/void av1_txb_init_levels/, "const tran_low_t *const coeff, const int width, const int height, uint8_t *const levels";
   specialize qw/av1_txb_init_levels sse4_1 avx2/;
 
@@ -525,6 +552,14 @@ specialize qw/cfl_get_predict_lbd_fn ssse3 avx2 neon/;
 add_proto qw/cfl_predict_hbd_fn cfl_get_predict_hbd_fn/, "TX_SIZE tx_size";
 specialize qw/cfl_get_predict_hbd_fn ssse3 avx2 neon/;
 
+if (aom_config("CONFIG_DERIVED_INTRA_MODE") eq "yes") {
+add_proto qw/void av1_derived_intra_grad_hist/, "const uint8_t *src, int src_stride, int rows, int cols, int *hist";
+specialize qw/av1_derived_intra_grad_hist sse4_1/;
+
+add_proto qw/void av1_derived_intra_grad_hist_hbd/, "const uint16_t *src, int src_stride, int rows, int cols, int *hist";
+specialize qw/av1_derived_intra_grad_hist_hbd sse4_1/;
+}
+
 if (aom_config("CONFIG_INTRA_ENTROPY") eq "yes") {
 add_proto qw/void av1_nn_fc_forward/, "FC_LAYER_EM *layer, const float *input, float *output";
 specialize qw/av1_nn_fc_forward sse4_1/;
@@ -532,6 +567,12 @@ specialize qw/av1_nn_fc_forward sse4_1/;
 add_proto qw/void av1_nn_softmax_em/, "const float *input, float *output, int n";
 specialize qw/av1_nn_softmax_em sse4_1/;
 
+add_proto qw/void av1_nn_input_backward_em/, "FC_INPUT_LAYER_EM *layer, const float *dy, const int *sparse_features, const float *dense_features";
+specialize qw/av1_nn_input_backward_em avx2/;
+
+add_proto qw/void av1_nn_adapt_em/, "float *w, float *dw, float mu, int n";
+specialize qw/av1_nn_adapt_em avx2/;
+
 if (aom_config("CONFIG_USE_SMALL_MODEL") ne "yes") {
 add_proto qw/void av1_get_gradient_hist_lbd/, "const uint8_t *dst, int stride, int rows, int cols, uint64_t *hist";
 specialize qw/av1_get_gradient_hist_lbd sse4_1/;
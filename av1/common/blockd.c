@@ -9,8 +9,13 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <float.h>
 #include <math.h>
+#include <string.h>
 
+#include "config/av1_rtcd.h"
+
+#include "aom_ports/aom_once.h"
 #include "aom_ports/system_state.h"
 
 #include "av1/common/blockd.h"
@@ -476,7 +481,7 @@ void av1_get_recon_var(const MACROBLOCKD *const xd, MB_MODE_INFO *const mbmi,
 
 #if CONFIG_DERIVED_INTRA_MODE
 // BIN_WIDTH * BINS should be equal to 180.
-#define BINS 36
+#define BINS DERIVED_INTRA_HIST_BINS
 #define BIN_WIDTH 5
 static int get_bin_index_from_angle(int angle) {
   angle = AOMMAX(0, AOMMIN(angle, 179));
@@ -487,9 +492,65 @@ static INLINE int get_angle_from_index(int index) {
   return index * BIN_WIDTH + (BIN_WIDTH >> 1);
 }
 
-static void get_gradient_hist(const uint8_t *src, int src_stride, int rows,
-                              int cols, int *hist) {
-  float angle;
+// Returns the histogram bin of a gradient whose dy / dx ratio is 'ratio'.
+static int get_bin_index_from_ratio(float ratio) {
+  const float angle = atanf(ratio);
+  int int_angle = 90 - (int)roundf(180 * angle / (float)PI);
+  if (int_angle >= 180) int_angle = 0;
+  int_angle = AOMMAX(int_angle, 0);
+  return get_bin_index_from_angle(int_angle);
+}
+
+static float angle_thresholds[BINS];
+
+// Order-preserving mapping between floats and unsigned integers.
+static uint32_t float_to_key(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+static float key_to_float(uint32_t key) {
+  const uint32_t bits = (key & 0x80000000u) ? key & 0x7fffffffu : ~key;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// Returns the smallest float ratio whose bin is at most 'max_bin', excluding
+// the very steep negative gradients that wrap around to bin 0.
+static float find_angle_threshold(int max_bin) {
+  uint32_t lo = float_to_key(-FLT_MAX);
+  uint32_t hi = float_to_key(FLT_MAX);
+  while (lo < hi) {
+    const uint32_t mid = lo + ((hi - lo) >> 1);
+    const float ratio = key_to_float(mid);
+    const int wrapped = 90 - (int)roundf(180 * atanf(ratio) / (float)PI) >= 180;
+    if (!wrapped && get_bin_index_from_ratio(ratio) <= max_bin) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return key_to_float(lo);
+}
+
+static void init_angle_thresholds(void) {
+  aom_clear_system_state();
+  angle_thresholds[0] = find_angle_threshold(BINS - 1);
+  for (int i = 1; i < BINS; ++i) {
+    angle_thresholds[i] = find_angle_threshold(BINS - 1 - i);
+  }
+  aom_clear_system_state();
+}
+
+const float *av1_get_derived_intra_angle_thresholds(void) {
+  aom_once(init_angle_thresholds);
+  return angle_thresholds;
+}
+
+void av1_derived_intra_grad_hist_c(const uint8_t *src, int src_stride,
+                                   int rows, int cols, int *hist) {
   src += src_stride;
   for (int r = 1; r < rows - 1; ++r) {
     for (int c = 1; c < cols - 1; ++c) {
@@ -502,16 +563,9 @@ static void get_gradient_hist(const uint8_t *src, int src_stride, int rows,
       const int dy = (below[-1] + 2 * below[0] + below[1]) -
                      (above[-1] + 2 * above[0] + above[1]);
       if (dx == 0 && dy == 0) continue;
-      if (dx == 0) {
-        angle = 0.0f;
-      } else {
-        angle = atanf(dy * 1.0f / dx);
-      }
-      int int_angle = 90 - (int)roundf(180 * angle / (float)PI);
-      if (int_angle >= 180) int_angle = 0;
-      int_angle = AOMMAX(int_angle, 0);
+      const int bin_index =
+          get_bin_index_from_ratio(dx == 0 ? 0.0f : dy * 1.0f / dx);
       const int temp = abs(dx) + abs(dy);
-      const int bin_index = get_bin_index_from_angle(int_angle);
       hist[bin_index] += temp;
       if (bin_index > 0) hist[bin_index - 1] += temp / 2;
       if (bin_index < BINS - 1) hist[bin_index + 1] += temp / 2;
@@ -520,10 +574,8 @@ static void get_gradient_hist(const uint8_t *src, int src_stride, int rows,
   }
 }
 
-static void get_highbd_gradient_hist(const uint8_t *src8, int src_stride,
-                                     int rows, int cols, int *hist) {
-  float angle;
-  uint16_t *src = CONVERT_TO_SHORTPTR(src8);
+void av1_derived_intra_grad_hist_hbd_c(const uint16_t *src, int src_stride,
+                                       int rows, int cols, int *hist) {
   src += src_stride;
   for (int r = 1; r < rows - 1; ++r) {
     for (int c = 1; c < cols - 1; ++c) {
@@ -537,16 +589,9 @@ static void get_highbd_gradient_hist(const uint8_t *src8, int src_stride,
       const int dy = (below[-1] + 2 * below[0] + below[1]) -
                      (above[-1] + 2 * above[0] + above[1]);
       if (dx == 0 && dy == 0) continue;
-      if (dx == 0) {
-        angle = 0.0f;
-      } else {
-        angle = atanf(dy * 1.0f / dx);
-      }
-      int int_angle = 90 - (int)roundf(180 * angle / (float)PI);
-      if (int_angle >= 180) int_angle = 0;
-      int_angle = AOMMAX(int_angle, 0);
+      const int bin_index =
+          get_bin_index_from_ratio(dx == 0 ? 0.0f : dy * 1.0f / dx);
       const int temp = abs(dx) + abs(dy);
-      const int bin_index = get_bin_index_from_angle(int_angle);
       hist[bin_index] += temp;
       if (bin_index > 0) hist[bin_index - 1] += temp / 2;
       if (bin_index < BINS - 1) hist[bin_index + 1] += temp / 2;
@@ -568,29 +613,32 @@ static void generate_hog(const MACROBLOCKD *xd, int *hist) {
   const int lines = 3;
 
   if (is_cur_buf_hbd(xd)) {
+    const uint16_t *buf16 = CONVERT_TO_SHORTPTR(buf);
     if (xd->above_mbmi) {
       if (xd->left_mbmi) {
-        get_highbd_gradient_hist(buf - lines * stride - lines, stride, lines,
-                                 cols + lines, hist);
+        av1_derived_intra_grad_hist_hbd(buf16 - lines * stride - lines, stride,
+                                        lines, cols + lines, hist);
       } else {
-        get_highbd_gradient_hist(buf - lines * stride, stride, lines, cols,
-                                 hist);
+        av1_derived_intra_grad_hist_hbd(buf16 - lines * stride, stride, lines,
+                                        cols, hist);
       }
     }
     if (xd->left_mbmi) {
-      get_highbd_gradient_hist(buf - lines, stride, rows, lines, hist);
+      av1_derived_intra_grad_hist_hbd(buf16 - lines, stride, rows, lines,
+                                      hist);
     }
   } else {
     if (xd->above_mbmi) {
       if (xd->left_mbmi) {
-        get_gradient_hist(buf - lines * stride - lines, stride, lines,
-                          cols + lines, hist);
+        av1_derived_intra_grad_hist(buf - lines * stride - lines, stride,
+                                    lines, cols + lines, hist);
       } else {
-        get_gradient_hist(buf - lines * stride, stride, lines, cols, hist);
+        av1_derived_intra_grad_hist(buf - lines * stride, stride, lines, cols,
+                                    hist);
       }
     }
     if (xd->left_mbmi) {
-      get_gradient_hist(buf - lines, stride, rows, lines, hist);
+      av1_derived_intra_grad_hist(buf - lines, stride, rows, lines, hist);
     }
   }
 }
@@ -610,62 +658,91 @@ static int angle_to_mode(int angle) {
   return D203_PRED;
 }
 
-int av1_get_derived_intra_mode(const MACROBLOCKD *xd, int bsize,
-                               MB_MODE_INFO *mbmi) {
-  if (av1_enable_derived_intra_mode(xd, bsize)) {
-    int hist[BINS] = { 0 };
-    aom_clear_system_state();
-    generate_hog(xd, hist);
-    aom_clear_system_state();
+static int derive_intra_mode(const MACROBLOCKD *xd, MB_MODE_INFO *mbmi) {
+  int hist[BINS] = { 0 };
+  aom_clear_system_state();
+  generate_hog(xd, hist);
+  aom_clear_system_state();
 #if FUSION_MODE
-    int total_weight = 1;
-    for (int i = 0; i < NUM_DERIVED_INTRA_MODES; ++i) {
-      int max_score = 0;
-      int best_idx = 0;
-      for (int idx = 0; idx < BINS; ++idx) {
-        const int this_score = hist[idx];
-        if (this_score > max_score) {
-          max_score = this_score;
-          best_idx = idx;
-        }
-      }
-      int angle = get_angle_from_index(best_idx);
-      if (angle < 36) angle += 180;
-      mbmi->derived_intra_angles[i] = angle;
-      mbmi->derived_intra_weights[i] = max_score;
-      total_weight += max_score;
-      hist[best_idx] = 0;
-    }
-
-    const int scale = 1 << DERIVED_INTRA_FUSION_SHIFT;
-    int sub_total_weight = 0;
-    for (int i = NUM_DERIVED_INTRA_MODES - 1; i > 0; --i) {
-      const int weight = mbmi->derived_intra_weights[i];
-      mbmi->derived_intra_weights[i] =
-          (weight * scale + (total_weight >> 1)) / total_weight;
-      sub_total_weight += mbmi->derived_intra_weights[i];
-    }
-    mbmi->derived_intra_weights[0] = scale - sub_total_weight;
-    mbmi->derived_angle = mbmi->derived_intra_angles[0];
-    return angle_to_mode(mbmi->derived_angle);
-#else
+  int total_weight = 1;
+  for (int i = 0; i < NUM_DERIVED_INTRA_MODES; ++i) {
     int max_score = 0;
     int best_idx = 0;
-    for (int i = 0; i < BINS; ++i) {
-      const int this_score = hist[i];
+    for (int idx = 0; idx < BINS; ++idx) {
+      const int this_score = hist[idx];
       if (this_score > max_score) {
         max_score = this_score;
-        best_idx = i;
+        best_idx = idx;
       }
     }
     int angle = get_angle_from_index(best_idx);
     if (angle < 36) angle += 180;
-    mbmi->derived_angle = angle;
-    const int mode = angle_to_mode(angle);
-    return mode;
+    mbmi->derived_intra_angles[i] = angle;
+    mbmi->derived_intra_weights[i] = max_score;
+    total_weight += max_score;
+    hist[best_idx] = 0;
+  }
+
+  const int scale = 1 << DERIVED_INTRA_FUSION_SHIFT;
+  int sub_total_weight = 0;
+  for (int i = NUM_DERIVED_INTRA_MODES - 1; i > 0; --i) {
+    const int weight = mbmi->derived_intra_weights[i];
+    mbmi->derived_intra_weights[i] =
+        (weight * scale + (total_weight >> 1)) / total_weight;
+    sub_total_weight += mbmi->derived_intra_weights[i];
+  }
+  mbmi->derived_intra_weights[0] = scale - sub_total_weight;
+  mbmi->derived_angle = mbmi->derived_intra_angles[0];
+  return angle_to_mode(mbmi->derived_angle);
+#else
+  int max_score = 0;
+  int best_idx = 0;
+  for (int i = 0; i < BINS; ++i) {
+    const int this_score = hist[i];
+    if (this_score > max_score) {
+      max_score = this_score;
+      best_idx = i;
+    }
+  }
+  int angle = get_angle_from_index(best_idx);
+  if (angle < 36) angle += 180;
+  mbmi->derived_angle = angle;
+  const int mode = angle_to_mode(angle);
+  return mode;
 #endif
+}
+
+int av1_get_derived_intra_mode(MACROBLOCKD *xd, int bsize,
+                               MB_MODE_INFO *mbmi) {
+  if (!av1_enable_derived_intra_mode(xd, bsize)) return INTRA_MODES;
+
+  DERIVED_INTRA_MODE_CACHE *const cache = &xd->derived_intra_mode_cache;
+  if (!cache->valid || cache->mi_row != xd->mi_row ||
+      cache->mi_col != xd->mi_col || cache->bsize != bsize ||
+      cache->dst_buf != xd->plane[0].dst.buf) {
+    cache->mode = derive_intra_mode(xd, mbmi);
+    cache->derived_angle = mbmi->derived_angle;
+#if FUSION_MODE
+    memcpy(cache->derived_intra_angles, mbmi->derived_intra_angles,
+           sizeof(cache->derived_intra_angles));
+    memcpy(cache->derived_intra_weights, mbmi->derived_intra_weights,
+           sizeof(cache->derived_intra_weights));
+#endif  // FUSION_MODE
+    cache->mi_row = xd->mi_row;
+    cache->mi_col = xd->mi_col;
+    cache->bsize = bsize;
+    cache->dst_buf = xd->plane[0].dst.buf;
+    cache->valid = 1;
+    return cache->mode;
   }
-  return INTRA_MODES;
+  mbmi->derived_angle = cache->derived_angle;
+#if FUSION_MODE
+  memcpy(mbmi->derived_intra_angles, cache->derived_intra_angles,
+         sizeof(mbmi->derived_intra_angles));
+  memcpy(mbmi->derived_intra_weights, cache->derived_intra_weights,
+         sizeof(mbmi->derived_intra_weights));
+#endif  // FUSION_MODE
+  return cache->mode;
 }
 
 #undef BINS
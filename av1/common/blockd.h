@@ -310,6 +310,38 @@ typedef struct {
 static const PREDICTION_MODE afimode_to_intradir[ADAPT_FILTER_INTRA_MODES] = {
   D135_PRED, D203_PRED, D67_PRED, D203_PRED, D67_PRED, D203_PRED, D67_PRED
 };
+
+// Solved adaptive filter intra coefficients of one transform block, along
+// with the parameters that determine its training region.
+typedef struct {
+  uint32_t generation;
+  int plane;
+  int px_row;
+  int px_col;
+  int n_top_px;
+  int n_topright_px;
+  int n_left_px;
+  int n_bottomleft_px;
+  double filt[4];
+} ADAPT_FILTER_INTRA_COEFFS;
+
+// Encoder-side cache of solved adaptive filter intra coefficients, indexed by
+// transform size and mode. Only transform blocks whose training region lies
+// outside the current coding block are cached, so the entries stay valid for
+// as long as the encoder works on the same block; bumping 'generation'
+// invalidates all of them at once.
+typedef struct {
+  uint32_t generation;
+  ADAPT_FILTER_INTRA_COEFFS entry[TX_SIZES_ALL][ADAPT_FILTER_INTRA_MODES];
+} ADAPT_FILTER_INTRA_CACHE;
+
+static INLINE void av1_reset_adapt_filter_intra_cache(
+    ADAPT_FILTER_INTRA_CACHE *cache) {
+  if (++cache->generation == 0) {
+    av1_zero(cache->entry);
+    cache->generation = 1;
+  }
+}
 #endif  // CONFIG_ADAPT_FILTER_INTRA
 
 #if CONFIG_RD_DEBUG
@@ -661,6 +693,27 @@ static INLINE void set_chroma_ref_info(int mi_row, int mi_col, int index,
 #define NUM_DERIVED_INTRA_MODES 1
 #define DERIVED_INTRA_FUSION_SHIFT 7
 #endif  // FUSION_MODE
+
+// Number of bins in the histogram of gradient directions.
+#define DERIVED_INTRA_HIST_BINS 36
+
+// Derived intra mode of the most recently queried block. It only depends on
+// the reconstructed pixels above and left of the block, which stay the same
+// while the block is searched or decoded, so the luma and chroma mode
+// searches and the inter-intra predictor of a block share one computation.
+typedef struct {
+  int valid;
+  int mi_row;
+  int mi_col;
+  int bsize;
+  const uint8_t *dst_buf;
+  int mode;
+  uint8_t derived_angle;
+#if FUSION_MODE
+  uint8_t derived_intra_angles[NUM_DERIVED_INTRA_MODES];
+  uint8_t derived_intra_weights[NUM_DERIVED_INTRA_MODES];
+#endif  // FUSION_MODE
+} DERIVED_INTRA_MODE_CACHE;
 #endif  // CONFIG_DERIVED_INTRA_MODE
 
 // This structure now relates to 4x4 block regions.
@@ -1147,6 +1200,11 @@ typedef struct macroblockd {
 #if CONFIG_EXT_IBC_MODES
   uint16_t *ibc_pred;
 #endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  // TFlite interpreter of the thread for the NN reconstruction of transform
+  // blocks.
+  struct NnReconCache *nn_recon_cache;
+#endif  // CONFIG_NN_RECON
 
   ENTROPY_CONTEXT *above_context[MAX_MB_PLANE];
   ENTROPY_CONTEXT left_context[MAX_MB_PLANE][MAX_MIB_SIZE];
@@ -1232,6 +1290,13 @@ typedef struct macroblockd {
 
   CONV_BUF_TYPE *tmp_conv_dst;
   uint8_t *tmp_obmc_bufs[2];
+#if CONFIG_ADAPT_FILTER_INTRA
+  // Coefficient cache used by the encoder; NULL in the decoder.
+  ADAPT_FILTER_INTRA_CACHE *adapt_filter_intra_cache;
+#endif  // CONFIG_ADAPT_FILTER_INTRA
+#if CONFIG_DERIVED_INTRA_MODE
+  DERIVED_INTRA_MODE_CACHE derived_intra_mode_cache;
+#endif  // CONFIG_DERIVED_INTRA_MODE
 } MACROBLOCKD;
 
 static INLINE int is_cur_buf_hbd(const MACROBLOCKD *xd) {
@@ -2021,8 +2086,22 @@ void av1_get_uv_mode_cdf_ml(const MACROBLOCKD *xd, PREDICTION_MODE y_mode,
 
 #if CONFIG_DERIVED_INTRA_MODE
 int av1_enable_derived_intra_mode(const MACROBLOCKD *xd, int bsize);
-int av1_get_derived_intra_mode(const MACROBLOCKD *xd, int bsize,
-                               MB_MODE_INFO *mbmi);
+// Returns the derived intra mode of the current block, or INTRA_MODES if it
+// is not available. The result is cached in xd until the next call to
+// av1_reset_derived_intra_mode_cache().
+int av1_get_derived_intra_mode(MACROBLOCKD *xd, int bsize, MB_MODE_INFO *mbmi);
+
+// Must be called whenever the pixels around the current block may change,
+// i.e. whenever a new block is set up.
+static INLINE void av1_reset_derived_intra_mode_cache(MACROBLOCKD *xd) {
+  xd->derived_intra_mode_cache.valid = 0;
+}
+
+// Returns the ascending ratio (dy / dx) thresholds that reproduce the
+// histogram bins of av1_derived_intra_grad_hist_c() without atanf(): entry 0
+// separates the steep gradients that wrap around to bin 0, and a ratio at or
+// above entries 1 to k falls into bin DERIVED_INTRA_HIST_BINS - 1 - k.
+const float *av1_get_derived_intra_angle_thresholds(void);
 #endif  // CONFIG_DERIVED_INTRA_MODE
 
 #if CONFIG_MODE_DEP_INTRA_TX || CONFIG_MODE_DEP_INTER_TX
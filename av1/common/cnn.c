@@ -40,28 +40,81 @@ static float identity(float x) { return x; }
 
 typedef struct {
   int allocsize;
+  // 1 + index of the scratch tensor slot holding buf[0], or 0 if buf[0] was
+  // allocated from the heap.
+  int scratch_slot;
   int channels;
   int width, height, stride;
   float *buf[CNN_MAX_CHANNELS];
 } TENSOR;
 
+// Hands out the memory of intermediate tensors. If a restoration scratch is
+// attached, its tensor slots are used before falling back to the heap.
+typedef struct {
+  RestorationScratch *scratch;
+  int slots_in_use;  // Bit mask of the scratch tensor slots in use.
+} TENSOR_POOL;
+
 static void init_tensor(TENSOR *tensor) { memset(tensor, 0, sizeof(*tensor)); }
 
-static void free_tensor(TENSOR *tensor) {
+static void free_tensor(TENSOR_POOL *pool, TENSOR *tensor) {
   if (tensor->allocsize) {
-    aom_free(tensor->buf[0]);
+    if (tensor->scratch_slot)
+      pool->slots_in_use &= ~(1 << (tensor->scratch_slot - 1));
+    else
+      aom_free(tensor->buf[0]);
     tensor->buf[0] = NULL;
     tensor->allocsize = 0;
+    tensor->scratch_slot = 0;
+  }
+}
+
+// Picks the free scratch slot to hold the given number of bytes: the smallest
+// one that is large enough, or else the largest one. Returns -1 if all slots
+// are in use.
+static int find_scratch_slot(const TENSOR_POOL *pool, size_t bytes) {
+  int best = -1;
+  for (int i = 0; i < RST_SCRATCH_CNN_TENSORS; ++i) {
+    if (pool->slots_in_use & (1 << i)) continue;
+    if (best < 0) {
+      best = i;
+      continue;
+    }
+    const size_t size = pool->scratch->size[RST_SCRATCH_CNN_TENSOR + i];
+    const size_t best_size = pool->scratch->size[RST_SCRATCH_CNN_TENSOR + best];
+    if (best_size >= bytes ? size >= bytes && size < best_size
+                           : size > best_size) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+static float *alloc_tensor_buf(TENSOR_POOL *pool, TENSOR *tensor,
+                               size_t bytes) {
+  tensor->scratch_slot = 0;
+  if (pool->scratch) {
+    const int slot = find_scratch_slot(pool, bytes);
+    if (slot >= 0) {
+      float *buf = (float *)av1_rst_scratch_get(
+          pool->scratch, RST_SCRATCH_CNN_TENSOR + slot, bytes);
+      if (buf) {
+        pool->slots_in_use |= 1 << slot;
+        tensor->scratch_slot = slot + 1;
+        return buf;
+      }
+    }
   }
+  return (float *)aom_malloc(bytes);
 }
 
-static void realloc_tensor(TENSOR *tensor, int channels, int width,
-                           int height) {
+static void realloc_tensor(TENSOR_POOL *pool, TENSOR *tensor, int channels,
+                           int width, int height) {
   const int newallocsize = channels * width * height;
   if (tensor->allocsize < newallocsize) {
-    free_tensor(tensor);
-    tensor->buf[0] =
-        (float *)aom_malloc(sizeof(*tensor->buf[0]) * newallocsize);
+    free_tensor(pool, tensor);
+    tensor->buf[0] = alloc_tensor_buf(pool, tensor,
+                                      sizeof(*tensor->buf[0]) * newallocsize);
     tensor->allocsize = newallocsize;
   }
   tensor->width = width;
@@ -96,6 +149,7 @@ static void copy_tensor(const TENSOR *src, int copy_channels, int dst_offset,
 static void assign_tensor(TENSOR *tensor, float *buf[CNN_MAX_CHANNELS],
                           int channels, int width, int height, int stride) {
   tensor->allocsize = 0;
+  tensor->scratch_slot = 0;
   tensor->channels = channels;
   tensor->width = width;
   tensor->height = height;
@@ -115,7 +169,8 @@ static void swap_tensor(TENSOR *t1, TENSOR *t2) {
 
 // The concatenated tensor goes into dst with first the channels in
 // original dst followed by the channels in the src
-static void concat_tensor(const TENSOR *src, TENSOR *dst) {
+static void concat_tensor(TENSOR_POOL *pool, const TENSOR *src,
+                          TENSOR *dst) {
   assert(src->width == dst->width);
   assert(src->height == dst->height);
 
@@ -126,11 +181,11 @@ static void concat_tensor(const TENSOR *src, TENSOR *dst) {
     TENSOR t;
     init_tensor(&t);
     // allocate new buffers and copy first the dst channels
-    realloc_tensor(&t, channels, dst->width, dst->height);
+    realloc_tensor(pool, &t, channels, dst->width, dst->height);
     copy_tensor(dst, dst->channels, 0, &t);
     // Swap the tensors and free the old buffers
     swap_tensor(dst, &t);
-    free_tensor(&t);
+    free_tensor(pool, &t);
   }
   for (int c = 1; c < channels; ++c)
     dst->buf[c] = &dst->buf[0][c * dst->width * dst->height];
@@ -333,7 +388,8 @@ void av1_cnn_activate_c(float **output, int channels, int width, int height,
   }
 }
 
-static void copy_active_tensor_to_branches(const TENSOR *layer_active_tensor,
+static void copy_active_tensor_to_branches(TENSOR_POOL *pool,
+                                           const TENSOR *layer_active_tensor,
                                            const CNN_LAYER_CONFIG *layer_config,
                                            int branch, TENSOR branch_output[]) {
   const CNN_BRANCH_CONFIG *branch_config = &layer_config->branch_config;
@@ -345,7 +401,7 @@ static void copy_active_tensor_to_branches(const TENSOR *layer_active_tensor,
       int copy_channels = branch_config->channels_to_copy > 0
                               ? branch_config->channels_to_copy
                               : layer_active_tensor->channels;
-      realloc_tensor(&branch_output[b], copy_channels,
+      realloc_tensor(pool, &branch_output[b], copy_channels,
                      layer_active_tensor->width, layer_active_tensor->height);
       copy_tensor(layer_active_tensor, copy_channels, 0, &branch_output[b]);
     }
@@ -844,6 +900,7 @@ void av1_cnn_predict_c(const float **input, int in_width, int in_height,
                        CNN_MULTI_OUT *output_struct) {
   TENSOR tensor1[CNN_MAX_BRANCHES] = { 0 };
   TENSOR tensor2[CNN_MAX_BRANCHES] = { 0 };
+  TENSOR_POOL pool = { thread_data->scratch, 0 };
 
   float **output[CNN_MAX_BRANCHES];
   const int *out_chs = output_struct->output_channels;
@@ -884,10 +941,10 @@ void av1_cnn_predict_c(const float **input, int in_width, int in_height,
                            &o_height);
     const int output_num = layer_config->output_num;
     if (output_num == -1) {  // Non-output layer
-      realloc_tensor(&tensor2[branch], layer_config->out_channels, o_width,
-                     o_height);
+      realloc_tensor(&pool, &tensor2[branch], layer_config->out_channels,
+                     o_width, o_height);
     } else {  // Output layer
-      free_tensor(&tensor2[branch]);
+      free_tensor(&pool, &tensor2[branch]);
       assign_tensor(&tensor2[branch], output[output_num],
                     layer_config->out_channels, o_width, o_height,
                     out_stride[output_num]);
@@ -899,8 +956,8 @@ void av1_cnn_predict_c(const float **input, int in_width, int in_height,
                    !(branch_config->branches_to_combine & (1 << branch))));
 
     if (layer_config->branch_copy_type == BRANCH_INPUT) {
-      copy_active_tensor_to_branches(&tensor1[branch], layer_config, branch,
-                                     tensor2);
+      copy_active_tensor_to_branches(&pool, &tensor1[branch], layer_config,
+                                     branch, tensor2);
     }
     // Check consistency of input and output channels
     assert(tensor1[branch].channels == layer_config->in_channels);
@@ -927,8 +984,8 @@ void av1_cnn_predict_c(const float **input, int in_width, int in_height,
     }
 
     if (layer_config->branch_copy_type == BRANCH_OUTPUT) {
-      copy_active_tensor_to_branches(&tensor2[branch], layer_config, branch,
-                                     tensor2);
+      copy_active_tensor_to_branches(&pool, &tensor2[branch], layer_config,
+                                     branch, tensor2);
     }
 
     // Add tensors from other branches if needed
@@ -964,7 +1021,7 @@ void av1_cnn_predict_c(const float **input, int in_width, int in_height,
           if ((branch_config->branches_to_combine & (1 << b)) && b != branch) {
             assert(check_tensor_equal_dims(&tensor2[b], &tensor2[branch]));
             assert(tensor2[b].channels > 0);
-            concat_tensor(&tensor2[b], &tensor2[branch]);
+            concat_tensor(&pool, &tensor2[b], &tensor2[branch]);
           }
         }
       } else {  // Output layer
@@ -994,17 +1051,30 @@ void av1_cnn_predict_c(const float **input, int in_width, int in_height,
     }
 
     if (layer_config->branch_copy_type == BRANCH_COMBINED) {
-      copy_active_tensor_to_branches(&tensor2[branch], layer_config, branch,
-                                     tensor2);
+      copy_active_tensor_to_branches(&pool, &tensor2[branch], layer_config,
+                                     branch, tensor2);
     }
   }
 
   for (int b = 0; b < CNN_MAX_BRANCHES; ++b) {
-    free_tensor(&tensor1[b]);
-    free_tensor(&tensor2[b]);
+    free_tensor(&pool, &tensor1[b]);
+    free_tensor(&pool, &tensor2[b]);
   }
 }
 
+// Returns a buffer from the given scratch slot if thread_data carries a
+// restoration scratch, or from the heap otherwise.
+static float *get_buf(const CNN_THREAD_DATA *thread_data, int slot,
+                      size_t bytes) {
+  if (thread_data->scratch)
+    return (float *)av1_rst_scratch_get(thread_data->scratch, slot, bytes);
+  return (float *)aom_malloc(bytes);
+}
+
+static void release_buf(const CNN_THREAD_DATA *thread_data, float *buf) {
+  if (!thread_data->scratch) aom_free(buf);
+}
+
 // Assume output already has proper allocation
 // Assume input image buffers all have same resolution and strides
 void av1_cnn_predict_img_multi_out(uint8_t **dgd, int width, int height,
@@ -1018,7 +1088,8 @@ void av1_cnn_predict_img_multi_out(uint8_t **dgd, int width, int height,
   const int in_channels = cnn_config->layer_config[0].in_channels;
   float *inputs[CNN_MAX_CHANNELS];
   float *input_ =
-      (float *)aom_malloc(in_width * in_height * in_channels * sizeof(*input_));
+      get_buf(thread_data, RST_SCRATCH_CNN_INPUT,
+              in_width * in_height * in_channels * sizeof(*input_));
   const int in_stride = in_width;
 
   for (int c = 0; c < in_channels; ++c) {
@@ -1056,7 +1127,7 @@ void av1_cnn_predict_img_multi_out(uint8_t **dgd, int width, int height,
   av1_cnn_predict((const float **)inputs, in_width, in_height, in_stride,
                   cnn_config, thread_data, output);
 
-  aom_free(input_);
+  release_buf(thread_data, input_);
 }
 
 // Assume output already has proper allocation
@@ -1074,7 +1145,8 @@ void av1_cnn_predict_img_multi_out_highbd(uint16_t **dgd, int width, int height,
   const int in_channels = cnn_config->layer_config[0].in_channels;
   float *inputs[CNN_MAX_CHANNELS];
   float *input_ =
-      (float *)aom_malloc(in_width * in_height * in_channels * sizeof(*input_));
+      get_buf(thread_data, RST_SCRATCH_CNN_INPUT,
+              in_width * in_height * in_channels * sizeof(*input_));
   const int in_stride = in_width;
 
   for (int c = 0; c < in_channels; ++c) {
@@ -1113,7 +1185,7 @@ void av1_cnn_predict_img_multi_out_highbd(uint16_t **dgd, int width, int height,
   av1_cnn_predict((const float **)inputs, in_width, in_height, in_stride,
                   cnn_config, thread_data, output);
 
-  aom_free(input_);
+  release_buf(thread_data, input_);
 }
 
 // Assume output already has proper allocation
@@ -1170,7 +1242,8 @@ void av1_restore_cnn_img(uint8_t *dgd, int width, int height, int stride,
   assert(out_channels == 1);
 
   const int out_stride = width;
-  float *output = (float *)aom_malloc(width * height * sizeof(*output));
+  float *output = get_buf(thread_data, RST_SCRATCH_CNN_OUTPUT,
+                          width * height * sizeof(*output));
   av1_cnn_predict_img(&dgd, width, height, stride, cnn_config, thread_data,
                       &output, out_stride);
 
@@ -1186,7 +1259,7 @@ void av1_restore_cnn_img(uint8_t *dgd, int width, int height, int stride,
         dgd[i * stride + j] =
             clip_pixel((int)(output[i * out_stride + j] * max_val + 0.5));
   }
-  aom_free(output);
+  release_buf(thread_data, output);
 }
 
 void av1_restore_cnn_img_highbd(uint16_t *dgd, int width, int height,
@@ -1207,7 +1280,8 @@ void av1_restore_cnn_img_highbd(uint16_t *dgd, int width, int height,
   // For restoration, we only want one channel outputted.
   assert(out_channels == 1);
 
-  float *output = (float *)aom_malloc(width * height * sizeof(*output));
+  float *output = get_buf(thread_data, RST_SCRATCH_CNN_OUTPUT,
+                          width * height * sizeof(*output));
   const int out_stride = width;
   av1_cnn_predict_img_highbd(&dgd, width, height, stride, cnn_config,
                              thread_data, bit_depth, &output, out_stride);
@@ -1225,15 +1299,19 @@ void av1_restore_cnn_img_highbd(uint16_t *dgd, int width, int height,
         dgd[i * stride + j] = clip_pixel_highbd(
             (int)(output[i * out_stride + j] * max_val + 0.5), bit_depth);
   }
-  aom_free(output);
+  release_buf(thread_data, output);
 }
 
-void av1_restore_cnn_plane_part(const AV1_COMMON *cm,
-                                const CNN_CONFIG *cnn_config,
+void av1_restore_cnn_plane_part(AV1_COMMON *cm, const CNN_CONFIG *cnn_config,
                                 const CNN_THREAD_DATA *thread_data, int plane,
                                 int start_x, int start_y, int width,
                                 int height) {
   YV12_BUFFER_CONFIG *buf = &cm->cur_frame->buf;
+  CNN_THREAD_DATA rst_thread_data = *thread_data;
+  rst_thread_data.scratch = &cm->rst_scratch;
+  av1_rst_scratch_set_frame_size(&cm->rst_scratch, buf->y_width,
+                                 buf->y_height);
+  thread_data = &rst_thread_data;
 
   assert(start_x >= 0 && start_x + width <= buf->y_crop_width);
   assert(start_y >= 0 && start_y + height <= buf->y_crop_height);
@@ -1294,11 +1372,17 @@ void av1_restore_cnn_plane_part(const AV1_COMMON *cm,
       default: assert(0 && "Invalid plane index");
     }
   }
+  av1_rst_scratch_trim(&cm->rst_scratch);
 }
 
-void av1_restore_cnn_plane(const AV1_COMMON *cm, const CNN_CONFIG *cnn_config,
+void av1_restore_cnn_plane(AV1_COMMON *cm, const CNN_CONFIG *cnn_config,
                            int plane, const CNN_THREAD_DATA *thread_data) {
   YV12_BUFFER_CONFIG *buf = &cm->cur_frame->buf;
+  CNN_THREAD_DATA rst_thread_data = *thread_data;
+  rst_thread_data.scratch = &cm->rst_scratch;
+  av1_rst_scratch_set_frame_size(&cm->rst_scratch, buf->y_width,
+                                 buf->y_height);
+  thread_data = &rst_thread_data;
   if (cm->seq_params.use_highbitdepth) {
     switch (plane) {
       case AOM_PLANE_Y:
@@ -1342,4 +1426,5 @@ void av1_restore_cnn_plane(const AV1_COMMON *cm, const CNN_CONFIG *cnn_config,
       default: assert(0 && "Invalid plane index");
     }
   }
+  av1_rst_scratch_trim(&cm->rst_scratch);
 }
@@ -19,6 +19,7 @@ extern "C" {
 #include <math.h>
 
 #include "aom_util/aom_thread.h"
+#include "av1/common/restoration_scratch.h"
 #include "config/av1_rtcd.h"
 
 struct AV1Common;
@@ -153,6 +154,9 @@ struct CNN_CONFIG {
 struct CNN_THREAD_DATA {
   int num_workers;
   AVxWorker *workers;
+  // If set, the input, output and intermediate tensors are kept in this
+  // scratch between calls instead of being allocated each time.
+  RestorationScratch *scratch;
 };
 
 struct CNN_MULTI_OUT {
@@ -201,11 +205,10 @@ void av1_restore_cnn_img_highbd(uint16_t *dgd, int width, int height,
                                 int bit_depth);
 
 // Restoration functions that work on current frame buffer in AV1_COMMON
-// directly for convenience.
-void av1_restore_cnn_plane(const struct AV1Common *cm,
-                           const CNN_CONFIG *cnn_config, int plane,
-                           const CNN_THREAD_DATA *thread_data);
-void av1_restore_cnn_plane_part(const struct AV1Common *cm,
+// directly for convenience. Buffers are kept in cm->rst_scratch.
+void av1_restore_cnn_plane(struct AV1Common *cm, const CNN_CONFIG *cnn_config,
+                           int plane, const CNN_THREAD_DATA *thread_data);
+void av1_restore_cnn_plane_part(struct AV1Common *cm,
                                 const CNN_CONFIG *cnn_config,
                                 const CNN_THREAD_DATA *thread_data, int plane,
                                 int start_x, int start_y, int width,
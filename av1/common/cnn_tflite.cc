@@ -9,6 +9,7 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <new>
 #include <vector>
 
 #include "av1/common/cnn_tflite.h"
@@ -66,9 +67,11 @@ static const unsigned char *get_inter_model_from_qindex(int qindex) {
   }
 }
 
-// Builds and returns the TFlite interpreter.
+// Builds and returns the TFlite interpreter, for 'batch_size' input images of
+// the given size.
 static std::unique_ptr<tflite::Interpreter> get_tflite_interpreter(
-    int qindex, int width, int height, int num_threads, int is_intra_only) {
+    int qindex, int width, int height, int num_threads, int is_intra_only,
+    int batch_size) {
   const unsigned char *const model_tflite_data =
       is_intra_only ? get_intra_model_from_qindex(qindex)
                     : get_inter_model_from_qindex(qindex);
@@ -86,7 +89,7 @@ static std::unique_ptr<tflite::Interpreter> get_tflite_interpreter(
 
   // Dimension order: batch_size, height, width, num_channels.
   // Note: height comes before width here!
-  const std::vector<int> in_out_dims = { 1, height, width, 1 };
+  const std::vector<int> in_out_dims = { batch_size, height, width, 1 };
   // We only need to resize the input tensor. All other tensors (including
   // output tensor) will be resized automatically.
   if (interpreter->ResizeInputTensor(interpreter->inputs()[0], in_out_dims) !=
@@ -107,8 +110,8 @@ extern "C" int av1_restore_cnn_img_tflite(int qindex, const uint8_t *dgd,
                                           uint8_t *rst, int rst_stride,
                                           int num_threads, int is_intra_only) {
   // TODO(dandan): Change the code to get interpreter for guided CNN model.
-  std::unique_ptr<tflite::Interpreter> interpreter =
-      get_tflite_interpreter(qindex, width, height, num_threads, is_intra_only);
+  std::unique_ptr<tflite::Interpreter> interpreter = get_tflite_interpreter(
+      qindex, width, height, num_threads, is_intra_only, 1);
 
   // Prepare input.
   const float max_val = 255.0f;
@@ -151,8 +154,8 @@ extern "C" int av1_restore_cnn_img_tflite_highbd(int qindex,
                                                  int num_threads, int bit_depth,
                                                  int is_intra_only) {
   // TODO(dandan): Change the code to get interpreter for guided CNN model.
-  std::unique_ptr<tflite::Interpreter> interpreter =
-      get_tflite_interpreter(qindex, width, height, num_threads, is_intra_only);
+  std::unique_ptr<tflite::Interpreter> interpreter = get_tflite_interpreter(
+      qindex, width, height, num_threads, is_intra_only, 1);
 
   // Prepare input.
   const auto max_val = static_cast<float>((1 << bit_depth) - 1);
@@ -189,62 +192,123 @@ extern "C" int av1_restore_cnn_img_tflite_highbd(int qindex,
   return 1;
 }
 
-extern "C" void av1_restore_cnn_tflite(const AV1_COMMON *cm, int num_threads) {
-  YV12_BUFFER_CONFIG *buf = &cm->cur_frame->buf;
-  const int plane_from = AOM_PLANE_Y;
-  const int plane_to = AOM_PLANE_Y;
-  const int is_intra_only = frame_is_intra_only(cm);
-  for (int plane = plane_from; plane <= plane_to; ++plane) {
-    if (cm->seq_params.use_highbitdepth) {
-      switch (plane) {
-        case AOM_PLANE_Y:
-          av1_restore_cnn_img_tflite_highbd(
-              cm->base_qindex, CONVERT_TO_SHORTPTR(buf->y_buffer),
-              buf->y_crop_width, buf->y_crop_height, buf->y_stride,
-              CONVERT_TO_SHORTPTR(buf->y_buffer), buf->y_stride, num_threads,
-              cm->seq_params.bit_depth, is_intra_only);
-          break;
-        case AOM_PLANE_U:
-          av1_restore_cnn_img_tflite_highbd(
-              cm->base_qindex, CONVERT_TO_SHORTPTR(buf->u_buffer),
-              buf->uv_crop_width, buf->uv_crop_height, buf->uv_stride,
-              CONVERT_TO_SHORTPTR(buf->u_buffer), buf->uv_stride, num_threads,
-              cm->seq_params.bit_depth, is_intra_only);
-          break;
-        case AOM_PLANE_V:
-          av1_restore_cnn_img_tflite_highbd(
-              cm->base_qindex, CONVERT_TO_SHORTPTR(buf->v_buffer),
-              buf->uv_crop_width, buf->uv_crop_height, buf->uv_stride,
-              CONVERT_TO_SHORTPTR(buf->u_buffer), buf->uv_stride, num_threads,
-              cm->seq_params.bit_depth, is_intra_only);
-          break;
-        default: assert(0 && "Invalid plane index");
+// Restores planes of the same size in place, with one interpreter invoke: each
+// plane is one image of the input batch. 'Pixel' is uint8_t or uint16_t.
+// Returns true on success.
+template <typename Pixel>
+static int restore_planes_tflite(int qindex, Pixel *const *planes,
+                                 int num_planes, int width, int height,
+                                 int stride, int num_threads, int bit_depth,
+                                 int is_intra_only) {
+  std::unique_ptr<tflite::Interpreter> interpreter = get_tflite_interpreter(
+      qindex, width, height, num_threads, is_intra_only, num_planes);
+  if (interpreter == nullptr) return 0;
+
+  // Prepare input.
+  const auto max_val = static_cast<float>((1 << bit_depth) - 1);
+  const int in_stride = width;
+  const int in_size = width * height;
+  auto input = interpreter->typed_input_tensor<float>(0);
+  for (int p = 0; p < num_planes; ++p) {
+    const Pixel *dgd = planes[p];
+    float *plane_input = input + p * in_size;
+    for (int r = 0; r < height; ++r) {
+      for (int c = 0; c < width; ++c) {
+        plane_input[r * in_stride + c] =
+            static_cast<float>(dgd[r * stride + c]) / max_val;
       }
-    } else {
-      assert(cm->seq_params.bit_depth == 8);
-      switch (plane) {
-        case AOM_PLANE_Y:
-          av1_restore_cnn_img_tflite(cm->base_qindex, buf->y_buffer,
-                                     buf->y_crop_width, buf->y_crop_height,
-                                     buf->y_stride, buf->y_buffer,
-                                     buf->y_stride, num_threads, is_intra_only);
-          break;
-        case AOM_PLANE_U:
-          av1_restore_cnn_img_tflite(
-              cm->base_qindex, buf->u_buffer, buf->uv_crop_width,
-              buf->uv_crop_height, buf->uv_stride, buf->u_buffer,
-              buf->uv_stride, num_threads, is_intra_only);
-          break;
-        case AOM_PLANE_V:
-          av1_restore_cnn_img_tflite(
-              cm->base_qindex, buf->v_buffer, buf->uv_crop_width,
-              buf->uv_crop_height, buf->uv_stride, buf->v_buffer,
-              buf->uv_stride, num_threads, is_intra_only);
-          break;
-        default: assert(0 && "Invalid plane index");
+    }
+  }
+
+  // Invoke TFlite inference.
+  tflite::ErrorReporter *reporter = tflite::DefaultErrorReporter();
+  auto status = interpreter->Invoke();
+  if (status != kTfLiteOk) {
+    reporter->Report("Failed at interpreter invocation");
+    return 0;
+  }
+
+  // Use the output to restore the planes in place.
+  const auto output = interpreter->typed_output_tensor<float>(0);
+  const int out_stride = width;
+  for (int p = 0; p < num_planes; ++p) {
+    Pixel *dgd = planes[p];
+    const float *plane_output = output + p * in_size;
+    for (int r = 0; r < height; ++r) {
+      for (int c = 0; c < width; ++c) {
+        const int residue =
+            static_cast<int>(plane_output[r * out_stride + c] * max_val + 0.5);
+        dgd[r * stride + c] = static_cast<Pixel>(
+            clip_pixel_highbd(dgd[r * stride + c] + residue, bit_depth));
       }
     }
   }
+  return 1;
+}
+
+// Planes of the current frame restored by one interpreter invoke.
+struct CnnPlanesJob {
+  const AV1_COMMON *cm;
+  int plane_start;
+  int num_planes;
+  int num_threads;
+};
+
+static int restore_planes_job(void *arg1, void *arg2) {
+  (void)arg2;
+  const CnnPlanesJob *job = static_cast<const CnnPlanesJob *>(arg1);
+  const AV1_COMMON *cm = job->cm;
+  const YV12_BUFFER_CONFIG *buf = &cm->cur_frame->buf;
+  const int is_uv = job->plane_start > AOM_PLANE_Y;
+  const int width = buf->crop_widths[is_uv];
+  const int height = buf->crop_heights[is_uv];
+  const int stride = buf->strides[is_uv];
+  if (cm->seq_params.use_highbitdepth) {
+    uint16_t *planes[MAX_MB_PLANE];
+    for (int p = 0; p < job->num_planes; ++p)
+      planes[p] = CONVERT_TO_SHORTPTR(buf->buffers[job->plane_start + p]);
+    return restore_planes_tflite(cm->base_qindex, planes, job->num_planes,
+                                 width, height, stride, job->num_threads,
+                                 cm->seq_params.bit_depth,
+                                 frame_is_intra_only(cm));
+  }
+  assert(cm->seq_params.bit_depth == 8);
+  return restore_planes_tflite(cm->base_qindex,
+                               &buf->buffers[job->plane_start],
+                               job->num_planes, width, height, stride,
+                               job->num_threads, 8, frame_is_intra_only(cm));
+}
+
+extern "C" void av1_restore_cnn_tflite(const AV1_COMMON *cm, int num_threads,
+                                       AVxWorker *worker) {
+  const int num_planes = av1_num_planes(cm);
+  CnnPlanesJob luma_job = { cm, AOM_PLANE_Y, 1, num_threads };
+  if (num_planes == 1) {
+    restore_planes_job(&luma_job, nullptr);
+    return;
+  }
+
+  // U and V have the same size, so they go through the model as one batch of
+  // two images.
+  CnnPlanesJob chroma_job = { cm, AOM_PLANE_U, 2, num_threads };
+  if (worker == nullptr) {
+    restore_planes_job(&luma_job, nullptr);
+    restore_planes_job(&chroma_job, nullptr);
+    return;
+  }
+
+  // Restore chroma on the worker while luma is restored on this thread. The
+  // chroma batch has half the samples of luma, so it gets a third of the
+  // interpreter threads.
+  luma_job.num_threads = AOMMAX(num_threads * 2 / 3, 1);
+  chroma_job.num_threads = AOMMAX(num_threads - luma_job.num_threads, 1);
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  worker->hook = restore_planes_job;
+  worker->data1 = &chroma_job;
+  worker->data2 = nullptr;
+  winterface->launch(worker);
+  restore_planes_job(&luma_job, nullptr);
+  winterface->sync(worker);
 }
 #endif  // CONFIG_CNN_RESTORATION || CONFIG_LOOP_RESTORE_CNN
 
@@ -280,11 +344,42 @@ static std::unique_ptr<tflite::Interpreter> get_nn_recon_tflite_interpreter(
   return interpreter;
 }
 
-extern "C" int av1_cnn_recon_tflite(uint8_t *dst, int dst_stride, int height,
-                                    int width) {
-  const int num_threads = 1;
-  std::unique_ptr<tflite::Interpreter> interpreter =
-      get_nn_recon_tflite_interpreter(width, height, num_threads);
+// Interpreter with its tensors allocated for one block size. The model is run
+// once per 16x16 transform block, so building it for every block dominated the
+// reconstruction time. Each encoder / decoder thread owns one in its thread
+// data, as TFlite interpreters must not be invoked concurrently.
+struct NnReconCache {
+  std::unique_ptr<tflite::Interpreter> interpreter;
+  int width = 0;
+  int height = 0;
+};
+
+extern "C" NnReconCache *av1_nn_recon_cache_alloc(void) {
+  return new (std::nothrow) NnReconCache();
+}
+
+extern "C" void av1_nn_recon_cache_free(NnReconCache *cache) { delete cache; }
+
+// Returns the interpreter of 'cache', built on first use.
+static tflite::Interpreter *get_cached_nn_recon_interpreter(
+    NnReconCache *cache, int width, int height) {
+  if (cache->interpreter == nullptr || cache->width != width ||
+      cache->height != height) {
+    const int num_threads = 1;
+    cache->interpreter =
+        get_nn_recon_tflite_interpreter(width, height, num_threads);
+    cache->width = width;
+    cache->height = height;
+  }
+  return cache->interpreter.get();
+}
+
+extern "C" int av1_cnn_recon_tflite(NnReconCache *cache, uint8_t *dst,
+                                    int dst_stride, int height, int width) {
+  assert(cache != nullptr);
+  tflite::Interpreter *const interpreter =
+      get_cached_nn_recon_interpreter(cache, width, height);
+  if (interpreter == nullptr) return 0;
 
   // Prepare input.
   const int in_stride = width;
@@ -53,11 +53,26 @@ int av1_restore_cnn_img_tflite_highbd(int qindex, const uint16_t *dgd,
 
 struct AV1Common;
 
-// Restore current frame buffer in 'cm' in-place with a CNN model using TFlite.
-void av1_restore_cnn_tflite(const struct AV1Common *cm, int num_threads);
+// Restore all planes of the current frame buffer in 'cm' in-place with a CNN
+// model using TFlite. U and V are restored as one batch. If 'worker' is not
+// NULL, it must own a thread, and restores chroma while the calling thread
+// restores luma.
+void av1_restore_cnn_tflite(const struct AV1Common *cm, int num_threads,
+                            AVxWorker *worker);
 
-// Uses CNN model for txfm reconstruction
-int av1_cnn_recon_tflite(uint8_t *dst, int dst_stride, int height, int width);
+struct NnReconCache;
+
+// Allocates the TFlite interpreter cache of one encoder or decoder thread.
+// Returns NULL on failure.
+struct NnReconCache *av1_nn_recon_cache_alloc(void);
+
+// Frees 'cache' and its interpreter. 'cache' may be NULL.
+void av1_nn_recon_cache_free(struct NnReconCache *cache);
+
+// Uses CNN model for txfm reconstruction, with the interpreter in 'cache' of
+// the calling thread.
+int av1_cnn_recon_tflite(struct NnReconCache *cache, uint8_t *dst,
+                         int dst_stride, int height, int width);
 
 #ifdef __cplusplus
 }
@@ -429,14 +429,25 @@ int av1_get_palette_color_index_context(const uint8_t *color_map, int stride,
   fc->model.dense_features = fc->model##_dense_features;                       \
   fc->model.output = fc->model##_output;
 
-static INLINE void av1_config_entropy_models(FRAME_CONTEXT *const fc) {
+static INLINE void av1_config_entropy_models(FRAME_CONTEXT *const fc,
+                                             int sb_update) {
   SETUP_SPARSE_FEATURE_POINTERS(intra_y_mode, 0);
   SETUP_SPARSE_FEATURE_POINTERS(intra_y_mode, 1);
   SETUP_MODEL_POINTERS(intra_y_mode);
+  fc->intra_y_mode.sb_update = sb_update;
 
   SETUP_SPARSE_FEATURE_POINTERS(intra_uv_mode, 0);
   SETUP_SPARSE_FEATURE_POINTERS(intra_uv_mode, 1);
   SETUP_MODEL_POINTERS(intra_uv_mode);
+  fc->intra_uv_mode.sb_update = sb_update;
+}
+
+// Applies the gradients accumulated over the superblock just coded, when the
+// models are updated once per superblock.
+static INLINE void av1_update_entropy_models_sb(FRAME_CONTEXT *const fc) {
+  if (!fc->intra_y_mode.sb_update) return;
+  av1_nn_update_em(&fc->intra_y_mode, fc->intra_y_mode.lr);
+  av1_nn_update_em(&fc->intra_uv_mode, fc->intra_uv_mode.lr);
 }
 #endif  // CONFIG_INTRA_ENTROPY
 
@@ -152,7 +152,8 @@ typedef enum {
   ROTATION_90,
   ROTATION_270,
   MIRROR_45,
-  MIRROR_135
+  MIRROR_135,
+  IBC_MODES
 } IBC_MODE;
 
 #define MAX_IBC_BLK_SIZE 128
@@ -14,12 +14,14 @@
 #include "av1/common/frame_buffers.h"
 #include "aom_mem/aom_mem.h"
 
-int av1_alloc_internal_frame_buffers(InternalFrameBufferList *list) {
+int av1_alloc_internal_frame_buffers(InternalFrameBufferList *list,
+                                     int num_extra_buffers) {
   assert(list != NULL);
+  assert(num_extra_buffers >= 0);
   av1_free_internal_frame_buffers(list);
 
   list->num_internal_frame_buffers =
-      AOM_MAXIMUM_REF_BUFFERS + AOM_MAXIMUM_WORK_BUFFERS;
+      AOM_MAXIMUM_REF_BUFFERS + AOM_MAXIMUM_WORK_BUFFERS + num_extra_buffers;
   list->int_fb = (InternalFrameBuffer *)aom_calloc(
       list->num_internal_frame_buffers, sizeof(*list->int_fb));
   if (list->int_fb == NULL) {
@@ -43,6 +45,50 @@ void av1_free_internal_frame_buffers(InternalFrameBufferList *list) {
   list->num_internal_frame_buffers = 0;
 }
 
+// Allocates the data of |int_fb| to at least |min_size| bytes. Returns 0 on
+// success.
+static int grow_internal_frame_buffer(InternalFrameBufferList *list,
+                                      InternalFrameBuffer *int_fb,
+                                      size_t min_size) {
+  if (int_fb->size >= min_size) return 0;
+  aom_free(int_fb->data);
+  // The data must be zeroed to fix a valgrind error from the C loop filter
+  // due to access uninitialized memory in frame border. It could be
+  // skipped if border were totally removed.
+  int_fb->data = (uint8_t *)aom_calloc(1, min_size);
+  if (!int_fb->data) {
+    int_fb->size = 0;
+    return -1;
+  }
+  int_fb->size = min_size;
+  ++list->num_allocs;
+  return 0;
+}
+
+int av1_reserve_internal_frame_buffers(InternalFrameBufferList *list,
+                                       size_t min_size) {
+  int i;
+
+  assert(list != NULL);
+
+  for (i = 0; i < list->num_internal_frame_buffers; ++i) {
+    if (grow_internal_frame_buffer(list, &list->int_fb[i], min_size)) return -1;
+  }
+  return 0;
+}
+
+size_t av1_internal_frame_buffers_size(const InternalFrameBufferList *list) {
+  size_t size = 0;
+  int i;
+
+  assert(list != NULL);
+
+  for (i = 0; i < list->num_internal_frame_buffers; ++i) {
+    size += list->int_fb[i].size;
+  }
+  return size;
+}
+
 void av1_zero_unused_internal_frame_buffers(InternalFrameBufferList *list) {
   int i;
 
@@ -68,17 +114,9 @@ int av1_get_frame_buffer(void *cb_priv, size_t min_size,
 
   if (i == int_fb_list->num_internal_frame_buffers) return -1;
 
-  if (int_fb_list->int_fb[i].size < min_size) {
-    aom_free(int_fb_list->int_fb[i].data);
-    // The data must be zeroed to fix a valgrind error from the C loop filter
-    // due to access uninitialized memory in frame border. It could be
-    // skipped if border were totally removed.
-    int_fb_list->int_fb[i].data = (uint8_t *)aom_calloc(1, min_size);
-    if (!int_fb_list->int_fb[i].data) {
-      int_fb_list->int_fb[i].size = 0;
-      return -1;
-    }
-    int_fb_list->int_fb[i].size = min_size;
+  if (grow_internal_frame_buffer(int_fb_list, &int_fb_list->int_fb[i],
+                                 min_size)) {
+    return -1;
   }
 
   fb->data = int_fb_list->int_fb[i].data;
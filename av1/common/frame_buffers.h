@@ -28,14 +28,28 @@ typedef struct InternalFrameBuffer {
 typedef struct InternalFrameBufferList {
   int num_internal_frame_buffers;
   InternalFrameBuffer *int_fb;
+  // The number of times the data of a frame buffer was allocated.
+  unsigned int num_allocs;
 } InternalFrameBufferList;
 
-// Initializes |list|. Returns 0 on success.
-int av1_alloc_internal_frame_buffers(InternalFrameBufferList *list);
+// Initializes |list| with the buffers of the frames of the decoder, and
+// |num_extra_buffers| more for other images, such as film grain output.
+// Returns 0 on success.
+int av1_alloc_internal_frame_buffers(InternalFrameBufferList *list,
+                                     int num_extra_buffers);
 
 // Free any data allocated to the frame buffers.
 void av1_free_internal_frame_buffers(InternalFrameBufferList *list);
 
+// Allocates the data of all the frame buffers of |list| to at least
+// |min_size| bytes, so that av1_get_frame_buffer() does not need to allocate
+// for frames of up to that size. Returns 0 on success.
+int av1_reserve_internal_frame_buffers(InternalFrameBufferList *list,
+                                       size_t min_size);
+
+// Returns the total size in bytes of the data of the frame buffers of |list|.
+size_t av1_internal_frame_buffers_size(const InternalFrameBufferList *list);
+
 // Zeros all unused internal frame buffers. In particular, this zeros the
 // frame borders. Call this function after a sequence header change to
 // re-initialize the frame borders for the different width, height, or bit
@@ -370,9 +370,11 @@ static void replace_block_alpha_highbd(Y_BUFFER_CONFIG tmp,
   }
 }
 
-// Dynamically allocate memory for a single buffer.
-static void mfqe_alloc_buf(Y_BUFFER_CONFIG *buf, int stride, int h, int w,
-                           int resize_factor) {
+// Get zeroed scratch memory for a single buffer. Returns 0 on allocation
+// failure.
+static int mfqe_alloc_buf(RestorationScratch *scratch, int slot,
+                          Y_BUFFER_CONFIG *buf, int stride, int h, int w,
+                          int resize_factor) {
   buf->stride = stride * resize_factor;
   buf->height = h * resize_factor;
   buf->width = w * resize_factor;
@@ -381,14 +383,19 @@ static void mfqe_alloc_buf(Y_BUFFER_CONFIG *buf, int stride, int h, int w,
   // in Gaussian Blur and resizing. buffer points to the start of the frame and
   // buffer_orig points to the originally allocated buffer including padding.
   int buf_bytes = buf->stride * (buf->height + 2 * MFQE_PADDING_SIZE);
-  buf->buffer_orig = aom_memalign(32, sizeof(uint8_t) * buf_bytes);
+  buf->buffer_orig =
+      av1_rst_scratch_get(scratch, slot, sizeof(uint8_t) * buf_bytes);
+  if (buf->buffer_orig == NULL) return 0;
   memset(buf->buffer_orig, 0, sizeof(uint8_t) * buf_bytes);
   buf->buffer = buf->buffer_orig + buf->stride * MFQE_PADDING_SIZE;
+  return 1;
 }
 
-// Dynamically allocate memory for a single buffer in high bitdepth version.
-static void mfqe_alloc_buf_highbd(Y_BUFFER_CONFIG *buf, int stride, int h,
-                                  int w, int resize_factor) {
+// Get zeroed scratch memory for a single buffer in high bitdepth version.
+// Returns 0 on allocation failure.
+static int mfqe_alloc_buf_highbd(RestorationScratch *scratch, int slot,
+                                 Y_BUFFER_CONFIG *buf, int stride, int h,
+                                 int w, int resize_factor) {
   buf->stride = stride * resize_factor;
   buf->height = h * resize_factor;
   buf->width = w * resize_factor;
@@ -397,81 +404,75 @@ static void mfqe_alloc_buf_highbd(Y_BUFFER_CONFIG *buf, int stride, int h,
   // in Gaussian Blur and resizing. buffer points to the start of the frame and
   // buffer_orig points to the originally allocated buffer including padding.
   int buf_bytes = buf->stride * (buf->height + 2 * MFQE_PADDING_SIZE);
-  uint16_t *buffer_orig = aom_memalign(32, sizeof(uint16_t) * buf_bytes);
+  uint16_t *buffer_orig =
+      av1_rst_scratch_get(scratch, slot, sizeof(uint16_t) * buf_bytes);
+  if (buffer_orig == NULL) return 0;
   memset(buffer_orig, 0, sizeof(uint16_t) * buf_bytes);
   uint16_t *buffer = buffer_orig + buf->stride * MFQE_PADDING_SIZE;
 
   buf->buffer_orig = CONVERT_TO_BYTEPTR(buffer_orig);
   buf->buffer = CONVERT_TO_BYTEPTR(buffer);
+  return 1;
 }
 
-// Dynamically allocate memory to be used for av1_apply_loop_mfqe.
-static void mfqe_mem_alloc(Y_BUFFER_CONFIG *tmp, RefCntBuffer *ref_frames[],
-                           Y_BUFFER_CONFIG *tmp_low, Y_BUFFER_CONFIG *tmp_sub,
-                           Y_BUFFER_CONFIG *refs_low, Y_BUFFER_CONFIG *refs_sub,
-                           int resize_factor) {
-  mfqe_alloc_buf(tmp_low, tmp->stride, tmp->height, tmp->width, 1);
-  mfqe_alloc_buf(tmp_sub, tmp->stride, tmp->height, tmp->width, resize_factor);
+// Get the scratch memory used by av1_apply_loop_mfqe. Returns 0 on allocation
+// failure.
+static int mfqe_mem_alloc(RestorationScratch *scratch, Y_BUFFER_CONFIG *tmp,
+                          RefCntBuffer *ref_frames[], Y_BUFFER_CONFIG *tmp_low,
+                          Y_BUFFER_CONFIG *tmp_sub, Y_BUFFER_CONFIG *refs_low,
+                          Y_BUFFER_CONFIG *refs_sub, int resize_factor) {
+  int ok = mfqe_alloc_buf(scratch, RST_SCRATCH_MFQE_LOW, tmp_low, tmp->stride,
+                          tmp->height, tmp->width, 1);
+  ok = ok && mfqe_alloc_buf(scratch, RST_SCRATCH_MFQE_SUB, tmp_sub,
+                            tmp->stride, tmp->height, tmp->width,
+                            resize_factor);
 
   YV12_BUFFER_CONFIG *ref;
-  for (int i = 0; i < MFQE_NUM_REFS; i++) {
+  for (int i = 0; ok && i < MFQE_NUM_REFS; i++) {
     ref = &ref_frames[i]->buf;
-    mfqe_alloc_buf(&refs_low[i], ref->y_stride, ref->y_height, ref->y_width, 1);
-    mfqe_alloc_buf(&refs_sub[i], ref->y_stride, ref->y_height, ref->y_width,
-                   resize_factor);
+    ok = mfqe_alloc_buf(scratch, RST_SCRATCH_MFQE_LOW + 1 + i, &refs_low[i],
+                        ref->y_stride, ref->y_height, ref->y_width, 1);
+    ok = ok && mfqe_alloc_buf(scratch, RST_SCRATCH_MFQE_SUB + 1 + i,
+                              &refs_sub[i], ref->y_stride, ref->y_height,
+                              ref->y_width, resize_factor);
   }
+  return ok;
 }
 
-// Dynamically allocate memory to be used for av1_apply_loop_mfqe.
-static void mfqe_mem_alloc_highbd(
-    Y_BUFFER_CONFIG *tmp, RefCntBuffer *ref_frames[], Y_BUFFER_CONFIG *tmp_low,
-    Y_BUFFER_CONFIG *tmp_sub, Y_BUFFER_CONFIG *refs_low,
-    Y_BUFFER_CONFIG *refs_sub, int resize_factor) {
-  mfqe_alloc_buf_highbd(tmp_low, tmp->stride, tmp->height, tmp->width, 1);
-  mfqe_alloc_buf_highbd(tmp_sub, tmp->stride, tmp->height, tmp->width,
-                        resize_factor);
-
-  YV12_BUFFER_CONFIG *ref;
-  for (int i = 0; i < MFQE_NUM_REFS; i++) {
-    ref = &ref_frames[i]->buf;
-    mfqe_alloc_buf_highbd(&refs_low[i], ref->y_stride, ref->y_height,
-                          ref->y_width, 1);
-    mfqe_alloc_buf_highbd(&refs_sub[i], ref->y_stride, ref->y_height,
-                          ref->y_width, resize_factor);
-  }
-}
-
-// Free all of the dynamically allocated memory inside av1_apply_loop_mfqe.
-static void mfqe_mem_free(Y_BUFFER_CONFIG *tmp_low, Y_BUFFER_CONFIG *tmp_sub,
-                          Y_BUFFER_CONFIG *refs_low,
-                          Y_BUFFER_CONFIG *refs_sub) {
-  aom_free(tmp_low->buffer_orig);
-  aom_free(tmp_sub->buffer_orig);
-
-  for (int i = 0; i < MFQE_NUM_REFS; i++) {
-    aom_free(refs_low[i].buffer_orig);
-    aom_free(refs_sub[i].buffer_orig);
-  }
-}
-
-// Free all of the dynamically allocated memory inside av1_apply_loop_mfqe.
-static void mfqe_mem_free_highbd(Y_BUFFER_CONFIG *tmp_low,
+// Get the scratch memory used by av1_apply_loop_mfqe in high bitdepth
+// version. Returns 0 on allocation failure.
+static int mfqe_mem_alloc_highbd(RestorationScratch *scratch,
+                                 Y_BUFFER_CONFIG *tmp,
+                                 RefCntBuffer *ref_frames[],
+                                 Y_BUFFER_CONFIG *tmp_low,
                                  Y_BUFFER_CONFIG *tmp_sub,
                                  Y_BUFFER_CONFIG *refs_low,
-                                 Y_BUFFER_CONFIG *refs_sub) {
-  aom_free(CONVERT_TO_SHORTPTR(tmp_low->buffer_orig));
-  aom_free(CONVERT_TO_SHORTPTR(tmp_sub->buffer_orig));
+                                 Y_BUFFER_CONFIG *refs_sub, int resize_factor) {
+  int ok = mfqe_alloc_buf_highbd(scratch, RST_SCRATCH_MFQE_LOW, tmp_low,
+                                 tmp->stride, tmp->height, tmp->width, 1);
+  ok = ok && mfqe_alloc_buf_highbd(scratch, RST_SCRATCH_MFQE_SUB, tmp_sub,
+                                   tmp->stride, tmp->height, tmp->width,
+                                   resize_factor);
 
-  for (int i = 0; i < MFQE_NUM_REFS; i++) {
-    aom_free(CONVERT_TO_SHORTPTR(refs_low[i].buffer_orig));
-    aom_free(CONVERT_TO_SHORTPTR(refs_sub[i].buffer_orig));
+  YV12_BUFFER_CONFIG *ref;
+  for (int i = 0; ok && i < MFQE_NUM_REFS; i++) {
+    ref = &ref_frames[i]->buf;
+    ok = mfqe_alloc_buf_highbd(scratch, RST_SCRATCH_MFQE_LOW + 1 + i,
+                               &refs_low[i], ref->y_stride, ref->y_height,
+                               ref->y_width, 1);
+    ok = ok && mfqe_alloc_buf_highbd(scratch, RST_SCRATCH_MFQE_SUB + 1 + i,
+                                     &refs_sub[i], ref->y_stride,
+                                     ref->y_height, ref->y_width,
+                                     resize_factor);
   }
+  return ok;
 }
 
 // Apply In-Loop Multi-Frame Quality Enhancement for low bitdepth version.
-static void apply_loop_mfqe_lowbd(Y_BUFFER_CONFIG *tmp,
-                                  RefCntBuffer *ref_frames[], BLOCK_SIZE bsize,
-                                  int resize_factor, int bd) {
+static int apply_loop_mfqe_lowbd(Y_BUFFER_CONFIG *tmp,
+                                 RefCntBuffer *ref_frames[], BLOCK_SIZE bsize,
+                                 int resize_factor, int bd,
+                                 RestorationScratch *scratch) {
   Y_BUFFER_CONFIG tmp_low;
   Y_BUFFER_CONFIG tmp_sub;
 
@@ -480,8 +481,10 @@ static void apply_loop_mfqe_lowbd(Y_BUFFER_CONFIG *tmp,
   // Contains resized versions of reference frames.
   Y_BUFFER_CONFIG refs_sub[MFQE_NUM_REFS];
 
-  mfqe_mem_alloc(tmp, ref_frames, &tmp_low, &tmp_sub, refs_low, refs_sub,
-                 resize_factor);
+  if (!mfqe_mem_alloc(scratch, tmp, ref_frames, &tmp_low, &tmp_sub, refs_low,
+                      refs_sub, resize_factor)) {
+    return 0;
+  }
 
   mfqe_gaussian_blur(tmp->buffer, tmp_low.buffer, tmp->stride, tmp->height,
                      tmp->width, 0, bd);
@@ -502,7 +505,9 @@ static void apply_loop_mfqe_lowbd(Y_BUFFER_CONFIG *tmp,
   int block_h = block_size_high[bsize];
 
   int block_bytes = (block_h + 2 * MFQE_PADDING_SIZE) * tmp->stride;
-  uint8_t *block_orig = aom_memalign(32, sizeof(uint8_t) * block_bytes);
+  uint8_t *block_orig = av1_rst_scratch_get(scratch, RST_SCRATCH_MFQE_BLOCK,
+                                            sizeof(uint8_t) * block_bytes);
+  if (block_orig == NULL) return 0;
   uint8_t *swap_block = block_orig + MFQE_PADDING_SIZE * tmp->stride;
 
   for (int16_t mb_row = 0; mb_row < tmp->width; mb_row += block_w) {
@@ -520,16 +525,14 @@ static void apply_loop_mfqe_lowbd(Y_BUFFER_CONFIG *tmp,
                           resize_factor, swap_block);
     }
   }
-
-  // Free all of the dynamically allocated resources.
-  aom_free(block_orig);
-  mfqe_mem_free(&tmp_low, &tmp_sub, refs_low, refs_sub);
+  return 1;
 }
 
 // Apply In-Loop Multi-Frame Quality Enhancement for high bitdepth version.
-static void apply_loop_mfqe_highbd(Y_BUFFER_CONFIG *tmp,
-                                   RefCntBuffer *ref_frames[], BLOCK_SIZE bsize,
-                                   int resize_factor, int bd) {
+static int apply_loop_mfqe_highbd(Y_BUFFER_CONFIG *tmp,
+                                  RefCntBuffer *ref_frames[], BLOCK_SIZE bsize,
+                                  int resize_factor, int bd,
+                                  RestorationScratch *scratch) {
   Y_BUFFER_CONFIG tmp_low;
   Y_BUFFER_CONFIG tmp_sub;
 
@@ -538,8 +541,10 @@ static void apply_loop_mfqe_highbd(Y_BUFFER_CONFIG *tmp,
   // Contains resized versions of reference frames.
   Y_BUFFER_CONFIG refs_sub[MFQE_NUM_REFS];
 
-  mfqe_mem_alloc_highbd(tmp, ref_frames, &tmp_low, &tmp_sub, refs_low, refs_sub,
-                        resize_factor);
+  if (!mfqe_mem_alloc_highbd(scratch, tmp, ref_frames, &tmp_low, &tmp_sub,
+                             refs_low, refs_sub, resize_factor)) {
+    return 0;
+  }
 
   mfqe_gaussian_blur(tmp->buffer, tmp_low.buffer, tmp->stride, tmp->height,
                      tmp->width, 1, bd);
@@ -562,7 +567,9 @@ static void apply_loop_mfqe_highbd(Y_BUFFER_CONFIG *tmp,
   int16_t num_rows = tmp->height / block_h;
 
   int block_bytes = (block_h + 2 * MFQE_PADDING_SIZE) * tmp->stride;
-  uint16_t *block_orig = aom_memalign(32, sizeof(uint16_t) * block_bytes);
+  uint16_t *block_orig = av1_rst_scratch_get(scratch, RST_SCRATCH_MFQE_BLOCK,
+                                             sizeof(uint16_t) * block_bytes);
+  if (block_orig == NULL) return 0;
   uint16_t *swap_block = block_orig + MFQE_PADDING_SIZE * tmp->stride;
 
   for (int16_t mb_row = 0; mb_row < num_rows; ++mb_row) {
@@ -580,19 +587,21 @@ static void apply_loop_mfqe_highbd(Y_BUFFER_CONFIG *tmp,
                                  resize_factor, swap_block, bd);
     }
   }
-
-  // Free all of the dynamically allocated resources.
-  aom_free(block_orig);
-  mfqe_mem_free_highbd(&tmp_low, &tmp_sub, refs_low, refs_sub);
+  return 1;
 }
 
-void av1_apply_loop_mfqe(Y_BUFFER_CONFIG *tmp, RefCntBuffer *ref_frames[],
-                         BLOCK_SIZE bsize, int resize_factor, int high_bd,
-                         int bd) {
+int av1_apply_loop_mfqe(Y_BUFFER_CONFIG *tmp, RefCntBuffer *ref_frames[],
+                        BLOCK_SIZE bsize, int resize_factor, int high_bd,
+                        int bd, RestorationScratch *scratch) {
+  // The scratch keeps one low-resolution and one upsampled plane for the
+  // current frame and for each reference.
+  assert(RST_SCRATCH_MFQE_PLANES == MFQE_NUM_REFS + 1);
   if (high_bd)
-    apply_loop_mfqe_highbd(tmp, ref_frames, bsize, resize_factor, bd);
+    return apply_loop_mfqe_highbd(tmp, ref_frames, bsize, resize_factor, bd,
+                                  scratch);
   else
-    apply_loop_mfqe_lowbd(tmp, ref_frames, bsize, resize_factor, bd);
+    return apply_loop_mfqe_lowbd(tmp, ref_frames, bsize, resize_factor, bd,
+                                 scratch);
 }
 
 // Copy the buffer from source to destination for a single plane.
@@ -633,6 +642,18 @@ static double get_mse_frame(uint8_t *buf1, uint8_t *buf2, int stride1,
   return mse;
 }
 
+// Get the zeroed scratch buffer holding the padded copy of the current frame.
+static void *get_frame_scratch(AV1_COMMON *cm, size_t bytes) {
+  void *buf = av1_rst_scratch_get(&cm->rst_scratch, RST_SCRATCH_MFQE_FRAME,
+                                  bytes);
+  if (buf == NULL) {
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate MFQE frame buffer");
+  }
+  memset(buf, 0, bytes);
+  return buf;
+}
+
 // Apply In-Loop Multi-Frame Quality Enhancement to the y plane of the current
 // frame. If MFQE improves the current frame, replace the current y plane with
 // the updated buffer. Returns 1 if MFQE is selected, 0 otherwise.
@@ -642,8 +663,7 @@ static void search_rest_mfqe_lowbd(const YV12_BUFFER_CONFIG *src,
   int frame_bytes = cur->y_stride * (cur->y_height + 2 * MFQE_PADDING_SIZE);
 
   // Buffer to store temporary copy of current frame for MFQE.
-  uint8_t *tmpbuf_orig = aom_memalign(32, sizeof(uint8_t) * frame_bytes);
-  memset(tmpbuf_orig, 0, sizeof(uint8_t) * frame_bytes);
+  uint8_t *tmpbuf_orig = get_frame_scratch(cm, sizeof(uint8_t) * frame_bytes);
 
   uint8_t *tmpbuf = tmpbuf_orig + cur->y_stride * MFQE_PADDING_SIZE;
   copy_single_plane_lowbd(cur->y_buffer, tmpbuf, cur->y_stride, cur->y_stride,
@@ -663,10 +683,7 @@ static void search_rest_mfqe_lowbd(const YV12_BUFFER_CONFIG *src,
   }
 
   // Return if we have less than 3 available reference frames.
-  if (num_ref_frames < MFQE_NUM_REFS) {
-    aom_free(tmpbuf_orig);
-    return;
-  }
+  if (num_ref_frames < MFQE_NUM_REFS) return;
 
   // Assert that pointers to RefCntBuffer are valid, then sort the reference
   // frames based on their base_qindex, from lowest to highest.
@@ -674,8 +691,11 @@ static void search_rest_mfqe_lowbd(const YV12_BUFFER_CONFIG *src,
   qsort(ref_frames, num_ref_frames, sizeof(ref_frames[0]), cmpref);
 
   // Perform In-Loop Multi-Frame Quality Enhancement on tmp.
-  av1_apply_loop_mfqe(&tmp, ref_frames, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE, 0,
-                      cm->seq_params.bit_depth);
+  if (!av1_apply_loop_mfqe(&tmp, ref_frames, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
+                           0, cm->seq_params.bit_depth, &cm->rst_scratch)) {
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate MFQE buffers");
+  }
 
   double mse_prev =
       get_mse_frame(src->y_buffer, cur->y_buffer, src->y_stride, cur->y_stride,
@@ -688,8 +708,6 @@ static void search_rest_mfqe_lowbd(const YV12_BUFFER_CONFIG *src,
     copy_single_plane_lowbd(tmpbuf, cur->y_buffer, cur->y_stride, cur->y_stride,
                             cur->y_height, cur->y_width);
   }
-
-  aom_free(tmpbuf_orig);
 }
 
 static void search_rest_mfqe_highbd(const YV12_BUFFER_CONFIG *src,
@@ -698,8 +716,8 @@ static void search_rest_mfqe_highbd(const YV12_BUFFER_CONFIG *src,
   int frame_bytes = cur->y_stride * (cur->y_height + 2 * MFQE_PADDING_SIZE);
 
   // Buffer to store temporary copy of current frame for MFQE.
-  uint16_t *tmpbuf_orig = aom_memalign(32, sizeof(uint16_t) * frame_bytes);
-  memset(tmpbuf_orig, 0, sizeof(uint16_t) * frame_bytes);
+  uint16_t *tmpbuf_orig =
+      get_frame_scratch(cm, sizeof(uint16_t) * frame_bytes);
 
   uint16_t *tmpbuf = tmpbuf_orig + cur->y_stride * MFQE_PADDING_SIZE;
   Y_BUFFER_CONFIG tmp = { .buffer = CONVERT_TO_BYTEPTR(tmpbuf),
@@ -719,10 +737,7 @@ static void search_rest_mfqe_highbd(const YV12_BUFFER_CONFIG *src,
   }
 
   // Return if we have less than 3 available reference frames.
-  if (num_ref_frames < MFQE_NUM_REFS) {
-    aom_free(tmpbuf_orig);
-    return;
-  }
+  if (num_ref_frames < MFQE_NUM_REFS) return;
 
   // Assert that pointers to RefCntBuffer are valid, then sort the reference
   // frames based on their base_qindex, from lowest to highest.
@@ -730,8 +745,11 @@ static void search_rest_mfqe_highbd(const YV12_BUFFER_CONFIG *src,
   qsort(ref_frames, num_ref_frames, sizeof(ref_frames[0]), cmpref);
 
   // Perform In-Loop Multi-Frame Quality Enhancement on tmp.
-  av1_apply_loop_mfqe(&tmp, ref_frames, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE, 1,
-                      cm->seq_params.bit_depth);
+  if (!av1_apply_loop_mfqe(&tmp, ref_frames, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
+                           1, cm->seq_params.bit_depth, &cm->rst_scratch)) {
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate MFQE buffers");
+  }
 
   double mse_prev =
       get_mse_frame(src->y_buffer, cur->y_buffer, src->y_stride, cur->y_stride,
@@ -744,8 +762,6 @@ static void search_rest_mfqe_highbd(const YV12_BUFFER_CONFIG *src,
     copy_single_plane_highbd(tmp.buffer, cur->y_buffer, cur->y_stride,
                              cur->y_stride, cur->y_height, cur->y_width);
   }
-
-  aom_free(tmpbuf_orig);
 }
 
 // Wrapper function for In-Loop Multi-Frame Quality Enhancement. There are two
@@ -753,10 +769,13 @@ static void search_rest_mfqe_highbd(const YV12_BUFFER_CONFIG *src,
 void av1_search_rest_mfqe(const YV12_BUFFER_CONFIG *src,
                           YV12_BUFFER_CONFIG *cur, AV1_COMMON *cm,
                           int *use_mfqe, int high_bd) {
+  av1_rst_scratch_set_frame_size(&cm->rst_scratch, cur->y_width,
+                                 cur->y_height);
   if (high_bd)
     search_rest_mfqe_highbd(src, cur, cm, use_mfqe);
   else
     search_rest_mfqe_lowbd(src, cur, cm, use_mfqe);
+  av1_rst_scratch_trim(&cm->rst_scratch);
 }
 
 // MFQE decoding function in low bitdepth version.
@@ -766,8 +785,7 @@ void decode_restore_mfqe_lowbd(AV1_COMMON *cm, BLOCK_SIZE bsize,
   int frame_bytes = cur->y_stride * (cur->y_height + 2 * MFQE_PADDING_SIZE);
 
   // Buffer to store temporary copy of current frame for MFQE.
-  uint8_t *tmpbuf_orig = aom_memalign(32, sizeof(uint8_t) * frame_bytes);
-  memset(tmpbuf_orig, 0, sizeof(uint8_t) * frame_bytes);
+  uint8_t *tmpbuf_orig = get_frame_scratch(cm, sizeof(uint8_t) * frame_bytes);
 
   uint8_t *tmpbuf = tmpbuf_orig + cur->y_stride * MFQE_PADDING_SIZE;
   copy_single_plane_lowbd(cur->y_buffer, tmpbuf, cur->y_stride, cur->y_stride,
@@ -793,13 +811,14 @@ void decode_restore_mfqe_lowbd(AV1_COMMON *cm, BLOCK_SIZE bsize,
   qsort(ref_frames, num_ref_frames, sizeof(ref_frames[0]), cmpref);
 
   // Perform In-Loop Multi-Frame Quality Enhancement on tmp.
-  av1_apply_loop_mfqe(&cur_frame, ref_frames, bsize, resize_factor, 0,
-                      cm->seq_params.bit_depth);
+  if (!av1_apply_loop_mfqe(&cur_frame, ref_frames, bsize, resize_factor, 0,
+                           cm->seq_params.bit_depth, &cm->rst_scratch)) {
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate MFQE buffers");
+  }
 
   copy_single_plane_lowbd(tmpbuf, cur->y_buffer, cur->y_stride, cur->y_stride,
                           cur->y_height, cur->y_width);
-
-  aom_free(tmpbuf_orig);
 }
 
 // MFQE decoding function in high bitdepth version.
@@ -810,8 +829,8 @@ void decode_restore_mfqe_highbd(AV1_COMMON *cm, BLOCK_SIZE bsize,
   int frame_bytes = cur->y_stride * (cur->y_height + 2 * MFQE_PADDING_SIZE);
 
   // Buffer to store temporary copy of current frame for MFQE.
-  uint16_t *tmpbuf_orig = aom_memalign(32, sizeof(uint16_t) * frame_bytes);
-  memset(tmpbuf_orig, 0, sizeof(uint16_t) * frame_bytes);
+  uint16_t *tmpbuf_orig =
+      get_frame_scratch(cm, sizeof(uint16_t) * frame_bytes);
 
   uint16_t *tmpbuf = tmpbuf_orig + cur->y_stride * MFQE_PADDING_SIZE;
   Y_BUFFER_CONFIG cur_frame = { .buffer = CONVERT_TO_BYTEPTR(tmpbuf),
@@ -837,17 +856,23 @@ void decode_restore_mfqe_highbd(AV1_COMMON *cm, BLOCK_SIZE bsize,
   qsort(ref_frames, num_ref_frames, sizeof(ref_frames[0]), cmpref);
 
   // Perform In-Loop Multi-Frame Quality Enhancement on tmp.
-  av1_apply_loop_mfqe(&cur_frame, ref_frames, bsize, resize_factor, 0,
-                      cm->seq_params.bit_depth);
+  if (!av1_apply_loop_mfqe(&cur_frame, ref_frames, bsize, resize_factor, 0,
+                           cm->seq_params.bit_depth, &cm->rst_scratch)) {
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate MFQE buffers");
+  }
 
   copy_single_plane_highbd(cur_frame.buffer, cur->y_buffer, cur->y_stride,
                            cur->y_stride, cur->y_height, cur->y_width);
-  aom_free(tmpbuf_orig);
 }
 
 void av1_decode_restore_mfqe(AV1_COMMON *cm, int high_bd) {
+  const YV12_BUFFER_CONFIG *cur = &cm->cur_frame->buf;
+  av1_rst_scratch_set_frame_size(&cm->rst_scratch, cur->y_width,
+                                 cur->y_height);
   if (high_bd)
     decode_restore_mfqe_highbd(cm, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE);
   else
     decode_restore_mfqe_lowbd(cm, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE);
+  av1_rst_scratch_trim(&cm->rst_scratch);
 }
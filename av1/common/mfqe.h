@@ -81,9 +81,11 @@ static INLINE double get_alpha_weight(double mse) {
 // Actually apply In-Loop Multi-Frame Quality Enhancement to the tmp buffer,
 // using the reference frames. Perform full-pixel motion search on 8x8 blocks,
 // then perform finer-grained search to obtain subpel motion vectors. Finally,
-// replace the blocks in current frame by interpolation.
-void av1_apply_loop_mfqe(Y_BUFFER_CONFIG *tmp, RefCntBuffer *ref_frames[],
-                         BLOCK_SIZE bsize, int scale, int high_bd, int bd);
+// replace the blocks in current frame by interpolation. Intermediate buffers
+// are taken from scratch. Returns 0 if they could not be allocated.
+int av1_apply_loop_mfqe(Y_BUFFER_CONFIG *tmp, RefCntBuffer *ref_frames[],
+                        BLOCK_SIZE bsize, int scale, int high_bd, int bd,
+                        RestorationScratch *scratch);
 
 // Wrapper function for In-Loop Multi-Frame Quality Enhancement. There are two
 // different code paths for low bit depth and high bit depth.
@@ -220,12 +220,6 @@ static void nn_fc_backward(const float *X, float *dX_out, FC_LAYER_EM *layer) {
 static void nn_fc_input_backward(const int *sparse_features,
                                  const float *dense_features,
                                  FC_INPUT_LAYER_EM *layer) {
-  const int num_sparse = layer->num_sparse_inputs;
-  const int num_dense = layer->num_dense_inputs;
-  const int num_out = layer->num_outputs;
-  const int has_sparse = num_sparse > 0;
-  const int has_dense = num_dense > 0;
-
   // backprop on activation
   const float *dy_fc = NULL;
   float dy_buffer[MAX_NODES] = { 0.0f };  // dY for fc
@@ -244,31 +238,37 @@ static void nn_fc_input_backward(const int *sparse_features,
     default: assert(0 && "Unknown activation");  // Unknown activation
   }
 
+  av1_nn_input_backward_em(layer, dy_fc, sparse_features, dense_features);
+}
+
+// Accumulates the gradients of the input layer weights and bias, given the
+// gradient dy of its (pre-activation) outputs.
+void av1_nn_input_backward_em_c(FC_INPUT_LAYER_EM *layer, const float *dy,
+                                const int *sparse_features,
+                                const float *dense_features) {
+  const int num_sparse = layer->num_sparse_inputs;
+  const int num_dense = layer->num_dense_inputs;
+  const int num_out = layer->num_outputs;
+
   // Handle bias
   float *db = layer->db;
   for (int j = 0; j < num_out; ++j) {
-    db[j] += dy_fc[j];
+    db[j] += dy[j];
   }
   // Handle sparse
-  float **dw_sparse = layer->dw_sparse;
-  if (has_sparse) {
-    for (int s_idx = 0; s_idx < num_sparse; s_idx++) {
-      const int non_zero_idx = sparse_features[s_idx];
-      for (int j = 0; j < num_out; ++j) {
-        dw_sparse[s_idx][non_zero_idx * num_out + j] += dy_fc[j];
-      }
+  for (int s_idx = 0; s_idx < num_sparse; s_idx++) {
+    float *dw = layer->dw_sparse[s_idx] + sparse_features[s_idx] * num_out;
+    for (int j = 0; j < num_out; ++j) {
+      dw[j] += dy[j];
     }
   }
-
   // Handle dense
-  if (has_dense) {
-    float *dw_dense = layer->dw_dense;
-    for (int j = 0; j < num_out; ++j) {
-      for (int i = 0; i < num_dense; ++i) {
-        dw_dense[i] += dy_fc[j] * dense_features[i];
-      }
-      dw_dense += num_dense;
+  float *dw_dense = layer->dw_dense;
+  for (int j = 0; j < num_out; ++j) {
+    for (int i = 0; i < num_dense; ++i) {
+      dw_dense[i] += dy[j] * dense_features[i];
     }
+    dw_dense += num_dense;
   }
 }
 
@@ -304,9 +304,11 @@ void av1_nn_backprop_em(NN_CONFIG_EM *nn_config, const int label) {
                        &nn_config->input_layer);
 }
 
-static INLINE void adapt(float *w, const float *dw, float mu, int n) {
+// Gradient descent step on n weights, which also clears their gradients.
+void av1_nn_adapt_em_c(float *w, float *dw, float mu, int n) {
   for (int idx = 0; idx < n; idx++) {
     w[idx] -= mu * dw[idx];
+    dw[idx] = 0.0f;
   }
 }
 
@@ -318,33 +320,33 @@ static void update_input_layer(NN_CONFIG_EM *nn_config, float mu) {
   const int has_sparse = num_sparse > 0;
   const int has_dense = num_dense > 0;
 
-  float *b = input_layer->bias;
-  float *db = input_layer->db;
-  adapt(b, db, mu, num_out);
-  av1_zero_array(db, num_out);
+  av1_nn_adapt_em(input_layer->bias, input_layer->db, mu, num_out);
 
   // Handle sparse
   if (has_sparse) {
     float **dw_sparse = input_layer->dw_sparse;
     float **w_sparse = input_layer->sparse_weights;
     for (int s_idx = 0; s_idx < num_sparse; s_idx++) {
-      const int non_zero_idx = nn_config->sparse_features[s_idx];
       const int sparse_size = input_layer->sparse_input_size[s_idx];
+      if (nn_config->sb_update) {
+        // Gradients of a whole superblock may touch any row but the last one,
+        // and rows left untouched have zero gradients.
+        av1_nn_adapt_em(w_sparse[s_idx], dw_sparse[s_idx], mu,
+                        (sparse_size - 1) * num_out);
+        continue;
+      }
+      const int non_zero_idx = nn_config->sparse_features[s_idx];
       if (non_zero_idx == sparse_size - 1) {
         continue;
       }
-      adapt(&w_sparse[s_idx][non_zero_idx * num_out],
-            &dw_sparse[s_idx][non_zero_idx * num_out], mu, num_out);
-      av1_zero_array(&dw_sparse[s_idx][non_zero_idx * num_out], num_out);
+      av1_nn_adapt_em(&w_sparse[s_idx][non_zero_idx * num_out],
+                      &dw_sparse[s_idx][non_zero_idx * num_out], mu, num_out);
     }
   }
 
   if (has_dense) {
-    const int num_dense_weights = num_dense * num_out;
-    float *dw_dense = input_layer->dw_dense;
-    float *w_dense = input_layer->dense_weights;
-    adapt(w_dense, dw_dense, mu, num_dense_weights);
-    av1_zero_array(dw_dense, num_dense_weights);
+    av1_nn_adapt_em(input_layer->dense_weights, input_layer->dw_dense, mu,
+                    num_dense * num_out);
   }
 }
 
@@ -355,12 +357,8 @@ void av1_nn_update_em(NN_CONFIG_EM *nn_config, float mu) {
   for (int i = 0; i < num_layers; ++i) {
     FC_LAYER_EM *layer = nn_config->layer + i;
     const int num_weights = layer->num_inputs * layer->num_outputs;
-    adapt(layer->weights, layer->dw, mu, num_weights);
-    av1_zero_array(layer->dw, num_weights);
-
-    const int num_out = layer->num_outputs;
-    adapt(layer->bias, layer->db, mu, num_out);
-    av1_zero_array(layer->db, num_out);
+    av1_nn_adapt_em(layer->weights, layer->dw, mu, num_weights);
+    av1_nn_adapt_em(layer->bias, layer->db, mu, layer->num_outputs);
   }
 
   // Input layer
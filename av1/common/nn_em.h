@@ -65,6 +65,7 @@ typedef struct NN_CONFIG_EM {
   float *output;
   int *sparse_features;
   float *dense_features;
+  int sb_update;  // Gradients are applied once per superblock when set.
 } NN_CONFIG_EM;
 
 // Calculate prediction based on the given input features and neural net config.
@@ -78,5 +79,11 @@ void av1_nn_backprop_em(NN_CONFIG_EM *nn_config, const int label);
 // Update the weights via gradient descent.
 // mu: learning rate, usually chosen from 0.01~0.0001.
 void av1_nn_update_em(NN_CONFIG_EM *nn_config, float mu);
+
+// Per-symbol weight update, skipped when the model accumulates gradients over
+// a superblock; those are applied by av1_nn_update_em() at the end of it.
+static INLINE void av1_nn_symbol_update_em(NN_CONFIG_EM *nn_config) {
+  if (!nn_config->sb_update) av1_nn_update_em(nn_config, nn_config->lr);
+}
 #endif  // CONFIG_INTRA_ENTROPY
 #endif  // AOM_AV1_COMMON_NN_EM_H_
@@ -26,11 +26,11 @@ static INLINE void av1_cnn_recon(const MACROBLOCKD *xd, uint8_t *dst,
                                  int dst_stride, TX_SIZE tx_size) {
   assert(tx_size == TX_16X16);
   assert(!is_inter_block(xd->mi[0]));
-  const int err_val = av1_cnn_recon_tflite(
-      dst, dst_stride, tx_size_high[tx_size], tx_size_wide[tx_size]);
+  const int err_val =
+      av1_cnn_recon_tflite(xd->nn_recon_cache, dst, dst_stride,
+                           tx_size_high[tx_size], tx_size_wide[tx_size]);
   assert(err_val);
   (void)err_val;
-  (void)xd;
 }
 
 static INLINE int av1_is_block_nn_recon_eligible(const AV1_COMMON *cm,
@@ -27,6 +27,7 @@
 #include "av1/common/mv.h"
 #include "av1/common/quant_common.h"
 #include "av1/common/restoration.h"
+#include "av1/common/restoration_scratch.h"
 #include "av1/common/tile_common.h"
 #include "av1/common/timing.h"
 #include "av1/common/odintrin.h"
@@ -143,6 +144,9 @@ typedef struct RefCntBuffer {
 
   MV_REF *mvs;
   uint8_t *seg_map;
+  // The allocated number of elements of mvs and seg_map, which only grow.
+  int mvs_alloc_size;
+  int seg_map_alloc_size;
   struct segmentation seg;
   int mi_rows;
   int mi_cols;
@@ -171,6 +175,11 @@ typedef struct RefCntBuffer {
 
   FRAME_CONTEXT frame_context;
   int base_qindex;
+
+  // Frame parallel decoding: the number of superblock rows of the frame that
+  // are final and may be referenced, INT_MAX once the whole frame is. Guarded
+  // by BufferPool.progress_mutex.
+  int decoded_sb_rows;
 } RefCntBuffer;
 
 typedef struct BufferPool {
@@ -181,6 +190,10 @@ typedef struct BufferPool {
 // https://chromium-review.googlesource.com/c/webm/libvpx/+/560630.
 #if CONFIG_MULTITHREAD
   pthread_mutex_t pool_mutex;
+  // Frame parallel decoding: guards RefCntBuffer.decoded_sb_rows, and is
+  // signaled when a frame makes progress.
+  pthread_mutex_t progress_mutex;
+  pthread_cond_t progress_cond;
 #endif
 
   // Private data associated with the frame buffer callbacks.
@@ -193,6 +206,11 @@ typedef struct BufferPool {
 
   // Frame buffers allocated internally by the codec.
   InternalFrameBufferList int_frame_buffers;
+
+  // Decoder: the number of allocations made for the side buffers of the
+  // frames (motion vector and segmentation maps, 8-bit luma copies and the
+  // superres scratch frames).
+  unsigned int num_side_allocs;
 } BufferPool;
 
 typedef struct {
@@ -258,6 +276,11 @@ typedef struct SequenceHeader {
 #if CONFIG_ADAPT_FILTER_INTRA
   int enable_adapt_filter_intra;  // enables/disables adaptive filter intra
 #endif
+#if CONFIG_INTRA_ENTROPY
+  // 0 - update intra mode models after each symbol
+  // 1 - update intra mode models once per superblock
+  int enable_intra_entropy_sb_update;
+#endif  // CONFIG_INTRA_ENTROPY
   uint8_t enable_intra_edge_filter;    // enables/disables edge upsampling
   uint8_t enable_interintra_compound;  // enables/disables interintra_compound
   uint8_t enable_masked_compound;      // enables/disables masked compound
@@ -514,6 +537,8 @@ typedef struct AV1Common {
   // Pointer to a scratch buffer used by self-guided restoration
   int32_t *rst_tmpbuf;
   RestorationLineBuffers *rlbs;
+  // Persistent scratch memory for MFQE and CNN restoration.
+  RestorationScratch rst_scratch;
 
   // Output of loop restoration
   YV12_BUFFER_CONFIG rst_frame;
@@ -785,22 +810,53 @@ static INLINE int frame_might_allow_warped_motion(const AV1_COMMON *cm) {
          cm->seq_params.enable_warped_motion;
 }
 
-static INLINE void ensure_mv_buffer(RefCntBuffer *buf, AV1_COMMON *cm) {
+// Allocates the motion vector and segmentation maps of buf for frames of up
+// to mi_rows x mi_cols. Returns the number of allocations made, or -1 on
+// failure.
+static INLINE int alloc_mv_buffer(RefCntBuffer *buf, int mi_rows,
+                                  int mi_cols) {
+  const int mvs_size = ((mi_rows + 1) >> 1) * ((mi_cols + 1) >> 1);
+  const int seg_map_size = mi_rows * mi_cols;
+  int num_allocs = 0;
+
+  if (buf->mvs == NULL || mvs_size > buf->mvs_alloc_size) {
+    aom_free(buf->mvs);
+    buf->mvs_alloc_size = 0;
+    buf->mvs = (MV_REF *)aom_calloc(mvs_size, sizeof(*buf->mvs));
+    if (buf->mvs == NULL) return -1;
+    buf->mvs_alloc_size = mvs_size;
+    ++num_allocs;
+  } else {
+    memset(buf->mvs, 0, mvs_size * sizeof(*buf->mvs));
+  }
+  if (buf->seg_map == NULL || seg_map_size > buf->seg_map_alloc_size) {
+    aom_free(buf->seg_map);
+    buf->seg_map_alloc_size = 0;
+    buf->seg_map = (uint8_t *)aom_calloc(seg_map_size, sizeof(*buf->seg_map));
+    if (buf->seg_map == NULL) return -1;
+    buf->seg_map_alloc_size = seg_map_size;
+    ++num_allocs;
+  } else {
+    memset(buf->seg_map, 0, seg_map_size * sizeof(*buf->seg_map));
+  }
+  return num_allocs;
+}
+
+// Returns the number of allocations made for the maps of buf.
+static INLINE int ensure_mv_buffer(RefCntBuffer *buf, AV1_COMMON *cm) {
   const int buf_rows = buf->mi_rows;
   const int buf_cols = buf->mi_cols;
+  int num_allocs = 0;
 
   if (buf->mvs == NULL || buf_rows != cm->mi_rows || buf_cols != cm->mi_cols) {
-    aom_free(buf->mvs);
+    // The maps are reused across size changes while they are large enough.
+    num_allocs = alloc_mv_buffer(buf, cm->mi_rows, cm->mi_cols);
+    if (num_allocs < 0) {
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate buf->mvs");
+    }
     buf->mi_rows = cm->mi_rows;
     buf->mi_cols = cm->mi_cols;
-    CHECK_MEM_ERROR(cm, buf->mvs,
-                    (MV_REF *)aom_calloc(
-                        ((cm->mi_rows + 1) >> 1) * ((cm->mi_cols + 1) >> 1),
-                        sizeof(*buf->mvs)));
-    aom_free(buf->seg_map);
-    CHECK_MEM_ERROR(cm, buf->seg_map,
-                    (uint8_t *)aom_calloc(cm->mi_rows * cm->mi_cols,
-                                          sizeof(*buf->seg_map)));
   }
 
   const int mem_size =
@@ -814,6 +870,7 @@ static INLINE void ensure_mv_buffer(RefCntBuffer *buf, AV1_COMMON *cm) {
                     (TPL_MV_REF *)aom_calloc(mem_size, sizeof(*cm->tpl_mvs)));
     cm->tpl_mvs_mem_size = mem_size;
   }
+  return num_allocs;
 }
 
 void cfl_init(CFL_CTX *cfl, const SequenceHeader *seq_params);
@@ -361,6 +361,18 @@ const qm_val_t *av1_qmatrix(AV1_COMMON *cm, int qmlevel, int plane,
 static const qm_val_t wt_matrix_ref[NUM_QM_LEVELS - 1][2][QM_TOTAL_SIZE];
 static const qm_val_t iwt_matrix_ref[NUM_QM_LEVELS - 1][2][QM_TOTAL_SIZE];
 
+void av1_dequantize_coeffs_c(tran_low_t *coeffs, int n_coeffs, int dqv_dc,
+                             int dqv_ac, int shift, int bd) {
+  const int32_t max_value = (1 << (7 + bd)) - 1;
+  const int32_t min_value = -(1 << (7 + bd));
+  for (int i = 0; i < n_coeffs; ++i) {
+    if (coeffs[i]) {
+      coeffs[i] = av1_dequant_coeff(coeffs[i], i ? dqv_ac : dqv_dc, shift,
+                                    min_value, max_value);
+    }
+  }
+}
+
 void av1_qm_init(AV1_COMMON *cm) {
   const int num_planes = av1_num_planes(cm);
   int q, c, t;
@@ -94,6 +94,25 @@ const qm_val_t *av1_qmatrix(struct AV1Common *cm, int qmlevel, int plane,
 void av1_get_dspl_delta_q(int base_qindex, int *dspl_delta_q);
 #endif  // CONFIG_DSPL_RESIDUAL
 
+// Dequantizes a coefficient read from the bitstream. The magnitude of the
+// product is kept to 24 bits, which covers the 17/19/21 bit range of 8/10/12
+// bit video, and the result is clamped to [min_value, max_value].
+static INLINE tran_low_t av1_dequant_coeff(tran_low_t qcoeff, int dqv,
+                                           int shift, int32_t min_value,
+                                           int32_t max_value) {
+  const tran_low_t level = abs(qcoeff);
+#if QUANT_TABLE_BITS
+  const int64_t dq_coeff_hp = (int64_t)level * dqv & 0xffffff;
+  tran_low_t dq_coeff =
+      (tran_low_t)(ROUND_POWER_OF_TWO_64(dq_coeff_hp, QUANT_TABLE_BITS));
+#else
+  tran_low_t dq_coeff = (tran_low_t)((int64_t)level * dqv & 0xffffff);
+#endif  // QUANT_TABLE_BITS
+  dq_coeff = dq_coeff >> shift;
+  if (qcoeff < 0) dq_coeff = -dq_coeff;
+  return clamp(dq_coeff, min_value, max_value);
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
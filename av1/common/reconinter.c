@@ -154,115 +154,42 @@ int av1_allow_warp(const MB_MODE_INFO *const mbmi,
 }
 
 #if CONFIG_EXT_IBC_MODES
-void av1_intrabc_allocate_sb(uint16_t **InputBlock, const uint16_t width,
-                             const uint16_t height) {
-  (*InputBlock) = (uint16_t *)aom_malloc(width * height * sizeof(uint16_t));
-}
-
-void av1_fetch_prediction_sb(const uint8_t *src, int src_stride,
-                             uint16_t *InputBlock, const uint16_t width,
-                             const uint16_t height) {
-  uint16_t *pixelStartAddr = CONVERT_TO_SHORTPTR(src);
-  uint16_t size = (width << 1);
-
-  // Populate prediction data
-  for (int rows = 0; rows < height; ++rows) {
-    memcpy(InputBlock, pixelStartAddr, size);
-    pixelStartAddr += src_stride;
-    InputBlock += width;
-  }
-}
-
-void av1_write_prediction_sb(const uint8_t *dst, int dst_stride,
-                             uint16_t *InputBlock, const uint16_t width,
-                             const uint16_t height) {
-  uint16_t *pixelStartAddr = CONVERT_TO_SHORTPTR(dst);
-  uint16_t size = (width << 1);
-
-  // Write prediction data
-  for (int rows = 0; rows < height; ++rows) {
-    memcpy(pixelStartAddr, InputBlock, size);
-    InputBlock += 128;
-    pixelStartAddr += dst_stride;
-  }
-}
-
-void av1_intrabc_rotate90_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                             const uint16_t width, const uint16_t height) {
-  // Rotate Block by 90 degrees
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[cols * 128 + (height - 1 - rows)] = SrcBlock[cols];
+void av1_intrabc_transform_sb_c(uint16_t *dst, int dst_stride,
+                                const uint16_t *src, int src_stride, int width,
+                                int height, IBC_MODE mode) {
+  const int transpose = av1_intrabc_mode_transposes(mode);
+  const int flip_h = av1_intrabc_mode_flips_h(mode);
+  const int flip_v = av1_intrabc_mode_flips_v(mode);
+  const int out_w = transpose ? height : width;
+  const int out_h = transpose ? width : height;
+
+  if (!transpose && !flip_h) {
+    // Whole rows can be copied, possibly in reverse order.
+    for (int r = 0; r < height; ++r) {
+      const int y = flip_v ? out_h - 1 - r : r;
+      memcpy(dst + y * dst_stride, src + r * src_stride,
+             width * sizeof(*src));
     }
-    SrcBlock += width;
-  }
-}
-
-void av1_intrabc_rotate180_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                              const uint16_t width, const uint16_t height) {
-  // Rotate Block by 180 degrees
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[(height - 1 - rows) * 128 + (width - 1 - cols)] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-
-void av1_intrabc_rotate270_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                              const uint16_t width, const uint16_t height) {
-  // Rotate Block by 270 degrees
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[(width - 1 - cols) * 128 + rows] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-
-void av1_intrabc_mirror0_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                            const uint16_t width, const uint16_t height) {
-  uint16_t size = (width << 1);
-
-  // Mirror Block across the 0 degree axis
-  DstBlock += (height - 1) * 128;
-  for (int rows = 0; rows < height; ++rows) {
-    memcpy(DstBlock, SrcBlock, size);
-    DstBlock -= 128;
-    SrcBlock += width;
-  }
-}
-
-void av1_intrabc_mirror45_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                             const uint16_t width, const uint16_t height) {
-  // Mirror Block across the 45 degree axis
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[(width - 1 - cols) * 128 + (height - 1 - rows)] = SrcBlock[cols];
-    }
-    SrcBlock += width;
+    return;
   }
-}
 
-void av1_intrabc_mirror90_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                             const uint16_t width, const uint16_t height) {
-  // Mirror Block across the 90 degree axis
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[rows * 128 + (width - 1 - cols)] = SrcBlock[cols];
+  for (int r = 0; r < height; ++r) {
+    for (int c = 0; c < width; ++c) {
+      int y = transpose ? c : r;
+      int x = transpose ? r : c;
+      if (flip_v) y = out_h - 1 - y;
+      if (flip_h) x = out_w - 1 - x;
+      dst[y * dst_stride + x] = src[r * src_stride + c];
     }
-    SrcBlock += width;
   }
 }
 
-void av1_intrabc_mirror135_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                              const uint16_t width, const uint16_t height) {
-  // Mirror Block across the 135 degree axis
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[cols * 128 + rows] = SrcBlock[cols];
-    }
-    SrcBlock += width;
+void av1_intrabc_transform_all_sb_c(uint16_t *const *dst, int dst_stride,
+                                    const uint16_t *src, int src_stride,
+                                    int width, int height, int num_modes) {
+  for (int mode = 0; mode < num_modes; ++mode) {
+    av1_intrabc_transform_sb_c(dst[mode], dst_stride, src, src_stride, width,
+                               height, (IBC_MODE)mode);
   }
 }
 #endif  // CONFIG_EXT_IBC_MODES
@@ -1210,76 +1137,24 @@ static void build_inter_predictors(
       conv_params.do_average = ref;
 
 #if CONFIG_EXT_IBC_MODES
-      // IBC+ Winners Only : Extract Predicted block & translate accordingly
+      // IBC+ Winners Only : Build the prediction in the orientation it was
+      // searched in, then undo that orientation straight into dst.
       if (is_intrabc && mi->ibc_mode) {
-        uint8_t ibcWinMode = mi->ibc_mode;
-
-        // Allocate & Extract/Fetch predicted block
-        uint16_t *pred_block = NULL;
-
-        uint8_t *dst_block = CONVERT_TO_BYTEPTR(xd->ibc_pred);
-        uint8_t dst_block_stride = 128;
-
-        if (bw != bh &&
-            (ibcWinMode == ROTATION_90 || ibcWinMode == ROTATION_270 ||
-             ibcWinMode == MIRROR_45 || ibcWinMode == MIRROR_135)) {
-          av1_make_inter_predictor(
-              pre, src_stride, dst_block, dst_block_stride, &subpel_params, sf,
-              bh, bw, &conv_params, mi->interp_filters, &warp_types,
-              mi_x >> pd->subsampling_x, mi_y >> pd->subsampling_y, plane, ref,
-              mi, build_for_obmc, xd, cm->allow_warped_motion, border);
-
-          av1_intrabc_allocate_sb(&pred_block, bh, bw);
-          av1_fetch_prediction_sb(dst_block, dst_block_stride, pred_block, bh,
-                                  bw);
-        } else {
-          av1_make_inter_predictor(
-              pre, src_stride, dst_block, dst_block_stride, &subpel_params, sf,
-              bw, bh, &conv_params, mi->interp_filters, &warp_types,
-              mi_x >> pd->subsampling_x, mi_y >> pd->subsampling_y, plane, ref,
-              mi, build_for_obmc, xd, cm->allow_warped_motion, border);
-
-          av1_intrabc_allocate_sb(&pred_block, bw, bh);
-          av1_fetch_prediction_sb(dst_block, dst_block_stride, pred_block, bw,
-                                  bh);
-        }
-
-        switch (ibcWinMode) {
-          case MIRROR_90:
-            av1_intrabc_mirror90_sb(xd->ibc_pred, pred_block, bw, bh);
-            break;
+        const IBC_MODE inv_mode = av1_intrabc_inverse_mode(mi->ibc_mode);
+        const int transposed = av1_intrabc_mode_transposes(inv_mode);
+        const int pred_w = transposed ? bh : bw;
+        const int pred_h = transposed ? bw : bh;
 
-          case MIRROR_0:
-            av1_intrabc_mirror0_sb(xd->ibc_pred, pred_block, bw, bh);
-            break;
-
-          case ROTATION_180:
-            av1_intrabc_rotate180_sb(xd->ibc_pred, pred_block, bw, bh);
-            break;
-
-          case ROTATION_90:
-            av1_intrabc_rotate270_sb(xd->ibc_pred, pred_block, bh, bw);
-            break;
-
-          case MIRROR_135:
-            av1_intrabc_mirror135_sb(xd->ibc_pred, pred_block, bh, bw);
-            break;
-
-          case MIRROR_45:
-            av1_intrabc_mirror45_sb(xd->ibc_pred, pred_block, bh, bw);
-            break;
-
-          case ROTATION_270:
-            av1_intrabc_rotate90_sb(xd->ibc_pred, pred_block, bh, bw);
-            break;
-
-          default: break;  // assert(0);
-        }
-
-        av1_write_prediction_sb(dst, dst_stride, xd->ibc_pred, bw, bh);
-
-        // Deallocate 1D arrays
-        aom_free(pred_block);
+        av1_make_inter_predictor(
+            pre, src_stride, CONVERT_TO_BYTEPTR(xd->ibc_pred), MAX_IBC_BLK_SIZE,
+            &subpel_params, sf, pred_w, pred_h, &conv_params,
+            mi->interp_filters, &warp_types, mi_x >> pd->subsampling_x,
+            mi_y >> pd->subsampling_y, plane, ref, mi, build_for_obmc, xd,
+            cm->allow_warped_motion, border);
+
+        av1_intrabc_transform_sb(CONVERT_TO_SHORTPTR(dst), dst_stride,
+                                 xd->ibc_pred, MAX_IBC_BLK_SIZE, pred_w, pred_h,
+                                 inv_mode);
       } else {  // Regular IBC
         av1_make_inter_predictor(
             pre, src_stride, dst, dst_stride, &subpel_params, sf, bw, bh,
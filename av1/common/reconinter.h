@@ -221,6 +221,32 @@ void av1_make_inter_predictor(
     int ref, const MB_MODE_INFO *mi, int build_for_obmc, const MACROBLOCKD *xd,
     int can_use_previous, const int border);
 
+#if CONFIG_EXT_IBC_MODES
+// Each IBC+ orientation is an optional transpose of the block followed by
+// optional horizontal and/or vertical flips of the (transposed) result.
+static INLINE int av1_intrabc_mode_transposes(IBC_MODE mode) {
+  return mode == ROTATION_90 || mode == ROTATION_270 || mode == MIRROR_45 ||
+         mode == MIRROR_135;
+}
+
+static INLINE int av1_intrabc_mode_flips_h(IBC_MODE mode) {
+  return mode == MIRROR_90 || mode == ROTATION_180 || mode == ROTATION_90 ||
+         mode == MIRROR_45;
+}
+
+static INLINE int av1_intrabc_mode_flips_v(IBC_MODE mode) {
+  return mode == MIRROR_0 || mode == ROTATION_180 || mode == ROTATION_270 ||
+         mode == MIRROR_45;
+}
+
+// Returns the orientation that undoes 'mode'.
+static INLINE IBC_MODE av1_intrabc_inverse_mode(IBC_MODE mode) {
+  if (mode == ROTATION_90) return ROTATION_270;
+  if (mode == ROTATION_270) return ROTATION_90;
+  return mode;
+}
+#endif  // CONFIG_EXT_IBC_MODES
+
 typedef void (*CalcSubpelParamsFunc)(
     MACROBLOCKD *xd, const struct scale_factors *const sf, const MV *const mv,
     int plane, int pre_x, int pre_y, int x, int y, struct buf_2d *const pre_buf,
@@ -961,8 +961,8 @@ void av1_upsample_intra_edge_high_c(uint16_t *p, int sz, int bd) {
 
 #define ADAPT_FILTER_INTRA_DEFINE_3_TAP_ACCUM_FUNC(func_name, tap1, tap2, \
                                                    tap3, data_type)       \
-  void func_name(const data_type *src, int stride, int w, int h,          \
-                 int64_t *dst_buf) {                                      \
+  static void func_name(const data_type *src, int stride, int w, int h,   \
+                        int64_t *dst_buf) {                               \
     for (int i = 0; i < h; i++) {                                         \
       for (int j = 0; j < w; j++) {                                       \
         const int x = src[i * stride + j];                                \
@@ -984,8 +984,8 @@ void av1_upsample_intra_edge_high_c(uint16_t *p, int sz, int bd) {
 
 #define ADAPT_FILTER_INTRA_DEFINE_4_TAP_ACCUM_FUNC(func_name, tap1, tap2, \
                                                    tap3, tap4, data_type) \
-  void func_name(const data_type *src, int stride, int w, int h,          \
-                 int64_t *dst_buf) {                                      \
+  static void func_name(const data_type *src, int stride, int w, int h,   \
+                        int64_t *dst_buf) {                               \
     for (int i = 0; i < h; i++) {                                         \
       for (int j = 0; j < w; j++) {                                       \
         const int x = src[i * stride + j];                                \
@@ -1013,8 +1013,9 @@ void av1_upsample_intra_edge_high_c(uint16_t *p, int sz, int bd) {
 
 #define ADAPT_FILTER_INTRA_DEFINE_PRED_FUNC_ROW_MAJOR(                      \
     func_name, pred_expression, data_type)                                  \
-  void func_name(data_type *dst, int stride, TX_SIZE tx_size, double *filt, \
-                 const data_type *above, const data_type *left) {           \
+  static void func_name(data_type *dst, int stride, TX_SIZE tx_size,        \
+                        const double *filt, const data_type *above,         \
+                        const data_type *left) {                            \
     int r, c;                                                               \
     double buf[65][66];                                                     \
     const int bw = tx_size_wide[tx_size];                                   \
@@ -1033,8 +1034,9 @@ void av1_upsample_intra_edge_high_c(uint16_t *p, int sz, int bd) {
 
 #define ADAPT_FILTER_INTRA_DEFINE_PRED_FUNC_COL_MAJOR(                      \
     func_name, pred_expression, data_type)                                  \
-  void func_name(data_type *dst, int stride, TX_SIZE tx_size, double *filt, \
-                 const data_type *above, const data_type *left) {           \
+  static void func_name(data_type *dst, int stride, TX_SIZE tx_size,        \
+                        const double *filt, const data_type *above,         \
+                        const data_type *left) {                            \
     int r, c;                                                               \
     double buf[66][65];                                                     \
     const int bw = tx_size_wide[tx_size];                                   \
@@ -1105,7 +1107,7 @@ static const adapt_filter_intra_accum_fn_hbd
 // Whenever coefficent for the bottom-left pixel is non-zero, we are forced to
 // do the prediction in the column-major order.
 typedef void (*adapt_filter_intra_pred_fn)(uint8_t *dst, int stride,
-                                           TX_SIZE tx_size, double *filt,
+                                           TX_SIZE tx_size, const double *filt,
                                            const uint8_t *above,
                                            const uint8_t *left);
 ADAPT_FILTER_INTRA_DEFINE_PRED_FUNC_ROW_MAJOR(adapt_filter_intra_pred_0,
@@ -1155,7 +1157,8 @@ static const adapt_filter_intra_pred_fn
     };
 
 typedef void (*adapt_filter_intra_pred_fn_hbd)(uint16_t *dst, int stride,
-                                               TX_SIZE tx_size, double *filt,
+                                               TX_SIZE tx_size,
+                                               const double *filt,
                                                const uint16_t *above,
                                                const uint16_t *left);
 ADAPT_FILTER_INTRA_DEFINE_PRED_FUNC_ROW_MAJOR(adapt_filter_intra_pred_0_hbd,
@@ -1203,6 +1206,30 @@ static const adapt_filter_intra_pred_fn_hbd
       adapt_filter_intra_pred_6_hbd
     };
 
+void av1_adapt_filter_intra_accum_c(const uint8_t *src, int stride, int w,
+                                    int h, int mode, int64_t *stats) {
+  adapt_filter_intra_accum_fns[mode](src, stride, w, h, stats);
+}
+
+void av1_adapt_filter_intra_accum_hbd_c(const uint16_t *src, int stride, int w,
+                                        int h, int mode, int64_t *stats) {
+  adapt_filter_intra_accum_fns_hbd[mode](src, stride, w, h, stats);
+}
+
+void av1_adapt_filter_intra_pred_c(uint8_t *dst, int stride, TX_SIZE tx_size,
+                                   const double *filt, const uint8_t *above,
+                                   const uint8_t *left, int mode) {
+  adapt_filter_intra_pred_fns[mode](dst, stride, tx_size, filt, above, left);
+}
+
+void av1_adapt_filter_intra_pred_hbd_c(uint16_t *dst, int stride,
+                                       TX_SIZE tx_size, const double *filt,
+                                       const uint16_t *above,
+                                       const uint16_t *left, int mode) {
+  adapt_filter_intra_pred_fns_hbd[mode](dst, stride, tx_size, filt, above,
+                                        left);
+}
+
 // Define the parameters that describe the shape of the region used to fit the
 // filter, i.e. the training region (separately for each transform size and
 // adaptive filter intra mode)
@@ -1679,39 +1706,42 @@ static void adapt_filter_intra_accumulate_stats(
       AOMMIN(n_top_px + n_topright_px, txwpx + top_right_offs);
   const int left_height =
       AOMMIN(n_left_px + n_bottomleft_px, txhpx + bottom_left_offs);
-  const adapt_filter_intra_accum_fn accum_fn =
-      adapt_filter_intra_accum_fns[mode];
 
   if (adapt_filter_intra_top_allowed[mode] &&
       adapt_filter_intra_left_allowed[mode]) {
     if (n_top_px > 0 && n_left_px > 0) {
-      accum_fn(ref - up_offs * stride, stride, top_width + w_adjust,
-               up_offs + h_adjust, dst_stats);
-      accum_fn(ref - left_offs, stride, left_offs + w_adjust,
-               left_height + h_adjust, dst_stats);
-      accum_fn(ref - up_offs * stride - left_offs, stride, left_offs, up_offs,
-               dst_stats);
+      av1_adapt_filter_intra_accum(ref - up_offs * stride, stride,
+                                   top_width + w_adjust, up_offs + h_adjust,
+                                   mode, dst_stats);
+      av1_adapt_filter_intra_accum(ref - left_offs, stride,
+                                   left_offs + w_adjust, left_height + h_adjust,
+                                   mode, dst_stats);
+      av1_adapt_filter_intra_accum(ref - up_offs * stride - left_offs, stride,
+                                   left_offs, up_offs, mode, dst_stats);
     } else if (n_top_px > 0) {
-      accum_fn(ref - up_offs * stride + 1, stride, top_width - 1 + w_adjust,
-               up_offs + h_adjust, dst_stats);
+      av1_adapt_filter_intra_accum(ref - up_offs * stride + 1, stride,
+                                   top_width - 1 + w_adjust, up_offs + h_adjust,
+                                   mode, dst_stats);
     } else if (n_left_px > 0) {
-      accum_fn(ref + stride - left_offs, stride, left_offs + w_adjust,
-               left_height - 1 + h_adjust, dst_stats);
+      av1_adapt_filter_intra_accum(ref + stride - left_offs, stride,
+                                   left_offs + w_adjust,
+                                   left_height - 1 + h_adjust, mode, dst_stats);
     }
   } else if (adapt_filter_intra_top_allowed[mode]) {
     const int extra_offs = (n_left_px > 0 || bottom_left_offs <= 0)
                                ? AOMMIN(bottom_left_offs, px_col)
                                : 0;
-    accum_fn(ref - up_offs * stride - (extra_offs - 1), stride,
-             top_width + extra_offs - 1 + w_adjust, up_offs + h_adjust,
-             dst_stats);
+    av1_adapt_filter_intra_accum(ref - up_offs * stride - (extra_offs - 1),
+                                 stride, top_width + extra_offs - 1 + w_adjust,
+                                 up_offs + h_adjust, mode, dst_stats);
   } else if (adapt_filter_intra_left_allowed[mode]) {
     const int extra_offs = (n_top_px > 0 || top_right_offs <= 0)
                                ? AOMMIN(top_right_offs, px_row)
                                : 0;
-    accum_fn(ref - (extra_offs - 1) * stride - left_offs, stride,
-             left_offs + w_adjust, left_height + extra_offs - 1 + h_adjust,
-             dst_stats);
+    av1_adapt_filter_intra_accum(ref - (extra_offs - 1) * stride - left_offs,
+                                 stride, left_offs + w_adjust,
+                                 left_height + extra_offs - 1 + h_adjust, mode,
+                                 dst_stats);
   }
 }
 
@@ -1737,38 +1767,44 @@ static void adapt_filter_intra_accumulate_stats_hbd(
   const int left_height =
       AOMMIN(n_left_px + n_bottomleft_px, txhpx + bottom_left_offs);
 
-  const adapt_filter_intra_accum_fn_hbd accum_fn =
-      adapt_filter_intra_accum_fns_hbd[mode];
   if (adapt_filter_intra_top_allowed[mode] &&
       adapt_filter_intra_left_allowed[mode]) {
     if (n_top_px > 0 && n_left_px > 0) {
-      accum_fn(ref - up_offs * stride, stride, top_width + w_adjust,
-               up_offs + h_adjust, dst_stats);
-      accum_fn(ref - left_offs, stride, left_offs + w_adjust,
-               left_height + h_adjust, dst_stats);
-      accum_fn(ref - up_offs * stride - left_offs, stride, left_offs, up_offs,
-               dst_stats);
+      av1_adapt_filter_intra_accum_hbd(ref - up_offs * stride, stride,
+                                       top_width + w_adjust,
+                                       up_offs + h_adjust, mode, dst_stats);
+      av1_adapt_filter_intra_accum_hbd(ref - left_offs, stride,
+                                       left_offs + w_adjust,
+                                       left_height + h_adjust, mode, dst_stats);
+      av1_adapt_filter_intra_accum_hbd(ref - up_offs * stride - left_offs,
+                                       stride, left_offs, up_offs, mode,
+                                       dst_stats);
     } else if (n_top_px > 0) {
-      accum_fn(ref - up_offs * stride + 1, stride, top_width - 1 + w_adjust,
-               up_offs + h_adjust, dst_stats);
+      av1_adapt_filter_intra_accum_hbd(ref - up_offs * stride + 1, stride,
+                                       top_width - 1 + w_adjust,
+                                       up_offs + h_adjust, mode, dst_stats);
     } else if (n_left_px > 0) {
-      accum_fn(ref + stride - left_offs, stride, left_offs + w_adjust,
-               left_height - 1 + h_adjust, dst_stats);
+      av1_adapt_filter_intra_accum_hbd(ref + stride - left_offs, stride,
+                                       left_offs + w_adjust,
+                                       left_height - 1 + h_adjust, mode,
+                                       dst_stats);
     }
   } else if (adapt_filter_intra_top_allowed[mode]) {
     const int extra_offs = (n_left_px > 0 || bottom_left_offs <= 0)
                                ? AOMMIN(bottom_left_offs, px_col)
                                : 0;
-    accum_fn(ref - up_offs * stride - (extra_offs - 1), stride,
-             top_width + extra_offs - 1 + w_adjust, up_offs + h_adjust,
-             dst_stats);
+    av1_adapt_filter_intra_accum_hbd(
+        ref - up_offs * stride - (extra_offs - 1), stride,
+        top_width + extra_offs - 1 + w_adjust, up_offs + h_adjust, mode,
+        dst_stats);
   } else if (adapt_filter_intra_left_allowed[mode]) {
     const int extra_offs = (n_top_px > 0 || top_right_offs <= 0)
                                ? AOMMIN(top_right_offs, px_row)
                                : 0;
-    accum_fn(ref - (extra_offs - 1) * stride - left_offs, stride,
-             left_offs + w_adjust, left_height + extra_offs - 1 + h_adjust,
-             dst_stats);
+    av1_adapt_filter_intra_accum_hbd(
+        ref - (extra_offs - 1) * stride - left_offs, stride,
+        left_offs + w_adjust, left_height + extra_offs - 1 + h_adjust, mode,
+        dst_stats);
   }
 }
 
@@ -1855,21 +1891,10 @@ static void adapt_filter_intra_solve_4x4(const int64_t *coefs,
   dst_solution[3] = (double)det4 / (double)base_det;
 }
 
-static void adapt_filter_intra_predictor(
-    uint8_t *dst, ptrdiff_t dst_stride, const uint8_t *ref,
-    ptrdiff_t ref_stride, int n_top_px, int n_topright_px, int n_left_px,
-    int n_bottomleft_px, TX_SIZE tx_size, const uint8_t *above_row,
-    const uint8_t *left_col, int mode, int px_row, int px_col) {
-  // Form a linear system of equations from the statistics collected over the
-  // training region around the current transform unit:
-  int64_t accumulated_stats[14] = { 0 };
-  adapt_filter_intra_accumulate_stats(ref, ref_stride, tx_size, n_top_px,
-                                      n_topright_px, n_left_px, n_bottomleft_px,
-                                      accumulated_stats, px_row, px_col, mode);
-
-  // Apply regularization and solve the resulting system to get the adaptive
-  // filter coefficients:
-  double adapt_filter[4] = { 0 };
+// Applies regularization to the accumulated statistics and solves the resulting
+// system to get the adaptive filter coefficients.
+static void adapt_filter_intra_solve(int64_t *accumulated_stats, int mode,
+                                     double *adapt_filter) {
   if (adapt_filter_intra_num_taps[mode] == 3) {
     accumulated_stats[0] += adapt_filter_intra_regularization_coef;
     accumulated_stats[2] += adapt_filter_intra_regularization_coef;
@@ -1884,45 +1909,105 @@ static void adapt_filter_intra_predictor(
   } else {
     assert(0);
   }
+}
+
+// Returns the coefficient cache slot for the given transform block, or NULL if
+// the block's coefficients can not be cached. The training region of a
+// transform block at the top (resp. left) edge of the coding block lies
+// entirely above (resp. to the left of) it, so its pixels do not change while
+// the encoder searches the current block. '*hit' is set if the slot already
+// holds the coefficients of this transform block.
+static ADAPT_FILTER_INTRA_COEFFS *adapt_filter_intra_cache_slot(
+    const MACROBLOCKD *xd, int plane, TX_SIZE tx_size, int mode, int row_off,
+    int col_off, int px_row, int px_col, int n_top_px, int n_topright_px,
+    int n_left_px, int n_bottomleft_px, int *hit) {
+  ADAPT_FILTER_INTRA_CACHE *const cache = xd->adapt_filter_intra_cache;
+  *hit = 0;
+  if (cache == NULL) return NULL;
+  if (row_off != 0 && adapt_filter_intra_top_allowed[mode]) return NULL;
+  if (col_off != 0 && adapt_filter_intra_left_allowed[mode]) return NULL;
+
+  ADAPT_FILTER_INTRA_COEFFS *const slot = &cache->entry[tx_size][mode];
+  *hit = slot->generation == cache->generation && slot->plane == plane &&
+         slot->px_row == px_row && slot->px_col == px_col &&
+         slot->n_top_px == n_top_px && slot->n_topright_px == n_topright_px &&
+         slot->n_left_px == n_left_px &&
+         slot->n_bottomleft_px == n_bottomleft_px;
+  if (!*hit) {
+    slot->generation = cache->generation;
+    slot->plane = plane;
+    slot->px_row = px_row;
+    slot->px_col = px_col;
+    slot->n_top_px = n_top_px;
+    slot->n_topright_px = n_topright_px;
+    slot->n_left_px = n_left_px;
+    slot->n_bottomleft_px = n_bottomleft_px;
+  }
+  return slot;
+}
+
+static void adapt_filter_intra_predictor(
+    const MACROBLOCKD *xd, uint8_t *dst, ptrdiff_t dst_stride,
+    const uint8_t *ref, ptrdiff_t ref_stride, int n_top_px, int n_topright_px,
+    int n_left_px, int n_bottomleft_px, TX_SIZE tx_size,
+    const uint8_t *above_row, const uint8_t *left_col, int mode, int plane,
+    int row_off, int col_off) {
+  const int px_row = (-xd->mb_to_top_edge >> 3) + (row_off << MI_SIZE_LOG2);
+  const int px_col = (-xd->mb_to_left_edge >> 3) + (col_off << MI_SIZE_LOG2);
+  int hit;
+  ADAPT_FILTER_INTRA_COEFFS *const slot = adapt_filter_intra_cache_slot(
+      xd, plane, tx_size, mode, row_off, col_off, px_row, px_col, n_top_px,
+      n_topright_px, n_left_px, n_bottomleft_px, &hit);
+
+  double adapt_filter[4] = { 0 };
+  if (hit) {
+    memcpy(adapt_filter, slot->filt, sizeof(adapt_filter));
+  } else {
+    // Form a linear system of equations from the statistics collected over
+    // the training region around the current transform unit:
+    int64_t accumulated_stats[14] = { 0 };
+    adapt_filter_intra_accumulate_stats(
+        ref, (int)ref_stride, tx_size, n_top_px, n_topright_px, n_left_px,
+        n_bottomleft_px, accumulated_stats, px_row, px_col, mode);
+    adapt_filter_intra_solve(accumulated_stats, mode, adapt_filter);
+    if (slot) memcpy(slot->filt, adapt_filter, sizeof(adapt_filter));
+  }
 
   // Finally, perform prediction using the fit filter coefficients:
-  adapt_filter_intra_pred_fns[mode](dst, dst_stride, tx_size, adapt_filter,
-                                    above_row, left_col);
+  av1_adapt_filter_intra_pred(dst, (int)dst_stride, tx_size, adapt_filter,
+                              above_row, left_col, mode);
 }
 
 static void adapt_filter_intra_predictor_hbd(
-    uint16_t *dst, ptrdiff_t dst_stride, const uint16_t *ref,
-    ptrdiff_t ref_stride, int n_top_px, int n_topright_px, int n_left_px,
-    int n_bottomleft_px, TX_SIZE tx_size, const uint16_t *above_row,
-    const uint16_t *left_col, int mode, int px_row, int px_col) {
-  // Form a linear system of equations from the statistics collected over the
-  // training region around the current transform unit:
-  int64_t accumulated_stats[14] = { 0 };
-  adapt_filter_intra_accumulate_stats_hbd(
-      ref, ref_stride, tx_size, n_top_px, n_topright_px, n_left_px,
-      n_bottomleft_px, accumulated_stats, px_row, px_col, mode);
-
-  // Apply regularization and solve the resulting system to get the adaptive
-  // filter coefficients:
+    const MACROBLOCKD *xd, uint16_t *dst, ptrdiff_t dst_stride,
+    const uint16_t *ref, ptrdiff_t ref_stride, int n_top_px, int n_topright_px,
+    int n_left_px, int n_bottomleft_px, TX_SIZE tx_size,
+    const uint16_t *above_row, const uint16_t *left_col, int mode, int plane,
+    int row_off, int col_off) {
+  const int px_row = (-xd->mb_to_top_edge >> 3) + (row_off << MI_SIZE_LOG2);
+  const int px_col = (-xd->mb_to_left_edge >> 3) + (col_off << MI_SIZE_LOG2);
+  int hit;
+  ADAPT_FILTER_INTRA_COEFFS *const slot = adapt_filter_intra_cache_slot(
+      xd, plane, tx_size, mode, row_off, col_off, px_row, px_col, n_top_px,
+      n_topright_px, n_left_px, n_bottomleft_px, &hit);
+
   double adapt_filter[4] = { 0 };
-  if (adapt_filter_intra_num_taps[mode] == 3) {
-    accumulated_stats[0] += adapt_filter_intra_regularization_coef;
-    accumulated_stats[2] += adapt_filter_intra_regularization_coef;
-    accumulated_stats[5] += adapt_filter_intra_regularization_coef;
-    adapt_filter_intra_solve_3x3(accumulated_stats, adapt_filter);
-  } else if (adapt_filter_intra_num_taps[mode] == 4) {
-    accumulated_stats[0] += adapt_filter_intra_regularization_coef;
-    accumulated_stats[2] += adapt_filter_intra_regularization_coef;
-    accumulated_stats[5] += adapt_filter_intra_regularization_coef;
-    accumulated_stats[9] += adapt_filter_intra_regularization_coef;
-    adapt_filter_intra_solve_4x4(accumulated_stats, adapt_filter);
+  if (hit) {
+    memcpy(adapt_filter, slot->filt, sizeof(adapt_filter));
   } else {
-    assert(0);
+    // Form a linear system of equations from the statistics collected over
+    // the training region around the current transform unit:
+    int64_t accumulated_stats[14] = { 0 };
+    adapt_filter_intra_accumulate_stats_hbd(
+        ref, (int)ref_stride, tx_size, n_top_px, n_topright_px, n_left_px,
+        n_bottomleft_px, accumulated_stats, px_row, px_col, mode);
+    adapt_filter_intra_solve(accumulated_stats, mode, adapt_filter);
+    if (slot) memcpy(slot->filt, adapt_filter, sizeof(adapt_filter));
   }
 
   // Finally, perform prediction using the fit filter coefficients:
-  adapt_filter_intra_pred_fns_hbd[mode](dst, dst_stride, tx_size, adapt_filter,
-                                        above_row, left_col);
+  av1_adapt_filter_intra_pred_hbd(dst, (int)dst_stride, tx_size, adapt_filter,
+                                  above_row, left_col, mode);
 }
 #endif  // CONFIG_ADAPT_FILTER_INTRA
 
@@ -2081,12 +2166,10 @@ static void build_intra_predictors_high(
   }
 #if CONFIG_ADAPT_FILTER_INTRA
   if (use_adapt_filter_intra) {
-    const int px_row = (-xd->mb_to_top_edge >> 3) + (row_off << MI_SIZE_LOG2);
-    const int px_col = (-xd->mb_to_left_edge >> 3) + (col_off << MI_SIZE_LOG2);
-    adapt_filter_intra_predictor_hbd(dst, dst_stride, ref, ref_stride, n_top_px,
-                                     n_topright_px, n_left_px, n_bottomleft_px,
-                                     tx_size, above_row, left_col,
-                                     adapt_filter_intra_mode, px_row, px_col);
+    adapt_filter_intra_predictor_hbd(
+        xd, dst, dst_stride, ref, ref_stride, n_top_px, n_topright_px,
+        n_left_px, n_bottomleft_px, tx_size, above_row, left_col,
+        adapt_filter_intra_mode, plane, row_off, col_off);
     return;
   }
 #endif  // CONFIG_ADAPT_FILTER_INTRA
@@ -2552,12 +2635,10 @@ static void build_intra_predictors(
 
 #if CONFIG_ADAPT_FILTER_INTRA
   if (use_adapt_filter_intra) {
-    const int px_row = (-xd->mb_to_top_edge >> 3) + (row_off << MI_SIZE_LOG2);
-    const int px_col = (-xd->mb_to_left_edge >> 3) + (col_off << MI_SIZE_LOG2);
-    adapt_filter_intra_predictor(dst, dst_stride, ref, ref_stride, n_top_px,
-                                 n_topright_px, n_left_px, n_bottomleft_px,
-                                 tx_size, above_row, left_col,
-                                 adapt_filter_intra_mode, px_row, px_col);
+    adapt_filter_intra_predictor(
+        xd, dst, dst_stride, ref, ref_stride, n_top_px, n_topright_px,
+        n_left_px, n_bottomleft_px, tx_size, above_row, left_col,
+        adapt_filter_intra_mode, plane, row_off, col_off);
     return;
   }
 #endif  // CONFIG_ADAPT_FILTER_INTRA
@@ -1815,30 +1815,33 @@ static void copy_buffer_config(const YV12_BUFFER_CONFIG *const src,
 // TODO(afergs): Look for in-place upscaling
 // TODO(afergs): aom_ vs av1_ functions? Which can I use?
 // Upscale decoded image.
-void av1_superres_upscale(AV1_COMMON *cm, BufferPool *const pool) {
+void av1_superres_upscale(AV1_COMMON *cm, BufferPool *const pool,
+                          YV12_BUFFER_CONFIG *scratch) {
   const int num_planes = av1_num_planes(cm);
   if (!av1_superres_scaled(cm)) return;
   const SequenceHeader *const seq_params = &cm->seq_params;
 
-  YV12_BUFFER_CONFIG copy_buffer;
-  memset(&copy_buffer, 0, sizeof(copy_buffer));
+  YV12_BUFFER_CONFIG local_copy_buffer;
+  YV12_BUFFER_CONFIG *const copy_buffer =
+      scratch != NULL ? scratch : &local_copy_buffer;
+  if (scratch == NULL) memset(&local_copy_buffer, 0, sizeof(local_copy_buffer));
 
   YV12_BUFFER_CONFIG *const frame_to_show = &cm->cur_frame->buf;
 
   const int aligned_width = ALIGN_POWER_OF_TWO(cm->width, 3);
-  if (aom_alloc_frame_buffer(
-          &copy_buffer, aligned_width, cm->height, seq_params->subsampling_x,
+  if (aom_realloc_frame_buffer(
+          copy_buffer, aligned_width, cm->height, seq_params->subsampling_x,
           seq_params->subsampling_y, seq_params->use_highbitdepth,
-          AOM_BORDER_IN_PIXELS, cm->byte_alignment))
+          AOM_BORDER_IN_PIXELS, cm->byte_alignment, NULL, NULL, NULL))
     aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
                        "Failed to allocate copy buffer for superres upscaling");
 
   // Copy function assumes the frames are the same size.
   // Note that it does not copy YV12_BUFFER_CONFIG config data.
-  aom_yv12_copy_frame(frame_to_show, &copy_buffer, num_planes);
+  aom_yv12_copy_frame(frame_to_show, copy_buffer, num_planes);
 
-  assert(copy_buffer.y_crop_width == aligned_width);
-  assert(copy_buffer.y_crop_height == cm->height);
+  assert(copy_buffer->y_crop_width == aligned_width);
+  assert(copy_buffer->y_crop_height == cm->height);
 
   // Realloc the current frame buffer at a higher resolution in place.
   if (pool != NULL) {
@@ -1870,7 +1873,7 @@ void av1_superres_upscale(AV1_COMMON *cm, BufferPool *const pool) {
     unlock_buffer_pool(pool);
   } else {
     // Make a copy of the config data for frame_to_show in copy_buffer
-    copy_buffer_config(frame_to_show, &copy_buffer);
+    copy_buffer_config(frame_to_show, copy_buffer);
 
     // Don't use callbacks on the encoder.
     // aom_alloc_frame_buffer() clears the config data for frame_to_show
@@ -1884,7 +1887,7 @@ void av1_superres_upscale(AV1_COMMON *cm, BufferPool *const pool) {
           "Failed to reallocate current frame buffer for superres upscaling");
 
     // Restore config data back to frame_to_show
-    copy_buffer_config(&copy_buffer, frame_to_show);
+    copy_buffer_config(copy_buffer, frame_to_show);
   }
   // TODO(afergs): verify frame_to_show is correct after realloc
   //               encoder:
@@ -1895,10 +1898,10 @@ void av1_superres_upscale(AV1_COMMON *cm, BufferPool *const pool) {
 
   // Scale up and back into frame_to_show.
   assert(frame_to_show->y_crop_width != cm->width);
-  av1_upscale_normative_and_extend_frame(cm, &copy_buffer, frame_to_show);
+  av1_upscale_normative_and_extend_frame(cm, copy_buffer, frame_to_show);
 
-  // Free the copy buffer
-  aom_free_frame_buffer(&copy_buffer);
+  // Free the copy buffer, unless it is the caller's.
+  if (scratch == NULL) aom_free_frame_buffer(&local_copy_buffer);
 }
 
 #if CONFIG_SUPERRES_TX64 || CONFIG_DSPL_RESIDUAL
@@ -92,7 +92,10 @@ void av1_calculate_scaled_superres_size(int *width, int *height,
 // denominator.
 void av1_calculate_unscaled_superres_size(int *width, int *height, int denom);
 
-void av1_superres_upscale(AV1_COMMON *cm, BufferPool *const pool);
+// Upscales cm->cur_frame in place. The downscaled frame is copied to scratch
+// first, or to a temporary buffer if scratch is NULL.
+void av1_superres_upscale(AV1_COMMON *cm, BufferPool *const pool,
+                          YV12_BUFFER_CONFIG *scratch);
 
 // Returns 1 if a superres upscaled frame is scaled and 0 otherwise.
 static INLINE int av1_superres_scaled(const AV1_COMMON *cm) {
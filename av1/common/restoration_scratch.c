@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "aom_mem/aom_mem.h"
+#include "av1/common/restoration_scratch.h"
+
+void av1_rst_scratch_init(RestorationScratch *scratch) {
+  memset(scratch, 0, sizeof(*scratch));
+}
+
+static void release_slot(RestorationScratch *scratch, int slot) {
+  aom_free(scratch->buf[slot]);
+  scratch->buf[slot] = NULL;
+  scratch->total_size -= scratch->size[slot];
+  scratch->size[slot] = 0;
+}
+
+void av1_rst_scratch_set_frame_size(RestorationScratch *scratch, int width,
+                                    int height) {
+  if (scratch->width == width && scratch->height == height) return;
+  av1_rst_scratch_free(scratch);
+  scratch->width = width;
+  scratch->height = height;
+}
+
+void *av1_rst_scratch_get(RestorationScratch *scratch, int slot, size_t size) {
+  assert(slot >= 0 && slot < RST_SCRATCH_SLOTS);
+  if (scratch->size[slot] >= size) return scratch->buf[slot];
+
+  release_slot(scratch, slot);
+  scratch->buf[slot] = aom_memalign(32, size);
+  if (scratch->buf[slot] == NULL) return NULL;
+  scratch->size[slot] = size;
+  scratch->total_size += size;
+  if (scratch->total_size > scratch->peak_size) {
+    scratch->peak_size = scratch->total_size;
+  }
+  ++scratch->num_allocs;
+  return scratch->buf[slot];
+}
+
+void av1_rst_scratch_trim(RestorationScratch *scratch) {
+  if (!scratch->limit) return;
+  while (scratch->total_size > scratch->limit) {
+    int largest = 0;
+    for (int slot = 1; slot < RST_SCRATCH_SLOTS; ++slot) {
+      if (scratch->size[slot] > scratch->size[largest]) largest = slot;
+    }
+    release_slot(scratch, largest);
+  }
+}
+
+void av1_rst_scratch_free(RestorationScratch *scratch) {
+  for (int slot = 0; slot < RST_SCRATCH_SLOTS; ++slot) {
+    release_slot(scratch, slot);
+  }
+  assert(scratch->total_size == 0);
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#ifndef AOM_AV1_COMMON_RESTORATION_SCRATCH_H_
+#define AOM_AV1_COMMON_RESTORATION_SCRATCH_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of luma planes MFQE works on: the current frame and its references.
+#define RST_SCRATCH_MFQE_PLANES 4
+// Number of intermediate tensors a CNN prediction can keep in scratch.
+#define RST_SCRATCH_CNN_TENSORS 10
+
+// Scratch buffers of the frame-level restoration tools.
+enum {
+  // Copy of the current luma plane that MFQE filters.
+  RST_SCRATCH_MFQE_FRAME,
+  // MFQE block being blended.
+  RST_SCRATCH_MFQE_BLOCK,
+  // Blurred MFQE planes: the current frame, then the references.
+  RST_SCRATCH_MFQE_LOW,
+  // Upsampled MFQE planes: the current frame, then the references.
+  RST_SCRATCH_MFQE_SUB = RST_SCRATCH_MFQE_LOW + RST_SCRATCH_MFQE_PLANES,
+  // CNN input tensor.
+  RST_SCRATCH_CNN_INPUT = RST_SCRATCH_MFQE_SUB + RST_SCRATCH_MFQE_PLANES,
+  // CNN output plane.
+  RST_SCRATCH_CNN_OUTPUT,
+  // CNN intermediate tensors.
+  RST_SCRATCH_CNN_TENSOR,
+  RST_SCRATCH_SLOTS = RST_SCRATCH_CNN_TENSOR + RST_SCRATCH_CNN_TENSORS
+};
+
+// Persistent scratch memory for MFQE and CNN restoration. Each slot holds a
+// 32-byte aligned buffer that only grows, so after the first frame of a given
+// size the tools run without allocating. All buffers are released when the
+// frame size changes. The contents of a buffer are undefined when it is
+// handed out. The scratch is not thread safe: it must have a single user at a
+// time.
+typedef struct RestorationScratch {
+  void *buf[RST_SCRATCH_SLOTS];
+  size_t size[RST_SCRATCH_SLOTS];
+  // Frame dimensions the buffers were sized for.
+  int width;
+  int height;
+  // Bytes currently held by all slots.
+  size_t total_size;
+  // Largest total_size seen since the scratch was initialized.
+  size_t peak_size;
+  // Number of allocations made, for profiling.
+  int num_allocs;
+  // If non-zero, av1_rst_scratch_trim() releases buffers until no more than
+  // this many bytes are held.
+  size_t limit;
+} RestorationScratch;
+
+void av1_rst_scratch_init(RestorationScratch *scratch);
+
+// Releases all buffers if the frame size differs from the last call.
+void av1_rst_scratch_set_frame_size(RestorationScratch *scratch, int width,
+                                    int height);
+
+// Returns the buffer of the given slot, grown to at least size bytes, or NULL
+// on allocation failure.
+void *av1_rst_scratch_get(RestorationScratch *scratch, int slot, size_t size);
+
+// Releases buffers, largest first, until the scratch holds no more than its
+// limit. Called by the tools once they are done with a frame.
+void av1_rst_scratch_trim(RestorationScratch *scratch);
+
+// Releases all buffers. The peak size and limit are kept.
+void av1_rst_scratch_free(RestorationScratch *scratch);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AOM_AV1_COMMON_RESTORATION_SCRATCH_H_
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <emmintrin.h>
+
+#include "config/av1_rtcd.h"
+
+#include "aom_dsp/x86/synonyms.h"
+#include "av1/common/common_data.h"
+
+#if CONFIG_ADAPT_FILTER_INTRA
+#define AFI_MAX_TAPS 4
+#define AFI_NUM_STATS 14
+
+// Taps used by each mode, in the order the statistics are laid out. Tap k
+// refers to the neighbor at (row + afi_tap_dr[k], col + afi_tap_dc[k]).
+static const int afi_num_taps[ADAPT_FILTER_INTRA_MODES] = { 3, 3, 3, 4,
+                                                            4, 3, 3 };
+static const int afi_taps[ADAPT_FILTER_INTRA_MODES][AFI_MAX_TAPS] = {
+  { 1, 2, 3, 0 }, { 0, 1, 3, 0 }, { 1, 3, 4, 0 }, { 0, 1, 2, 3 },
+  { 1, 2, 3, 4 }, { 0, 2, 3, 0 }, { 1, 2, 4, 0 },
+};
+static const int afi_tap_dr[5] = { 1, 0, -1, -1, -1 };
+static const int afi_tap_dc[5] = { -1, -1, -1, 0, 1 };
+
+// Loads 8 pixels of one row, or 4 pixels of each of two rows, as 16-bit lanes.
+static INLINE __m128i afi_load_8(const void *src, int hbd) {
+  if (hbd) return _mm_loadu_si128((const __m128i *)src);
+  return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src),
+                           _mm_setzero_si128());
+}
+
+static INLINE __m128i afi_load_4x2(const void *src, int stride, int two_rows,
+                                   int hbd) {
+  if (hbd) {
+    const uint16_t *p = (const uint16_t *)src;
+    const __m128i lo = _mm_loadl_epi64((const __m128i *)p);
+    const __m128i hi = two_rows ? _mm_loadl_epi64((const __m128i *)(p + stride))
+                                : _mm_setzero_si128();
+    return _mm_unpacklo_epi64(lo, hi);
+  }
+  const uint8_t *p = (const uint8_t *)src;
+  const __m128i lo = xx_loadl_32(p);
+  const __m128i hi = two_rows ? xx_loadl_32(p + stride) : _mm_setzero_si128();
+  return _mm_unpacklo_epi8(_mm_unpacklo_epi32(lo, hi), _mm_setzero_si128());
+}
+
+// Accumulates the pairwise products of the taps and the source pixels in the
+// same layout as the C version: the upper triangle of the tap correlation
+// matrix column by column, followed by the tap-source correlations.
+static INLINE void afi_accum_group(const __m128i *v, int n, __m128i x,
+                                   __m128i *acc) {
+  int k = 0;
+  for (int b = 0; b < n; ++b) {
+    for (int a = 0; a <= b; ++a, ++k) {
+      acc[k] = _mm_add_epi32(acc[k], _mm_madd_epi16(v[a], v[b]));
+    }
+  }
+  for (int a = 0; a < n; ++a, ++k) {
+    acc[k] = _mm_add_epi32(acc[k], _mm_madd_epi16(v[a], x));
+  }
+}
+
+static INLINE void afi_flush(__m128i *acc32, __m128i *acc64, int num_stats) {
+  const __m128i zero = _mm_setzero_si128();
+  for (int k = 0; k < num_stats; ++k) {
+    acc64[k] = _mm_add_epi64(acc64[k], _mm_unpacklo_epi32(acc32[k], zero));
+    acc64[k] = _mm_add_epi64(acc64[k], _mm_unpackhi_epi32(acc32[k], zero));
+    acc32[k] = zero;
+  }
+}
+
+// Regions at least 8 pixels wide are processed 8 columns at a time, with the
+// last group shifted left so it ends at the region boundary. Narrower regions
+// (the left context strips) are processed two rows at a time, 4 columns per
+// row; for regions narrower than 4 pixels this reads up to 3 pixels past the
+// right edge of the region, which are masked out.
+static INLINE void afi_accum_kernel(const void *src, int stride, int w, int h,
+                                    int mode, int64_t *stats, int hbd) {
+  if (w <= 0 || h <= 0) return;
+  const int n = afi_num_taps[mode];
+  const int num_stats = n * (n + 1) / 2 + n;
+  // The 32-bit lane accumulators must be flushed before they can overflow:
+  // each group adds at most 2 products of two pixels to a lane.
+  const int max_groups = hbd ? 64 : 16384;
+  const int px_size = hbd ? 2 : 1;
+  const char *const base = (const char *)src;
+  __m128i acc32[AFI_NUM_STATS], acc64[AFI_NUM_STATS];
+  int tap_offset[AFI_MAX_TAPS];
+  for (int k = 0; k < num_stats; ++k) {
+    acc32[k] = _mm_setzero_si128();
+    acc64[k] = _mm_setzero_si128();
+  }
+  for (int a = 0; a < n; ++a) {
+    const int t = afi_taps[mode][a];
+    tap_offset[a] = (afi_tap_dr[t] * stride + afi_tap_dc[t]) * px_size;
+  }
+
+  const int wide = w >= 8;
+  const int group_w = wide ? 8 : 4;
+  const int row_step = wide ? 1 : 2;
+  const __m128i lane_col = wide ? _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7)
+                                : _mm_setr_epi16(0, 1, 2, 3, 0, 1, 2, 3);
+  int groups = 0;
+  for (int i = 0; i < h; i += row_step) {
+    const int two_rows = i + 1 < h;
+    for (int j = 0; j < w; j += group_w) {
+      const int j0 = w >= group_w ? AOMMIN(j, w - group_w) : 0;
+      const char *const p = base + (i * stride + j0) * px_size;
+      __m128i v[AFI_MAX_TAPS], x;
+      if (wide) {
+        x = afi_load_8(p, hbd);
+        for (int a = 0; a < n; ++a) v[a] = afi_load_8(p + tap_offset[a], hbd);
+      } else {
+        x = afi_load_4x2(p, stride, two_rows, hbd);
+        for (int a = 0; a < n; ++a) {
+          v[a] = afi_load_4x2(p + tap_offset[a], stride, two_rows, hbd);
+        }
+      }
+      if (j0 != j || j0 + group_w > w || (!wide && !two_rows)) {
+        // Only columns [j, w) of the rows in range are new.
+        const __m128i lo = _mm_set1_epi16(j - j0 - 1);
+        const __m128i hi =
+            wide || two_rows ? _mm_set1_epi16(w - j0)
+                             : _mm_setr_epi16(w - j0, w - j0, w - j0, w - j0,
+                                              0, 0, 0, 0);
+        const __m128i mask = _mm_and_si128(_mm_cmpgt_epi16(lane_col, lo),
+                                           _mm_cmpgt_epi16(hi, lane_col));
+        x = _mm_and_si128(x, mask);
+        for (int a = 0; a < n; ++a) v[a] = _mm_and_si128(v[a], mask);
+      }
+      afi_accum_group(v, n, x, acc32);
+      if (++groups == max_groups) {
+        afi_flush(acc32, acc64, num_stats);
+        groups = 0;
+      }
+    }
+  }
+  afi_flush(acc32, acc64, num_stats);
+
+  for (int k = 0; k < num_stats; ++k) {
+    int64_t sum[2];
+    _mm_storeu_si128((__m128i *)sum, acc64[k]);
+    stats[k] += sum[0] + sum[1];
+  }
+}
+
+void av1_adapt_filter_intra_accum_sse2(const uint8_t *src, int stride, int w,
+                                       int h, int mode, int64_t *stats) {
+  afi_accum_kernel(src, stride, w, h, mode, stats, 0);
+}
+
+void av1_adapt_filter_intra_accum_hbd_sse2(const uint16_t *src, int stride,
+                                           int w, int h, int mode,
+                                           int64_t *stats) {
+  afi_accum_kernel(src, stride, w, h, mode, stats, 1);
+}
+
+// Neighbors referenced by the recursive predictor, relative to the pixel being
+// predicted in a row-major scan.
+enum { AFI_L, AFI_AL, AFI_A, AFI_AR };
+
+// Column-major modes (those using the bottom-left neighbor) are predicted as
+// row-major modes on the transposed block. The terms are listed in the order
+// the C version adds them up, so the results are bit-exact.
+static const int afi_pred_transposed[ADAPT_FILTER_INTRA_MODES] = { 0, 1, 0, 1,
+                                                                   0, 1, 0 };
+static const int afi_pred_terms[ADAPT_FILTER_INTRA_MODES][AFI_MAX_TAPS] = {
+  { AFI_L, AFI_AL, AFI_A, 0 },       { AFI_AR, AFI_A, AFI_L, 0 },
+  { AFI_L, AFI_A, AFI_AR, 0 },       { AFI_AR, AFI_A, AFI_AL, AFI_L },
+  { AFI_L, AFI_AL, AFI_A, AFI_AR },  { AFI_AR, AFI_AL, AFI_L, 0 },
+  { AFI_L, AFI_AL, AFI_AR, 0 },
+};
+
+// Rounds the predicted values of one row the same way as the C version and
+// writes them out 'step' pixels apart.
+static INLINE void afi_store_row(const double *vals, int w, uint8_t *dst8,
+                                 uint16_t *dst16, int step) {
+  const __m128d lo_clamp = _mm_set1_pd(0.001);
+  const __m128d hi_clamp = _mm_set1_pd(254.999);
+  const __m128d half = _mm_set1_pd(0.5);
+  for (int c = 0; c < w; c += 2) {
+    const __m128d v = _mm_loadu_pd(vals + c);
+    const __m128i px = _mm_cvttpd_epi32(
+        _mm_add_pd(_mm_min_pd(_mm_max_pd(v, lo_clamp), hi_clamp), half));
+    const int px0 = _mm_cvtsi128_si32(px);
+    const int px1 = _mm_cvtsi128_si32(_mm_srli_si128(px, 4));
+    if (dst16) {
+      dst16[c * step] = (uint16_t)px0;
+      dst16[(c + 1) * step] = (uint16_t)px1;
+    } else {
+      dst8[c * step] = (uint8_t)px0;
+      dst8[(c + 1) * step] = (uint8_t)px1;
+    }
+  }
+}
+
+// Evaluates one wavefront step from the outputs of the previous four steps.
+static AOM_FORCE_INLINE __m128d afi_pred_step(const double *prev, __m128d v1,
+                                              __m128d v2, __m128d v3,
+                                              __m128d v4, const __m128d *f,
+                                              int mode) {
+  const __m128d nb[4] = {
+    v1,                                          // AFI_L
+    _mm_unpacklo_pd(_mm_load_sd(prev), v4),      // AFI_AL
+    _mm_unpacklo_pd(_mm_load_sd(prev + 1), v3),  // AFI_A
+    _mm_unpacklo_pd(_mm_load_sd(prev + 2), v2),  // AFI_AR
+  };
+  __m128d v = _mm_mul_pd(f[0], nb[afi_pred_terms[mode][0]]);
+  for (int a = 1; a < afi_num_taps[mode]; ++a) {
+    v = _mm_add_pd(v, _mm_mul_pd(f[a], nb[afi_pred_terms[mode][a]]));
+  }
+  return v;
+}
+
+// The predictor is evaluated along a wavefront covering two rows at a time,
+// with the second row lagging three columns behind the first: at step t the
+// lanes hold pixels (r, t) and (r + 1, t - 3). This keeps only the left
+// neighbor on the dependency chain between consecutive steps. All neighbors
+// of the second row were produced in the previous four steps, so they are
+// kept in registers; the row above the pair is read from 'prev'.
+static AOM_FORCE_INLINE void afi_pred_kernel(int w, int h, const double *top,
+                                             const double *left,
+                                             const double *filt, int mode,
+                                             uint8_t *dst8, uint16_t *dst16,
+                                             int stride) {
+  const int transposed = afi_pred_transposed[mode];
+  const int row_stride = transposed ? 1 : stride;
+  const int col_stride = transposed ? stride : 1;
+  __m128d f[AFI_MAX_TAPS];
+  // Column c of the row above the pair is kept at prev[c + 1] for c in
+  // [-1, w + 2]; the two rows of the pair at cur[c] and next[c + 1].
+  double row_buf[3][MAX_TX_SIZE + 4] = { { 0 } };
+  double *prev = row_buf[0];
+  double *cur = row_buf[1];
+  double *next = row_buf[2];
+
+  for (int a = 0; a < afi_num_taps[mode]; ++a) f[a] = _mm_set1_pd(filt[a]);
+  for (int c = -1; c <= w; ++c) prev[c + 1] = top[c];
+  next[w + 1] = top[w];
+
+  for (int r = 0; r < h; r += 2) {
+    const int two_rows = r + 1 < h;
+    const double left1 = two_rows ? left[r + 1] : 0;
+    // Outputs of the previous four steps. Initially only pixel (r, -1) is
+    // used.
+    __m128d v1 = _mm_set_sd(left[r]);
+    __m128d v2 = _mm_setzero_pd();
+    __m128d v3 = _mm_setzero_pd();
+    __m128d v4 = _mm_setzero_pd();
+    __m128d v;
+    int t;
+
+    // The second row starts at step 3, right of pixel (r + 1, -1).
+    for (t = 0; t < 3; ++t) {
+      v = afi_pred_step(prev + t, v1, v2, v3, v4, f, mode);
+      _mm_storel_pd(cur + t, v);
+      if (t == 2) v = _mm_unpacklo_pd(v, _mm_set_sd(left1));
+      v4 = v3;
+      v3 = v2;
+      v2 = v1;
+      v1 = v;
+    }
+    for (; t < w; ++t) {
+      v = afi_pred_step(prev + t, v1, v2, v3, v4, f, mode);
+      _mm_storel_pd(cur + t, v);
+      _mm_storeh_pd(next + t - 2, v);
+      v4 = v3;
+      v3 = v2;
+      v2 = v1;
+      v1 = v;
+    }
+    // The first row is done; its column w is equal to top[w].
+    for (; t < w + 3; ++t) {
+      v = afi_pred_step(prev + t, v1, v2, v3, v4, f, mode);
+      v = _mm_move_sd(v, _mm_set_sd(top[w]));
+      _mm_storeh_pd(next + t - 2, v);
+      v4 = v3;
+      v3 = v2;
+      v2 = v1;
+      v1 = v;
+    }
+
+    afi_store_row(cur, w, dst8 ? dst8 + r * row_stride : NULL,
+                  dst16 ? dst16 + r * row_stride : NULL, col_stride);
+    if (!two_rows) break;
+    afi_store_row(next + 1, w, dst8 ? dst8 + (r + 1) * row_stride : NULL,
+                  dst16 ? dst16 + (r + 1) * row_stride : NULL, col_stride);
+
+    next[0] = left1;
+    double *const tmp = prev;
+    prev = next;
+    next = tmp;
+    next[w + 1] = top[w];
+  }
+}
+
+// Instantiates the kernel for each mode so the tap lookups are resolved at
+// compile time.
+static AOM_FORCE_INLINE void afi_pred(int w, int h, const double *top,
+                                      const double *left, const double *filt,
+                                      int mode, uint8_t *dst8, uint16_t *dst16,
+                                      int stride) {
+  switch (mode) {
+    case 0:
+      afi_pred_kernel(w, h, top, left, filt, 0, dst8, dst16, stride);
+      break;
+    case 1:
+      afi_pred_kernel(w, h, top, left, filt, 1, dst8, dst16, stride);
+      break;
+    case 2:
+      afi_pred_kernel(w, h, top, left, filt, 2, dst8, dst16, stride);
+      break;
+    case 3:
+      afi_pred_kernel(w, h, top, left, filt, 3, dst8, dst16, stride);
+      break;
+    case 4:
+      afi_pred_kernel(w, h, top, left, filt, 4, dst8, dst16, stride);
+      break;
+    case 5:
+      afi_pred_kernel(w, h, top, left, filt, 5, dst8, dst16, stride);
+      break;
+    case 6:
+      afi_pred_kernel(w, h, top, left, filt, 6, dst8, dst16, stride);
+      break;
+    default: assert(0);
+  }
+}
+
+void av1_adapt_filter_intra_pred_sse2(uint8_t *dst, int stride,
+                                      TX_SIZE tx_size, const double *filt,
+                                      const uint8_t *above, const uint8_t *left,
+                                      int mode) {
+  const int bw = tx_size_wide[tx_size];
+  const int bh = tx_size_high[tx_size];
+  double top_buf[MAX_TX_SIZE + 2], left_buf[MAX_TX_SIZE];
+  double *const top = top_buf + 1;
+  if (afi_pred_transposed[mode]) {
+    top[-1] = above[-1];
+    for (int r = 0; r <= bh; ++r) top[r] = left[r];
+    for (int c = 0; c < bw; ++c) left_buf[c] = above[c];
+    afi_pred(bh, bw, top, left_buf, filt, mode, dst, NULL, stride);
+  } else {
+    for (int c = -1; c <= bw; ++c) top[c] = above[c];
+    for (int r = 0; r < bh; ++r) left_buf[r] = left[r];
+    afi_pred(bw, bh, top, left_buf, filt, mode, dst, NULL, stride);
+  }
+}
+
+void av1_adapt_filter_intra_pred_hbd_sse2(uint16_t *dst, int stride,
+                                          TX_SIZE tx_size, const double *filt,
+                                          const uint16_t *above,
+                                          const uint16_t *left, int mode) {
+  const int bw = tx_size_wide[tx_size];
+  const int bh = tx_size_high[tx_size];
+  double top_buf[MAX_TX_SIZE + 2], left_buf[MAX_TX_SIZE];
+  double *const top = top_buf + 1;
+  if (afi_pred_transposed[mode]) {
+    top[-1] = above[-1];
+    for (int r = 0; r <= bh; ++r) top[r] = left[r];
+    for (int c = 0; c < bw; ++c) left_buf[c] = above[c];
+    afi_pred(bh, bw, top, left_buf, filt, mode, NULL, dst, stride);
+  } else {
+    for (int c = -1; c <= bw; ++c) top[c] = above[c];
+    for (int r = 0; r < bh; ++r) left_buf[r] = left[r];
+    afi_pred(bw, bh, top, left_buf, filt, mode, NULL, dst, stride);
+  }
+}
+#endif  // CONFIG_ADAPT_FILTER_INTRA
@@ -7,6 +7,7 @@
 
 #include "aom_ports/system_state.h"
 
+#include "av1/common/blockd.h"
 #include "av1/common/entropymode.h"
 
 #if CONFIG_INTRA_ENTROPY
@@ -246,3 +247,131 @@ void av1_get_gradient_hist_lbd_sse4_1(const uint8_t *dst, int stride, int rows,
 }
 
 #endif  // CONFIG_INTRA_ENTROPY
+
+#if CONFIG_DERIVED_INTRA_MODE
+// Adds the Sobel gradients (dx, dy) of n <= 4 pixels to a histogram padded by
+// one bin on each side. The bins are found by comparing dy / dx against the
+// thresholds of av1_get_derived_intra_angle_thresholds(), which gives the same
+// result as the atanf() based C code.
+static INLINE void accumulate_derived_grad(__m128i dx, __m128i dy, int n,
+                                           const __m128 *thr, int *hist_pad) {
+  const __m128i dx_zero = _mm_cmpeq_epi32(dx, _mm_setzero_si128());
+  __m128 ratio = _mm_div_ps(_mm_cvtepi32_ps(dy), _mm_cvtepi32_ps(dx));
+  ratio = _mm_andnot_ps(_mm_castsi128_ps(dx_zero), ratio);
+
+  __m128i count = _mm_setzero_si128();
+  for (int k = 1; k < DERIVED_INTRA_HIST_BINS; ++k) {
+    count = _mm_sub_epi32(count, _mm_castps_si128(_mm_cmpge_ps(ratio, thr[k])));
+  }
+  const __m128i wrapped = _mm_castps_si128(_mm_cmplt_ps(ratio, thr[0]));
+  const __m128i bin = _mm_blendv_epi8(
+      _mm_sub_epi32(_mm_set1_epi32(DERIVED_INTRA_HIST_BINS), count),
+      _mm_set1_epi32(1), wrapped);
+  const __m128i weight = _mm_add_epi32(_mm_abs_epi32(dx), _mm_abs_epi32(dy));
+
+  int bins[4];
+  int weights[4];
+  _mm_storeu_si128((__m128i *)bins, bin);
+  _mm_storeu_si128((__m128i *)weights, weight);
+  for (int i = 0; i < n; ++i) {
+    hist_pad[bins[i]] += weights[i];
+    hist_pad[bins[i] - 1] += weights[i] >> 1;
+    hist_pad[bins[i] + 1] += weights[i] >> 1;
+  }
+}
+
+// Sobel gradients of four pixels from the columns to their left (l), at (c)
+// and to their right (r), each taken from the rows above (0), at (1) and
+// below (2) the pixels.
+static INLINE void derived_sobel(const __m128i *l, const __m128i *c,
+                                 const __m128i *r, __m128i *dx, __m128i *dy) {
+  const __m128i sum_r =
+      _mm_add_epi32(_mm_add_epi32(r[0], r[2]), _mm_slli_epi32(r[1], 1));
+  const __m128i sum_l =
+      _mm_add_epi32(_mm_add_epi32(l[0], l[2]), _mm_slli_epi32(l[1], 1));
+  const __m128i sum_b =
+      _mm_add_epi32(_mm_add_epi32(l[2], r[2]), _mm_slli_epi32(c[2], 1));
+  const __m128i sum_a =
+      _mm_add_epi32(_mm_add_epi32(l[0], r[0]), _mm_slli_epi32(c[0], 1));
+  *dx = _mm_sub_epi32(sum_r, sum_l);
+  *dy = _mm_sub_epi32(sum_b, sum_a);
+}
+
+static INLINE void load_derived_thresholds(__m128 *thr) {
+  const float *thresholds = av1_get_derived_intra_angle_thresholds();
+  for (int k = 0; k < DERIVED_INTRA_HIST_BINS; ++k) {
+    thr[k] = _mm_set1_ps(thresholds[k]);
+  }
+}
+
+static INLINE void add_derived_hist(const int *hist_pad, int *hist) {
+  for (int k = 0; k < DERIVED_INTRA_HIST_BINS; ++k) hist[k] += hist_pad[k + 1];
+}
+
+// Regions are either a few rows tall and processed four columns at a time, or
+// a few columns wide (the strip left of a block) and processed four rows at a
+// time. In the latter case the 3x3 neighborhoods are gathered column-wise.
+#define DERIVED_GRAD_HIST(name, pixel_t, load_row)                            \
+  void name(const pixel_t *src, int src_stride, int rows, int cols,          \
+            int *hist) {                                                      \
+    __m128 thr[DERIVED_INTRA_HIST_BINS];                                      \
+    int hist_pad[DERIVED_INTRA_HIST_BINS + 2] = { 0 };                        \
+    __m128i l[3], c[3], r[3], dx, dy;                                         \
+    load_derived_thresholds(thr);                                             \
+    if (cols >= 6) {                                                          \
+      for (int y = 1; y < rows - 1; ++y) {                                    \
+        for (int x = 1; x < cols - 1; x += 4) {                               \
+          for (int k = 0; k < 3; ++k) {                                       \
+            load_row(src + (y - 1 + k) * src_stride + x - 1, &l[k], &c[k],   \
+                     &r[k]);                                                  \
+          }                                                                   \
+          derived_sobel(l, c, r, &dx, &dy);                                   \
+          accumulate_derived_grad(dx, dy, AOMMIN(4, cols - 1 - x), thr,       \
+                                  hist_pad);                                  \
+        }                                                                     \
+      }                                                                       \
+    } else {                                                                  \
+      for (int x = 1; x < cols - 1; ++x) {                                    \
+        for (int y = 1; y < rows - 1; y += 4) {                               \
+          const int n = AOMMIN(4, rows - 1 - y);                              \
+          int col[3][6] = { { 0 } };                                          \
+          for (int i = 0; i < n + 2; ++i) {                                   \
+            const pixel_t *p = src + (y - 1 + i) * src_stride + x - 1;        \
+            col[0][i] = p[0];                                                 \
+            col[1][i] = p[1];                                                 \
+            col[2][i] = p[2];                                                 \
+          }                                                                   \
+          for (int k = 0; k < 3; ++k) {                                       \
+            l[k] = _mm_loadu_si128((const __m128i *)(col[0] + k));            \
+            c[k] = _mm_loadu_si128((const __m128i *)(col[1] + k));            \
+            r[k] = _mm_loadu_si128((const __m128i *)(col[2] + k));            \
+          }                                                                   \
+          derived_sobel(l, c, r, &dx, &dy);                                   \
+          accumulate_derived_grad(dx, dy, n, thr, hist_pad);                  \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+    add_derived_hist(hist_pad, hist);                                         \
+  }
+
+// Loads pixels x - 1 to x + 2, x to x + 3 and x + 1 to x + 4 of a row.
+static INLINE void load_row_lbd(const uint8_t *p, __m128i *l, __m128i *c,
+                                __m128i *r) {
+  const __m128i v = _mm_loadl_epi64((const __m128i *)p);
+  *l = _mm_cvtepu8_epi32(v);
+  *c = _mm_cvtepu8_epi32(_mm_srli_si128(v, 1));
+  *r = _mm_cvtepu8_epi32(_mm_srli_si128(v, 2));
+}
+
+static INLINE void load_row_hbd(const uint16_t *p, __m128i *l, __m128i *c,
+                                __m128i *r) {
+  const __m128i v = _mm_loadu_si128((const __m128i *)p);
+  *l = _mm_cvtepu16_epi32(v);
+  *c = _mm_cvtepu16_epi32(_mm_srli_si128(v, 2));
+  *r = _mm_cvtepu16_epi32(_mm_srli_si128(v, 4));
+}
+
+DERIVED_GRAD_HIST(av1_derived_intra_grad_hist_sse4_1, uint8_t, load_row_lbd)
+DERIVED_GRAD_HIST(av1_derived_intra_grad_hist_hbd_sse4_1, uint16_t,
+                  load_row_hbd)
+#endif  // CONFIG_DERIVED_INTRA_MODE
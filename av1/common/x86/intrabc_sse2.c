@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <emmintrin.h>
+
+#include "config/av1_rtcd.h"
+
+#include "aom_dsp/x86/transpose_sse2.h"
+#include "av1/common/reconinter.h"
+
+#if CONFIG_EXT_IBC_MODES
+// Reverses the order of the eight 16-bit lanes.
+static INLINE __m128i reverse_epi16(__m128i a) {
+  a = _mm_shufflelo_epi16(a, 0x1b);
+  a = _mm_shufflehi_epi16(a, 0x1b);
+  return _mm_shuffle_epi32(a, 0x4e);
+}
+
+// Stores the 8x8 tile 'rows' (already transposed if the mode requires it)
+// whose top-left corner maps to (y0, x0) of the unflipped output.
+static INLINE void store_tile_8x8(uint16_t *dst, int dst_stride,
+                                  const __m128i *rows, int y0, int x0,
+                                  int out_w, int out_h, IBC_MODE mode) {
+  const int flip_h = av1_intrabc_mode_flips_h(mode);
+  const int flip_v = av1_intrabc_mode_flips_v(mode);
+  if (flip_h) x0 = out_w - 8 - x0;
+  if (flip_v) y0 = out_h - 8 - y0;
+  dst += y0 * dst_stride + x0;
+
+  for (int i = 0; i < 8; ++i) {
+    const __m128i v = flip_h ? reverse_epi16(rows[i]) : rows[i];
+    const int y = flip_v ? 7 - i : i;
+    _mm_storeu_si128((__m128i *)(dst + y * dst_stride), v);
+  }
+}
+
+static INLINE void load_tile_8x8(const uint16_t *src, int src_stride,
+                                 __m128i *rows) {
+  for (int i = 0; i < 8; ++i) {
+    rows[i] = _mm_loadu_si128((const __m128i *)(src + i * src_stride));
+  }
+}
+
+void av1_intrabc_transform_sb_sse2(uint16_t *dst, int dst_stride,
+                                   const uint16_t *src, int src_stride,
+                                   int width, int height, IBC_MODE mode) {
+  if ((width & 7) || (height & 7)) {
+    av1_intrabc_transform_sb_c(dst, dst_stride, src, src_stride, width, height,
+                               mode);
+    return;
+  }
+
+  const int transpose = av1_intrabc_mode_transposes(mode);
+  const int out_w = transpose ? height : width;
+  const int out_h = transpose ? width : height;
+  __m128i in[8], tr[8];
+
+  for (int r = 0; r < height; r += 8) {
+    for (int c = 0; c < width; c += 8) {
+      load_tile_8x8(src + r * src_stride + c, src_stride, in);
+      if (transpose) {
+        transpose_16bit_8x8(in, tr);
+        store_tile_8x8(dst, dst_stride, tr, c, r, out_w, out_h, mode);
+      } else {
+        store_tile_8x8(dst, dst_stride, in, r, c, out_w, out_h, mode);
+      }
+    }
+  }
+}
+
+void av1_intrabc_transform_all_sb_sse2(uint16_t *const *dst, int dst_stride,
+                                       const uint16_t *src, int src_stride,
+                                       int width, int height, int num_modes) {
+  if ((width & 7) || (height & 7)) {
+    av1_intrabc_transform_all_sb_c(dst, dst_stride, src, src_stride, width,
+                                   height, num_modes);
+    return;
+  }
+
+  __m128i in[8], tr[8];
+
+  // Each 8x8 source tile is loaded and transposed once, then stored in every
+  // requested orientation.
+  for (int r = 0; r < height; r += 8) {
+    for (int c = 0; c < width; c += 8) {
+      load_tile_8x8(src + r * src_stride + c, src_stride, in);
+      int have_transpose = 0;
+      for (int mode = 0; mode < num_modes; ++mode) {
+        if (av1_intrabc_mode_transposes((IBC_MODE)mode)) {
+          if (!have_transpose) {
+            transpose_16bit_8x8(in, tr);
+            have_transpose = 1;
+          }
+          store_tile_8x8(dst[mode], dst_stride, tr, c, r, height, width,
+                         (IBC_MODE)mode);
+        } else {
+          store_tile_8x8(dst[mode], dst_stride, in, r, c, width, height,
+                         (IBC_MODE)mode);
+        }
+      }
+    }
+  }
+}
+#endif  // CONFIG_EXT_IBC_MODES
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>
+
+#include "config/av1_rtcd.h"
+
+#include "av1/common/entropymode.h"
+
+#if CONFIG_INTRA_ENTROPY
+
+// Lane mask for the last n % 8 floats of a row.
+static INLINE __m256i tail_mask(int n) {
+  static const int32_t mask_array[16] = { -1, -1, -1, -1, -1, -1, -1, -1,
+                                          0,  0,  0,  0,  0,  0,  0,  0 };
+  return _mm256_loadu_si256((const __m256i *)(mask_array + 8 - (n & 7)));
+}
+
+// dst[i] += src[i]
+static INLINE void add_row(float *dst, const float *src, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 d = _mm256_loadu_ps(dst + i);
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(d, _mm256_loadu_ps(src + i)));
+  }
+  if (i < n) {
+    const __m256i mask = tail_mask(n);
+    const __m256 d = _mm256_maskload_ps(dst + i, mask);
+    const __m256 s = _mm256_maskload_ps(src + i, mask);
+    _mm256_maskstore_ps(dst + i, mask, _mm256_add_ps(d, s));
+  }
+}
+
+// dst[i] += scale * src[i], rounding the product first like the C code.
+static INLINE void add_scaled_row(float *dst, const float *src, float scale,
+                                  int n) {
+  const __m256 k = _mm256_set1_ps(scale);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 p = _mm256_mul_ps(k, _mm256_loadu_ps(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), p));
+  }
+  if (i < n) {
+    const __m256i mask = tail_mask(n);
+    const __m256 p = _mm256_mul_ps(k, _mm256_maskload_ps(src + i, mask));
+    const __m256 d = _mm256_maskload_ps(dst + i, mask);
+    _mm256_maskstore_ps(dst + i, mask, _mm256_add_ps(d, p));
+  }
+}
+
+void av1_nn_input_backward_em_avx2(FC_INPUT_LAYER_EM *layer, const float *dy,
+                                   const int *sparse_features,
+                                   const float *dense_features) {
+  const int num_sparse = layer->num_sparse_inputs;
+  const int num_dense = layer->num_dense_inputs;
+  const int num_out = layer->num_outputs;
+
+  add_row(layer->db, dy, num_out);
+  for (int s_idx = 0; s_idx < num_sparse; s_idx++) {
+    add_row(layer->dw_sparse[s_idx] + sparse_features[s_idx] * num_out, dy,
+            num_out);
+  }
+  // Row j of the dense gradient gets the features scaled by dy[j].
+  float *dw_dense = layer->dw_dense;
+  for (int j = 0; j < num_out && num_dense > 0; ++j) {
+    add_scaled_row(dw_dense, dense_features, dy[j], num_dense);
+    dw_dense += num_dense;
+  }
+}
+
+void av1_nn_adapt_em_avx2(float *w, float *dw, float mu, int n) {
+  const __m256 k = _mm256_set1_ps(mu);
+  const __m256 zero = _mm256_setzero_ps();
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 step = _mm256_mul_ps(k, _mm256_loadu_ps(dw + i));
+    _mm256_storeu_ps(w + i, _mm256_sub_ps(_mm256_loadu_ps(w + i), step));
+    _mm256_storeu_ps(dw + i, zero);
+  }
+  if (i < n) {
+    const __m256i mask = tail_mask(n);
+    const __m256 step = _mm256_mul_ps(k, _mm256_maskload_ps(dw + i, mask));
+    const __m256 v = _mm256_maskload_ps(w + i, mask);
+    _mm256_maskstore_ps(w + i, mask, _mm256_sub_ps(v, step));
+    _mm256_maskstore_ps(dw + i, mask, zero);
+  }
+}
+#endif  // CONFIG_INTRA_ENTROPY
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <smmintrin.h>  // SSE4.1
+
+#include "config/av1_rtcd.h"
+
+#include "av1/common/quant_common.h"
+
+static INLINE __m128i dequantize_4_sse4_1(const __m128i qcoeff,
+                                          const __m128i dqv,
+                                          const __m128i shift,
+                                          const __m128i min_value,
+                                          const __m128i max_value) {
+  const __m128i mask = _mm_set1_epi32(0xffffff);
+  // Only the low 24 bits of the product are kept, so the 32 bit product is
+  // as good as the 64 bit one.
+  __m128i dq_coeff = _mm_mullo_epi32(_mm_abs_epi32(qcoeff), dqv);
+  dq_coeff = _mm_and_si128(dq_coeff, mask);
+#if QUANT_TABLE_BITS
+  dq_coeff = _mm_add_epi32(dq_coeff,
+                           _mm_set1_epi32((1 << QUANT_TABLE_BITS) >> 1));
+  dq_coeff = _mm_srli_epi32(dq_coeff, QUANT_TABLE_BITS);
+#endif  // QUANT_TABLE_BITS
+  dq_coeff = _mm_srl_epi32(dq_coeff, shift);
+  // Negates where qcoeff is negative, and keeps the zero coefficients zero.
+  dq_coeff = _mm_sign_epi32(dq_coeff, qcoeff);
+  dq_coeff = _mm_max_epi32(dq_coeff, min_value);
+  return _mm_min_epi32(dq_coeff, max_value);
+}
+
+void av1_dequantize_coeffs_sse4_1(tran_low_t *coeffs, int n_coeffs,
+                                  int dqv_dc, int dqv_ac, int shift, int bd) {
+  const int32_t max_value = (1 << (7 + bd)) - 1;
+  const int32_t min_value = -(1 << (7 + bd));
+  const __m128i shift_vec = _mm_cvtsi32_si128(shift);
+  const __m128i min_vec = _mm_set1_epi32(min_value);
+  const __m128i max_vec = _mm_set1_epi32(max_value);
+  const __m128i dqv_ac_vec = _mm_set1_epi32(dqv_ac);
+  __m128i dqv = _mm_insert_epi32(dqv_ac_vec, dqv_dc, 0);
+  int i = 0;
+
+  for (; i + 4 <= n_coeffs; i += 4) {
+    const __m128i qcoeff = _mm_loadu_si128((const __m128i *)(coeffs + i));
+    _mm_storeu_si128(
+        (__m128i *)(coeffs + i),
+        dequantize_4_sse4_1(qcoeff, dqv, shift_vec, min_vec, max_vec));
+    dqv = dqv_ac_vec;
+  }
+  for (; i < n_coeffs; ++i) {
+    if (coeffs[i]) {
+      coeffs[i] = av1_dequant_coeff(coeffs[i], i ? dqv_ac : dqv_dc, shift,
+                                    min_value, max_value);
+    }
+  }
+}
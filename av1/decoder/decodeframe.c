@@ -10,6 +10,7 @@
  */
 
 #include <assert.h>
+#include <limits.h>
 #include <stddef.h>
 
 #include "config/aom_config.h"
@@ -420,6 +421,9 @@ static void set_offsets(AV1_COMMON *const cm, MACROBLOCKD *const xd,
 
   av1_setup_dst_planes(xd->plane, &cm->cur_frame->buf, mi_row, mi_col, 0,
                        num_planes, &xd->mi[0]->chroma_ref_info);
+#if CONFIG_DERIVED_INTRA_MODE
+  av1_reset_derived_intra_mode_cache(xd);
+#endif  // CONFIG_DERIVED_INTRA_MODE
 }
 
 static void decode_mbmi_block(AV1Decoder *const pbi, MACROBLOCKD *const xd,
@@ -1537,6 +1541,9 @@ static void set_offsets_for_pred_and_recon(AV1Decoder *const pbi,
 
   av1_setup_dst_planes(xd->plane, &cm->cur_frame->buf, mi_row, mi_col, 0,
                        num_planes, &xd->mi[0]->chroma_ref_info);
+#if CONFIG_DERIVED_INTRA_MODE
+  av1_reset_derived_intra_mode_cache(xd);
+#endif  // CONFIG_DERIVED_INTRA_MODE
 }
 
 static void decode_block(AV1Decoder *const pbi, ThreadData *const td,
@@ -2546,7 +2553,11 @@ static void resize_context_buffers(AV1_COMMON *cm, int width, int height) {
     cm->height = height;
   }
 
-  ensure_mv_buffer(cm->cur_frame, cm);
+  if (ensure_mv_buffer(cm->cur_frame, cm) > 0) {
+    lock_buffer_pool(cm->buffer_pool);
+    ++cm->buffer_pool->num_side_allocs;
+    unlock_buffer_pool(cm->buffer_pool);
+  }
   cm->cur_frame->width = cm->width;
   cm->cur_frame->height = cm->height;
 }
@@ -2554,6 +2565,7 @@ static void resize_context_buffers(AV1_COMMON *cm, int width, int height) {
 static void setup_buffer_pool(AV1_COMMON *cm) {
   BufferPool *const pool = cm->buffer_pool;
   const SequenceHeader *const seq_params = &cm->seq_params;
+  const size_t y_buffer_8bit_sz = cm->cur_frame->buf.y_buffer_8bit_sz;
 
   lock_buffer_pool(pool);
   if (aom_realloc_frame_buffer(
@@ -2565,6 +2577,8 @@ static void setup_buffer_pool(AV1_COMMON *cm) {
     aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
                        "Failed to allocate frame buffer");
   }
+  if (cm->cur_frame->buf.y_buffer_8bit_sz > y_buffer_8bit_sz)
+    ++pool->num_side_allocs;
   unlock_buffer_pool(pool);
 
   cm->cur_frame->buf.bit_depth = (unsigned int)seq_params->bit_depth;
@@ -3269,15 +3283,6 @@ static void set_decode_func_pointers(ThreadData *td, int parse_decode_flag) {
   }
 }
 
-#if CONFIG_EXT_IBC_MODES
-static void av1_allocate_intrabc_sb(uint16_t **InputBlock, BLOCK_SIZE bsize) {
-  uint16_t width = block_size_wide[bsize];
-  uint16_t height = block_size_high[bsize];
-
-  (*InputBlock) = (uint16_t *)aom_malloc(width * height * sizeof(uint16_t));
-}
-#endif  // CONFIG_EXT_IBC_MODES
-
 static void decode_tile(AV1Decoder *pbi, ThreadData *const td, int tile_row,
                         int tile_col) {
   TileInfo tile_info;
@@ -3328,6 +3333,10 @@ static void decode_tile(AV1Decoder *pbi, ThreadData *const td, int tile_row,
       decode_partition(pbi, td, mi_row, mi_col, td->bit_reader,
                        cm->seq_params.sb_size, xd->sbi, xd->sbi->ptree_root,
                        0x3);
+#if CONFIG_INTRA_ENTROPY
+      if (td->bit_reader->allow_update_cdf)
+        av1_update_entropy_models_sb(xd->tile_ctx);
+#endif  // CONFIG_INTRA_ENTROPY
 
       if (aom_reader_has_overflowed(td->bit_reader)) {
         aom_merge_corrupted_flag(&xd->corrupted, 1);
@@ -3424,12 +3433,12 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
   for (int j = 0; j < 2; ++j) {
     td->xd.tmp_obmc_bufs[j] = td->tmp_obmc_bufs[j];
   }
-
 #if CONFIG_EXT_IBC_MODES
-  // Allocate 128x128 scratch buffers for Decode:
-  MACROBLOCKD *const xd = &td->xd;
-  av1_allocate_intrabc_sb(&xd->ibc_pred, BLOCK_128X128);
+  td->xd.ibc_pred = td->ibc_pred;
 #endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  td->xd.nn_recon_cache = td->nn_recon_cache;
+#endif  // CONFIG_NN_RECON
 
   for (tile_row = tile_rows_start; tile_row < tile_rows_end; ++tile_row) {
     const int row = inv_row_order ? tile_rows - 1 - tile_row : tile_row;
@@ -3464,7 +3473,8 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
       // Initialise the tile context from the frame context
       tile_data->tctx = *cm->fc;
 #if CONFIG_INTRA_ENTROPY
-      av1_config_entropy_models(&tile_data->tctx);
+      av1_config_entropy_models(
+          &tile_data->tctx, cm->seq_params.enable_intra_entropy_sb_update);
 #endif  // CONFIG_INTRA_ENTROPY
       td->xd.tile_ctx = &tile_data->tctx;
 
@@ -3477,11 +3487,6 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
     }
   }
 
-#if CONFIG_EXT_IBC_MODES
-  // Free scratch buffers for Decode
-  aom_free(xd->ibc_pred);
-#endif  // CONFIG_EXT_IBC_MODES
-
   if (cm->large_scale_tile) {
     if (n_tiles == 1) {
       // Find the end of the single tile buffer
@@ -3545,7 +3550,8 @@ static void tile_worker_hook_init(AV1Decoder *const pbi,
   // Initialise the tile context from the frame context
   tile_data->tctx = *cm->fc;
 #if CONFIG_INTRA_ENTROPY
-  av1_config_entropy_models(&tile_data->tctx);
+  av1_config_entropy_models(
+      &tile_data->tctx, cm->seq_params.enable_intra_entropy_sb_update);
 #endif  // CONFIG_INTRA_ENTROPY
   td->xd.tile_ctx = &tile_data->tctx;
 #if CONFIG_ACCOUNTING
@@ -3599,18 +3605,18 @@ static int tile_worker_hook(void *arg1, void *arg2) {
   return !td->xd.corrupted;
 }
 
+// One worker parses a tile while the others reconstruct its parsed superblock
+// rows behind it, in wavefront order. A tile gets at least
+// AOM_MAX_THREADS_PER_TILE workers, and shares the threads left over by the
+// other tiles, so that a single large tile scales past two threads. More than
+// one reconstructing worker per superblock row cannot help.
 static INLINE int get_max_row_mt_workers_per_tile(AV1_COMMON *cm,
-                                                  TileInfo tile) {
-  // NOTE: Currently value of max workers is calculated based
-  // on the parse and decode time. As per the theoretical estimate
-  // when percentage of parse time is equal to percentage of decode
-  // time, number of workers needed to parse + decode a tile can not
-  // exceed more than 2.
-  // TODO(any): Modify this value if parsing is optimized in future.
-  int sb_rows = av1_get_sb_rows_in_tile(cm, tile);
-  int max_workers =
-      sb_rows == 1 ? AOM_MIN_THREADS_PER_TILE : AOM_MAX_THREADS_PER_TILE;
-  return max_workers;
+                                                  TileInfo tile,
+                                                  int max_threads,
+                                                  int num_tiles) {
+  const int sb_rows = av1_get_sb_rows_in_tile(cm, tile);
+  if (sb_rows == 1) return AOM_MIN_THREADS_PER_TILE;
+  return clamp(max_threads / num_tiles, AOM_MAX_THREADS_PER_TILE, sb_rows + 1);
 }
 
 // The caller must hold pbi->row_mt_mutex_ when calling this function.
@@ -3693,8 +3699,7 @@ static int get_next_job_info(AV1Decoder *const pbi,
         }
         if (num_threads_working == min_threads_working &&
             num_mis_to_decode > max_mis_to_decode &&
-            num_threads_working <
-                get_max_row_mt_workers_per_tile(cm, tile_data->tile_info)) {
+            num_threads_working < dec_row_mt_sync->max_threads_working) {
           max_mis_to_decode = num_mis_to_decode;
           tile_row = tile_row_idx;
           tile_col = tile_col_idx;
@@ -3781,6 +3786,10 @@ static void parse_tile_row_mt(AV1Decoder *pbi, ThreadData *const td,
       decode_partition(pbi, td, mi_row, mi_col, td->bit_reader,
                        cm->seq_params.sb_size, td->xd.sbi,
                        td->xd.sbi->ptree_root, 0x1);
+#if CONFIG_INTRA_ENTROPY
+      if (td->bit_reader->allow_update_cdf)
+        av1_update_entropy_models_sb(td->xd.tile_ctx);
+#endif  // CONFIG_INTRA_ENTROPY
 
       if (aom_reader_has_overflowed(td->bit_reader)) {
         aom_merge_corrupted_flag(&td->xd.corrupted, 1);
@@ -3983,6 +3992,14 @@ void av1_free_mc_tmp_buf(ThreadData *thread_data) {
     aom_free(thread_data->tmp_obmc_bufs[i]);
     thread_data->tmp_obmc_bufs[i] = NULL;
   }
+#if CONFIG_EXT_IBC_MODES
+  aom_free(thread_data->ibc_pred);
+  thread_data->ibc_pred = NULL;
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  av1_nn_recon_cache_free(thread_data->nn_recon_cache);
+  thread_data->nn_recon_cache = NULL;
+#endif  // CONFIG_NN_RECON
 }
 
 static void allocate_mc_tmp_buf(AV1_COMMON *const cm, ThreadData *thread_data,
@@ -4009,6 +4026,14 @@ static void allocate_mc_tmp_buf(AV1_COMMON *const cm, ThreadData *thread_data,
         aom_memalign(16, 2 * MAX_MB_PLANE * MAX_SB_SQUARE *
                              sizeof(*thread_data->tmp_obmc_bufs[i])));
   }
+#if CONFIG_EXT_IBC_MODES
+  CHECK_MEM_ERROR(
+      cm, thread_data->ibc_pred,
+      aom_memalign(32, MAX_SB_SQUARE * sizeof(*thread_data->ibc_pred)));
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  CHECK_MEM_ERROR(cm, thread_data->nn_recon_cache, av1_nn_recon_cache_alloc());
+#endif  // CONFIG_NN_RECON
 }
 
 static void reset_dec_workers(AV1Decoder *pbi, AVxWorkerHook worker_hook,
@@ -4027,6 +4052,12 @@ static void reset_dec_workers(AV1Decoder *pbi, AVxWorkerHook worker_hook,
     for (int j = 0; j < 2; ++j) {
       thread_data->td->xd.tmp_obmc_bufs[j] = thread_data->td->tmp_obmc_bufs[j];
     }
+#if CONFIG_EXT_IBC_MODES
+    thread_data->td->xd.ibc_pred = thread_data->td->ibc_pred;
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+    thread_data->td->xd.nn_recon_cache = thread_data->td->nn_recon_cache;
+#endif  // CONFIG_NN_RECON
     winterface->sync(worker);
 
     worker->hook = worker_hook;
@@ -4248,7 +4279,7 @@ static void dec_alloc_cb_buf(AV1Decoder *pbi) {
 static void row_mt_frame_init(AV1Decoder *pbi, int tile_rows_start,
                               int tile_rows_end, int tile_cols_start,
                               int tile_cols_end, int start_tile, int end_tile,
-                              int max_sb_rows) {
+                              int num_tiles, int max_sb_rows) {
   AV1_COMMON *const cm = &pbi->common;
   AV1DecRowMTInfo *frame_row_mt_info = &pbi->frame_row_mt_info;
 
@@ -4276,6 +4307,9 @@ static void row_mt_frame_init(AV1Decoder *pbi, int tile_rows_start,
       tile_data->dec_row_mt_sync.mi_rows_parse_done = 0;
       tile_data->dec_row_mt_sync.mi_rows_decode_started = 0;
       tile_data->dec_row_mt_sync.num_threads_working = 0;
+      tile_data->dec_row_mt_sync.max_threads_working =
+          get_max_row_mt_workers_per_tile(cm, tile_info, pbi->max_threads,
+                                          num_tiles);
       tile_data->dec_row_mt_sync.mi_rows =
           ALIGN_POWER_OF_TWO(tile_info.mi_row_end - tile_info.mi_row_start,
                              cm->seq_params.mib_size_log2);
@@ -4346,6 +4380,11 @@ static const uint8_t *decode_tiles_row_mt(AV1Decoder *pbi, const uint8_t *data,
   }
   tile_count_tg = end_tile - start_tile + 1;
   max_threads = pbi->max_threads;
+  // Number of tiles decoded by this call.
+  const int num_tiles = cm->large_scale_tile
+                            ? (tile_rows_end - tile_rows_start) *
+                                  (tile_cols_end - tile_cols_start)
+                            : tile_count_tg;
 
   // No tiles to decode.
   if (tile_rows_end <= tile_rows_start || tile_cols_end <= tile_cols_start ||
@@ -4362,8 +4401,6 @@ static const uint8_t *decode_tiles_row_mt(AV1Decoder *pbi, const uint8_t *data,
   assert(start_tile <= end_tile);
   assert(start_tile >= 0 && end_tile < n_tiles);
 
-  (void)tile_count_tg;
-
   decode_mt_init(pbi);
 
   // get tile size in tile group
@@ -4390,7 +4427,8 @@ static const uint8_t *decode_tiles_row_mt(AV1Decoder *pbi, const uint8_t *data,
 
       max_sb_rows = AOMMAX(max_sb_rows,
                            av1_get_sb_rows_in_tile(cm, tile_data->tile_info));
-      num_workers += get_max_row_mt_workers_per_tile(cm, tile_data->tile_info);
+      num_workers += get_max_row_mt_workers_per_tile(
+          cm, tile_data->tile_info, max_threads, num_tiles);
     }
   }
   num_workers = AOMMIN(num_workers, max_threads);
@@ -4410,7 +4448,8 @@ static const uint8_t *decode_tiles_row_mt(AV1Decoder *pbi, const uint8_t *data,
   dec_alloc_cb_buf(pbi);
 
   row_mt_frame_init(pbi, tile_rows_start, tile_rows_end, tile_cols_start,
-                    tile_cols_end, start_tile, end_tile, max_sb_rows);
+                    tile_cols_end, start_tile, end_tile, num_tiles,
+                    max_sb_rows);
 
   reset_dec_workers(pbi, row_mt_worker_hook, num_workers);
   launch_dec_workers(pbi, data_end, num_workers);
@@ -4812,6 +4851,9 @@ void av1_read_sequence_header(AV1_COMMON *cm, struct aom_read_bit_buffer *rb,
 #if CONFIG_ADAPT_FILTER_INTRA
   seq_params->enable_adapt_filter_intra = aom_rb_read_bit(rb);
 #endif
+#if CONFIG_INTRA_ENTROPY
+  seq_params->enable_intra_entropy_sb_update = aom_rb_read_bit(rb);
+#endif  // CONFIG_INTRA_ENTROPY
   seq_params->enable_intra_edge_filter = aom_rb_read_bit(rb);
 
   if (seq_params->reduced_still_picture_hdr) {
@@ -5072,7 +5114,12 @@ static void show_existing_frame_reset(AV1Decoder *const pbi,
   generate_next_ref_frame_map(pbi);
 
   // Reload the adapted CDFs from when we originally coded this keyframe
-  *cm->fc = cm->next_ref_frame_map[existing_frame_idx]->frame_context;
+  RefCntBuffer *const frame_to_show =
+      cm->next_ref_frame_map[existing_frame_idx];
+  if (pbi->frame_parallel) {
+    av1_frame_progress_wait(cm->buffer_pool, frame_to_show, INT_MAX);
+  }
+  *cm->fc = frame_to_show->frame_context;
 }
 
 static INLINE void reset_frame_buffers(AV1_COMMON *cm) {
@@ -5802,7 +5849,13 @@ static void superres_post_decode(AV1Decoder *pbi) {
   if (!av1_superres_scaled(cm)) return;
   assert(!cm->all_lossless);
 
-  av1_superres_upscale(cm, pool);
+  const size_t scratch_size = pbi->superres_scratch.buffer_alloc_sz;
+  av1_superres_upscale(cm, pool, &pbi->superres_scratch);
+  if (pbi->superres_scratch.buffer_alloc_sz > scratch_size) {
+    lock_buffer_pool(pool);
+    ++pool->num_side_allocs;
+    unlock_buffer_pool(pool);
+  }
 }
 
 uint32_t av1_decode_frame_headers_and_setup(AV1Decoder *pbi,
@@ -5865,10 +5918,20 @@ uint32_t av1_decode_frame_headers_and_setup(AV1Decoder *pbi,
 
   cm->setup_mi(cm);
 
-  av1_setup_motion_field(cm);
-
   av1_setup_block_planes(xd, cm->seq_params.subsampling_x,
                          cm->seq_params.subsampling_y, num_planes);
+  // In frame parallel decoding, the reference frames may still be decoding.
+  if (!pbi->frame_parallel) av1_setup_frame_from_refs(pbi);
+
+  xd->corrupted = 0;
+  return uncomp_hdr_size;
+}
+
+void av1_setup_frame_from_refs(AV1Decoder *pbi) {
+  AV1_COMMON *const cm = &pbi->common;
+
+  av1_setup_motion_field(cm);
+
   if (cm->primary_ref_frame == PRIMARY_REF_NONE) {
     // use the default frame context values
     *cm->fc = *cm->default_frame_context;
@@ -5878,9 +5941,6 @@ uint32_t av1_decode_frame_headers_and_setup(AV1Decoder *pbi,
   if (!cm->fc->initialized)
     aom_internal_error(&cm->error, AOM_CODEC_CORRUPT_FRAME,
                        "Uninitialized entropy context.");
-
-  xd->corrupted = 0;
-  return uncomp_hdr_size;
 }
 
 // Once-per-frame initialization
@@ -5955,7 +6015,11 @@ void av1_decode_tg_tiles_and_wrapup(AV1Decoder *pbi, const uint8_t *data,
     if (cm->use_cnn) {
       assert(cm->rst_info[0].frame_restoration_type == RESTORE_NONE);
       assert(cm->cdef_info.cdef_strengths[0] == 0);
-      av1_restore_cnn_tflite(cm, pbi->num_workers);
+      // The last tile worker runs on the main thread, so chroma goes to the
+      // first one.
+      av1_restore_cnn_tflite(
+          cm, pbi->num_workers,
+          pbi->num_workers > 1 ? &pbi->tile_workers[0] : NULL);
     }
 #endif  // CONFIG_CNN_RESTORATION && !CONFIG_LOOP_RESTORE_CNN
 
@@ -47,6 +47,12 @@ uint32_t av1_decode_frame_headers_and_setup(struct AV1Decoder *pbi,
                                             const uint8_t **p_data_end,
                                             int trailing_bits_present);
 
+// Sets up the motion field projection and the entropy context of the frame,
+// which come from its reference frames. In frame parallel decoding, this is
+// only done once they are decoded, instead of in
+// av1_decode_frame_headers_and_setup().
+void av1_setup_frame_from_refs(struct AV1Decoder *pbi);
+
 void av1_decode_tg_tiles_and_wrapup(struct AV1Decoder *pbi, const uint8_t *data,
                                     const uint8_t *data_end,
                                     const uint8_t **p_data_end, int start_tile,
@@ -130,7 +130,7 @@ static UV_PREDICTION_MODE read_intra_mode_uv(FRAME_CONTEXT *ec_ctx,
                                              aom_reader *r,
                                              CFL_ALLOWED_TYPE cfl_allowed,
 #if CONFIG_DERIVED_INTRA_MODE
-                                             const MACROBLOCKD *const xd,
+                                             MACROBLOCKD *const xd,
 #endif  // CONFIG_DERIVED_INTRA_MODE
                                              MB_MODE_INFO *const mbmi) {
   PREDICTION_MODE y_mode = mbmi->mode;
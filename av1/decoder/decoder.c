@@ -177,6 +177,7 @@ void av1_decoder_remove(AV1Decoder *pbi) {
 
   // Free the tile list output buffer.
   aom_free_frame_buffer(&pbi->tile_list_outbuf);
+  aom_free_frame_buffer(&pbi->superres_scratch);
 
   aom_get_worker_interface()->end(&pbi->lf_worker);
   aom_free(pbi->lf_worker.data1);
@@ -218,6 +219,7 @@ void av1_decoder_remove(AV1Decoder *pbi) {
   }
 
   av1_dec_free_cb_buf(pbi);
+  aom_free(pbi->tile_groups);
 #if CONFIG_ACCOUNTING
   aom_accounting_clear(&pbi->accounting);
 #endif
@@ -230,6 +232,73 @@ void av1_decoder_remove(AV1Decoder *pbi) {
   aom_free(pbi);
 }
 
+int av1_reserve_frame_buffers(BufferPool *pool, int max_width, int max_height,
+                              int use_highbitdepth, int byte_alignment) {
+  const int mi_rows = ALIGN_POWER_OF_TWO(max_height, 3) >> MI_SIZE_LOG2;
+  const int mi_cols = ALIGN_POWER_OF_TWO(max_width, 3) >> MI_SIZE_LOG2;
+  size_t max_frame_size = 0;
+  int ret = 0;
+  int i;
+
+  lock_buffer_pool(pool);
+  // Set up every frame at the largest size, in 4:4:4 and with the border of
+  // the superres upscaled frames, so that the raw frame buffers they take fit
+  // any frame. They are all held at once to take a different one each.
+  for (i = 0; i < FRAME_BUFFERS && ret == 0; ++i) {
+    RefCntBuffer *const buf = &pool->frame_bufs[i];
+    const size_t y_buffer_8bit_sz = buf->buf.y_buffer_8bit_sz;
+    assert(buf->ref_count == 0);
+    if (aom_realloc_frame_buffer(&buf->buf, max_width, max_height, 0, 0,
+                                 use_highbitdepth, AOM_BORDER_IN_PIXELS,
+                                 byte_alignment, &buf->raw_frame_buffer,
+                                 pool->get_fb_cb, pool->cb_priv)) {
+      ret = -1;
+      break;
+    }
+    if (buf->buf.y_buffer_8bit_sz > y_buffer_8bit_sz) ++pool->num_side_allocs;
+    max_frame_size = buf->raw_frame_buffer.size;
+
+    const int num_allocs = alloc_mv_buffer(buf, mi_rows, mi_cols);
+    if (num_allocs < 0) {
+      ret = -1;
+      break;
+    }
+    pool->num_side_allocs += num_allocs;
+    buf->mi_rows = 0;
+    buf->mi_cols = 0;
+  }
+  for (i = 0; i < FRAME_BUFFERS; ++i) {
+    RefCntBuffer *const buf = &pool->frame_bufs[i];
+    if (buf->raw_frame_buffer.data != NULL) {
+      pool->release_fb_cb(pool->cb_priv, &buf->raw_frame_buffer);
+      buf->raw_frame_buffer.data = NULL;
+      buf->raw_frame_buffer.size = 0;
+      buf->raw_frame_buffer.priv = NULL;
+    }
+  }
+  // The internal frame buffers left, if any, hold the film grain outputs.
+  if (ret == 0 && pool->cb_priv == &pool->int_frame_buffers) {
+    ret = av1_reserve_internal_frame_buffers(&pool->int_frame_buffers,
+                                             max_frame_size);
+  }
+  unlock_buffer_pool(pool);
+  return ret;
+}
+
+int av1_reserve_superres_scratch(AV1Decoder *pbi, int max_width,
+                                 int max_height, int use_highbitdepth) {
+  BufferPool *const pool = pbi->common.buffer_pool;
+  if (aom_realloc_frame_buffer(&pbi->superres_scratch, max_width, max_height, 0,
+                               0, use_highbitdepth, AOM_BORDER_IN_PIXELS,
+                               pbi->common.byte_alignment, NULL, NULL, NULL)) {
+    return -1;
+  }
+  lock_buffer_pool(pool);
+  ++pool->num_side_allocs;
+  unlock_buffer_pool(pool);
+  return 0;
+}
+
 void av1_visit_palette(AV1Decoder *const pbi, MACROBLOCKD *const xd,
                        aom_reader *r, palette_visitor_fn_t visit) {
   if (!is_inter_block(xd->mi[0])) {
@@ -450,6 +519,33 @@ static void swap_frame_buffers(AV1Decoder *pbi, int frame_decoded) {
   }
 }
 
+// Updates the references and the output queue once cm->cur_frame is decoded,
+// and consumes the reference to it. Returns 0 on success, or 1 with
+// cm->error.error_code set on failure.
+static int finish_frame(AV1Decoder *pbi, int frame_decoded) {
+  AV1_COMMON *const cm = &pbi->common;
+
+  // Note: At this point, this function holds a reference to cm->cur_frame
+  // in the buffer pool. This reference is consumed by swap_frame_buffers().
+  swap_frame_buffers(pbi, frame_decoded);
+
+  if (cm->error.error_code != AOM_CODEC_OK) return 1;
+
+  aom_clear_system_state();
+
+  if (!cm->show_existing_frame) {
+    if (cm->seg.enabled) {
+      if (cm->prev_frame && (cm->mi_rows == cm->prev_frame->mi_rows) &&
+          (cm->mi_cols == cm->prev_frame->mi_cols)) {
+        cm->last_frame_seg_map = cm->prev_frame->seg_map;
+      } else {
+        cm->last_frame_seg_map = NULL;
+      }
+    }
+  }
+  return 0;
+}
+
 int av1_receive_compressed_data(AV1Decoder *pbi, size_t size,
                                 const uint8_t **psource) {
   AV1_COMMON *volatile const cm = &pbi->common;
@@ -519,36 +615,179 @@ int av1_receive_compressed_data(AV1Decoder *pbi, size_t size,
   cm->txb_count = 0;
 #endif
 
-  // Note: At this point, this function holds a reference to cm->cur_frame
-  // in the buffer pool. This reference is consumed by swap_frame_buffers().
-  swap_frame_buffers(pbi, frame_decoded);
-
   if (frame_decoded) {
     pbi->decoding_first_frame = 0;
   }
 
-  if (cm->error.error_code != AOM_CODEC_OK) {
+  cm->error.setjmp = 0;
+
+  if (pbi->num_tile_groups > 0) {
+    // The tile groups deferred in frame parallel decoding hold on to
+    // cm->cur_frame until av1_decode_deferred_frame(). No other frame
+    // references it yet, so its progress is reset without locking.
+    cm->cur_frame->decoded_sb_rows = 0;
+    return 0;
+  }
+
+  return finish_frame(pbi, frame_decoded);
+}
+
+int av1_decode_deferred_frame(AV1Decoder *pbi) {
+  AV1_COMMON *volatile const cm = &pbi->common;
+  BufferPool *const pool = cm->buffer_pool;
+  assert(pbi->num_tile_groups > 0);
+
+  if (setjmp(cm->error.jmp)) {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+
     cm->error.setjmp = 0;
-    return 1;
+    pbi->num_tile_groups = 0;
+
+    winterface->sync(&pbi->lf_worker);
+    for (int i = 0; i < pbi->num_workers; ++i) {
+      winterface->sync(&pbi->tile_workers[i]);
+    }
+
+    // Do not keep the frames referencing this one waiting.
+    av1_frame_progress_set(pool, cm->cur_frame, INT_MAX);
+    release_frame_buffers(pbi);
+    aom_clear_system_state();
+    return -1;
   }
 
-  aom_clear_system_state();
+  cm->error.setjmp = 1;
 
-  if (!cm->show_existing_frame) {
-    if (cm->seg.enabled) {
-      if (cm->prev_frame && (cm->mi_rows == cm->prev_frame->mi_rows) &&
-          (cm->mi_cols == cm->prev_frame->mi_cols)) {
-        cm->last_frame_seg_map = cm->prev_frame->seg_map;
-      } else {
-        cm->last_frame_seg_map = NULL;
+  // The motion field projection reads the motion vectors of all the reference
+  // frames, and the loop filters only run once a frame is fully decoded, so
+  // the references are waited for as a whole.
+  for (int i = LAST_FRAME; i <= ALTREF_FRAME; ++i) {
+    RefCntBuffer *const buf = get_ref_frame_buf(cm, i);
+    if (buf != NULL) av1_frame_progress_wait(pool, buf, INT_MAX);
+  }
+  av1_setup_frame_from_refs(pbi);
+
+  for (int i = 0; i < pbi->num_tile_groups; ++i) {
+    const TileGroupDec *const tg = &pbi->tile_groups[i];
+    const uint8_t *data_end;
+    av1_decode_tg_tiles_and_wrapup(pbi, tg->data, tg->data_end, &data_end,
+                                   tg->start_tile, tg->end_tile, i == 0);
+    // As aom_decode_frame_from_obus() checks for the tile groups it decodes,
+    // the rest of the OBU is zero padding.
+    for (; data_end < tg->data_end; ++data_end) {
+      if (*data_end != 0) {
+        aom_internal_error(&cm->error, AOM_CODEC_CORRUPT_FRAME,
+                           "Nonzero padding after a tile group");
       }
     }
   }
-
-  // Update progress in frame parallel decode.
+  pbi->num_tile_groups = 0;
   cm->error.setjmp = 0;
 
-  return 0;
+  av1_frame_progress_set(pool, cm->cur_frame, INT_MAX);
+  const int ret = finish_frame(pbi, 1);
+
+  // The next frame of this worker gets its references from the header state,
+  // so let go of these ones early.
+  lock_buffer_pool(pool);
+  for (int i = 0; i < REF_FRAMES; ++i) {
+    decrease_ref_count(cm->ref_frame_map[i], pool);
+    cm->ref_frame_map[i] = NULL;
+  }
+  unlock_buffer_pool(pool);
+  return ret;
+}
+
+void av1_save_header_state(const AV1Decoder *pbi, AV1DecHeaderState *state) {
+  const AV1_COMMON *const cm = &pbi->common;
+  BufferPool *const pool = cm->buffer_pool;
+  // The references of the next frame are the ones after this frame updates
+  // them, which are only in next_ref_frame_map while it is decoding.
+  RefCntBuffer *const *const ref_frame_map =
+      pbi->hold_ref_buf ? cm->next_ref_frame_map : cm->ref_frame_map;
+
+  state->default_frame_context = *cm->default_frame_context;
+  state->seq_params = cm->seq_params;
+  state->timing_info_present = cm->timing_info_present;
+  state->timing_info = cm->timing_info;
+  state->buffer_model = cm->buffer_model;
+  memcpy(state->op_params, cm->op_params, sizeof(state->op_params));
+  state->number_temporal_layers = cm->number_temporal_layers;
+  state->number_spatial_layers = cm->number_spatial_layers;
+  state->current_frame = cm->current_frame;
+  state->current_frame_id = cm->current_frame_id;
+  memcpy(state->ref_frame_id, cm->ref_frame_id, sizeof(state->ref_frame_id));
+  memcpy(state->valid_for_referencing, cm->valid_for_referencing,
+         sizeof(state->valid_for_referencing));
+  lock_buffer_pool(pool);
+  for (int i = 0; i < REF_FRAMES; ++i) {
+    if (ref_frame_map[i] != NULL) ++ref_frame_map[i]->ref_count;
+    decrease_ref_count(state->ref_frame_map[i], pool);
+    state->ref_frame_map[i] = ref_frame_map[i];
+  }
+  unlock_buffer_pool(pool);
+  state->sequence_header_ready = pbi->sequence_header_ready;
+  state->sequence_header_changed = pbi->sequence_header_changed;
+  state->decoding_first_frame = pbi->decoding_first_frame;
+  state->need_resync = pbi->need_resync;
+  state->current_operating_point = pbi->current_operating_point;
+}
+
+void av1_load_header_state(AV1Decoder *pbi, const AV1DecHeaderState *state) {
+  AV1_COMMON *const cm = &pbi->common;
+  BufferPool *const pool = cm->buffer_pool;
+
+  *cm->default_frame_context = state->default_frame_context;
+  cm->seq_params = state->seq_params;
+  cm->timing_info_present = state->timing_info_present;
+  cm->timing_info = state->timing_info;
+  cm->buffer_model = state->buffer_model;
+  memcpy(cm->op_params, state->op_params, sizeof(cm->op_params));
+  cm->number_temporal_layers = state->number_temporal_layers;
+  cm->number_spatial_layers = state->number_spatial_layers;
+  cm->current_frame = state->current_frame;
+  cm->current_frame_id = state->current_frame_id;
+  memcpy(cm->ref_frame_id, state->ref_frame_id, sizeof(cm->ref_frame_id));
+  memcpy(cm->valid_for_referencing, state->valid_for_referencing,
+         sizeof(cm->valid_for_referencing));
+  lock_buffer_pool(pool);
+  for (int i = 0; i < REF_FRAMES; ++i) {
+    if (state->ref_frame_map[i] != NULL) ++state->ref_frame_map[i]->ref_count;
+    decrease_ref_count(cm->ref_frame_map[i], pool);
+    cm->ref_frame_map[i] = state->ref_frame_map[i];
+  }
+  unlock_buffer_pool(pool);
+  pbi->sequence_header_ready = state->sequence_header_ready;
+  pbi->sequence_header_changed = state->sequence_header_changed;
+  pbi->decoding_first_frame = state->decoding_first_frame;
+  pbi->need_resync = state->need_resync;
+  pbi->current_operating_point = state->current_operating_point;
+}
+
+void av1_frame_progress_set(BufferPool *pool, RefCntBuffer *buf, int sb_rows) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&pool->progress_mutex);
+  buf->decoded_sb_rows = sb_rows;
+  pthread_cond_broadcast(&pool->progress_cond);
+  pthread_mutex_unlock(&pool->progress_mutex);
+#else
+  (void)pool;
+  buf->decoded_sb_rows = sb_rows;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void av1_frame_progress_wait(BufferPool *pool, RefCntBuffer *buf,
+                             int sb_rows) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&pool->progress_mutex);
+  while (buf->decoded_sb_rows < sb_rows) {
+    pthread_cond_wait(&pool->progress_cond, &pool->progress_mutex);
+  }
+  pthread_mutex_unlock(&pool->progress_mutex);
+#else
+  (void)pool;
+  (void)sb_rows;
+  assert(buf->decoded_sb_rows >= sb_rows);
+#endif  // CONFIG_MULTITHREAD
 }
 
 // Get the frame at a particular index in the output queue
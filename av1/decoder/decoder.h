@@ -57,6 +57,12 @@ typedef struct ThreadData {
 
   CONV_BUF_TYPE *tmp_conv_dst;
   uint8_t *tmp_obmc_bufs[2];
+#if CONFIG_EXT_IBC_MODES
+  uint16_t *ibc_pred;
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  struct NnReconCache *nn_recon_cache;
+#endif  // CONFIG_NN_RECON
 
   decode_block_visitor_fn_t read_coeffs_tx_intra_block_visit;
   decode_block_visitor_fn_t predict_and_recon_intra_block_visit;
@@ -90,6 +96,9 @@ typedef struct AV1DecRowMTSyncData {
   int mi_rows_parse_done;
   int mi_rows_decode_started;
   int num_threads_working;
+  // Limit of num_threads_working: the parsing worker and the reconstructing
+  // ones.
+  int max_threads_working;
 } AV1DecRowMTSync;
 
 typedef struct AV1DecRowMTInfo {
@@ -149,6 +158,14 @@ typedef struct TileJobsDec {
   TileDataDec *tile_data;
 } TileJobsDec;
 
+// A tile group whose decoding is deferred in frame parallel decoding.
+typedef struct TileGroupDec {
+  const uint8_t *data;
+  const uint8_t *data_end;
+  int start_tile;
+  int end_tile;
+} TileGroupDec;
+
 typedef struct AV1DecTileMTData {
 #if CONFIG_MULTITHREAD
   pthread_mutex_t *job_mutex;
@@ -238,6 +255,8 @@ typedef struct AV1Decoder {
   unsigned int row_mt;
   EXTERNAL_REFERENCES ext_refs;
   YV12_BUFFER_CONFIG tile_list_outbuf;
+  // The downscaled frame, during superres upscaling.
+  YV12_BUFFER_CONFIG superres_scratch;
 
   CB_BUFFER *cb_buffer_base;
   int cb_buffer_alloc_size;
@@ -250,13 +269,66 @@ typedef struct AV1Decoder {
 #endif
 
   AV1DecRowMTInfo frame_row_mt_info;
+
+  // Frame parallel decoding: av1_receive_compressed_data() only parses the
+  // headers and records the tile groups of the frame, which are decoded by
+  // av1_decode_deferred_frame() once the reference frames are decoded.
+  int frame_parallel;
+  TileGroupDec *tile_groups;
+  int num_tile_groups;
+  int allocated_tile_groups;
 } AV1Decoder;
 
+// Frame parallel decoding: the state that the headers of a frame inherit from
+// the previous frame in decoding order, which is parsed by another frame
+// worker. The references in ref_frame_map are held.
+typedef struct AV1DecHeaderState {
+  FRAME_CONTEXT default_frame_context;
+  SequenceHeader seq_params;
+  int timing_info_present;
+  aom_timing_info_t timing_info;
+  aom_dec_model_info_t buffer_model;
+  aom_dec_model_op_parameters_t op_params[MAX_NUM_OPERATING_POINTS + 1];
+  unsigned int number_temporal_layers;
+  unsigned int number_spatial_layers;
+  CurrentFrame current_frame;
+  int current_frame_id;
+  int ref_frame_id[REF_FRAMES];
+  int valid_for_referencing[REF_FRAMES];
+  RefCntBuffer *ref_frame_map[REF_FRAMES];
+  int sequence_header_ready;
+  int sequence_header_changed;
+  int decoding_first_frame;
+  int need_resync;
+  int current_operating_point;
+} AV1DecHeaderState;
+
 // Returns 0 on success. Sets pbi->common.error.error_code to a nonzero error
 // code and returns a nonzero value on failure.
 int av1_receive_compressed_data(struct AV1Decoder *pbi, size_t size,
                                 const uint8_t **psource);
 
+// Frame parallel decoding: decodes the tile groups deferred by
+// av1_receive_compressed_data(), once the reference frames are decoded, and
+// finishes the frame like it. Returns 0 on success. Sets
+// pbi->common.error.error_code and returns a nonzero value on failure.
+int av1_decode_deferred_frame(struct AV1Decoder *pbi);
+
+// Frame parallel decoding: saves the header state of pbi after
+// av1_receive_compressed_data() parsed a frame, and loads it into the frame
+// worker that parses the next one.
+void av1_save_header_state(const struct AV1Decoder *pbi,
+                           AV1DecHeaderState *state);
+void av1_load_header_state(struct AV1Decoder *pbi,
+                           const AV1DecHeaderState *state);
+
+// Frame parallel decoding: records that the first sb_rows superblock rows of
+// buf are final, and wakes up the frame workers waiting for them.
+void av1_frame_progress_set(BufferPool *pool, RefCntBuffer *buf, int sb_rows);
+// Frame parallel decoding: waits until the first sb_rows superblock rows of
+// buf are final. INT_MAX waits for the whole frame.
+void av1_frame_progress_wait(BufferPool *pool, RefCntBuffer *buf, int sb_rows);
+
 // Get the frame at a particular index in the output queue
 int av1_get_raw_frame(AV1Decoder *pbi, size_t index, YV12_BUFFER_CONFIG **sd,
                       aom_film_grain_t **grain_params);
@@ -276,6 +348,17 @@ aom_codec_err_t av1_copy_new_frame_dec(AV1_COMMON *cm,
 struct AV1Decoder *av1_decoder_create(BufferPool *const pool);
 
 void av1_decoder_remove(struct AV1Decoder *pbi);
+
+// Allocates the frame buffers of the pool and their side buffers for frames of
+// up to max_width x max_height, in any chroma format, so that decoding frames
+// of any size up to that reuses them. Returns 0 on success.
+int av1_reserve_frame_buffers(BufferPool *pool, int max_width, int max_height,
+                              int use_highbitdepth, int byte_alignment);
+
+// Allocates the superres scratch frame of pbi for frames of up to max_width x
+// max_height. Returns 0 on success.
+int av1_reserve_superres_scratch(struct AV1Decoder *pbi, int max_width,
+                                 int max_height, int use_highbitdepth);
 void av1_dealloc_dec_jobs(struct AV1DecTileMTData *tile_mt_info);
 
 void av1_dec_row_mt_dealloc(AV1DecRowMTSync *dec_row_mt_sync);
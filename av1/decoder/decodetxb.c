@@ -87,11 +87,13 @@ static INLINE void read_coeffs_reverse_2d(aom_reader *r, TX_SIZE tx_size,
   }
 }
 
-static INLINE void read_coeffs_reverse(aom_reader *r, TX_SIZE tx_size,
-                                       TX_CLASS tx_class, int start_si,
-                                       int end_si, const int16_t *scan, int bwl,
-                                       uint8_t *levels, base_cdf_arr base_cdf,
-                                       br_cdf_arr br_cdf) {
+// Always inlined with a constant tx_class, so that each class gets its own
+// copy with the neighbor offsets of get_lower_levels_ctx() and get_br_ctx()
+// known at compile time.
+static AOM_FORCE_INLINE void read_coeffs_reverse(
+    aom_reader *r, TX_SIZE tx_size, const TX_CLASS tx_class, int start_si,
+    int end_si, const int16_t *scan, int bwl, uint8_t *levels,
+    base_cdf_arr base_cdf, br_cdf_arr br_cdf) {
   for (int c = end_si; c >= start_si; --c) {
     const int pos = scan[c];
     const int coeff_ctx =
@@ -350,17 +352,28 @@ uint8_t av1_read_coeffs_txb(const AV1_COMMON *const cm, MACROBLOCKD *const xd,
     base_cdf_arr base_cdf = ec_ctx->coeff_base_cdf[txs_ctx][plane_type];
     br_cdf_arr br_cdf =
         ec_ctx->coeff_br_cdf[AOMMIN(txs_ctx, TX_32X32)][plane_type];
-    if (tx_class == TX_CLASS_2D) {
-      read_coeffs_reverse_2d(r, tx_size, 1, *eob - 1 - 1, scan, bwl, levels,
-                             base_cdf, br_cdf);
-      read_coeffs_reverse(r, tx_size, tx_class, 0, 0, scan, bwl, levels,
-                          base_cdf, br_cdf);
-    } else {
-      read_coeffs_reverse(r, tx_size, tx_class, 0, *eob - 1 - 1, scan, bwl,
-                          levels, base_cdf, br_cdf);
+    switch (tx_class) {
+      case TX_CLASS_2D:
+        read_coeffs_reverse_2d(r, tx_size, 1, *eob - 1 - 1, scan, bwl, levels,
+                               base_cdf, br_cdf);
+        read_coeffs_reverse(r, tx_size, TX_CLASS_2D, 0, 0, scan, bwl, levels,
+                            base_cdf, br_cdf);
+        break;
+      case TX_CLASS_HORIZ:
+        read_coeffs_reverse(r, tx_size, TX_CLASS_HORIZ, 0, *eob - 1 - 1, scan,
+                            bwl, levels, base_cdf, br_cdf);
+        break;
+      case TX_CLASS_VERT:
+        read_coeffs_reverse(r, tx_size, TX_CLASS_VERT, 0, *eob - 1 - 1, scan,
+                            bwl, levels, base_cdf, br_cdf);
+        break;
+      default: assert(0);
     }
   }
 
+  // Read the signs and the golomb remainders, and store the signed levels in
+  // tcoeffs[] for the dequantization below.
+  int nz_count = 0;
   for (int c = 0; c < *eob; ++c) {
     const int pos = scan[c];
     uint8_t sign;
@@ -384,23 +397,32 @@ uint8_t av1_read_coeffs_txb(const AV1_COMMON *const cm, MACROBLOCKD *const xd,
       //   The valid range for 8/10/12 bit vdieo is at most 14/16/18 bit
       level &= 0xfffff;
       cul_level += level;
-      tran_low_t dq_coeff;
-      // Bitmasking to clamp dq_coeff to valid range:
-      //   The valid range for 8/10/12 bit video is at most 17/19/21 bit
-#if QUANT_TABLE_BITS
-      const int64_t dq_coeff_hp =
-          (int64_t)level * get_dqv(dequant, scan[c], iqmatrix) & 0xffffff;
-      dq_coeff =
-          (tran_low_t)(ROUND_POWER_OF_TWO_64(dq_coeff_hp, QUANT_TABLE_BITS));
-#else
-      dq_coeff = (tran_low_t)(
-          (int64_t)level * get_dqv(dequant, scan[c], iqmatrix) & 0xffffff);
-#endif  // QUANT_TABLE_BITS
-      dq_coeff = dq_coeff >> shift;
-      if (sign) {
-        dq_coeff = -dq_coeff;
+      tcoeffs[pos] = sign ? -level : level;
+      ++nz_count;
+    }
+  }
+
+  if (iqmatrix != NULL) {
+    for (int c = 0; c < *eob; ++c) {
+      const int pos = scan[c];
+      if (tcoeffs[pos]) {
+        tcoeffs[pos] =
+            av1_dequant_coeff(tcoeffs[pos], get_dqv(dequant, pos, iqmatrix),
+                              shift, min_value, max_value);
+      }
+    }
+  } else if (nz_count * 4 > *max_scan_line) {
+    // Dense enough for a raster pass over [0, max_scan_line]. The positions
+    // in it that are not coded are zero already and stay zero.
+    av1_dequantize_coeffs(tcoeffs, *max_scan_line + 1, dequant[0], dequant[1],
+                          shift, xd->bd);
+  } else {
+    for (int c = 0; c < *eob; ++c) {
+      const int pos = scan[c];
+      if (tcoeffs[pos]) {
+        tcoeffs[pos] = av1_dequant_coeff(tcoeffs[pos], dequant[pos != 0], shift,
+                                         min_value, max_value);
       }
-      tcoeffs[pos] = clamp(dq_coeff, min_value, max_value);
     }
   }
 
@@ -43,6 +43,11 @@ typedef struct FrameWorkerData {
   int received_frame;
   int frame_context_ready;  // Current frame's context is ready to read.
   int frame_decoded;        // Finished decoding current frame.
+  // Frame parallel decoding: the temporal unit of the frame, and a copy of its
+  // data, which the tile groups point into until the frame is decoded.
+  unsigned int tu_id;
+  uint8_t *scratch_buffer;
+  size_t scratch_buffer_size;
 } FrameWorkerData;
 
 #ifdef __cplusplus
@@ -16,6 +16,7 @@
 
 #include "aom/aom_codec.h"
 #include "aom_dsp/bitreader_buffer.h"
+#include "aom_mem/aom_mem.h"
 #include "aom_ports/mem_ops.h"
 
 #include "av1/common/common.h"
@@ -324,6 +325,30 @@ static int32_t read_tile_group_header(AV1Decoder *pbi,
   return ((rb->bit_offset - saved_bit_offset + 7) >> 3);
 }
 
+// Records a tile group for av1_decode_deferred_frame(). Until its tiles are
+// decoded, the tile group extends to the end of its OBU.
+static void defer_tile_group(AV1Decoder *pbi, const uint8_t *data,
+                             const uint8_t *data_end, int start_tile,
+                             int end_tile) {
+  AV1_COMMON *const cm = &pbi->common;
+  // A frame has at most one tile group per tile.
+  const int num_tiles = cm->tile_rows * cm->tile_cols;
+  if (pbi->allocated_tile_groups < num_tiles) {
+    aom_free(pbi->tile_groups);
+    pbi->allocated_tile_groups = 0;
+    CHECK_MEM_ERROR(
+        cm, pbi->tile_groups,
+        (TileGroupDec *)aom_malloc(num_tiles * sizeof(*pbi->tile_groups)));
+    pbi->allocated_tile_groups = num_tiles;
+  }
+  assert(pbi->num_tile_groups < num_tiles);
+  TileGroupDec *const tg = &pbi->tile_groups[pbi->num_tile_groups++];
+  tg->data = data;
+  tg->data_end = data_end;
+  tg->start_tile = start_tile;
+  tg->end_tile = end_tile;
+}
+
 // On success, returns the tile group OBU size. On failure, sets
 // pbi->common.error.error_code and returns 0.
 static uint32_t read_one_tile_group_obu(
@@ -341,8 +366,13 @@ static uint32_t read_one_tile_group_obu(
                                        tile_start_implicit);
   if (header_size == -1 || byte_alignment(cm, rb)) return 0;
   data += header_size;
-  av1_decode_tg_tiles_and_wrapup(pbi, data, data_end, p_data_end, start_tile,
-                                 end_tile, is_first_tg);
+  if (pbi->frame_parallel) {
+    defer_tile_group(pbi, data, data_end, start_tile, end_tile);
+    *p_data_end = data_end;
+  } else {
+    av1_decode_tg_tiles_and_wrapup(pbi, data, data_end, p_data_end, start_tile,
+                                   end_tile, is_first_tg);
+  }
 
   tg_payload_size = (uint32_t)(*p_data_end - data);
 
@@ -755,6 +785,7 @@ int aom_decode_frame_from_obus(struct AV1Decoder *pbi, const uint8_t *data,
   memset(&obu_header, 0, sizeof(obu_header));
   pbi->seen_frame_header = 0;
   pbi->next_start_tile = 0;
+  pbi->num_tile_groups = 0;
 
   if (data_end < data) {
     cm->error.error_code = AOM_CODEC_CORRUPT_FRAME;
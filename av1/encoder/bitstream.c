@@ -48,6 +48,7 @@
 #include "av1/encoder/cost.h"
 #include "av1/encoder/encodemv.h"
 #include "av1/encoder/encodetxb.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/mcomp.h"
 #include "av1/encoder/palette.h"
 #include "av1/encoder/segmentation.h"
@@ -706,14 +707,15 @@ int av1_neg_interleave(int x, int ref, int max) {
   }
 }
 
-static void write_segment_id(AV1_COMP *cpi, const MB_MODE_INFO *const mbmi,
-                             aom_writer *w, const struct segmentation *seg,
+static void write_segment_id(AV1_COMP *cpi, ThreadData *const td,
+                             const MB_MODE_INFO *const mbmi, aom_writer *w,
+                             const struct segmentation *seg,
                              struct segmentation_probs *segp, int mi_row,
                              int mi_col, int skip) {
   if (!seg->enabled || !seg->update_map) return;
 
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   int cdf_num;
   const int pred = av1_get_spatial_seg_pred(cm, xd, mi_row, mi_col, &cdf_num);
 
@@ -896,9 +898,10 @@ static void write_angle_delta(aom_writer *w, int angle_delta,
                    2 * MAX_ANGLE_DELTA + 1);
 }
 
-static void write_mb_interp_filter(AV1_COMP *cpi, const MACROBLOCKD *xd,
+static void write_mb_interp_filter(AV1_COMP *cpi, ThreadData *const td,
                                    aom_writer *w) {
   AV1_COMMON *const cm = &cpi->common;
+  const MACROBLOCKD *const xd = &td->mb.e_mbd;
   const MB_MODE_INFO *const mbmi = xd->mi[0];
   FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
 
@@ -921,7 +924,7 @@ static void write_mb_interp_filter(AV1_COMP *cpi, const MACROBLOCKD *xd,
           av1_extract_interp_filter(mbmi->interp_filters, dir);
       aom_write_symbol(w, filter, ec_ctx->switchable_interp_cdf[ctx],
                        SWITCHABLE_FILTERS);
-      ++cm->cur_frame->interp_filter_selected[filter];
+      ++td->interp_filter_selected[filter];
     }
   }
 }
@@ -1298,12 +1301,13 @@ static void write_cdef(AV1_COMMON *cm, MACROBLOCKD *const xd, aom_writer *w,
   }
 }
 
-static void write_inter_segment_id(AV1_COMP *cpi, aom_writer *w,
+static void write_inter_segment_id(AV1_COMP *cpi, ThreadData *const td,
+                                   aom_writer *w,
                                    const struct segmentation *const seg,
                                    struct segmentation_probs *const segp,
                                    int mi_row, int mi_col, int skip,
                                    int preskip) {
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   MB_MODE_INFO *const mbmi = xd->mi[0];
   AV1_COMMON *const cm = &cpi->common;
 
@@ -1313,7 +1317,7 @@ static void write_inter_segment_id(AV1_COMP *cpi, aom_writer *w,
     } else {
       if (seg->segid_preskip) return;
       if (skip) {
-        write_segment_id(cpi, mbmi, w, seg, segp, mi_row, mi_col, 1);
+        write_segment_id(cpi, td, mbmi, w, seg, segp, mi_row, mi_col, 1);
         if (seg->temporal_update) mbmi->seg_id_predicted = 0;
         return;
       }
@@ -1323,27 +1327,28 @@ static void write_inter_segment_id(AV1_COMP *cpi, aom_writer *w,
       aom_cdf_prob *pred_cdf = av1_get_pred_cdf_seg_id(segp, xd);
       aom_write_symbol(w, pred_flag, pred_cdf, 2);
       if (!pred_flag) {
-        write_segment_id(cpi, mbmi, w, seg, segp, mi_row, mi_col, 0);
+        write_segment_id(cpi, td, mbmi, w, seg, segp, mi_row, mi_col, 0);
       }
       if (pred_flag) {
         set_spatial_segment_id(cm, cm->cur_frame->seg_map, mbmi->sb_type,
                                mi_row, mi_col, mbmi->segment_id);
       }
     } else {
-      write_segment_id(cpi, mbmi, w, seg, segp, mi_row, mi_col, 0);
+      write_segment_id(cpi, td, mbmi, w, seg, segp, mi_row, mi_col, 0);
     }
   }
 }
 
 // If delta q is present, writes delta_q index.
 // Also writes delta_q loop filter levels, if present.
-static void write_delta_q_params(AV1_COMP *cpi, const int mi_row,
-                                 const int mi_col, int skip, aom_writer *w) {
+static void write_delta_q_params(AV1_COMP *cpi, ThreadData *const td,
+                                 const int mi_row, const int mi_col, int skip,
+                                 aom_writer *w) {
   AV1_COMMON *const cm = &cpi->common;
   const DeltaQInfo *const delta_q_info = &cm->delta_q_info;
 
   if (delta_q_info->delta_q_present_flag) {
-    MACROBLOCK *const x = &cpi->td.mb;
+    MACROBLOCK *const x = &td->mb;
     MACROBLOCKD *const xd = &x->e_mbd;
     const MB_MODE_INFO *const mbmi = xd->mi[0];
     const BLOCK_SIZE bsize = mbmi->sb_type;
@@ -1382,10 +1387,10 @@ static void write_delta_q_params(AV1_COMP *cpi, const int mi_row,
   }
 }
 
-static void write_intra_prediction_modes(AV1_COMP *cpi, int is_keyframe,
-                                         aom_writer *w) {
+static void write_intra_prediction_modes(AV1_COMP *cpi, ThreadData *const td,
+                                         int is_keyframe, aom_writer *w) {
   const AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCK *const x = &cpi->td.mb;
+  MACROBLOCK *const x = &td->mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
   const MB_MODE_INFO *const mbmi = xd->mi[0];
@@ -1572,10 +1577,11 @@ static void write_interintra_mode_and_wedge_bits(MACROBLOCKD *const xd,
 #endif  // CONFIG_INTERINTRA_ML
 }
 
-static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
-                                const int mi_col, aom_writer *w) {
+static void pack_inter_mode_mvs(AV1_COMP *cpi, ThreadData *const td,
+                                const int mi_row, const int mi_col,
+                                aom_writer *w) {
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCK *const x = &cpi->td.mb;
+  MACROBLOCK *const x = &td->mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
   const struct segmentation *const seg = &cm->seg;
@@ -1589,7 +1595,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
   const int is_compound = has_second_ref(mbmi);
   int ref;
 
-  write_inter_segment_id(cpi, w, seg, segp, mi_row, mi_col, 0, 1);
+  write_inter_segment_id(cpi, td, w, seg, segp, mi_row, mi_col, 0, 1);
 
   write_skip_mode(cm, xd, segment_id, mbmi, w);
 
@@ -1604,11 +1610,11 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
   const int skip =
       mbmi->skip_mode ? 1 : write_skip(cm, xd, segment_id, mbmi, w);
 
-  write_inter_segment_id(cpi, w, seg, segp, mi_row, mi_col, skip, 0);
+  write_inter_segment_id(cpi, td, w, seg, segp, mi_row, mi_col, skip, 0);
 
   write_cdef(cm, xd, w, skip, mi_col, mi_row);
 
-  write_delta_q_params(cpi, mi_row, mi_col, skip, w);
+  write_delta_q_params(cpi, td, mi_row, mi_col, skip, w);
 
   if (!mbmi->skip_mode) write_is_inter(cm, xd, mbmi->segment_id, w, is_inter);
 
@@ -1623,7 +1629,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
 #endif  // CONFIG_DSPL_RESIDUAL
 
   if (!is_inter) {
-    write_intra_prediction_modes(cpi, 0, w);
+    write_intra_prediction_modes(cpi, td, 0, w);
   } else {
     av1_collect_neighbors_ref_counts(xd);
 
@@ -1667,7 +1673,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
       for (ref = 0; ref < 1 + is_compound; ++ref) {
         nmv_context *nmvc = &ec_ctx->nmvc;
         const int_mv ref_mv = av1_get_ref_mv(x, ref);
-        av1_encode_mv(cpi, w, &mbmi->mv[ref].as_mv, &ref_mv.as_mv, nmvc,
+        av1_encode_mv(cpi, td, w, &mbmi->mv[ref].as_mv, &ref_mv.as_mv, nmvc,
                       mbmi->pb_mv_precision);
       }
 #if CONFIG_NEW_INTER_MODES
@@ -1675,24 +1681,24 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
     } else if (mode == NEAR_NEWMV || mode == SCALED_NEWMV) {
       nmv_context *nmvc = &ec_ctx->nmvc;
       const int_mv ref_mv = av1_get_ref_mv(x, 1);
-      av1_encode_mv(cpi, w, &mbmi->mv[1].as_mv, &ref_mv.as_mv, nmvc,
+      av1_encode_mv(cpi, td, w, &mbmi->mv[1].as_mv, &ref_mv.as_mv, nmvc,
                     mbmi->pb_mv_precision);
     } else if (mode == NEW_NEARMV || mode == NEW_SCALEDMV) {
       nmv_context *nmvc = &ec_ctx->nmvc;
       const int_mv ref_mv = av1_get_ref_mv(x, 0);
-      av1_encode_mv(cpi, w, &mbmi->mv[0].as_mv, &ref_mv.as_mv, nmvc,
+      av1_encode_mv(cpi, td, w, &mbmi->mv[0].as_mv, &ref_mv.as_mv, nmvc,
                     mbmi->pb_mv_precision);
     }
 #else   // !CONFIG_EXT_COMPOUND
     } else if (mode == NEAR_NEWMV) {
       nmv_context *nmvc = &ec_ctx->nmvc;
       const int_mv ref_mv = av1_get_ref_mv(x, 1);
-      av1_encode_mv(cpi, w, &mbmi->mv[1].as_mv, &ref_mv.as_mv, nmvc,
+      av1_encode_mv(cpi, td, w, &mbmi->mv[1].as_mv, &ref_mv.as_mv, nmvc,
                     mbmi->pb_mv_precision);
     } else if (mode == NEW_NEARMV) {
       nmv_context *nmvc = &ec_ctx->nmvc;
       const int_mv ref_mv = av1_get_ref_mv(x, 0);
-      av1_encode_mv(cpi, w, &mbmi->mv[0].as_mv, &ref_mv.as_mv, nmvc,
+      av1_encode_mv(cpi, td, w, &mbmi->mv[0].as_mv, &ref_mv.as_mv, nmvc,
                     mbmi->pb_mv_precision);
     }
 #endif  // CONFIG_EXT_COMPOUND
@@ -1700,12 +1706,12 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
     } else if (mode == NEAREST_NEWMV || mode == NEAR_NEWMV) {
       nmv_context *nmvc = &ec_ctx->nmvc;
       const int_mv ref_mv = av1_get_ref_mv(x, 1);
-      av1_encode_mv(cpi, w, &mbmi->mv[1].as_mv, &ref_mv.as_mv, nmvc,
+      av1_encode_mv(cpi, td, w, &mbmi->mv[1].as_mv, &ref_mv.as_mv, nmvc,
                     mbmi->pb_mv_precision);
     } else if (mode == NEW_NEARESTMV || mode == NEW_NEARMV) {
       nmv_context *nmvc = &ec_ctx->nmvc;
       const int_mv ref_mv = av1_get_ref_mv(x, 0);
-      av1_encode_mv(cpi, w, &mbmi->mv[0].as_mv, &ref_mv.as_mv, nmvc,
+      av1_encode_mv(cpi, td, w, &mbmi->mv[0].as_mv, &ref_mv.as_mv, nmvc,
                     mbmi->pb_mv_precision);
     }
 #endif  // CONFIG_NEW_INTER_MODES
@@ -1778,7 +1784,7 @@ static void pack_inter_mode_mvs(AV1_COMP *cpi, const int mi_row,
         }
       }
     }
-    write_mb_interp_filter(cpi, xd, w);
+    write_mb_interp_filter(cpi, td, w);
   }
 }
 
@@ -1808,27 +1814,28 @@ static void write_intrabc_info(
   }
 }
 
-static void write_mb_modes_kf(AV1_COMP *cpi, MACROBLOCKD *xd,
+static void write_mb_modes_kf(AV1_COMP *cpi, ThreadData *const td,
                               const MB_MODE_INFO_EXT *mbmi_ext,
                               const int mi_row, const int mi_col,
                               aom_writer *w) {
   AV1_COMMON *const cm = &cpi->common;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   FRAME_CONTEXT *ec_ctx = xd->tile_ctx;
   const struct segmentation *const seg = &cm->seg;
   struct segmentation_probs *const segp = &ec_ctx->seg;
   const MB_MODE_INFO *const mbmi = xd->mi[0];
 
   if (seg->segid_preskip && seg->update_map)
-    write_segment_id(cpi, mbmi, w, seg, segp, mi_row, mi_col, 0);
+    write_segment_id(cpi, td, mbmi, w, seg, segp, mi_row, mi_col, 0);
 
   const int skip = write_skip(cm, xd, mbmi->segment_id, mbmi, w);
 
   if (!seg->segid_preskip && seg->update_map)
-    write_segment_id(cpi, mbmi, w, seg, segp, mi_row, mi_col, skip);
+    write_segment_id(cpi, td, mbmi, w, seg, segp, mi_row, mi_col, skip);
 
   write_cdef(cm, xd, w, skip, mi_col, mi_row);
 
-  write_delta_q_params(cpi, mi_row, mi_col, skip, w);
+  write_delta_q_params(cpi, td, mi_row, mi_col, skip, w);
 
   if (av1_allow_intrabc(cm)) {
 #if CONFIG_EXT_IBC_MODES
@@ -1839,7 +1846,7 @@ static void write_mb_modes_kf(AV1_COMP *cpi, MACROBLOCKD *xd,
     if (is_intrabc_block(mbmi)) return;
   }
 
-  write_intra_prediction_modes(cpi, 1, w);
+  write_intra_prediction_modes(cpi, td, 1, w);
 }
 
 #if CONFIG_RD_DEBUG
@@ -1932,13 +1939,14 @@ static void enc_dump_logs(AV1_COMP *cpi, int mi_row, int mi_col) {
 }
 #endif  // ENC_MISMATCH_DEBUG
 
-static void write_mbmi_b(AV1_COMP *cpi, aom_writer *w, int mi_row, int mi_col) {
+static void write_mbmi_b(AV1_COMP *cpi, ThreadData *const td, aom_writer *w,
+                         int mi_row, int mi_col) {
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   MB_MODE_INFO *m = xd->mi[0];
 
   if (frame_is_intra_only(cm)) {
-    write_mb_modes_kf(cpi, xd, cpi->td.mb.mbmi_ext, mi_row, mi_col, w);
+    write_mb_modes_kf(cpi, td, td->mb.mbmi_ext, mi_row, mi_col, w);
   } else {
     // has_subpel_mv_component needs the ref frame buffers set up to look
     // up if they are scaled. has_subpel_mv_component is in turn needed by
@@ -1949,7 +1957,7 @@ static void write_mbmi_b(AV1_COMP *cpi, aom_writer *w, int mi_row, int mi_col) {
     enc_dump_logs(cpi, mi_row, mi_col);
 #endif  // ENC_MISMATCH_DEBUG
 
-    pack_inter_mode_mvs(cpi, mi_row, mi_col, w);
+    pack_inter_mode_mvs(cpi, td, mi_row, mi_col, w);
   }
 }
 
@@ -1989,10 +1997,11 @@ static void write_inter_txb_coeff(AV1_COMMON *const cm, MACROBLOCK *const x,
   }
 }
 
-static void write_tokens_b(AV1_COMP *cpi, aom_writer *w, const TOKENEXTRA **tok,
+static void write_tokens_b(AV1_COMP *cpi, ThreadData *const td, aom_writer *w,
+                           const TOKENEXTRA **tok,
                            const TOKENEXTRA *const tok_end) {
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCK *const x = &cpi->td.mb;
+  MACROBLOCK *const x = &td->mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   MB_MODE_INFO *const mbmi = xd->mi[0];
   const BLOCK_SIZE bsize = mbmi->sb_type;
@@ -2045,14 +2054,15 @@ static void write_tokens_b(AV1_COMP *cpi, aom_writer *w, const TOKENEXTRA **tok,
   }
 }
 
-static void write_modes_b(AV1_COMP *cpi, const TileInfo *const tile,
-                          aom_writer *w, const TOKENEXTRA **tok,
+static void write_modes_b(AV1_COMP *cpi, ThreadData *const td,
+                          const TileInfo *const tile, aom_writer *w,
+                          const TOKENEXTRA **tok,
                           const TOKENEXTRA *const tok_end, int mi_row,
                           int mi_col) {
   const AV1_COMMON *cm = &cpi->common;
-  MACROBLOCKD *xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *xd = &td->mb.e_mbd;
   xd->mi = cm->mi_grid_base + (mi_row * cm->mi_stride + mi_col);
-  cpi->td.mb.mbmi_ext = cpi->mbmi_ext_base + (mi_row * cm->mi_cols + mi_col);
+  td->mb.mbmi_ext = cpi->mbmi_ext_base + (mi_row * cm->mi_cols + mi_col);
 
   const MB_MODE_INFO *mbmi = xd->mi[0];
   const BLOCK_SIZE bsize = mbmi->sb_type;
@@ -2068,7 +2078,7 @@ static void write_modes_b(AV1_COMP *cpi, const TileInfo *const tile,
   xd->left_txfm_context =
       xd->left_txfm_context_buffer + (mi_row & MAX_MIB_MASK);
 
-  write_mbmi_b(cpi, w, mi_row, mi_col);
+  write_mbmi_b(cpi, td, w, mi_row, mi_col);
 
   for (int plane = 0; plane < AOMMIN(2, av1_num_planes(cm)); ++plane) {
     const uint8_t palette_size_plane =
@@ -2121,7 +2131,7 @@ static void write_modes_b(AV1_COMP *cpi, const TileInfo *const tile,
   }
 
   if (!mbmi->skip) {
-    write_tokens_b(cpi, w, tok, tok_end);
+    write_tokens_b(cpi, td, w, tok, tok_end);
   } else {
     assert(1 == av1_get_txk_skip(cm, xd->mi_row, xd->mi_col, 0, 0, 0));
   }
@@ -2190,15 +2200,16 @@ static void write_partition(const AV1_COMMON *const cm,
 #endif  // CONFIG_EXT_RECUR_PARTITIONS
 }
 
-static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
-                           aom_writer *const w, const TOKENEXTRA **tok,
+static void write_modes_sb(AV1_COMP *const cpi, ThreadData *const td,
+                           const TileInfo *const tile, aom_writer *const w,
+                           const TOKENEXTRA **tok,
                            const TOKENEXTRA *const tok_end,
                            PARTITION_TREE *ptree, int mi_row, int mi_col,
                            BLOCK_SIZE bsize) {
   assert(bsize < BLOCK_SIZES_ALL);
   assert(ptree);
   const AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   assert(bsize < BLOCK_SIZES_ALL);
   const int hbs_w = mi_size_wide[bsize] / 2;
   const int hbs_h = mi_size_high[bsize] / 2;
@@ -2233,8 +2244,7 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
           const int runit_idx = rcol + rrow * rstride;
           const RestorationUnitInfo *rui =
               &cm->rst_info[plane].unit_info[runit_idx];
-          loop_restoration_write_sb_coeffs(cm, xd, rui, w, plane,
-                                           cpi->td.counts);
+          loop_restoration_write_sb_coeffs(cm, xd, rui, w, plane, td->counts);
         }
       }
     }
@@ -2243,96 +2253,98 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
   write_partition(cm, xd, mi_row, mi_col, partition, bsize, w);
   switch (partition) {
     case PARTITION_NONE:
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
       break;
     case PARTITION_HORZ:
 #if CONFIG_EXT_RECUR_PARTITIONS
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
                      mi_col, subsize);
       if (mi_row + hbs_h < cm->mi_rows) {
-        write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[1],
+        write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[1],
                        mi_row + hbs_h, mi_col, subsize);
       }
 #else   // CONFIG_EXT_RECUR_PARTITIONS
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
       if (mi_row + hbs_h < cm->mi_rows)
-        write_modes_b(cpi, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
+        write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
 #endif  // CONFIG_EXT_RECUR_PARTITIONS
       break;
     case PARTITION_VERT:
 #if CONFIG_EXT_RECUR_PARTITIONS
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
                      mi_col, subsize);
       if (mi_col + hbs_w < cm->mi_cols) {
-        write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[1], mi_row,
-                       mi_col + hbs_w, subsize);
+        write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[1],
+                       mi_row, mi_col + hbs_w, subsize);
       }
 #else  // CONFIG_EXT_RECUR_PARTITIONS
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
       if (mi_col + hbs_w < cm->mi_cols)
-        write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
+        write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
 #endif
       break;
     case PARTITION_SPLIT:
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
                      mi_col, subsize);
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[1], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[1], mi_row,
                      mi_col + hbs_w, subsize);
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[2],
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[2],
                      mi_row + hbs_h, mi_col, subsize);
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[3],
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[3],
                      mi_row + hbs_h, mi_col + hbs_w, subsize);
       break;
 #if CONFIG_EXT_RECUR_PARTITIONS
     case PARTITION_HORZ_3:
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
                      mi_col, subsize);
       if (mi_row + qbs_h >= cm->mi_rows) break;
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[1],
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[1],
                      mi_row + qbs_h, mi_col,
                      get_partition_subsize(bsize, PARTITION_HORZ));
       if (mi_row + 3 * qbs_h >= cm->mi_rows) break;
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[2],
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[2],
                      mi_row + 3 * qbs_h, mi_col, subsize);
       break;
     case PARTITION_VERT_3:
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[0], mi_row,
                      mi_col, subsize);
       if (mi_col + qbs_w >= cm->mi_cols) break;
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[1], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[1], mi_row,
                      mi_col + qbs_w,
                      get_partition_subsize(bsize, PARTITION_VERT));
       if (mi_col + 3 * qbs_w >= cm->mi_cols) break;
-      write_modes_sb(cpi, tile, w, tok, tok_end, ptree->sub_tree[2], mi_row,
+      write_modes_sb(cpi, td, tile, w, tok, tok_end, ptree->sub_tree[2], mi_row,
                      mi_col + 3 * qbs_w, subsize);
       break;
 #else
     case PARTITION_HORZ_A:
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
       break;
     case PARTITION_HORZ_B:
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row + hbs_h, mi_col + hbs_w);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs_h,
+                    mi_col + hbs_w);
       break;
     case PARTITION_VERT_A:
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs_h, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
       break;
     case PARTITION_VERT_B:
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
-      write_modes_b(cpi, tile, w, tok, tok_end, mi_row + hbs_h, mi_col + hbs_w);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, mi_col + hbs_w);
+      write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row + hbs_h,
+                    mi_col + hbs_w);
       break;
     case PARTITION_HORZ_4:
       for (int i = 0; i < 4; ++i) {
         int this_mi_row = mi_row + i * qbs_h;
         if (i > 0 && this_mi_row >= cm->mi_rows) break;
 
-        write_modes_b(cpi, tile, w, tok, tok_end, this_mi_row, mi_col);
+        write_modes_b(cpi, td, tile, w, tok, tok_end, this_mi_row, mi_col);
       }
       break;
     case PARTITION_VERT_4:
@@ -2340,7 +2352,7 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
         int this_mi_col = mi_col + i * qbs_w;
         if (i > 0 && this_mi_col >= cm->mi_cols) break;
 
-        write_modes_b(cpi, tile, w, tok, tok_end, mi_row, this_mi_col);
+        write_modes_b(cpi, td, tile, w, tok, tok_end, mi_row, this_mi_col);
       }
       break;
 #endif  // CONFIG_EXT_RECUR_PARTITIONS
@@ -2351,10 +2363,11 @@ static void write_modes_sb(AV1_COMP *const cpi, const TileInfo *const tile,
   update_ext_partition_context(xd, mi_row, mi_col, subsize, bsize, partition);
 }
 
-static void write_modes(AV1_COMP *const cpi, const TileInfo *const tile,
-                        aom_writer *const w, int tile_row, int tile_col) {
+static void write_modes(AV1_COMP *const cpi, ThreadData *const td,
+                        const TileInfo *const tile, aom_writer *const w,
+                        int tile_row, int tile_col) {
   AV1_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   const int mi_row_start = tile->mi_row_start;
   const int mi_row_end = tile->mi_row_end;
   const int mi_col_start = tile->mi_col_start;
@@ -2386,9 +2399,12 @@ static void write_modes(AV1_COMP *const cpi, const TileInfo *const tile,
          mi_col += cm->seq_params.mib_size) {
       av1_reset_is_mi_coded_map(xd, cm->seq_params.mib_size);
       xd->sbi = av1_get_sb_info(cm, mi_row, mi_col);
-      cpi->td.mb.cb_coef_buff = av1_get_cb_coeff_buffer(cpi, mi_row, mi_col);
-      write_modes_sb(cpi, tile, w, &tok, tok_end, xd->sbi->ptree_root, mi_row,
-                     mi_col, cm->seq_params.sb_size);
+      td->mb.cb_coef_buff = av1_get_cb_coeff_buffer(cpi, mi_row, mi_col);
+      write_modes_sb(cpi, td, tile, w, &tok, tok_end, xd->sbi->ptree_root,
+                     mi_row, mi_col, cm->seq_params.sb_size);
+#if CONFIG_INTRA_ENTROPY
+      if (w->allow_update_cdf) av1_update_entropy_models_sb(xd->tile_ctx);
+#endif  // CONFIG_INTRA_ENTROPY
     }
     assert(tok == cpi->tplist[tile_row][tile_col][sb_row_in_tile].stop);
   }
@@ -3469,6 +3485,9 @@ static void write_sequence_header(const SequenceHeader *const seq_params,
 #if CONFIG_ADAPT_FILTER_INTRA
   aom_wb_write_bit(wb, seq_params->enable_adapt_filter_intra);
 #endif
+#if CONFIG_INTRA_ENTROPY
+  aom_wb_write_bit(wb, seq_params->enable_intra_entropy_sb_update);
+#endif  // CONFIG_INTRA_ENTROPY
   aom_wb_write_bit(wb, seq_params->enable_intra_edge_filter);
 
   if (!seq_params->reduced_still_picture_hdr) {
@@ -4040,20 +4059,15 @@ static int remux_tiles(const AV1_COMMON *const cm, uint8_t *dst,
                        const uint32_t max_tile_col_size,
                        int *const tile_size_bytes,
                        int *const tile_col_size_bytes) {
-  // Choose the tile size bytes (tsb) and tile column size bytes (tcsb)
-  int tsb;
-  int tcsb;
+  // Only large scale tile frames are remuxed, the tiles of other frames are
+  // gathered with the final tile size fields in write_tiles_in_tg_obus().
+  assert(cm->large_scale_tile);
 
-  if (cm->large_scale_tile) {
-    // The top bit in the tile size field indicates tile copy mode, so we
-    // have 1 less bit to code the tile size
-    tsb = choose_size_bytes(max_tile_size, 1);
-    tcsb = choose_size_bytes(max_tile_col_size, 0);
-  } else {
-    tsb = choose_size_bytes(max_tile_size, 0);
-    tcsb = 4;  // This is ignored
-    (void)max_tile_col_size;
-  }
+  // Choose the tile size bytes (tsb) and tile column size bytes (tcsb).
+  // The top bit in the tile size field indicates tile copy mode, so we
+  // have 1 less bit to code the tile size
+  const int tsb = choose_size_bytes(max_tile_size, 1);
+  const int tcsb = choose_size_bytes(max_tile_col_size, 0);
 
   assert(tsb > 0);
   assert(tcsb > 0);
@@ -4065,72 +4079,44 @@ static int remux_tiles(const AV1_COMMON *const cm, uint8_t *dst,
   uint32_t wpos = 0;
   uint32_t rpos = 0;
 
-  if (cm->large_scale_tile) {
-    int tile_row;
-    int tile_col;
-
-    for (tile_col = 0; tile_col < cm->tile_cols; tile_col++) {
-      // All but the last column has a column header
-      if (tile_col < cm->tile_cols - 1) {
-        uint32_t tile_col_size = mem_get_le32(dst + rpos);
-        rpos += 4;
-
-        // Adjust the tile column size by the number of bytes removed
-        // from the tile size fields.
-        tile_col_size -= (4 - tsb) * cm->tile_rows;
+  int tile_row;
+  int tile_col;
 
-        mem_put_varsize(dst + wpos, tcsb, tile_col_size);
-        wpos += tcsb;
-      }
+  for (tile_col = 0; tile_col < cm->tile_cols; tile_col++) {
+    // All but the last column has a column header
+    if (tile_col < cm->tile_cols - 1) {
+      uint32_t tile_col_size = mem_get_le32(dst + rpos);
+      rpos += 4;
 
-      for (tile_row = 0; tile_row < cm->tile_rows; tile_row++) {
-        // All, including the last row has a header
-        uint32_t tile_header = mem_get_le32(dst + rpos);
-        rpos += 4;
-
-        // If this is a copy tile, we need to shift the MSB to the
-        // top bit of the new width, and there is no data to copy.
-        if (tile_header >> 31 != 0) {
-          if (tsb < 4) tile_header >>= 32 - 8 * tsb;
-          mem_put_varsize(dst + wpos, tsb, tile_header);
-          wpos += tsb;
-        } else {
-          mem_put_varsize(dst + wpos, tsb, tile_header);
-          wpos += tsb;
+      // Adjust the tile column size by the number of bytes removed
+      // from the tile size fields.
+      tile_col_size -= (4 - tsb) * cm->tile_rows;
 
-          tile_header += AV1_MIN_TILE_SIZE_BYTES;
-          memmove(dst + wpos, dst + rpos, tile_header);
-          rpos += tile_header;
-          wpos += tile_header;
-        }
-      }
+      mem_put_varsize(dst + wpos, tcsb, tile_col_size);
+      wpos += tcsb;
     }
 
-    assert(rpos > wpos);
-    assert(rpos == data_size);
-
-    return wpos;
-  }
-  const int n_tiles = cm->tile_cols * cm->tile_rows;
-  int n;
-
-  for (n = 0; n < n_tiles; n++) {
-    int tile_size;
-
-    if (n == n_tiles - 1) {
-      tile_size = data_size - rpos;
-    } else {
-      tile_size = mem_get_le32(dst + rpos);
+    for (tile_row = 0; tile_row < cm->tile_rows; tile_row++) {
+      // All, including the last row has a header
+      uint32_t tile_header = mem_get_le32(dst + rpos);
       rpos += 4;
-      mem_put_varsize(dst + wpos, tsb, tile_size);
-      tile_size += AV1_MIN_TILE_SIZE_BYTES;
-      wpos += tsb;
-    }
 
-    memmove(dst + wpos, dst + rpos, tile_size);
+      // If this is a copy tile, we need to shift the MSB to the
+      // top bit of the new width, and there is no data to copy.
+      if (tile_header >> 31 != 0) {
+        if (tsb < 4) tile_header >>= 32 - 8 * tsb;
+        mem_put_varsize(dst + wpos, tsb, tile_header);
+        wpos += tsb;
+      } else {
+        mem_put_varsize(dst + wpos, tsb, tile_header);
+        wpos += tsb;
 
-    rpos += tile_size;
-    wpos += tile_size;
+        tile_header += AV1_MIN_TILE_SIZE_BYTES;
+        memmove(dst + wpos, dst + rpos, tile_header);
+        rpos += tile_header;
+        wpos += tile_header;
+      }
+    }
   }
 
   assert(rpos > wpos);
@@ -4306,6 +4292,133 @@ typedef struct {
   size_t total_length;
 } FrameHeaderInfo;
 
+// Returns the size of the bitstream buffer of a tile. Like the output buffer
+// of a whole frame in av1_cx_iface.c, it is far larger than the tile will
+// ever take.
+static size_t get_tile_pack_buf_size(const AV1_COMMON *const cm,
+                                     const TileInfo *const tile_info) {
+  const SequenceHeader *const seq_params = &cm->seq_params;
+  const int width = (tile_info->mi_col_end - tile_info->mi_col_start)
+                    << MI_SIZE_LOG2;
+  const int height = (tile_info->mi_row_end - tile_info->mi_row_start)
+                     << MI_SIZE_LOG2;
+  const int chroma_bps =
+      seq_params->monochrome
+          ? 0
+          : 16 >> (seq_params->subsampling_x + seq_params->subsampling_y);
+  const int bps = (8 + chroma_bps) << seq_params->use_highbitdepth;
+  return (size_t)ALIGN_POWER_OF_TWO(width, 5) * ALIGN_POWER_OF_TWO(height, 5) *
+         bps;
+}
+
+static void alloc_tile_pack_bufs(AV1_COMP *const cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  const int n_tiles = cm->tile_rows * cm->tile_cols;
+  size_t total_size = 0;
+  TileInfo tile_info;
+
+  for (int t = 0; t < n_tiles; ++t) {
+    av1_tile_init(&tile_info, cm, t / cm->tile_cols, t % cm->tile_cols);
+    total_size += get_tile_pack_buf_size(cm, &tile_info);
+  }
+  if (total_size > cpi->tile_pack_buf_size) {
+    aom_free(cpi->tile_pack_buf);
+    cpi->tile_pack_buf_size = 0;
+    CHECK_MEM_ERROR(cm, cpi->tile_pack_buf, (uint8_t *)aom_malloc(total_size));
+    cpi->tile_pack_buf_size = total_size;
+  }
+
+  uint8_t *buf = cpi->tile_pack_buf;
+  for (int t = 0; t < n_tiles; ++t) {
+    av1_tile_init(&tile_info, cm, t / cm->tile_cols, t % cm->tile_cols);
+    cpi->tile_data[t].pack_buf = buf;
+    buf += get_tile_pack_buf_size(cm, &tile_info);
+  }
+}
+
+void av1_pack_tile(AV1_COMP *const cpi, ThreadData *const td, int tile_row,
+                   int tile_col) {
+  const AV1_COMMON *const cm = &cpi->common;
+  TileDataEnc *const this_tile =
+      &cpi->tile_data[tile_row * cm->tile_cols + tile_col];
+  TileInfo tile_info;
+  aom_writer mode_bc;
+
+  av1_tile_init(&tile_info, cm, tile_row, tile_col);
+  td->mb.e_mbd.tile_ctx = &this_tile->tctx;
+  mode_bc.allow_update_cdf = !cm->disable_cdf_update;
+  av1_reset_loop_restoration(&td->mb.e_mbd, av1_num_planes(cm));
+
+  aom_start_encode(&mode_bc, this_tile->pack_buf);
+  write_modes(cpi, td, &tile_info, &mode_bc, tile_row, tile_col);
+  aom_stop_encode(&mode_bc);
+  this_tile->pack_size = mode_bc.pos;
+  assert(this_tile->pack_size >= AV1_MIN_TILE_SIZE_BYTES);
+}
+
+static void reset_pack_stats(ThreadData *const td) {
+  td->max_mv_magnitude = 0;
+  av1_zero(td->interp_filter_selected);
+}
+
+static void merge_pack_stats(AV1_COMP *const cpi, const ThreadData *const td) {
+  AV1_COMMON *const cm = &cpi->common;
+  cpi->max_mv_magnitude = AOMMAX(cpi->max_mv_magnitude, td->max_mv_magnitude);
+  for (int i = 0; i < SWITCHABLE; ++i)
+    cm->cur_frame->interp_filter_selected[i] += td->interp_filter_selected[i];
+}
+
+// Packs every tile into its own buffer, in parallel on the encoder workers
+// when there are any.
+static void pack_tiles(AV1_COMP *const cpi) {
+  const AV1_COMMON *const cm = &cpi->common;
+  const int n_tiles = cm->tile_rows * cm->tile_cols;
+#if CONFIG_BITSTREAM_DEBUG || CONFIG_ENTROPY_STATS
+  // The symbol queue and the entropy counts need the tiles in order.
+  const int num_workers = 1;
+#else
+  const int num_workers = AOMMIN(cpi->num_workers, n_tiles);
+#endif  // CONFIG_BITSTREAM_DEBUG || CONFIG_ENTROPY_STATS
+
+  alloc_tile_pack_bufs(cpi);
+  if (num_workers > 1) {
+    for (int i = 0; i < num_workers; ++i)
+      reset_pack_stats(cpi->tile_thr_data[i].td);
+    av1_pack_tiles_mt(cpi, num_workers);
+    for (int i = 0; i < num_workers; ++i)
+      merge_pack_stats(cpi, cpi->tile_thr_data[i].td);
+  } else {
+    reset_pack_stats(&cpi->td);
+    for (int t = 0; t < n_tiles; ++t)
+      av1_pack_tile(cpi, &cpi->td, t / cm->tile_cols, t % cm->tile_cols);
+    merge_pack_stats(cpi, &cpi->td);
+  }
+}
+
+// Writes the OBU header of the tile group of tiles [start_tile, end_tile],
+// followed by the frame header for a frame with a single tile group, and the
+// tile group header. The OBU size field is left for the caller to insert
+// after the first 'obu_header_size' bytes.
+static uint32_t write_tg_obu_headers(AV1_COMP *const cpi,
+                                     struct aom_write_bit_buffer *saved_wb,
+                                     uint8_t *const dst,
+                                     uint8_t obu_extension_header,
+                                     int start_tile, int end_tile,
+                                     uint32_t *const obu_header_size) {
+  const AV1_COMMON *const cm = &cpi->common;
+  const OBU_TYPE obu_type = (cm->num_tg == 1) ? OBU_FRAME : OBU_TILE_GROUP;
+  uint32_t size =
+      av1_write_obu_header(cpi, obu_type, obu_extension_header, dst);
+  *obu_header_size = size;
+
+  if (cm->num_tg == 1)
+    size += write_frame_header_obu(cpi, saved_wb, dst + size, 0);
+  size += write_tile_group_header(dst + size, start_tile, end_tile,
+                                  cm->log2_tile_rows + cm->log2_tile_cols,
+                                  cm->num_tg > 1);
+  return size;
+}
+
 static uint32_t write_tiles_in_tg_obus(AV1_COMP *const cpi, uint8_t *const dst,
                                        struct aom_write_bit_buffer *saved_wb,
                                        uint8_t obu_extension_header,
@@ -4322,19 +4435,14 @@ static uint32_t write_tiles_in_tg_obus(AV1_COMP *const cpi, uint8_t *const dst,
   unsigned int tile_size = 0;
   unsigned int max_tile_size = 0;
   unsigned int max_tile_col_size = 0;
-  const int n_log2_tiles = cm->log2_tile_rows + cm->log2_tile_cols;
   // Fixed size tile groups for the moment
   const int num_tg_hdrs = cm->num_tg;
   const int tg_size =
       (cm->large_scale_tile)
           ? 1
           : (tile_rows * tile_cols + num_tg_hdrs - 1) / num_tg_hdrs;
-  int tile_count = 0;
-  int curr_tg_data_size = 0;
   uint8_t *data = dst;
-  int new_tg = 1;
   const int have_tiles = tile_cols * tile_rows > 1;
-  int first_tg = 1;
 
   *largest_tile_id = 0;
 
@@ -4367,6 +4475,8 @@ static uint32_t write_tiles_in_tg_obus(AV1_COMP *const cpi, uint8_t *const dst,
     int tile_size_bytes = 0;
     int tile_col_size_bytes = 0;
 
+    reset_pack_stats(&cpi->td);
+
     for (tile_col = 0; tile_col < tile_cols; tile_col++) {
       TileInfo tile_info;
       const int is_last_col = (tile_col == tile_cols - 1);
@@ -4394,7 +4504,7 @@ static uint32_t write_tiles_in_tg_obus(AV1_COMP *const cpi, uint8_t *const dst,
         mode_bc.allow_update_cdf =
             mode_bc.allow_update_cdf && !cm->disable_cdf_update;
         aom_start_encode(&mode_bc, buf->data + data_offset);
-        write_modes(cpi, &tile_info, &mode_bc, tile_row, tile_col);
+        write_modes(cpi, &cpi->td, &tile_info, &mode_bc, tile_row, tile_col);
         aom_stop_encode(&mode_bc);
         tile_size = mode_bc.pos;
         buf->size = tile_size;
@@ -4445,6 +4555,8 @@ static uint32_t write_tiles_in_tg_obus(AV1_COMP *const cpi, uint8_t *const dst,
       }
     }
 
+    merge_pack_stats(cpi, &cpi->td);
+
     if (have_tiles) {
       total_size = remux_tiles(cm, data, total_size - frame_header_size,
                                max_tile_size, max_tile_col_size,
@@ -4477,125 +4589,85 @@ static uint32_t write_tiles_in_tg_obus(AV1_COMP *const cpi, uint8_t *const dst,
     return total_size;
   }
 
-  uint32_t obu_header_size = 0;
-  uint8_t *tile_data_start = dst + total_size;
-  for (tile_row = 0; tile_row < tile_rows; tile_row++) {
-    TileInfo tile_info;
-    av1_tile_set_row(&tile_info, cm, tile_row);
+  const int n_tiles = tile_rows * tile_cols;
+  uint32_t obu_header_size;
+  // The frame header goes before the first tile group, so write it before
+  // packing the tiles, as the tiles are written in bitstream order.
+  uint32_t tg_hdr_size =
+      write_tg_obu_headers(cpi, saved_wb, data, obu_extension_header, 0,
+                           AOMMIN(tg_size, n_tiles) - 1, &obu_header_size);
+  pack_tiles(cpi);
+
+  for (int t = 0; t < n_tiles; t++) {
+    // Record the maximum tile size to choose the size of the tile size fields.
+    if (cpi->tile_data[t].pack_size > max_tile_size) {
+      max_tile_size = cpi->tile_data[t].pack_size;
+      *largest_tile_id = t;
+    }
+  }
+  // With more than one tile group, tile_size_bytes takes the default value 4.
+  const int tile_size_bytes =
+      num_tg_hdrs == 1 ? choose_size_bytes(max_tile_size, 0) : 4;
+  assert(tile_size_bytes >= 1 && tile_size_bytes <= 4);
 
-    for (tile_col = 0; tile_col < tile_cols; tile_col++) {
-      const int tile_idx = tile_row * tile_cols + tile_col;
-      TileBufferEnc *const buf = &tile_buffers[tile_row][tile_col];
-      TileDataEnc *this_tile = &cpi->tile_data[tile_idx];
-      int is_last_tile_in_tg = 0;
-
-      if (new_tg) {
-        data = dst + total_size;
-
-        // A new tile group begins at this tile.  Write the obu header and
-        // tile group header
-        const OBU_TYPE obu_type =
-            (num_tg_hdrs == 1) ? OBU_FRAME : OBU_TILE_GROUP;
-        curr_tg_data_size =
-            av1_write_obu_header(cpi, obu_type, obu_extension_header, data);
-        obu_header_size = curr_tg_data_size;
-
-        if (num_tg_hdrs == 1) {
-          curr_tg_data_size += write_frame_header_obu(
-              cpi, saved_wb, data + curr_tg_data_size, 0);
-        }
-        curr_tg_data_size += write_tile_group_header(
-            data + curr_tg_data_size, tile_idx,
-            AOMMIN(tile_idx + tg_size - 1, tile_cols * tile_rows - 1),
-            n_log2_tiles, cm->num_tg > 1);
-        total_size += curr_tg_data_size;
-        tile_data_start += curr_tg_data_size;
-        new_tg = 0;
-        tile_count = 0;
-      }
-      tile_count++;
-      av1_tile_set_col(&tile_info, cm, tile_col);
+  for (int tg_start = 0; tg_start < n_tiles; tg_start += tg_size) {
+    const int tg_end = AOMMIN(tg_start + tg_size, n_tiles) - 1;
 
-      if (tile_count == tg_size || tile_idx == (tile_cols * tile_rows - 1)) {
-        is_last_tile_in_tg = 1;
-        new_tg = 1;
-      } else {
-        is_last_tile_in_tg = 0;
-      }
+    if (tg_start > 0) {
+      if (cm->error_resilient_mode) {
+        // Insert a copy of the Frame Header OBU.
+        memcpy(data, fh_info->frame_header, fh_info->total_length);
 
-      buf->data = dst + total_size;
-
-      // The last tile of the tile group does not have a header.
-      if (!is_last_tile_in_tg) total_size += 4;
-
-      cpi->td.mb.e_mbd.tile_ctx = &this_tile->tctx;
-      mode_bc.allow_update_cdf = 1;
-      mode_bc.allow_update_cdf =
-          mode_bc.allow_update_cdf && !cm->disable_cdf_update;
-      const int num_planes = av1_num_planes(cm);
-      av1_reset_loop_restoration(&cpi->td.mb.e_mbd, num_planes);
-
-      aom_start_encode(&mode_bc, dst + total_size);
-      write_modes(cpi, &tile_info, &mode_bc, tile_row, tile_col);
-      aom_stop_encode(&mode_bc);
-      tile_size = mode_bc.pos;
-      assert(tile_size >= AV1_MIN_TILE_SIZE_BYTES);
-
-      curr_tg_data_size += (tile_size + (is_last_tile_in_tg ? 0 : 4));
-      buf->size = tile_size;
-      if (tile_size > max_tile_size) {
-        *largest_tile_id = tile_cols * tile_row + tile_col;
-        max_tile_size = tile_size;
-      }
+        // Force context update tile to be the first tile in error
+        // resiliant mode as the duplicate frame headers will have
+        // context_update_tile_id set to 0
+        *largest_tile_id = 0;
 
-      if (!is_last_tile_in_tg) {
-        // size of this tile
-        mem_put_le32(buf->data, tile_size - AV1_MIN_TILE_SIZE_BYTES);
-      } else {
-        // write current tile group size
-        const uint32_t obu_payload_size = curr_tg_data_size - obu_header_size;
-        const size_t length_field_size =
-            obu_memmove(obu_header_size, obu_payload_size, data);
-        if (av1_write_uleb_obu_size(obu_header_size, obu_payload_size, data) !=
-            AOM_CODEC_OK) {
-          assert(0);
-        }
-        curr_tg_data_size += (int)length_field_size;
-        total_size += (uint32_t)length_field_size;
-        tile_data_start += length_field_size;
-        if (num_tg_hdrs == 1) {
-          // if this tg is combined with the frame header then update saved
-          // frame header base offset accroding to length field size
-          saved_wb->bit_buffer += length_field_size;
-        }
+        // Rewrite the OBU header to change the OBU type to Redundant Frame
+        // Header.
+        av1_write_obu_header(cpi, OBU_REDUNDANT_FRAME_HEADER,
+                             obu_extension_header,
+                             &data[fh_info->obu_header_byte_offset]);
 
-        if (!first_tg && cm->error_resilient_mode) {
-          // Make room for a duplicate Frame Header OBU.
-          memmove(data + fh_info->total_length, data, curr_tg_data_size);
-
-          // Insert a copy of the Frame Header OBU.
-          memcpy(data, fh_info->frame_header, fh_info->total_length);
-
-          // Force context update tile to be the first tile in error
-          // resiliant mode as the duplicate frame headers will have
-          // context_update_tile_id set to 0
-          *largest_tile_id = 0;
+        data += fh_info->total_length;
+      }
+      tg_hdr_size =
+          write_tg_obu_headers(cpi, saved_wb, data, obu_extension_header,
+                               tg_start, tg_end, &obu_header_size);
+    }
 
-          // Rewrite the OBU header to change the OBU type to Redundant Frame
-          // Header.
-          av1_write_obu_header(cpi, OBU_REDUNDANT_FRAME_HEADER,
-                               obu_extension_header,
-                               &data[fh_info->obu_header_byte_offset]);
+    // The last tile of the tile group does not have a size field.
+    uint32_t obu_payload_size = tg_hdr_size - obu_header_size;
+    for (int t = tg_start; t <= tg_end; t++) {
+      obu_payload_size += cpi->tile_data[t].pack_size;
+      if (t < tg_end) obu_payload_size += tile_size_bytes;
+    }
 
-          data += fh_info->total_length;
+    // Only the headers have to move to make room for the OBU size field.
+    const size_t length_field_size = aom_uleb_size_in_bytes(obu_payload_size);
+    memmove(data + obu_header_size + length_field_size, data + obu_header_size,
+            tg_hdr_size - obu_header_size);
+    if (av1_write_uleb_obu_size(obu_header_size, obu_payload_size, data) !=
+        AOM_CODEC_OK) {
+      assert(0);
+    }
+    if (num_tg_hdrs == 1) {
+      // if this tg is combined with the frame header then update saved
+      // frame header base offset accroding to length field size
+      saved_wb->bit_buffer += length_field_size;
+    }
+    data += tg_hdr_size + length_field_size;
 
-          curr_tg_data_size += (int)(fh_info->total_length);
-          total_size += (uint32_t)(fh_info->total_length);
-        }
-        first_tg = 0;
+    for (int t = tg_start; t <= tg_end; t++) {
+      const TileDataEnc *const this_tile = &cpi->tile_data[t];
+      if (t < tg_end) {
+        // size of this tile
+        mem_put_varsize(data, tile_size_bytes,
+                        this_tile->pack_size - AV1_MIN_TILE_SIZE_BYTES);
+        data += tile_size_bytes;
       }
-
-      total_size += tile_size;
+      memcpy(data, this_tile->pack_buf, this_tile->pack_size);
+      data += this_tile->pack_size;
     }
   }
 
@@ -4605,48 +4677,11 @@ static uint32_t write_tiles_in_tg_obus(AV1_COMP *const cpi, uint8_t *const dst,
     // (but is up to the encoder)
     aom_wb_overwrite_literal(saved_wb, *largest_tile_id,
                              cm->log2_tile_cols + cm->log2_tile_rows);
-    // If more than one tile group. tile_size_bytes takes the default value 4
-    // and does not need to be set. For a single tile group it is set in the
-    // section below.
-    if (num_tg_hdrs == 1) {
-      int tile_size_bytes = 4, unused;
-      const uint32_t tile_data_offset = (uint32_t)(tile_data_start - dst);
-      const uint32_t tile_data_size = total_size - tile_data_offset;
-
-      total_size =
-          remux_tiles(cm, tile_data_start, tile_data_size, max_tile_size,
-                      max_tile_col_size, &tile_size_bytes, &unused);
-      total_size += tile_data_offset;
-      assert(tile_size_bytes >= 1 && tile_size_bytes <= 4);
-
+    // For a single tile group, tile_size_bytes is coded in the frame header.
+    if (num_tg_hdrs == 1)
       aom_wb_overwrite_literal(saved_wb, tile_size_bytes - 1, 2);
-
-      // Update the OBU length if remux_tiles() reduced the size.
-      uint64_t payload_size;
-      size_t length_field_size;
-      int res =
-          aom_uleb_decode(dst + obu_header_size, total_size - obu_header_size,
-                          &payload_size, &length_field_size);
-      assert(res == 0);
-      (void)res;
-
-      const uint64_t new_payload_size =
-          total_size - obu_header_size - length_field_size;
-      if (new_payload_size != payload_size) {
-        size_t new_length_field_size;
-        res = aom_uleb_encode(new_payload_size, length_field_size,
-                              dst + obu_header_size, &new_length_field_size);
-        assert(res == 0);
-        if (new_length_field_size < length_field_size) {
-          const size_t src_offset = obu_header_size + length_field_size;
-          const size_t dst_offset = obu_header_size + new_length_field_size;
-          memmove(dst + dst_offset, dst + src_offset, (size_t)payload_size);
-          total_size -= (int)(length_field_size - new_length_field_size);
-        }
-      }
-    }
   }
-  return total_size;
+  return (uint32_t)(data - dst);
 }
 
 int av1_pack_bitstream(AV1_COMP *const cpi, uint8_t *dst, size_t *size,
@@ -36,6 +36,12 @@ int av1_write_uleb_obu_size(uint32_t obu_header_size, uint32_t obu_payload_size,
 int av1_pack_bitstream(AV1_COMP *const cpi, uint8_t *dst, size_t *size,
                        int *const largest_tile_id);
 
+// Packs the modes and coefficients of a tile into the pack_buf of its
+// TileDataEnc, using the thread data 'td'. Tiles can be packed concurrently
+// with different thread data.
+void av1_pack_tile(AV1_COMP *const cpi, ThreadData *const td, int tile_row,
+                   int tile_col);
+
 void av1_write_tx_type(const AV1_COMMON *const cm, const MACROBLOCKD *xd,
                        int blk_row, int blk_col, int plane, TX_SIZE tx_size,
                        aom_writer *w);
@@ -188,8 +188,15 @@ typedef struct {
   COMPOUND_TYPE comp_type;
   int64_t rd;
   unsigned int pred_sse;
+  // Slot in interp_pred_bufs holding the predictor built with 'filters', or -1.
+  int8_t pred_slot;
+  int8_t is_global[2];
 } INTERPOLATION_FILTER_STATS;
 
+// Number of predictors kept alongside the interpolation filter stats. Each
+// slot holds all planes of one block at up to 16 bits per pixel.
+#define MAX_INTERP_PRED_SLOTS 4
+
 #define MAX_COMP_RD_STATS 64
 typedef struct {
   int32_t rate[COMPOUND_TYPES];
@@ -327,6 +334,12 @@ struct macroblock {
   // [comp_idx][saved stat_idx]
   INTERPOLATION_FILTER_STATS interp_filter_stats[2][MAX_INTERP_FILTER_STATS];
   int interp_filter_stats_idx[2];
+  // Predictors of the most recent interpolation filter searches, so that a
+  // repeated (ref_frame, mv) pair reuses the prediction instead of rebuilding
+  // it. interp_pred_owner[] is comp_idx * MAX_INTERP_FILTER_STATS + stats idx.
+  uint8_t *interp_pred_bufs;
+  int interp_pred_owner[MAX_INTERP_PRED_SLOTS];
+  int interp_pred_next_slot;
 
 #if CONFIG_NEW_INTER_MODES
   // prune_comp_search_by_single_result (MAX_REF_MV_SEARCH = MAX_DRL_BITS + 1)
@@ -339,7 +352,10 @@ struct macroblock {
   MB_RD_RECORD mb_rd_record;
 
 #if CONFIG_EXT_IBC_MODES
+  // Source block in the IBC+ orientation currently being searched. Points into
+  // ibc_src_buf, which holds one MAX_SB_SQUARE plane per orientation.
   uint16_t *ibc_src;
+  uint16_t *ibc_src_buf;
 #endif  // CONFIG_EXT_IBC_MODES
 
   // Inter transform block RD search info. for square TX sizes.
@@ -411,6 +427,13 @@ struct macroblock {
 
   CONV_BUF_TYPE *tmp_conv_dst;
   uint8_t *tmp_obmc_bufs[2];
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+  struct Av1SegmentScratch *seg_scratch;
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
+#if CONFIG_HTB_TRELLIS
+  // Hash trellis cache of the thread this macroblock is encoded on.
+  struct HbtCache *hbt_cache;
+#endif  // CONFIG_HTB_TRELLIS
 
   FRAME_CONTEXT *row_ctx;
   // This context will be used to update color_map_cdf pointer which would be
@@ -521,6 +544,9 @@ struct macroblock {
 #if CONFIG_ADAPT_FILTER_INTRA
   int adapt_filter_intra_cost[BLOCK_SIZES_ALL][2];
   int adapt_filter_intra_mode_cost[USED_ADAPT_FILTER_INTRA_MODES];
+  // Solved adaptive filter intra coefficients, reused while the same block is
+  // being searched.
+  ADAPT_FILTER_INTRA_CACHE adapt_filter_intra_cache;
 #endif  // CONFIG_ADAPT_FILTER_INTRA
   int switchable_interp_costs[SWITCHABLE_FILTER_CONTEXTS][SWITCHABLE_FILTERS];
 #if CONFIG_FLEX_MVRES
@@ -9,6 +9,8 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include "aom_ports/bitops.h"
+#include "aom_ports/mem.h"
 #include "av1/encoder/context_tree.h"
 #include "av1/encoder/encoder.h"
 #include "av1/encoder/rd.h"
@@ -67,6 +69,60 @@ void av1_free_shared_coeff_buffer(PC_TREE_SHARED_BUFFERS *shared_bufs) {
     shared_bufs->qcoeff_buf[i] = NULL;
     shared_bufs->dqcoeff_buf[i] = NULL;
   }
+  PC_TREE_ARENA_CHUNK *chunk = shared_bufs->arena.chunks;
+  while (chunk != NULL) {
+    PC_TREE_ARENA_CHUNK *const next = chunk->next;
+    aom_free(chunk);
+    chunk = next;
+  }
+  av1_zero(shared_bufs->arena);
+}
+
+// Arena objects, and the buffers inside PICK_MODE_CONTEXTs, are 32-byte
+// aligned like the aom_memalign() allocations they replace.
+#define ARENA_ALIGN(size) ALIGN_POWER_OF_TWO((size_t)(size), 5)
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(PC_TREE_ARENA_CHUNK))
+#define PC_TREE_NODE_CLASS PC_TREE_ARENA_PMC_CLASSES
+
+void av1_reset_pc_tree_arena(PC_TREE_SHARED_BUFFERS *shared_bufs) {
+  PC_TREE_ARENA *const arena = &shared_bufs->arena;
+  arena->cur = arena->chunks;
+  arena->used = ARENA_HEADER_SIZE;
+  av1_zero(arena->free_list);
+}
+
+static void *arena_alloc(PC_TREE_ARENA *arena, int size_class, size_t size) {
+  void *obj = arena->free_list[size_class];
+  if (obj != NULL) {
+    arena->free_list[size_class] = *(void **)obj;
+    return obj;
+  }
+
+  size = ARENA_ALIGN(size);
+  assert(size <= PC_TREE_ARENA_CHUNK_SIZE - ARENA_HEADER_SIZE);
+  if (arena->cur == NULL || arena->used + size > PC_TREE_ARENA_CHUNK_SIZE) {
+    PC_TREE_ARENA_CHUNK *next = arena->cur ? arena->cur->next : arena->chunks;
+    if (next == NULL) {
+      struct aom_internal_error_info error;
+      AOM_CHECK_MEM_ERROR(&error, next,
+                          aom_memalign(32, PC_TREE_ARENA_CHUNK_SIZE));
+      next->next = NULL;
+      if (arena->cur)
+        arena->cur->next = next;
+      else
+        arena->chunks = next;
+    }
+    arena->cur = next;
+    arena->used = ARENA_HEADER_SIZE;
+  }
+  obj = (uint8_t *)arena->cur + arena->used;
+  arena->used += size;
+  return obj;
+}
+
+static void arena_free(PC_TREE_ARENA *arena, int size_class, void *obj) {
+  *(void **)obj = arena->free_list[size_class];
+  arena->free_list[size_class] = obj;
 }
 
 PICK_MODE_CONTEXT *av1_alloc_pmc(const AV1_COMMON *cm, int mi_row, int mi_col,
@@ -74,10 +130,31 @@ PICK_MODE_CONTEXT *av1_alloc_pmc(const AV1_COMMON *cm, int mi_row, int mi_col,
                                  PARTITION_TYPE parent_partition, int index,
                                  int subsampling_x, int subsampling_y,
                                  PC_TREE_SHARED_BUFFERS *shared_bufs) {
-  PICK_MODE_CONTEXT *ctx = NULL;
-  struct aom_internal_error_info error;
-
-  AOM_CHECK_MEM_ERROR(&error, ctx, aom_calloc(1, sizeof(*ctx)));
+  const int num_planes = av1_num_planes(cm);
+  const int num_pix = block_size_wide[bsize] * block_size_high[bsize];
+  const int num_blk = num_pix / 16;
+  const int has_palette = num_pix <= MAX_PALETTE_SQUARE;
+
+  // The context and all of its per-block buffers share one arena object, so
+  // blocks with the same area reuse each other's storage. The layout always
+  // has room for MAX_MB_PLANE planes.
+  const size_t ctx_size = ARENA_ALIGN(sizeof(PICK_MODE_CONTEXT));
+  const size_t blk_skip_size = ARENA_ALIGN(num_blk * sizeof(uint8_t));
+  const size_t eobs_size = ARENA_ALIGN(num_blk * sizeof(uint16_t));
+  const size_t entropy_ctx_size = ARENA_ALIGN(num_blk * sizeof(uint8_t));
+  const size_t color_map_size =
+      has_palette ? ARENA_ALIGN(num_pix * sizeof(uint8_t)) : 0;
+  const size_t total_size =
+      ctx_size + blk_skip_size +
+      MAX_MB_PLANE * (eobs_size + entropy_ctx_size) + 2 * color_map_size;
+
+  PC_TREE_ARENA *const arena = &shared_bufs->arena;
+  uint8_t *buf = arena_alloc(arena, get_msb(num_blk), total_size);
+  PICK_MODE_CONTEXT *const ctx = (PICK_MODE_CONTEXT *)buf;
+  memset(ctx, 0, sizeof(*ctx));
+  buf += ctx_size;
+
+  ctx->arena = arena;
   ctx->parent = parent;
   ctx->index = index;
 #if CONFIG_DSPL_RESIDUAL
@@ -90,29 +167,25 @@ PICK_MODE_CONTEXT *av1_alloc_pmc(const AV1_COMMON *cm, int mi_row, int mi_col,
                       parent_partition, subsampling_x, subsampling_y);
   ctx->mic.chroma_ref_info = ctx->chroma_ref_info;
 
-  const int num_planes = av1_num_planes(cm);
-  const int num_pix = block_size_wide[bsize] * block_size_high[bsize];
-  const int num_blk = num_pix / 16;
-
   ctx->num_4x4_blk = num_blk;
-  AOM_CHECK_MEM_ERROR(&error, ctx->blk_skip,
-                      aom_calloc(num_blk, sizeof(uint8_t)));
+  ctx->blk_skip = buf;
+  memset(ctx->blk_skip, 0, num_blk * sizeof(uint8_t));
+  buf += blk_skip_size;
   for (int i = 0; i < num_planes; ++i) {
     ctx->coeff[i] = shared_bufs->coeff_buf[i];
     ctx->qcoeff[i] = shared_bufs->qcoeff_buf[i];
     ctx->dqcoeff[i] = shared_bufs->dqcoeff_buf[i];
-    AOM_CHECK_MEM_ERROR(&error, ctx->eobs[i],
-                        aom_memalign(32, num_blk * sizeof(*ctx->eobs[i])));
-    AOM_CHECK_MEM_ERROR(
-        &error, ctx->txb_entropy_ctx[i],
-        aom_memalign(32, num_blk * sizeof(*ctx->txb_entropy_ctx[i])));
+    ctx->eobs[i] = (uint16_t *)buf;
+    buf += eobs_size;
+    ctx->txb_entropy_ctx[i] = buf;
+    buf += entropy_ctx_size;
   }
+  buf += (MAX_MB_PLANE - num_planes) * (eobs_size + entropy_ctx_size);
 
-  if (num_pix <= MAX_PALETTE_SQUARE) {
+  if (has_palette) {
     for (int i = 0; i < 2; ++i) {
-      AOM_CHECK_MEM_ERROR(
-          &error, ctx->color_index_map[i],
-          aom_memalign(32, num_pix * sizeof(*ctx->color_index_map[i])));
+      ctx->color_index_map[i] = buf;
+      buf += color_map_size;
     }
   }
 
@@ -122,38 +195,24 @@ PICK_MODE_CONTEXT *av1_alloc_pmc(const AV1_COMMON *cm, int mi_row, int mi_col,
 }
 
 void av1_free_pmc(PICK_MODE_CONTEXT *ctx, int num_planes) {
+  (void)num_planes;
   if (ctx == NULL) return;
 
-  aom_free(ctx->blk_skip);
-  ctx->blk_skip = NULL;
-  for (int i = 0; i < num_planes; ++i) {
-    ctx->coeff[i] = NULL;
-    ctx->qcoeff[i] = NULL;
-    ctx->dqcoeff[i] = NULL;
-    aom_free(ctx->eobs[i]);
-    ctx->eobs[i] = NULL;
-    aom_free(ctx->txb_entropy_ctx[i]);
-    ctx->txb_entropy_ctx[i] = NULL;
-  }
-
-  for (int i = 0; i < 2; ++i) {
-    aom_free(ctx->color_index_map[i]);
-    ctx->color_index_map[i] = NULL;
-  }
-
-  aom_free(ctx);
+  arena_free(ctx->arena, get_msb(ctx->num_4x4_blk), ctx);
 }
 
 PC_TREE *av1_alloc_pc_tree_node(int mi_row, int mi_col, BLOCK_SIZE bsize,
                                 PC_TREE *parent,
                                 PARTITION_TYPE parent_partition, int index,
                                 int is_last, int subsampling_x,
-                                int subsampling_y) {
-  PC_TREE *pc_tree = NULL;
-  struct aom_internal_error_info error;
-
-  AOM_CHECK_MEM_ERROR(&error, pc_tree, aom_calloc(1, sizeof(*pc_tree)));
-
+                                int subsampling_y,
+                                PC_TREE_SHARED_BUFFERS *shared_bufs) {
+  PC_TREE_ARENA *const arena = &shared_bufs->arena;
+  PC_TREE *const pc_tree =
+      arena_alloc(arena, PC_TREE_NODE_CLASS, sizeof(*pc_tree));
+  memset(pc_tree, 0, sizeof(*pc_tree));
+
+  pc_tree->arena = arena;
   pc_tree->mi_row = mi_row;
   pc_tree->mi_col = mi_col;
   pc_tree->parent = parent;
@@ -272,7 +331,8 @@ void av1_free_pc_tree_recursive(PC_TREE *pc_tree, int num_planes, int keep_best,
     }
   }
 
-  if (!keep_best && !keep_none) aom_free(pc_tree);
+  if (!keep_best && !keep_none)
+    arena_free(pc_tree->arena, PC_TREE_NODE_CLASS, pc_tree);
 }
 
 #if CONFIG_EXT_RECUR_PARTITIONS
@@ -313,7 +373,7 @@ void av1_copy_pc_tree_recursive(const AV1_COMMON *cm, PC_TREE *dst,
             const int y_idx = (i >> 1) * (mi_size_high[bsize] >> 1);
             dst->split[i] = av1_alloc_pc_tree_node(
                 mi_row + y_idx, mi_col + x_idx, subsize, dst, PARTITION_SPLIT,
-                i, i == 3, ss_x, ss_y);
+                i, i == 3, ss_x, ss_y, shared_bufs);
             av1_copy_pc_tree_recursive(cm, dst->split[i], src->split[i], ss_x,
                                        ss_y, shared_bufs, num_planes);
           }
@@ -332,7 +392,8 @@ void av1_copy_pc_tree_recursive(const AV1_COMMON *cm, PC_TREE *dst,
             const int this_mi_row = mi_row + i * (mi_size_high[bsize] >> 1);
             dst->horizontal[i] =
                 av1_alloc_pc_tree_node(this_mi_row, mi_col, subsize, dst,
-                                       PARTITION_HORZ, i, i == 1, ss_x, ss_y);
+                                       PARTITION_HORZ, i, i == 1, ss_x, ss_y,
+                                       shared_bufs);
             av1_copy_pc_tree_recursive(cm, dst->horizontal[i],
                                        src->horizontal[i], ss_x, ss_y,
                                        shared_bufs, num_planes);
@@ -352,7 +413,8 @@ void av1_copy_pc_tree_recursive(const AV1_COMMON *cm, PC_TREE *dst,
             const int this_mi_col = mi_col + i * (mi_size_wide[bsize] >> 1);
             dst->vertical[i] =
                 av1_alloc_pc_tree_node(mi_row, this_mi_col, subsize, dst,
-                                       PARTITION_VERT, i, i == 1, ss_x, ss_y);
+                                       PARTITION_VERT, i, i == 1, ss_x, ss_y,
+                                       shared_bufs);
             av1_copy_pc_tree_recursive(cm, dst->vertical[i], src->vertical[i],
                                        ss_x, ss_y, shared_bufs, num_planes);
           }
@@ -376,7 +438,8 @@ void av1_copy_pc_tree_recursive(const AV1_COMMON *cm, PC_TREE *dst,
           if (src->horizontal3[i]) {
             dst->horizontal3[i] =
                 av1_alloc_pc_tree_node(mi_rows[i], mi_col, subsizes[i], dst,
-                                       PARTITION_HORZ_3, i, i == 2, ss_x, ss_y);
+                                       PARTITION_HORZ_3, i, i == 2, ss_x, ss_y,
+                                       shared_bufs);
             av1_copy_pc_tree_recursive(cm, dst->horizontal3[i],
                                        src->horizontal3[i], ss_x, ss_y,
                                        shared_bufs, num_planes);
@@ -401,7 +464,8 @@ void av1_copy_pc_tree_recursive(const AV1_COMMON *cm, PC_TREE *dst,
           if (src->vertical3[i]) {
             dst->vertical3[i] =
                 av1_alloc_pc_tree_node(mi_row, mi_cols[i], subsizes[i], dst,
-                                       PARTITION_VERT_3, i, i == 2, ss_x, ss_y);
+                                       PARTITION_VERT_3, i, i == 2, ss_x, ss_y,
+                                       shared_bufs);
             av1_copy_pc_tree_recursive(cm, dst->vertical3[i], src->vertical3[i],
                                        ss_x, ss_y, shared_bufs, num_planes);
           }
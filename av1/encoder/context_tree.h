@@ -23,10 +23,32 @@ struct AV1_COMP;
 struct AV1Common;
 struct ThreadData;
 
+#define PC_TREE_ARENA_CHUNK_SIZE (256 * 1024)
+// One free list per PICK_MODE_CONTEXT size (log2 of its number of 4x4 blocks)
+// and one for PC_TREE nodes.
+#define PC_TREE_ARENA_PMC_CLASSES (2 * (MAX_SB_SIZE_LOG2 - 2) + 1)
+#define PC_TREE_ARENA_CLASSES (PC_TREE_ARENA_PMC_CLASSES + 1)
+
+typedef struct PC_TREE_ARENA_CHUNK {
+  struct PC_TREE_ARENA_CHUNK *next;
+} PC_TREE_ARENA_CHUNK;
+
+// Allocator for the PC_TREE nodes and PICK_MODE_CONTEXTs of the partition
+// search. Objects are carved from large chunks and recycled through per-size
+// free lists, and av1_reset_pc_tree_arena() releases all of them at once when
+// a new superblock starts. The chunks are kept until the encoder is freed.
+typedef struct PC_TREE_ARENA {
+  PC_TREE_ARENA_CHUNK *chunks;
+  PC_TREE_ARENA_CHUNK *cur;
+  size_t used;  // Bytes in use in cur, including its header.
+  void *free_list[PC_TREE_ARENA_CLASSES];
+} PC_TREE_ARENA;
+
 typedef struct {
   tran_low_t *coeff_buf[MAX_MB_PLANE];
   tran_low_t *qcoeff_buf[MAX_MB_PLANE];
   tran_low_t *dqcoeff_buf[MAX_MB_PLANE];
+  PC_TREE_ARENA arena;
 } PC_TREE_SHARED_BUFFERS;
 
 // Structure to hold snapshot of coding context during the mode picking process
@@ -64,6 +86,7 @@ typedef struct PICK_MODE_CONTEXT {
 
   struct PC_TREE *parent;
   int index;
+  PC_TREE_ARENA *arena;
 } PICK_MODE_CONTEXT;
 
 typedef struct PC_TREE {
@@ -93,6 +116,7 @@ typedef struct PC_TREE {
   int is_last_subblock;
   CHROMA_REF_INFO chroma_ref_info;
   RD_STATS rd_cost;
+  PC_TREE_ARENA *arena;
 } PC_TREE;
 
 typedef struct SIMPLE_MOTION_DATA_TREE {
@@ -115,12 +139,14 @@ PC_TREE *av1_look_for_counterpart_block(PC_TREE *pc_tree);
 void av1_setup_shared_coeff_buffer(AV1_COMMON *cm,
                                    PC_TREE_SHARED_BUFFERS *shared_bufs);
 void av1_free_shared_coeff_buffer(PC_TREE_SHARED_BUFFERS *shared_bufs);
+void av1_reset_pc_tree_arena(PC_TREE_SHARED_BUFFERS *shared_bufs);
 
 PC_TREE *av1_alloc_pc_tree_node(int mi_row, int mi_col, BLOCK_SIZE bsize,
                                 PC_TREE *parent,
                                 PARTITION_TYPE parent_partition, int index,
                                 int is_last, int subsampling_x,
-                                int subsampling_y);
+                                int subsampling_y,
+                                PC_TREE_SHARED_BUFFERS *shared_bufs);
 void av1_free_pc_tree_recursive(PC_TREE *tree, int num_planes, int keep_best,
                                 int keep_none);
 #if CONFIG_EXT_RECUR_PARTITIONS
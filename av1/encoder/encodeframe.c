@@ -529,8 +529,10 @@ static AOM_INLINE void encode_nonrd_sb(AV1_COMP *cpi, ThreadData *td,
                                      sb_chr_ref_info);
   av1_choose_var_based_partitioning(cpi, tile_info, x, mi_row, mi_col);
   td->mb.cb_offset = 0;
+  av1_reset_pc_tree_arena(&td->shared_coeff_buf);
   PC_TREE *pc_root = av1_alloc_pc_tree_node(mi_row, mi_col, sb_size, NULL,
-                                            PARTITION_NONE, 0, 1, ss_x, ss_y);
+                                            PARTITION_NONE, 0, 1, ss_x, ss_y,
+                                            &td->shared_coeff_buf);
   av1_reset_ptree_in_sbi(xd->sbi);
   xd->sbi->sb_mv_precision = cm->fr_mv_precision;
   av1_nonrd_use_partition(cpi, td, tile_data, mi, tp, mi_row, mi_col, sb_size,
@@ -571,6 +573,8 @@ static AOM_INLINE void encode_rd_sb(AV1_COMP *cpi, ThreadData *td,
   x->sms_bufs = td->sms_bufs;
 #endif  // CONFIG_EXT_RECUR_PARTITIONS
 
+  // The trees of the previous superblock have all been freed.
+  av1_reset_pc_tree_arena(&td->shared_coeff_buf);
   av1_init_encode_rd_sb(cpi, td, tile_data, &pc_root, sms_root, &dummy_rdc,
                         mi_row, mi_col, 1);
 
@@ -889,6 +893,9 @@ static void encode_sb_row(AV1_COMP *cpi, ThreadData *td, TileDataEnc *tile_data,
                    &sb_chr_ref_info);
 #endif  // !CONFIG_REALTIME_ONLY
     }
+#if CONFIG_INTRA_ENTROPY
+    if (tile_data->allow_update_cdf) av1_update_entropy_models_sb(xd->tile_ctx);
+#endif  // CONFIG_INTRA_ENTROPY
     if (tile_data->allow_update_cdf && (cpi->row_mt == 1) &&
         (tile_info->mi_row_end > (mi_row + mib_size))) {
       if (sb_cols_in_tile == 1)
@@ -960,15 +967,6 @@ void av1_alloc_tile_data(AV1_COMP *cpi) {
   cpi->allocated_tiles = tile_cols * tile_rows;
 }
 
-#if CONFIG_EXT_IBC_MODES
-void av1_allocate_intrabc_sb(uint16_t **InputBlock, BLOCK_SIZE bsize) {
-  uint16_t width = block_size_wide[bsize];
-  uint16_t height = block_size_high[bsize];
-
-  (*InputBlock) = (uint16_t *)aom_malloc(width * height * sizeof(uint16_t));
-}
-#endif  // CONFIG_EXT_IBC_MODES
-
 void av1_init_tile_data(AV1_COMP *cpi) {
   AV1_COMMON *const cm = &cpi->common;
   const int num_planes = av1_num_planes(cm);
@@ -999,7 +997,8 @@ void av1_init_tile_data(AV1_COMP *cpi) {
           tile_data->allow_update_cdf && !cm->disable_cdf_update;
       tile_data->tctx = *cm->fc;
 #if CONFIG_INTRA_ENTROPY
-      av1_config_entropy_models(&tile_data->tctx);
+      av1_config_entropy_models(
+          &tile_data->tctx, cm->seq_params.enable_intra_entropy_sb_update);
 #endif  // CONFIG_INTRA_ENTROPY
     }
   }
@@ -1024,6 +1023,12 @@ void av1_encode_sb_row(AV1_COMP *cpi, ThreadData *td, int tile_row,
                 cm->seq_params.mib_size_log2 + MI_SIZE_LOG2, num_planes);
   cpi->tplist[tile_row][tile_col][sb_row_in_tile].start = tok;
 
+#if CONFIG_HTB_TRELLIS
+  // Start each superblock row from an empty cache, so that the result does
+  // not depend on which thread encoded the previous rows.
+  av1_hbt_cache_reset(&td->hbt_cache);
+#endif  // CONFIG_HTB_TRELLIS
+
   encode_sb_row(cpi, td, this_tile, mi_row, &tok, cpi->sf.use_nonrd_pick_mode);
 
   cpi->tplist[tile_row][tile_col][sb_row_in_tile].stop = tok;
@@ -1081,16 +1086,9 @@ static void encode_tiles(AV1_COMP *cpi) {
     av1_alloc_tile_data(cpi);
 
   av1_init_tile_data(cpi);
-
-#if CONFIG_EXT_IBC_MODES
-  // Allocate 128x128 scratch buffers for Encode:
-  // 1. Source
-  MACROBLOCK *const x = &cpi->td.mb;
-  av1_allocate_intrabc_sb(&x->ibc_src, BLOCK_128X128);
-  // 2. Prediction
-  MACROBLOCKD *const xd = &x->e_mbd;
-  av1_allocate_intrabc_sb(&xd->ibc_pred, BLOCK_128X128);
-#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_HTB_TRELLIS
+  av1_setup_hbt_cache(cpi, &cpi->td);
+#endif  // CONFIG_HTB_TRELLIS
 
   for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
     for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
@@ -1105,12 +1103,6 @@ static void encode_tiles(AV1_COMP *cpi) {
       cpi->deltaq_used |= cpi->td.deltaq_used;
     }
   }
-
-#if CONFIG_EXT_IBC_MODES
-  // Free scratch buffers for Encode
-  aom_free(x->ibc_src);
-  aom_free(xd->ibc_pred);
-#endif  // CONFIG_EXT_IBC_MODES
 }
 
 #define GLOBAL_TRANS_TYPES_ENC 3  // highest motion model to search
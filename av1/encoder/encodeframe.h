@@ -38,10 +38,6 @@ void av1_setup_src_planes(struct macroblock *x,
 
 void av1_encode_frame(struct AV1_COMP *cpi);
 
-#if CONFIG_EXT_IBC_MODES
-void av1_allocate_intrabc_sb(uint16_t **InputBlock, BLOCK_SIZE bsize);
-#endif  // CONFIG_EXT_IBC_MODES
-
 void av1_alloc_tile_data(struct AV1_COMP *cpi);
 void av1_init_tile_data(struct AV1_COMP *cpi);
 void av1_encode_tile(struct AV1_COMP *cpi, struct ThreadData *td, int tile_row,
@@ -417,7 +417,8 @@ void av1_init_encode_rd_sb(AV1_COMP *cpi, ThreadData *td,
     const int ss_x = xd->plane[1].subsampling_x;
     const int ss_y = xd->plane[1].subsampling_y;
     *pc_root = av1_alloc_pc_tree_node(mi_row, mi_col, sb_size, NULL,
-                                      PARTITION_NONE, 0, 1, ss_x, ss_y);
+                                      PARTITION_NONE, 0, 1, ss_x, ss_y,
+                                      &td->shared_coeff_buf);
   }
 
   x->sb_energy_level = 0;
@@ -505,6 +506,16 @@ void av1_set_offsets_without_segment_id(const AV1_COMP *const cpi,
 
   xd->cfl.mi_row = mi_row;
   xd->cfl.mi_col = mi_col;
+
+#if CONFIG_ADAPT_FILTER_INTRA
+  // The neighbors of this block may differ from the ones the cached
+  // coefficients were solved from.
+  xd->adapt_filter_intra_cache = &x->adapt_filter_intra_cache;
+  av1_reset_adapt_filter_intra_cache(xd->adapt_filter_intra_cache);
+#endif  // CONFIG_ADAPT_FILTER_INTRA
+#if CONFIG_DERIVED_INTRA_MODE
+  av1_reset_derived_intra_mode_cache(xd);
+#endif  // CONFIG_DERIVED_INTRA_MODE
 }
 
 void av1_enc_set_offsets(const AV1_COMP *const cpi, const TileInfo *const tile,
@@ -119,6 +119,13 @@ int av1_optimize_b(const struct AV1_COMP *cpi, MACROBLOCK *x, int plane,
     return eob;
   }
 
+#if CONFIG_HTB_TRELLIS
+  if (eob <= HBT_EOB && x->hbt_cache->entries != NULL) {
+    return av1_optimize_txb(cpi, x, plane, block, tx_size, tx_type, txb_ctx,
+                            fast_mode, rate_cost);
+  }
+#endif  // CONFIG_HTB_TRELLIS
+
   return av1_optimize_txb_new(cpi, x, plane, block, tx_size, tx_type, txb_ctx,
                               rate_cost, cpi->oxcf.sharpness, fast_mode);
 }
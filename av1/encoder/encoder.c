@@ -73,15 +73,18 @@
 #include "av1/encoder/ratectrl.h"
 #include "av1/encoder/rd.h"
 #include "av1/encoder/rdopt.h"
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+#include "av1/encoder/segment_patch.h"
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
 #include "av1/encoder/segmentation.h"
 #include "av1/encoder/speed_features.h"
 #include "av1/encoder/tpl_model.h"
 #include "av1/encoder/reconinter_enc.h"
 #include "av1/encoder/var_based_part.h"
 
-#if CONFIG_CNN_RESTORATION || CONFIG_LOOP_RESTORE_CNN
+#if CONFIG_CNN_RESTORATION || CONFIG_LOOP_RESTORE_CNN || CONFIG_NN_RECON
 #include "av1/common/cnn_tflite.h"
-#endif  // CONFIG_CNN_RESTORATION || CONFIG_LOOP_RESTORE_CNN
+#endif  // CONFIG_CNN_RESTORATION || CONFIG_LOOP_RESTORE_CNN || CONFIG_NN_RECON
 
 #define DEFAULT_EXPLICIT_ORDER_HINT_BITS 7
 
@@ -518,6 +521,9 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
 
   aom_free(cpi->tile_data);
   cpi->tile_data = NULL;
+  aom_free(cpi->tile_pack_buf);
+  cpi->tile_pack_buf = NULL;
+  cpi->tile_pack_buf_size = 0;
 
   // Delete sementation map
   aom_free(cpi->segmentation_map);
@@ -595,6 +601,20 @@ static void dealloc_compressor_data(AV1_COMP *cpi) {
   for (int j = 0; j < 2; ++j) {
     aom_free(cpi->td.mb.tmp_obmc_bufs[j]);
   }
+  aom_free(cpi->td.mb.interp_pred_bufs);
+#if CONFIG_EXT_IBC_MODES
+  aom_free(cpi->td.mb.ibc_src_buf);
+  aom_free(cpi->td.mb.e_mbd.ibc_pred);
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  av1_nn_recon_cache_free(cpi->td.mb.e_mbd.nn_recon_cache);
+#endif  // CONFIG_NN_RECON
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+  aom_free(cpi->td.mb.seg_scratch);
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
+#if CONFIG_HTB_TRELLIS
+  av1_hbt_cache_free(&cpi->td.hbt_cache);
+#endif  // CONFIG_HTB_TRELLIS
 
 #if CONFIG_DENOISE
   if (cpi->denoise_and_model) {
@@ -1117,6 +1137,9 @@ static void init_seq_coding_tools(SequenceHeader *seq, AV1_COMMON *cm,
 #if CONFIG_ADAPT_FILTER_INTRA
   seq->enable_adapt_filter_intra = 1;
 #endif
+#if CONFIG_INTRA_ENTROPY
+  seq->enable_intra_entropy_sb_update = oxcf->intra_entropy_sb_update;
+#endif  // CONFIG_INTRA_ENTROPY
 
   set_bitstream_level_tier(seq, cm, oxcf);
 
@@ -2870,6 +2893,39 @@ void av1_change_config(struct AV1_COMP *cpi, const AV1EncoderConfig *oxcf) {
       x->e_mbd.tmp_obmc_bufs[i] = x->tmp_obmc_bufs[i];
     }
   }
+  if (x->interp_pred_bufs == NULL) {
+    CHECK_MEM_ERROR(cm, x->interp_pred_bufs,
+                    aom_memalign(32, MAX_INTERP_PRED_SLOTS * 2 * MAX_MB_PLANE *
+                                         MAX_SB_SQUARE *
+                                         sizeof(*x->interp_pred_bufs)));
+  }
+#if CONFIG_EXT_IBC_MODES
+  if (x->ibc_src_buf == NULL) {
+    CHECK_MEM_ERROR(cm, x->ibc_src_buf,
+                    aom_memalign(32, IBC_MODES * MAX_SB_SQUARE *
+                                         sizeof(*x->ibc_src_buf)));
+    x->ibc_src = x->ibc_src_buf;
+  }
+  if (x->e_mbd.ibc_pred == NULL) {
+    CHECK_MEM_ERROR(
+        cm, x->e_mbd.ibc_pred,
+        aom_memalign(32, MAX_SB_SQUARE * sizeof(*x->e_mbd.ibc_pred)));
+  }
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  if (x->e_mbd.nn_recon_cache == NULL) {
+    CHECK_MEM_ERROR(cm, x->e_mbd.nn_recon_cache, av1_nn_recon_cache_alloc());
+  }
+#endif  // CONFIG_NN_RECON
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+  if (x->seg_scratch == NULL) {
+    CHECK_MEM_ERROR(cm, x->seg_scratch, aom_calloc(1, sizeof(*x->seg_scratch)));
+  }
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
+#if CONFIG_HTB_TRELLIS
+  // The cache itself is sized before encoding the tiles.
+  x->hbt_cache = &cpi->td.hbt_cache;
+#endif  // CONFIG_HTB_TRELLIS
 
   av1_reset_segment_features(cm);
   av1_set_mv_precision(cpi, MV_SUBPEL_EIGHTH_PRECISION, 0);
@@ -3591,6 +3647,20 @@ void av1_remove_compressor(AV1_COMP *cpi) {
       for (int j = 0; j < 2; ++j) {
         aom_free(thread_data->td->tmp_obmc_bufs[j]);
       }
+      aom_free(thread_data->td->interp_pred_bufs);
+#if CONFIG_EXT_IBC_MODES
+      aom_free(thread_data->td->ibc_src_buf);
+      aom_free(thread_data->td->ibc_pred);
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+      av1_nn_recon_cache_free(thread_data->td->nn_recon_cache);
+#endif  // CONFIG_NN_RECON
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+      aom_free(thread_data->td->seg_scratch);
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
+#if CONFIG_HTB_TRELLIS
+      av1_hbt_cache_free(&thread_data->td->hbt_cache);
+#endif  // CONFIG_HTB_TRELLIS
       aom_free(thread_data->td->above_pred_buf);
       aom_free(thread_data->td->left_pred_buf);
       aom_free(thread_data->td->wsrc_buf);
@@ -3643,9 +3713,6 @@ void av1_remove_compressor(AV1_COMP *cpi) {
   for (i = 0; i < FRAME_BUFFERS; ++i) {
     av1_hash_table_destroy(&cm->buffer_pool->frame_bufs[i].hash_table);
   }
-#if CONFIG_HTB_TRELLIS
-  if (cpi->sf.use_hash_based_trellis) hbt_destroy();
-#endif  // CONFIG_HTB_TRELLIS
   av1_free_ref_frame_buffers(cm->buffer_pool);
 
   aom_free(cpi->twopass.total_stats);
@@ -4700,7 +4767,7 @@ static void superres_post_encode(AV1_COMP *cpi) {
   assert(!is_lossless_requested(&cpi->oxcf));
   assert(!cm->all_lossless);
 
-  av1_superres_upscale(cm, NULL);
+  av1_superres_upscale(cm, NULL, NULL);
 
   // If regular resizing is occurring the source will need to be downscaled to
   // match the upscaled superres resolution. Otherwise the original source is
@@ -4905,15 +4972,27 @@ static void loopfilter_frame(AV1_COMP *cpi, AV1_COMMON *cm) {
     dgd_error = aom_get_sse_plane(cpi->source, &cm->cur_frame->buf, plane,
                                   cm->seq_params.use_highbitdepth);
 
-    av1_restore_cnn_tflite(cm, cpi->num_workers);
+    // Worker 0 runs on the main thread, so chroma goes to the last one.
+    av1_restore_cnn_tflite(
+        cm, cpi->num_workers,
+        cpi->num_workers > 1 ? &cpi->workers[cpi->num_workers - 1] : NULL);
 
     // Find the error of the plane from source after applying cnn.
     cnn_error = aom_get_sse_plane(cpi->source, &cm->cur_frame->buf, plane,
                                   cm->seq_params.use_highbitdepth);
 
-    if (cnn_error < dgd_error)
+    if (cnn_error < dgd_error) {
       aom_yv12_copy_y(&cm->cur_frame->buf, &cpi->cnn_buffer);
+      if (num_planes > 1)
+        aom_yv12_copy_u(&cm->cur_frame->buf, &cpi->cnn_buffer);
+      if (num_planes > 2)
+        aom_yv12_copy_v(&cm->cur_frame->buf, &cpi->cnn_buffer);
+    }
     aom_yv12_copy_y(&cpi->last_frame_uf, &cm->cur_frame->buf);
+    if (num_planes > 1)
+      aom_yv12_copy_u(&cpi->last_frame_uf, &cm->cur_frame->buf);
+    if (num_planes > 2)
+      aom_yv12_copy_v(&cpi->last_frame_uf, &cm->cur_frame->buf);
 
     cdef_restoration_frame(cpi, cm, xd, use_restoration, use_cdef);
 
@@ -4922,11 +5001,12 @@ static void loopfilter_frame(AV1_COMP *cpi, AV1_COMMON *cm) {
                                   cm->seq_params.use_highbitdepth);
     if (cnn_error < res_error && cnn_error < dgd_error) {
       cm->use_cnn = 1;
+      // The decoder restores all planes with the CNN before CDEF and LR.
       aom_yv12_copy_y(&cpi->cnn_buffer, &cm->cur_frame->buf);
       if (num_planes > 1)
-        aom_yv12_copy_u(&cpi->last_frame_uf, &cm->cur_frame->buf);
+        aom_yv12_copy_u(&cpi->cnn_buffer, &cm->cur_frame->buf);
       if (num_planes > 2)
-        aom_yv12_copy_v(&cpi->last_frame_uf, &cm->cur_frame->buf);
+        aom_yv12_copy_v(&cpi->cnn_buffer, &cm->cur_frame->buf);
       // Since cnn restores better than CDEF and LR for Y plane, we disable CDEF
       // and LR for Y plane.
       // TODO(now): Should be quicker to do this.
@@ -5093,7 +5173,9 @@ static void finalize_encoded_frame(AV1_COMP *const cpi) {
       const int tile_idx = tile_row * cm->tile_cols + tile_col;
       cpi->tile_data[tile_idx].tctx = *cm->fc;
 #if CONFIG_INTRA_ENTROPY
-      av1_config_entropy_models(&cpi->tile_data[tile_idx].tctx);
+      av1_config_entropy_models(
+          &cpi->tile_data[tile_idx].tctx,
+          cm->seq_params.enable_intra_entropy_sb_update);
 #endif  // CONFIG_INTRA_ENTROPY
     }
   }
@@ -6393,8 +6475,11 @@ static int apply_denoise_2d(AV1_COMP *cpi, YV12_BUFFER_CONFIG *sd,
     }
     memset(cpi->film_grain_table, 0, sizeof(*cpi->film_grain_table));
   }
-  if (aom_denoise_and_model_run(cpi->denoise_and_model, sd,
-                                &cm->film_grain_params)) {
+  // The encoder workers are idle between frames, so the denoiser borrows
+  // them. They are created with the first multithreaded frame encode.
+  if (aom_denoise_and_model_run_mt(cpi->denoise_and_model, sd,
+                                   &cm->film_grain_params, cpi->workers,
+                                   cpi->num_workers)) {
     if (cm->film_grain_params.apply_grain) {
       aom_film_grain_table_append(cpi->film_grain_table, time_stamp, end_time,
                                   &cm->film_grain_params);
@@ -6406,7 +6491,8 @@ static int apply_denoise_2d(AV1_COMP *cpi, YV12_BUFFER_CONFIG *sd,
 
 int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
                           YV12_BUFFER_CONFIG *sd, int64_t time_stamp,
-                          int64_t end_time) {
+                          int64_t end_time,
+                          const struct lookahead_src_ref *src_ref) {
   AV1_COMMON *const cm = &cpi->common;
   const SequenceHeader *const seq_params = &cm->seq_params;
   int res = 0;
@@ -6426,7 +6512,7 @@ int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
 #endif  //  CONFIG_DENOISE
 
   if (av1_lookahead_push(cpi->lookahead, sd, time_stamp, end_time,
-                         use_highbitdepth, frame_flags))
+                         use_highbitdepth, frame_flags, src_ref))
     res = -1;
 #if CONFIG_INTERNAL_STATS
   aom_usec_timer_mark(&timer);
@@ -49,6 +49,9 @@
 #if CONFIG_DENOISE
 #include "aom_dsp/noise_model.h"
 #endif
+#if CONFIG_HTB_TRELLIS
+#include "av1/encoder/hash_trellis.h"
+#endif  // CONFIG_HTB_TRELLIS
 #include "aom/internal/aom_codec_internal.h"
 #include "aom_util/aom_thread.h"
 
@@ -368,6 +371,14 @@ typedef struct AV1EncoderConfig {
   int enable_dual_filter;
   unsigned int motion_vector_unit_test;
   unsigned int sb_multipass_unit_test;
+#if CONFIG_INTRA_ENTROPY
+  int intra_entropy_sb_update;
+#endif  // CONFIG_INTRA_ENTROPY
+#if CONFIG_HTB_TRELLIS
+  // Log2 of the number of entries of the hash trellis cache of each thread,
+  // 0 to disable the hash based trellis.
+  int hash_trellis_size;
+#endif  // CONFIG_HTB_TRELLIS
   int disable_ml_partition_speed_features;
   int enable_rect_partitions;
   int enable_ab_partitions;
@@ -646,6 +657,10 @@ typedef struct TileDataEnc {
   InterModeRdModel inter_mode_rd_models[BLOCK_SIZES_ALL];
   AV1RowMTSync row_mt_sync;
   AV1RowMTInfo row_mt_info;
+  // Bitstream of the tile, packed by av1_pack_tile() into a slice of
+  // cpi->tile_pack_buf.
+  uint8_t *pack_buf;
+  uint32_t pack_size;
 } TileDataEnc;
 
 typedef struct {
@@ -690,9 +705,27 @@ typedef struct ThreadData {
   CompoundTypeRdBuffers comp_rd_buffer;
   CONV_BUF_TYPE *tmp_conv_dst;
   uint8_t *tmp_obmc_bufs[2];
+  uint8_t *interp_pred_bufs;
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+  struct Av1SegmentScratch *seg_scratch;
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
+#if CONFIG_EXT_IBC_MODES
+  uint16_t *ibc_src_buf;
+  uint16_t *ibc_pred;
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+  struct NnReconCache *nn_recon_cache;
+#endif  // CONFIG_NN_RECON
+#if CONFIG_HTB_TRELLIS
+  HbtCache hbt_cache;
+#endif  // CONFIG_HTB_TRELLIS
   int intrabc_used;
   int deltaq_used;
   FRAME_CONTEXT *tctx;
+  // Statistics gathered while packing tiles, merged into the frame once all
+  // tiles are packed.
+  unsigned int max_mv_magnitude;
+  int interp_filter_selected[SWITCHABLE];
 } ThreadData;
 
 struct EncWorkerData;
@@ -1050,6 +1083,8 @@ typedef struct AV1_COMP {
 
   TileDataEnc *tile_data;
   int allocated_tiles;  // Keep track of memory allocated for tiles.
+  uint8_t *tile_pack_buf;  // Bitstream buffers of all tiles.
+  size_t tile_pack_buf_size;
 
   TOKENEXTRA *tile_tok[MAX_TILE_ROWS][MAX_TILE_COLS];
   TOKENLIST *tplist[MAX_TILE_ROWS][MAX_TILE_COLS];
@@ -1263,10 +1298,12 @@ void av1_check_initial_width(AV1_COMP *cpi, int use_highbitdepth,
                              int subsampling_x, int subsampling_y);
 
 // receive a frames worth of data. caller can assume that a copy of this
-// frame is made and not just a copy of the pointer..
+// frame is made and not just a copy of the pointer, unless src_ref is non-NULL
+// (see av1_lookahead_push()).
 int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
                           YV12_BUFFER_CONFIG *sd, int64_t time_stamp,
-                          int64_t end_time_stamp);
+                          int64_t end_time_stamp,
+                          const struct lookahead_src_ref *src_ref);
 
 int av1_get_compressed_data(AV1_COMP *cpi, unsigned int *frame_flags,
                             size_t *size, uint8_t *dest, int64_t *time_stamp,
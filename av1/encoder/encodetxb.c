@@ -19,29 +19,14 @@
 #include "av1/encoder/bitstream.h"
 #include "av1/encoder/cost.h"
 #include "av1/encoder/encodeframe.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/hash.h"
 #include "av1/encoder/rdopt.h"
 #include "av1/encoder/tokenize.h"
 
 #if CONFIG_HTB_TRELLIS
-static int hbt_needs_init = 1;
-static CRC32C crc_calculator;
-static const int HBT_EOB = 16;            // also the length in opt_qcoeff
-static const int HBT_TABLE_SIZE = 65536;  // 16 bit: holds 65536 'arrays'
-static const int HBT_ARRAY_LENGTH = 256;  // 8 bit: 256 entries
 // If removed in hbt_create_hashes or increased beyond int8_t, widen deltas type
 static const int HBT_KICKOUT = 3;
-
-typedef struct OptTxbQcoeff {
-  // Use larger type if larger/no kickout value is used in hbt_create_hashes
-  int8_t deltas[16];
-  uint32_t hbt_qc_hash;
-  uint32_t hbt_ctx_hash;
-  int init;
-  int rate_cost;
-} OptTxbQcoeff;
-
-OptTxbQcoeff *hbt_hash_table;
 #endif  // CONFIG_HTB_TRELLIS
 
 typedef struct LevelDownStats {
@@ -570,6 +555,17 @@ void av1_get_nz_map_contexts_c(const uint8_t *const levels,
   }
 }
 
+void av1_get_br_contexts_c(const uint8_t *const levels,
+                           const int16_t *const scan, const uint16_t eob,
+                           const TX_SIZE tx_size, const TX_CLASS tx_class,
+                           int8_t *const br_contexts) {
+  const int bwl = get_txb_bwl(tx_size);
+  for (int i = 0; i < eob; ++i) {
+    const int pos = scan[i];
+    br_contexts[pos] = get_br_ctx(levels, pos, bwl, tx_class);
+  }
+}
+
 void av1_write_coeffs_txb(const AV1_COMMON *const cm, MACROBLOCKD *xd,
                           aom_writer *w, int blk_row, int blk_col, int plane,
                           TX_SIZE tx_size, const tran_low_t *tcoeff,
@@ -924,6 +920,8 @@ static AOM_FORCE_INLINE int warehouse_efficients_txb(
   uint8_t levels_buf[TX_PAD_2D];
   uint8_t *const levels = set_levels(levels_buf, width);
   DECLARE_ALIGNED(16, int8_t, coeff_contexts[MAX_TX_SQUARE]);
+  DECLARE_ALIGNED(16, int8_t, br_contexts[MAX_TX_SQUARE]);
+  int has_br_contexts = 0;
   const int eob_multi_size = txsize_log2_minus4[tx_size];
 #if CONFIG_ENTROPY_CONTEXTS
   const LV_MAP_EOB_COST *eob_costs =
@@ -980,8 +978,14 @@ static AOM_FORCE_INLINE int warehouse_efficients_txb(
       // sign bit cost
       cost += av1_cost_literal(1);
       if (level > NUM_BASE_LEVELS) {
-        const int ctx = get_br_ctx(levels, pos, bwl, tx_class);
-        cost += get_br_cost(level, lps_cost[ctx]);
+        // Most blocks have no level above NUM_BASE_LEVELS, so only the ones
+        // that do get the contexts of the whole block at once.
+        if (!has_br_contexts) {
+          av1_get_br_contexts(levels, scan, eob, tx_size, tx_class,
+                              br_contexts);
+          has_br_contexts = 1;
+        }
+        cost += get_br_cost(level, lps_cost[br_contexts[pos]]);
       }
     }
     cost += cost0;
@@ -1000,7 +1004,9 @@ static AOM_FORCE_INLINE int warehouse_efficients_txb(
       const int dc_sign_ctx = txb_ctx->dc_sign_ctx;
       cost += coeff_costs->dc_sign_cost[dc_sign_ctx][sign01];
       if (level > NUM_BASE_LEVELS) {
-        const int ctx = get_br_ctx(levels, pos, bwl, tx_class);
+        const int ctx = has_br_contexts
+                            ? br_contexts[pos]
+                            : get_br_ctx(levels, pos, bwl, tx_class);
         cost += get_br_cost(level, lps_cost[ctx]);
       }
     }
@@ -1204,28 +1210,17 @@ static int optimize_txb(TxbInfo *txb_info, const LV_MAP_COEFF_COST *txb_costs,
 }
 
 #if CONFIG_HTB_TRELLIS
-static void hbt_init() {
-  hbt_hash_table =
-      aom_malloc(sizeof(OptTxbQcoeff) * HBT_TABLE_SIZE * HBT_ARRAY_LENGTH);
-  memset(hbt_hash_table, 0,
-         sizeof(OptTxbQcoeff) * HBT_TABLE_SIZE * HBT_ARRAY_LENGTH);
-  av1_crc32c_calculator_init(&crc_calculator);  // 31 bit: qc & ctx
-
-  hbt_needs_init = 0;
-}
-
-void hbt_destroy() { aom_free(hbt_hash_table); }
-
-static int hbt_hash_miss(uint32_t hbt_ctx_hash, uint32_t hbt_qc_hash,
-                         TxbInfo *txb_info, const LV_MAP_COEFF_COST *txb_costs,
+static int hbt_hash_miss(HbtCache *cache, uint32_t hbt_ctx_hash,
+                         uint32_t hbt_qc_hash, TxbInfo *txb_info,
+                         const LV_MAP_COEFF_COST *txb_costs,
                          const LV_MAP_EOB_COST *txb_eob_costs,
                          const struct macroblock_plane *p, int block,
                          int fast_mode, int *rate_cost) {
   (void)fast_mode;
   const int16_t *scan = txb_info->scan_order->scan;
   int prev_eob = txb_info->eob;
-  assert(HBT_EOB <= 16);  // Lengthen array if allowing longer eob.
-  int32_t prev_coeff[16];
+  assert(prev_eob <= HBT_EOB);
+  int32_t prev_coeff[HBT_EOB];
   for (int i = 0; i < prev_eob; i++) {
     prev_coeff[i] = txb_info->qcoeff[scan[i]];
   }
@@ -1239,68 +1234,53 @@ static int hbt_hash_miss(uint32_t hbt_ctx_hash, uint32_t hbt_qc_hash,
   const int update =
       optimize_txb(txb_info, txb_costs, txb_eob_costs, rate_cost);
 
-  // Overwrite old entry
-  uint16_t hbt_table_index = hbt_ctx_hash % HBT_TABLE_SIZE;
-  uint16_t hbt_array_index = hbt_qc_hash % HBT_ARRAY_LENGTH;
-  hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-      .rate_cost = *rate_cost;
-  hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index].init = 1;
-  hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-      .hbt_qc_hash = hbt_qc_hash;
-  hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-      .hbt_ctx_hash = hbt_ctx_hash;
+  // Replace an old entry of the set.
+  HbtEntry *const entry =
+      av1_hbt_cache_insert(cache, hbt_ctx_hash, hbt_qc_hash);
+  entry->rate_cost = *rate_cost;
   assert(prev_eob >= txb_info->eob);  // eob can't get longer
   for (int i = 0; i < txb_info->eob; i++) {
     // Record how coeff changed. Convention: towards zero is negative.
     if (txb_info->qcoeff[scan[i]] > 0)
-      hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-          .deltas[i] = txb_info->qcoeff[scan[i]] - prev_coeff[i];
+      entry->deltas[i] = txb_info->qcoeff[scan[i]] - prev_coeff[i];
     else
-      hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-          .deltas[i] = prev_coeff[i] - txb_info->qcoeff[scan[i]];
+      entry->deltas[i] = prev_coeff[i] - txb_info->qcoeff[scan[i]];
   }
   for (int i = txb_info->eob; i < prev_eob; i++) {
     // If eob got shorter, record that all after it changed to zero.
     if (prev_coeff[i] > 0)
-      hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-          .deltas[i] = -prev_coeff[i];
+      entry->deltas[i] = -prev_coeff[i];
     else
-      hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-          .deltas[i] = prev_coeff[i];
+      entry->deltas[i] = prev_coeff[i];
   }
   for (int i = prev_eob; i < HBT_EOB; i++) {
     // Record 'no change' after optimized coefficients run out.
-    hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-        .deltas[i] = 0;
+    entry->deltas[i] = 0;
   }
 
   if (update) {
     p->eobs[block] = txb_info->eob;
-    p->txb_entropy_ctx[block] = av1_get_txb_entropy_context(
-        txb_info->qcoeff, txb_info->scan_order, txb_info->eob);
+    p->txb_entropy_ctx[block] =
+        av1_get_txb_entropy_context(txb_info->qcoeff, txb_info->scan_order,
+                                    txb_info->tx_size, txb_info->eob);
   }
   return txb_info->eob;
 }
 
-static int hbt_hash_hit(uint32_t hbt_table_index, int hbt_array_index,
-                        TxbInfo *txb_info, const struct macroblock_plane *p,
-                        int block, int *rate_cost) {
+static int hbt_hash_hit(const HbtEntry *entry, TxbInfo *txb_info,
+                        const struct macroblock_plane *p, int block,
+                        int *rate_cost) {
   const int16_t *scan = txb_info->scan_order->scan;
   int new_eob = 0;
   int update = 0;
 
   for (int i = 0; i < txb_info->eob; i++) {
     // Delta convention is negatives go towards zero, so only apply those ones.
-    if (hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-            .deltas[i] < 0) {
+    if (entry->deltas[i] < 0) {
       if (txb_info->qcoeff[scan[i]] > 0)
-        txb_info->qcoeff[scan[i]] +=
-            hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-                .deltas[i];
+        txb_info->qcoeff[scan[i]] += entry->deltas[i];
       else
-        txb_info->qcoeff[scan[i]] -=
-            hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-                .deltas[i];
+        txb_info->qcoeff[scan[i]] -= entry->deltas[i];
 
       update = 1;
       update_coeff(scan[i], txb_info->qcoeff[scan[i]], txb_info);
@@ -1310,54 +1290,42 @@ static int hbt_hash_hit(uint32_t hbt_table_index, int hbt_array_index,
 
   // Rate_cost can be calculated here instead (av1_cost_coeffs_txb), but
   // it is expensive and gives little benefit as long as qc_hash is high bit
-  *rate_cost =
-      hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-          .rate_cost;
+  *rate_cost = entry->rate_cost;
 
   if (update) {
     txb_info->eob = new_eob;
     p->eobs[block] = txb_info->eob;
-    p->txb_entropy_ctx[block] = av1_get_txb_entropy_context(
-        txb_info->qcoeff, txb_info->scan_order, txb_info->eob);
+    p->txb_entropy_ctx[block] =
+        av1_get_txb_entropy_context(txb_info->qcoeff, txb_info->scan_order,
+                                    txb_info->tx_size, txb_info->eob);
   }
 
   return txb_info->eob;
 }
 
-static int hbt_search_match(uint32_t hbt_ctx_hash, uint32_t hbt_qc_hash,
-                            TxbInfo *txb_info,
+static int hbt_search_match(HbtCache *cache, uint32_t hbt_ctx_hash,
+                            uint32_t hbt_qc_hash, TxbInfo *txb_info,
                             const LV_MAP_COEFF_COST *txb_costs,
                             const LV_MAP_EOB_COST *txb_eob_costs,
                             const struct macroblock_plane *p, int block,
                             int fast_mode, int *rate_cost) {
   // Check for qcoeff match
-  int hbt_array_index = hbt_qc_hash % HBT_ARRAY_LENGTH;
-  int hbt_table_index = hbt_ctx_hash % HBT_TABLE_SIZE;
-
-  if (hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-              .hbt_qc_hash == hbt_qc_hash &&
-      hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-              .hbt_ctx_hash == hbt_ctx_hash &&
-      hbt_hash_table[hbt_table_index * HBT_ARRAY_LENGTH + hbt_array_index]
-          .init) {
-    return hbt_hash_hit(hbt_table_index, hbt_array_index, txb_info, p, block,
-                        rate_cost);
+  const HbtEntry *const entry =
+      av1_hbt_cache_lookup(cache, hbt_ctx_hash, hbt_qc_hash);
+  if (entry != NULL) {
+    return hbt_hash_hit(entry, txb_info, p, block, rate_cost);
   } else {
-    return hbt_hash_miss(hbt_ctx_hash, hbt_qc_hash, txb_info, txb_costs,
-                         txb_eob_costs, p, block, fast_mode, rate_cost);
+    return hbt_hash_miss(cache, hbt_ctx_hash, hbt_qc_hash, txb_info,
+                         txb_costs, txb_eob_costs, p, block, fast_mode,
+                         rate_cost);
   }
 }
 
-static int hbt_create_hashes(TxbInfo *txb_info,
+static int hbt_create_hashes(HbtCache *cache, TxbInfo *txb_info,
                              const LV_MAP_COEFF_COST *txb_costs,
                              const LV_MAP_EOB_COST *txb_eob_costs,
                              const struct macroblock_plane *p, int block,
                              int fast_mode, int *rate_cost) {
-  // Initialize hash table if needed.
-  if (hbt_needs_init) {
-    hbt_init();
-  }
-
   //// Hash creation
   uint8_t txb_hash_data[256];  // Asserts below to ensure enough space.
   const int16_t *scan = txb_info->scan_order->scan;
@@ -1385,8 +1353,9 @@ static int hbt_create_hashes(TxbInfo *txb_info,
 
       if (update) {
         p->eobs[block] = txb_info->eob;
-        p->txb_entropy_ctx[block] = av1_get_txb_entropy_context(
-            txb_info->qcoeff, txb_info->scan_order, txb_info->eob);
+        p->txb_entropy_ctx[block] =
+            av1_get_txb_entropy_context(txb_info->qcoeff, txb_info->scan_order,
+                                        txb_info->tx_size, txb_info->eob);
       }
       return txb_info->eob;
     }
@@ -1403,12 +1372,12 @@ static int hbt_create_hashes(TxbInfo *txb_info,
       hash_data_index++;
     }
   }
-  // Needed when packing_index != 0, to include final byte.
-  hash_data_index++;
+  // Include the final, partially filled byte.
+  if (packing_index != 0) hash_data_index++;
   assert(hash_data_index <= 64);
-  // 31 bit qc_hash: index to array
-  uint32_t hbt_qc_hash =
-      av1_get_crc32c_value(&crc_calculator, txb_hash_data, hash_data_index);
+  // 31 bit qc_hash: picks the entry with ctx_hash.
+  uint32_t hbt_qc_hash = av1_get_crc32c_value(&cache->crc_calculator,
+                                              txb_hash_data, hash_data_index);
 
   // Make ctx_hash.
   hash_data_index = 0;
@@ -1465,13 +1434,32 @@ static int hbt_create_hashes(TxbInfo *txb_info,
   }
 
   assert(hash_data_index <= 256);
-  // 31 bit ctx_hash: used to index table
-  uint32_t hbt_ctx_hash =
-      av1_get_crc32c_value(&crc_calculator, txb_hash_data, hash_data_index);
+  // 31 bit ctx_hash: picks the entry with qc_hash.
+  uint32_t hbt_ctx_hash = av1_get_crc32c_value(&cache->crc_calculator,
+                                               txb_hash_data, hash_data_index);
   //// End hash creation
 
-  return hbt_search_match(hbt_ctx_hash, hbt_qc_hash, txb_info, txb_costs,
-                          txb_eob_costs, p, block, fast_mode, rate_cost);
+  return hbt_search_match(cache, hbt_ctx_hash, hbt_qc_hash, txb_info,
+                          txb_costs, txb_eob_costs, p, block, fast_mode,
+                          rate_cost);
+}
+
+void av1_setup_hbt_cache(AV1_COMP *cpi, ThreadData *td) {
+  td->mb.hbt_cache = &td->hbt_cache;
+  const int size_log2 =
+      cpi->sf.use_hash_based_trellis ? cpi->oxcf.hash_trellis_size : 0;
+  if (av1_hbt_cache_resize(&td->hbt_cache, size_log2)) {
+    aom_internal_error(&cpi->common.error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate hash trellis cache");
+  }
+}
+
+void av1_get_hbt_stats(const AV1_COMP *cpi, HbtStats *stats) {
+  av1_zero(*stats);
+  av1_hbt_accumulate_stats(stats, &cpi->td.hbt_cache.stats);
+  for (int i = 1; i < cpi->num_workers; ++i) {
+    av1_hbt_accumulate_stats(stats, &cpi->tile_thr_data[i].td->hbt_cache.stats);
+  }
 }
 #endif  // CONFIG_HTB_TRELLIS
 
@@ -2043,14 +2031,13 @@ int av1_optimize_txb_new(const struct AV1_COMP *cpi, MACROBLOCK *x, int plane,
 // This function is deprecated, but we keep it here because hash trellis
 // is not integrated with av1_optimize_txb_new yet
 int av1_optimize_txb(const struct AV1_COMP *cpi, MACROBLOCK *x, int plane,
-                     int blk_row, int blk_col, int block, TX_SIZE tx_size,
-                     TXB_CTX *txb_ctx, int fast_mode, int *rate_cost) {
+                     int block, TX_SIZE tx_size, TX_TYPE tx_type,
+                     const TXB_CTX *const txb_ctx, int fast_mode,
+                     int *rate_cost) {
   const AV1_COMMON *cm = &cpi->common;
   MACROBLOCKD *const xd = &x->e_mbd;
   const PLANE_TYPE plane_type = get_plane_type(plane);
   const TX_SIZE txs_ctx = get_txsize_entropy_ctx(tx_size);
-  const TX_TYPE tx_type = av1_get_tx_type(plane_type, xd, blk_row, blk_col,
-                                          tx_size, cm->reduced_tx_set_used);
   const MB_MODE_INFO *mbmi = xd->mi[0];
   const struct macroblock_plane *p = &x->plane[plane];
   struct macroblockd_plane *pd = &xd->plane[plane];
@@ -2102,11 +2089,10 @@ int av1_optimize_txb(const struct AV1_COMP *cpi, MACROBLOCK *x, int plane,
 
 #if CONFIG_HTB_TRELLIS
   // Hash based trellis (hbt) speed feature: avoid expensive optimize_txb calls
-  // by storing the coefficient deltas in a hash table.
-  // Currently disabled in speedfeatures.c
-  if (eob <= HBT_EOB && eob > 0 && cpi->sf.use_hash_based_trellis) {
-    return hbt_create_hashes(&txb_info, txb_costs, &txb_eob_costs, p, block,
-                             fast_mode, rate_cost);
+  // by storing the coefficient deltas in the cache of the thread.
+  if (eob <= HBT_EOB && eob > 0 && x->hbt_cache->entries != NULL) {
+    return hbt_create_hashes(x->hbt_cache, &txb_info, txb_costs, txb_eob_costs,
+                             p, block, fast_mode, rate_cost);
   }
 #else
   (void)fast_mode;
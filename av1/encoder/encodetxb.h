@@ -53,7 +53,7 @@ typedef struct TxbInfo {
   int eob;
   int seg_eob;
   const SCAN_ORDER *scan_order;
-  TXB_CTX *txb_ctx;
+  const TXB_CTX *txb_ctx;
   int64_t rdmult;
   const qm_val_t *iqmatrix;
   int tx_type_cost;
@@ -84,8 +84,16 @@ void av1_update_txb_context_b(int plane, int block, int blk_row, int blk_col,
 void av1_update_and_record_txb_context(int plane, int block, int blk_row,
                                        int blk_col, BLOCK_SIZE plane_bsize,
                                        TX_SIZE tx_size, void *arg);
+int av1_optimize_txb(const struct AV1_COMP *cpi, MACROBLOCK *x, int plane,
+                     int block, TX_SIZE tx_size, TX_TYPE tx_type,
+                     const TXB_CTX *const txb_ctx, int fast_mode,
+                     int *rate_cost);
 #if CONFIG_HTB_TRELLIS
-void hbt_destroy();
+// Points td->mb at the hash trellis cache of td and sizes it for the current
+// configuration.
+void av1_setup_hbt_cache(AV1_COMP *cpi, ThreadData *td);
+// Sums the hash trellis cache statistics of all encoder threads.
+void av1_get_hbt_stats(const AV1_COMP *cpi, HbtStats *stats);
 #endif  // CONFIG_HTB_TRELLIS
 int av1_optimize_txb_new(const struct AV1_COMP *cpi, MACROBLOCK *x, int plane,
                          int block, TX_SIZE tx_size, TX_TYPE tx_type,
@@ -10,10 +10,18 @@
  */
 
 #include "av1/encoder/av1_multi_thread.h"
+#include "av1/encoder/bitstream.h"
 #include "av1/encoder/encodeframe.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/encodetxb.h"
 #include "av1/encoder/ethread.h"
 #include "av1/encoder/rdopt.h"
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+#include "av1/encoder/segment_patch.h"
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
+#if CONFIG_NN_RECON
+#include "av1/common/cnn_tflite.h"
+#endif  // CONFIG_NN_RECON
 #include "aom_dsp/aom_dsp_common.h"
 
 static void accumulate_rd_opt(ThreadData *td, ThreadData *td_t) {
@@ -375,6 +383,24 @@ static int enc_worker_hook(void *arg1, void *unused) {
   return 1;
 }
 
+static int pack_tile_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  AV1_COMP *const cpi = thread_data->cpi;
+  const AV1_COMMON *const cm = &cpi->common;
+  const int tile_cols = cm->tile_cols;
+  const int tile_rows = cm->tile_rows;
+  int t;
+
+  (void)unused;
+
+  for (t = thread_data->start; t < tile_rows * tile_cols;
+       t += cpi->num_workers) {
+    av1_pack_tile(cpi, thread_data->td, t / tile_cols, t % tile_cols);
+  }
+
+  return 1;
+}
+
 static void create_enc_workers(AV1_COMP *cpi, int num_workers) {
   AV1_COMMON *const cm = &cpi->common;
   const AVxWorkerInterface *const winterface = aom_get_worker_interface();
@@ -470,6 +496,28 @@ static void create_enc_workers(AV1_COMP *cpi, int num_workers) {
             aom_memalign(32, 2 * MAX_MB_PLANE * MAX_SB_SQUARE *
                                  sizeof(*thread_data->td->tmp_obmc_bufs[j])));
       }
+      CHECK_MEM_ERROR(
+          cm, thread_data->td->interp_pred_bufs,
+          aom_memalign(32, MAX_INTERP_PRED_SLOTS * 2 * MAX_MB_PLANE *
+                               MAX_SB_SQUARE *
+                               sizeof(*thread_data->td->interp_pred_bufs)));
+#if CONFIG_EXT_IBC_MODES
+      CHECK_MEM_ERROR(
+          cm, thread_data->td->ibc_src_buf,
+          aom_memalign(32, IBC_MODES * MAX_SB_SQUARE *
+                               sizeof(*thread_data->td->ibc_src_buf)));
+      CHECK_MEM_ERROR(cm, thread_data->td->ibc_pred,
+                      aom_memalign(32, MAX_SB_SQUARE *
+                                           sizeof(*thread_data->td->ibc_pred)));
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+      CHECK_MEM_ERROR(cm, thread_data->td->nn_recon_cache,
+                      av1_nn_recon_cache_alloc());
+#endif  // CONFIG_NN_RECON
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+      CHECK_MEM_ERROR(cm, thread_data->td->seg_scratch,
+                      aom_calloc(1, sizeof(*thread_data->td->seg_scratch)));
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
 
       // Create threads
       if (!winterface->reset(worker))
@@ -584,13 +632,29 @@ static void prepare_enc_workers(AV1_COMP *cpi, AVxWorkerHook hook,
         thread_data->td->mb.tmp_obmc_bufs[j] =
             thread_data->td->tmp_obmc_bufs[j];
       }
+      thread_data->td->mb.interp_pred_bufs = thread_data->td->interp_pred_bufs;
 
       thread_data->td->mb.e_mbd.tmp_conv_dst = thread_data->td->mb.tmp_conv_dst;
       for (int j = 0; j < 2; ++j) {
         thread_data->td->mb.e_mbd.tmp_obmc_bufs[j] =
             thread_data->td->mb.tmp_obmc_bufs[j];
       }
+#if CONFIG_EXT_IBC_MODES
+      thread_data->td->mb.ibc_src_buf = thread_data->td->ibc_src_buf;
+      thread_data->td->mb.ibc_src = thread_data->td->ibc_src_buf;
+      thread_data->td->mb.e_mbd.ibc_pred = thread_data->td->ibc_pred;
+#endif  // CONFIG_EXT_IBC_MODES
+#if CONFIG_NN_RECON
+      thread_data->td->mb.e_mbd.nn_recon_cache =
+          thread_data->td->nn_recon_cache;
+#endif  // CONFIG_NN_RECON
+#if CONFIG_SEGMENT_BASED_PARTITIONING
+      thread_data->td->mb.seg_scratch = thread_data->td->seg_scratch;
+#endif  // CONFIG_SEGMENT_BASED_PARTITIONING
     }
+#if CONFIG_HTB_TRELLIS
+    av1_setup_hbt_cache(cpi, thread_data->td);
+#endif  // CONFIG_HTB_TRELLIS
   }
 }
 
@@ -616,6 +680,14 @@ void av1_encode_tiles_mt(AV1_COMP *cpi) {
   accumulate_counters_enc_workers(cpi, num_workers);
 }
 
+// Packs the bitstream of all tiles on the workers created for encoding them.
+void av1_pack_tiles_mt(AV1_COMP *cpi, int num_workers) {
+  assert(num_workers <= cpi->num_workers);
+  prepare_enc_workers(cpi, pack_tile_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+}
+
 // Accumulate frame counts. FRAME_COUNTS consist solely of 'unsigned int'
 // members, so we treat it as an array, and sum over the whole length.
 void av1_accumulate_frame_counts(FRAME_COUNTS *acc_counts,
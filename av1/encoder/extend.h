@@ -19,6 +19,8 @@
 extern "C" {
 #endif
 
+// Copies src into dst and extends its borders. If src and dst share the same
+// planes, only the borders are written.
 void av1_copy_and_extend_frame(const YV12_BUFFER_CONFIG *src,
                                YV12_BUFFER_CONFIG *dst);
 
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "aom_mem/aom_mem.h"
+#include "av1/encoder/hash_trellis.h"
+
+static HbtEntry *get_set(const HbtCache *cache, uint32_t ctx_hash,
+                         uint32_t qc_hash, int *set_idx) {
+  const uint32_t num_sets = 1u << (cache->size_log2 - HBT_WAYS_LOG2);
+  // Both hashes are crc32c values, so their low bits are well mixed.
+  *set_idx = (int)((ctx_hash ^ (qc_hash * 0x9E3779B1u)) & (num_sets - 1));
+  return &cache->entries[*set_idx << HBT_WAYS_LOG2];
+}
+
+void av1_hbt_cache_free(HbtCache *cache) {
+  aom_free(cache->entries);
+  aom_free(cache->hands);
+  cache->entries = NULL;
+  cache->hands = NULL;
+  cache->size_log2 = 0;
+}
+
+int av1_hbt_cache_resize(HbtCache *cache, int size_log2) {
+  if (size_log2 == cache->size_log2) return 0;
+  av1_hbt_cache_free(cache);
+  if (size_log2 == 0) return 0;
+  assert(size_log2 >= HBT_MIN_SIZE_LOG2 && size_log2 <= HBT_MAX_SIZE_LOG2);
+
+  const size_t num_sets = (size_t)1 << (size_log2 - HBT_WAYS_LOG2);
+  cache->entries = (HbtEntry *)aom_calloc(num_sets << HBT_WAYS_LOG2,
+                                          sizeof(*cache->entries));
+  cache->hands = (HbtHand *)aom_calloc(num_sets, sizeof(*cache->hands));
+  if (cache->entries == NULL || cache->hands == NULL) {
+    av1_hbt_cache_free(cache);
+    return -1;
+  }
+  cache->size_log2 = size_log2;
+  // Zeroed entries have epoch 0, so they start out invalid.
+  cache->epoch = 1;
+  av1_crc32c_calculator_init(&cache->crc_calculator);
+  return 0;
+}
+
+void av1_hbt_cache_reset(HbtCache *cache) {
+  if (cache->entries == NULL) return;
+  if (++cache->epoch == 0) {
+    // The epoch wrapped around: really clear the entries and hands once.
+    memset(cache->entries, 0, sizeof(*cache->entries) << cache->size_log2);
+    memset(cache->hands, 0,
+           sizeof(*cache->hands) << (cache->size_log2 - HBT_WAYS_LOG2));
+    cache->epoch = 1;
+  }
+}
+
+const HbtEntry *av1_hbt_cache_lookup(HbtCache *cache, uint32_t ctx_hash,
+                                     uint32_t qc_hash) {
+  int set_idx;
+  HbtEntry *const set = get_set(cache, ctx_hash, qc_hash, &set_idx);
+  for (int way = 0; way < HBT_WAYS; ++way) {
+    HbtEntry *const entry = &set[way];
+    if (entry->epoch == cache->epoch && entry->ctx_hash == ctx_hash &&
+        entry->qc_hash == qc_hash) {
+      entry->referenced = 1;
+      ++cache->stats.hits;
+      return entry;
+    }
+  }
+  ++cache->stats.misses;
+  return NULL;
+}
+
+HbtEntry *av1_hbt_cache_insert(HbtCache *cache, uint32_t ctx_hash,
+                               uint32_t qc_hash) {
+  int set_idx;
+  HbtEntry *const set = get_set(cache, ctx_hash, qc_hash, &set_idx);
+  HbtEntry *victim = NULL;
+  for (int way = 0; way < HBT_WAYS; ++way) {
+    if (set[way].epoch != cache->epoch) {
+      victim = &set[way];
+      break;
+    }
+  }
+  if (victim == NULL) {
+    // The set is full: skip over the recently hit entries, clearing their
+    // reference bits, and evict the first one that was not hit. This takes at
+    // most two rounds.
+    HbtHand *const hand = &cache->hands[set_idx];
+    if (hand->epoch != cache->epoch) {
+      hand->epoch = cache->epoch;
+      hand->way = 0;
+    }
+    while (set[hand->way].referenced) {
+      set[hand->way].referenced = 0;
+      hand->way = (hand->way + 1) & (HBT_WAYS - 1);
+    }
+    victim = &set[hand->way];
+    hand->way = (hand->way + 1) & (HBT_WAYS - 1);
+    ++cache->stats.evictions;
+  }
+  victim->ctx_hash = ctx_hash;
+  victim->qc_hash = qc_hash;
+  victim->epoch = cache->epoch;
+  victim->referenced = 0;
+  return victim;
+}
+
+void av1_hbt_accumulate_stats(HbtStats *acc, const HbtStats *stats) {
+  acc->hits += stats->hits;
+  acc->misses += stats->misses;
+  acc->evictions += stats->evictions;
+}
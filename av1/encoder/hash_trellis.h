@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#ifndef AOM_AV1_ENCODER_HASH_TRELLIS_H_
+#define AOM_AV1_ENCODER_HASH_TRELLIS_H_
+
+#include "config/aom_config.h"
+
+#include "aom/aom_integer.h"
+#include "av1/encoder/hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest eob handled by the hash based trellis, also the length of deltas.
+#define HBT_EOB 16
+// Number of entries in each set of the cache.
+#define HBT_WAYS_LOG2 2
+#define HBT_WAYS (1 << HBT_WAYS_LOG2)
+// Limits of the log2 of the number of entries in a cache.
+#define HBT_MIN_SIZE_LOG2 HBT_WAYS_LOG2
+#define HBT_MAX_SIZE_LOG2 24
+
+// The result of optimize_txb() for one transform block: how each coefficient
+// changed, in scan order. Changes towards zero are negative.
+typedef struct HbtEntry {
+  int8_t deltas[HBT_EOB];
+  uint32_t qc_hash;
+  uint32_t ctx_hash;
+  // The entry is only valid while it matches the epoch of the cache.
+  uint32_t epoch;
+  int rate_cost;
+  // CLOCK reference bit, set on each hit.
+  uint8_t referenced;
+} HbtEntry;
+
+// CLOCK hand of a set. Like the entries, it is only valid in its epoch, and
+// starts at way 0 otherwise.
+typedef struct HbtHand {
+  uint32_t epoch;
+  int way;
+} HbtHand;
+
+typedef struct HbtStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+} HbtStats;
+
+// Bounded, set associative cache of trellis results. Each encoder thread owns
+// one, so it is accessed without locking. The set of an entry is picked by its
+// hashes and a full set evicts with the CLOCK policy.
+typedef struct HbtCache {
+  HbtEntry *entries;
+  HbtHand *hands;
+  int size_log2;
+  uint32_t epoch;
+  HbtStats stats;
+  CRC32C crc_calculator;
+} HbtCache;
+
+// Resizes the cache to 2^size_log2 entries and empties it, or frees it when
+// size_log2 is 0. Does nothing if the size is unchanged. The statistics are
+// kept. Returns 0 on success, or -1 if the allocation failed, in which case
+// the cache is left freed.
+int av1_hbt_cache_resize(HbtCache *cache, int size_log2);
+
+void av1_hbt_cache_free(HbtCache *cache);
+
+// Invalidates all entries and hands in O(1).
+void av1_hbt_cache_reset(HbtCache *cache);
+
+// Returns the valid entry matching both hashes, or NULL on a miss.
+const HbtEntry *av1_hbt_cache_lookup(HbtCache *cache, uint32_t ctx_hash,
+                                     uint32_t qc_hash);
+
+// Returns the entry to overwrite with the result for the given hashes. The
+// caller fills in deltas and rate_cost.
+HbtEntry *av1_hbt_cache_insert(HbtCache *cache, uint32_t ctx_hash,
+                               uint32_t qc_hash);
+
+void av1_hbt_accumulate_stats(HbtStats *acc, const HbtStats *stats);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AOM_AV1_ENCODER_HASH_TRELLIS_H_
@@ -29,11 +29,48 @@ static struct lookahead_entry *pop(struct lookahead_ctx *ctx, int *idx) {
   return buf;
 }
 
+// Waits for the border extension of the most recently referenced frame.
+static void sync_border_worker(struct lookahead_ctx *ctx) {
+  if (ctx->border_pending) {
+    aom_get_worker_interface()->sync(&ctx->border_worker);
+    ctx->border_pending = NULL;
+  }
+}
+
+static int extend_border_hook(void *arg1, void *unused) {
+  struct lookahead_entry *buf = (struct lookahead_entry *)arg1;
+  (void)unused;
+  // The source aliases img, so this only writes the border.
+  av1_copy_and_extend_frame(&buf->src_img, &buf->img);
+  return 1;
+}
+
+static void release_src(const struct lookahead_src_ref *src_ref) {
+  if (src_ref)
+    src_ref->release_cb(src_ref->release_cb_priv, src_ref->user_priv);
+}
+
+// Hands a frame referenced in place back to its owner, and restores the
+// buffer owned by the entry.
+static void release_entry(struct lookahead_entry *buf) {
+  if (!buf->is_zero_copy) return;
+  buf->img = buf->alloc_img;
+  buf->is_zero_copy = 0;
+  buf->release_cb(buf->release_cb_priv, buf->user_priv);
+}
+
 void av1_lookahead_destroy(struct lookahead_ctx *ctx) {
   if (ctx) {
+    sync_border_worker(ctx);
+    if (ctx->border_worker_valid)
+      aom_get_worker_interface()->end(&ctx->border_worker);
     if (ctx->buf) {
       int i;
 
+      // Release the frames referenced in place from the oldest one.
+      for (i = 0; i < ctx->max_sz; i++) {
+        release_entry(&ctx->buf[(ctx->write_idx + i) % ctx->max_sz]);
+      }
       for (i = 0; i < ctx->max_sz; i++) aom_free_frame_buffer(&ctx->buf[i].img);
       free(ctx->buf);
     }
@@ -92,9 +129,81 @@ fail:
 
 #define USE_PARTIAL_COPY 0
 
+// Returns 1 if src can be used in place of the lookahead buffer of buf: it
+// must have the same geometry and stride, and a border at least as large,
+// which av1_copy_and_extend_frame() must not overflow.
+static int can_reference_src(const struct lookahead_entry *buf,
+                             const YV12_BUFFER_CONFIG *src, int border) {
+  const YV12_BUFFER_CONFIG *img = &buf->img;
+  if (border < img->border) return 0;
+  // av1_copy_and_extend_frame() writes 16 pixels above and to the left, and
+  // below and to the right up to the stored size, plus 16, rounded up to 64.
+  const int ext_width =
+      AOMMAX(src->y_width + 16, ALIGN_POWER_OF_TWO(src->y_width, 6));
+  const int ext_height =
+      AOMMAX(src->y_height + 16, ALIGN_POWER_OF_TWO(src->y_height, 6));
+  if (border < 16 || ext_width > src->y_width + border ||
+      ext_height > src->y_height + border)
+    return 0;
+  if (src->y_stride != img->y_stride || src->uv_stride != img->uv_stride)
+    return 0;
+  if ((src->flags & YV12_FLAG_HIGHBITDEPTH) !=
+      (img->flags & YV12_FLAG_HIGHBITDEPTH))
+    return 0;
+  if (src->y_crop_width != img->y_crop_width ||
+      src->y_crop_height != img->y_crop_height ||
+      src->uv_crop_width != img->uv_crop_width ||
+      src->uv_crop_height != img->uv_crop_height ||
+      src->subsampling_x != img->subsampling_x ||
+      src->subsampling_y != img->subsampling_y)
+    return 0;
+  const int is_hbd = (src->flags & YV12_FLAG_HIGHBITDEPTH) != 0;
+  const uint8_t *planes[3] = { src->y_buffer, src->u_buffer, src->v_buffer };
+  for (int i = 0; i < 3; ++i) {
+    const uintptr_t addr = is_hbd ? (uintptr_t)CONVERT_TO_SHORTPTR(planes[i])
+                                  : (uintptr_t)planes[i];
+    if (addr & 31) return 0;
+  }
+  return 1;
+}
+
+// Makes buf reference src, and starts extending its border.
+static void reference_src(struct lookahead_ctx *ctx,
+                          struct lookahead_entry *buf,
+                          const YV12_BUFFER_CONFIG *src,
+                          const struct lookahead_src_ref *src_ref) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  buf->alloc_img = buf->img;
+  buf->img.y_buffer = src->y_buffer;
+  buf->img.u_buffer = src->u_buffer;
+  buf->img.v_buffer = src->v_buffer;
+  buf->img.buffer_alloc = NULL;
+  buf->img.buffer_alloc_sz = 0;
+  buf->src_img = *src;
+  buf->is_zero_copy = 1;
+  buf->release_cb = src_ref->release_cb;
+  buf->release_cb_priv = src_ref->release_cb_priv;
+  buf->user_priv = src_ref->user_priv;
+
+  if (!ctx->border_worker_valid) {
+    winterface->init(&ctx->border_worker);
+    ctx->border_worker.thread_name = "aom lookahead";
+    ctx->border_worker_valid = winterface->reset(&ctx->border_worker);
+  }
+  ctx->border_worker.hook = extend_border_hook;
+  ctx->border_worker.data1 = buf;
+  ctx->border_worker.data2 = NULL;
+  ctx->border_pending = buf;
+  if (ctx->border_worker_valid)
+    winterface->launch(&ctx->border_worker);
+  else
+    winterface->execute(&ctx->border_worker);
+}
+
 int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end, int use_highbitdepth,
-                       aom_enc_frame_flags_t flags) {
+                       aom_enc_frame_flags_t flags,
+                       const struct lookahead_src_ref *src_ref) {
   struct lookahead_entry *buf;
 #if USE_PARTIAL_COPY
   int row, col, active_end;
@@ -117,6 +226,8 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
     ctx->read_ctxs[LAP_STAGE].sz++;
   }
   buf = pop(ctx, &ctx->write_idx);
+  sync_border_worker(ctx);
+  release_entry(buf);
 
   new_dimensions = width != buf->img.y_crop_width ||
                    height != buf->img.y_crop_height ||
@@ -167,7 +278,10 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
     }
   } else {
 #endif
-    if (larger_dimensions) {
+    if (src_ref && can_reference_src(buf, src, src_ref->border)) {
+      reference_src(ctx, buf, src, src_ref);
+      src_ref = NULL;
+    } else if (larger_dimensions) {
       YV12_BUFFER_CONFIG new_img;
       memset(&new_img, 0, sizeof(new_img));
       if (aom_alloc_frame_buffer(&new_img, width, height, subsampling_x,
@@ -185,10 +299,11 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
       buf->img.subsampling_y = src->subsampling_y;
     }
     // Partial copy not implemented yet
-    av1_copy_and_extend_frame(src, &buf->img);
+    if (!buf->is_zero_copy) av1_copy_and_extend_frame(src, &buf->img);
 #if USE_PARTIAL_COPY
   }
 #endif
+  release_src(src_ref);
 
   buf->ts_start = ts_start;
   buf->ts_end = ts_end;
@@ -205,6 +320,7 @@ struct lookahead_entry *av1_lookahead_pop(struct lookahead_ctx *ctx, int drain,
     if (read_ctx->sz && (drain || read_ctx->sz == read_ctx->pop_sz)) {
       buf = pop(ctx, &read_ctx->read_idx);
       read_ctx->sz--;
+      if (buf == ctx->border_pending) sync_border_worker(ctx);
     }
   }
   return buf;
@@ -236,6 +352,7 @@ struct lookahead_entry *av1_lookahead_peek(struct lookahead_ctx *ctx, int index,
     }
   }
 
+  if (buf && buf == ctx->border_pending) sync_border_worker(ctx);
   return buf;
 }
 
@@ -13,7 +13,9 @@
 #define AOM_AV1_ENCODER_LOOKAHEAD_H_
 
 #include "aom_scale/yv12config.h"
+#include "aom_util/aom_thread.h"
 #include "aom/aom_integer.h"
+#include "aom/aomcx.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,6 +31,23 @@ struct lookahead_entry {
   int64_t ts_start;
   int64_t ts_end;
   aom_enc_frame_flags_t flags;
+  // Set when img references the caller's frame (src_img) in place. The buffer
+  // owned by this entry is kept in alloc_img, and the caller's frame is handed
+  // back through release_cb when the entry is reused or destroyed.
+  int is_zero_copy;
+  YV12_BUFFER_CONFIG alloc_img;
+  YV12_BUFFER_CONFIG src_img;
+  aom_release_source_cb_fn_t release_cb;
+  void *release_cb_priv;
+  void *user_priv;
+};
+
+// A source frame that the lookahead may reference instead of copying.
+struct lookahead_src_ref {
+  int border;  // Padding around each plane, in luma pixels.
+  aom_release_source_cb_fn_t release_cb;
+  void *release_cb_priv;
+  void *user_priv;
 };
 
 // The max of past frames we want to keep in the queue.
@@ -48,6 +67,11 @@ struct lookahead_ctx {
   int write_idx;                         /* Write index */
   struct read_ctx read_ctxs[MAX_STAGES]; /* Read context */
   struct lookahead_entry *buf;           /* Buffer list */
+  // Worker extending the borders of frames referenced in place, and the entry
+  // it is working on, if any.
+  AVxWorker border_worker;
+  int border_worker_valid;
+  struct lookahead_entry *border_pending;
 };
 
 /**\brief Initializes the lookahead stage
@@ -69,19 +93,24 @@ void av1_lookahead_destroy(struct lookahead_ctx *ctx);
  * This function will copy the source image into a new framebuffer with
  * the expected stride/border.
  *
- * If active_map is non-NULL and there is only one frame in the queue, then copy
- * only active macroblocks.
+ * If src_ref is non-NULL and the source has the stride of the lookahead
+ * buffers and a large enough border, the source is referenced in place
+ * instead. Its border is then extended on a worker thread, which is joined
+ * the first time the frame is peeked or popped. Otherwise the source is
+ * copied and released right away. A source that is not enqueued because of an
+ * error is not released.
  *
  * \param[in] ctx         Pointer to the lookahead context
  * \param[in] src         Pointer to the image to enqueue
  * \param[in] ts_start    Timestamp for the start of this frame
  * \param[in] ts_end      Timestamp for the end of this frame
  * \param[in] flags       Flags set on this frame
- * \param[in] active_map  Map that specifies which macroblock is active
+ * \param[in] src_ref     Ownership of src, or NULL if src must be copied
  */
 int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end, int use_highbitdepth,
-                       aom_enc_frame_flags_t flags);
+                       aom_enc_frame_flags_t flags,
+                       const struct lookahead_src_ref *src_ref);
 
 /**\brief Get the next source buffer to encode
  *
@@ -304,10 +304,12 @@ void av1_nonrd_use_partition(AV1_COMP *cpi, ThreadData *td,
       ptree->sub_tree[1]->partition = PARTITION_NONE;
 
       pc_tree->vertical[0] = av1_alloc_pc_tree_node(
-          mi_row, mi_col, subsize, pc_tree, PARTITION_VERT, 0, 0, ss_x, ss_y);
+          mi_row, mi_col, subsize, pc_tree, PARTITION_VERT, 0, 0, ss_x, ss_y,
+          &td->shared_coeff_buf);
       pc_tree->vertical[1] =
           av1_alloc_pc_tree_node(mi_row, mi_col + hbs, subsize, pc_tree,
-                                 PARTITION_VERT, 1, 1, ss_x, ss_y);
+                                 PARTITION_VERT, 1, 1, ss_x, ss_y,
+                                 &td->shared_coeff_buf);
 
       av1_nonrd_use_partition(cpi, td, tile_data, mib, tp, mi_row, mi_col,
                               subsize, pc_tree->vertical[0],
@@ -346,10 +348,12 @@ void av1_nonrd_use_partition(AV1_COMP *cpi, ThreadData *td,
       ptree->sub_tree[1]->partition = PARTITION_NONE;
 
       pc_tree->horizontal[0] = av1_alloc_pc_tree_node(
-          mi_row, mi_col, subsize, pc_tree, PARTITION_HORZ, 0, 0, ss_x, ss_y);
+          mi_row, mi_col, subsize, pc_tree, PARTITION_HORZ, 0, 0, ss_x, ss_y,
+          &td->shared_coeff_buf);
       pc_tree->horizontal[1] =
           av1_alloc_pc_tree_node(mi_row + hbs, mi_col, subsize, pc_tree,
-                                 PARTITION_HORZ, 1, 1, ss_x, ss_y);
+                                 PARTITION_HORZ, 1, 1, ss_x, ss_y,
+                                 &td->shared_coeff_buf);
 
       av1_nonrd_use_partition(cpi, td, tile_data, mib, tp, mi_row, mi_col,
                               subsize, pc_tree->horizontal[0],
@@ -395,7 +399,7 @@ void av1_nonrd_use_partition(AV1_COMP *cpi, ThreadData *td,
 
         pc_tree->split[i] = av1_alloc_pc_tree_node(
             mi_row + y_idx, mi_col + x_idx, subsize, pc_tree, PARTITION_SPLIT,
-            i, i == 3, ss_x, ss_y);
+            i, i == 3, ss_x, ss_y, &td->shared_coeff_buf);
         av1_nonrd_use_partition(cpi, td, tile_data,
                                 mib + jj * hbs * cm->mi_stride + ii * hbs, tp,
                                 mi_row + y_idx, mi_col + x_idx, subsize,
@@ -574,7 +578,7 @@ void av1_rd_use_partition(AV1_COMP *cpi, ThreadData *td, TileDataEnc *tile_data,
   for (int i = 0; i < 4; ++i) {
     pc_tree->split[i] = av1_alloc_pc_tree_node(
         mi_row + (i >> 1) * hbh, mi_col + (i & 1) * hbw, subsize, pc_tree,
-        PARTITION_SPLIT, i, i == 3, ss_x, ss_y);
+        PARTITION_SPLIT, i, i == 3, ss_x, ss_y, &td->shared_coeff_buf);
   }
   switch (partition) {
     case PARTITION_NONE:
@@ -584,10 +588,12 @@ void av1_rd_use_partition(AV1_COMP *cpi, ThreadData *td, TileDataEnc *tile_data,
     case PARTITION_HORZ:
 #if CONFIG_EXT_RECUR_PARTITIONS
       pc_tree->horizontal[0] = av1_alloc_pc_tree_node(
-          mi_row, mi_col, subsize, pc_tree, PARTITION_HORZ, 0, 0, ss_x, ss_y);
+          mi_row, mi_col, subsize, pc_tree, PARTITION_HORZ, 0, 0, ss_x, ss_y,
+          &td->shared_coeff_buf);
       pc_tree->horizontal[1] =
           av1_alloc_pc_tree_node(mi_row + hbh, mi_col, subsize, pc_tree,
-                                 PARTITION_HORZ, 1, 1, ss_x, ss_y);
+                                 PARTITION_HORZ, 1, 1, ss_x, ss_y,
+                                 &td->shared_coeff_buf);
       av1_rd_use_partition(cpi, td, tile_data, mib, tp, mi_row, mi_col, subsize,
                            &last_part_rdc.rate, &last_part_rdc.dist, 1,
                            pc_tree->horizontal[0]);
@@ -630,10 +636,12 @@ void av1_rd_use_partition(AV1_COMP *cpi, ThreadData *td, TileDataEnc *tile_data,
     case PARTITION_VERT:
 #if CONFIG_EXT_RECUR_PARTITIONS
       pc_tree->vertical[0] = av1_alloc_pc_tree_node(
-          mi_row, mi_col, subsize, pc_tree, PARTITION_VERT, 0, 0, ss_x, ss_y);
+          mi_row, mi_col, subsize, pc_tree, PARTITION_VERT, 0, 0, ss_x, ss_y,
+          &td->shared_coeff_buf);
       pc_tree->vertical[1] =
           av1_alloc_pc_tree_node(mi_row, mi_col + hbw, subsize, pc_tree,
-                                 PARTITION_VERT, 1, 1, ss_x, ss_y);
+                                 PARTITION_VERT, 1, 1, ss_x, ss_y,
+                                 &td->shared_coeff_buf);
       av1_rd_use_partition(cpi, td, tile_data, mib, tp, mi_row, mi_col, subsize,
                            &last_part_rdc.rate, &last_part_rdc.dist, 1,
                            pc_tree->vertical[0]);
@@ -1209,7 +1217,7 @@ static INLINE void search_partition_split(
     const int y_idx = (i >> 1) * blk_params->mi_step_h;
     pc_tree->split[i] = av1_alloc_pc_tree_node(
         mi_row + y_idx, mi_col + x_idx, subsize, pc_tree, PARTITION_SPLIT, i,
-        i == 3, blk_params->ss_x, blk_params->ss_y);
+        i == 3, blk_params->ss_x, blk_params->ss_y, &td->shared_coeff_buf);
   }
 
   RD_STATS sum_rdc;
@@ -1353,10 +1361,11 @@ static INLINE void search_partition_horz(PartitionSearchState *search_state,
 #if CONFIG_EXT_RECUR_PARTITIONS
   pc_tree->horizontal[0] =
       av1_alloc_pc_tree_node(mi_row, mi_col, subsize, pc_tree, PARTITION_HORZ,
-                             0, 0, blk_params->ss_x, blk_params->ss_y);
+                             0, 0, blk_params->ss_x, blk_params->ss_y,
+                             &td->shared_coeff_buf);
   pc_tree->horizontal[1] = av1_alloc_pc_tree_node(
       mi_row + blk_params->mi_step_h, mi_col, subsize, pc_tree, PARTITION_HORZ,
-      1, 1, blk_params->ss_x, blk_params->ss_y);
+      1, 1, blk_params->ss_x, blk_params->ss_y, &td->shared_coeff_buf);
 
   if (ENABLE_FAST_RECUR_PARTITION && !frame_is_intra_only(cm) &&
       !x->must_find_valid_partition) {
@@ -1517,10 +1526,11 @@ static INLINE void search_partition_vert(PartitionSearchState *search_state,
 #if CONFIG_EXT_RECUR_PARTITIONS
   pc_tree->vertical[0] =
       av1_alloc_pc_tree_node(mi_row, mi_col, subsize, pc_tree, PARTITION_VERT,
-                             0, 0, blk_params->ss_x, blk_params->ss_y);
+                             0, 0, blk_params->ss_x, blk_params->ss_y,
+                             &td->shared_coeff_buf);
   pc_tree->vertical[1] = av1_alloc_pc_tree_node(
       mi_row, mi_col + blk_params->mi_step_w, subsize, pc_tree, PARTITION_VERT,
-      1, 1, blk_params->ss_x, blk_params->ss_y);
+      1, 1, blk_params->ss_x, blk_params->ss_y, &td->shared_coeff_buf);
 
   if (ENABLE_FAST_RECUR_PARTITION && !frame_is_intra_only(cm) &&
       !x->must_find_valid_partition) {
@@ -2296,13 +2306,15 @@ static INLINE void search_partition_horz_3(PartitionSearchState *search_state,
 
   pc_tree->horizontal3[0] = av1_alloc_pc_tree_node(
       mi_row, mi_col, subblock_sizes[0], pc_tree, PARTITION_HORZ_3, 0, 0,
-      blk_params->ss_x, blk_params->ss_y);
-  pc_tree->horizontal3[1] = av1_alloc_pc_tree_node(
-      mi_row + quarter_step, mi_col, subblock_sizes[1], pc_tree,
-      PARTITION_HORZ_3, 1, 0, blk_params->ss_x, blk_params->ss_y);
+      blk_params->ss_x, blk_params->ss_y, &td->shared_coeff_buf);
+  pc_tree->horizontal3[1] =
+      av1_alloc_pc_tree_node(mi_row + quarter_step, mi_col, subblock_sizes[1],
+                             pc_tree, PARTITION_HORZ_3, 1, 0, blk_params->ss_x,
+                             blk_params->ss_y, &td->shared_coeff_buf);
   pc_tree->horizontal3[2] = av1_alloc_pc_tree_node(
       mi_row + quarter_step * 3, mi_col, subblock_sizes[2], pc_tree,
-      PARTITION_HORZ_3, 2, 1, blk_params->ss_x, blk_params->ss_y);
+      PARTITION_HORZ_3, 2, 1, blk_params->ss_x, blk_params->ss_y,
+      &td->shared_coeff_buf);
 
   // TODO(chiyotsai@google.com): Pruning horz/vert3 gives a significant loss
   // on certain clips (e.g. galleon_cif.y4m). Need to investigate before we
@@ -2419,13 +2431,15 @@ static INLINE void search_partition_vert_3(PartitionSearchState *search_state,
 
   pc_tree->vertical3[0] = av1_alloc_pc_tree_node(
       mi_row, mi_col, subblock_sizes[0], pc_tree, PARTITION_VERT_3, 0, 0,
-      blk_params->ss_x, blk_params->ss_y);
-  pc_tree->vertical3[1] = av1_alloc_pc_tree_node(
-      mi_row, mi_col + quarter_step, subblock_sizes[1], pc_tree,
-      PARTITION_VERT_3, 1, 0, blk_params->ss_x, blk_params->ss_y);
+      blk_params->ss_x, blk_params->ss_y, &td->shared_coeff_buf);
+  pc_tree->vertical3[1] =
+      av1_alloc_pc_tree_node(mi_row, mi_col + quarter_step, subblock_sizes[1],
+                             pc_tree, PARTITION_VERT_3, 1, 0, blk_params->ss_x,
+                             blk_params->ss_y, &td->shared_coeff_buf);
   pc_tree->vertical3[2] = av1_alloc_pc_tree_node(
       mi_row, mi_col + quarter_step * 3, subblock_sizes[2], pc_tree,
-      PARTITION_VERT_3, 2, 1, blk_params->ss_x, blk_params->ss_y);
+      PARTITION_VERT_3, 2, 1, blk_params->ss_x, blk_params->ss_y,
+      &td->shared_coeff_buf);
 
   // TODO(chiyotsai@google.com): Pruning horz/vert3 gives a significant loss
   // on certain clips (e.g. galleon_cif.y4m). Need to investigate before we
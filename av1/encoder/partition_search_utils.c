@@ -1273,7 +1273,7 @@ static void sum_intra_stats(const AV1_COMMON *const cm, FRAME_COUNTS *counts,
                                   aboveleft_mi);
       av1_nn_predict_em(nn_model);
       av1_nn_backprop_em(nn_model, y_mode);
-      av1_nn_update_em(nn_model, nn_model->lr);
+      av1_nn_symbol_update_em(nn_model);
 #else
 #if CONFIG_DERIVED_INTRA_MODE
       const int is_dr_mode = av1_is_directional_mode(y_mode);
@@ -1404,7 +1404,7 @@ static void sum_intra_stats(const AV1_COMMON *const cm, FRAME_COUNTS *counts,
                                    is_cfl_allowed(xd), above_mi, left_mi);
     av1_nn_predict_em(nn_model);
     av1_nn_backprop_em(nn_model, uv_mode);
-    av1_nn_update_em(nn_model, nn_model->lr);
+    av1_nn_symbol_update_em(nn_model);
 #else
 #if CONFIG_DERIVED_INTRA_MODE
     if (av1_enable_derived_intra_mode(xd, bsize)) {
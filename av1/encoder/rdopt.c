@@ -9015,6 +9015,65 @@ static int64_t pick_wedge_fixed_sign(const AV1_COMP *const cpi,
 }
 
 #if CONFIG_SEGMENT_BASED_PARTITIONING
+// Segments the source block into the smooth mask used by arbitrary wedges and
+// returns the number of segments; the mask is only set when there are 2.
+// Results are cached per block, as every compound candidate of the block
+// needs the same mask.
+static int get_arbitrary_wedge_mask(const AV1_COMP *const cpi,
+                                    MACROBLOCK *const x, BLOCK_SIZE bsize,
+                                    uint8_t *seg_mask) {
+  const MACROBLOCKD *const xd = &x->e_mbd;
+  const int bw = block_size_wide[bsize];
+  const int bh = block_size_high[bsize];
+  const uint8_t *const src = x->plane[0].src.buf;
+  const unsigned int frame_number = cpi->common.current_frame.frame_number;
+  Av1SegmentScratch *const scratch = x->seg_scratch;
+  for (int i = 0; i < SEGMENT_MASK_CACHE_SIZE; ++i) {
+    const Av1SegmentMaskCacheEntry *const entry = &scratch->mask_cache[i];
+    if (entry->valid && entry->frame_number == frame_number &&
+        entry->mi_row == xd->mi_row && entry->mi_col == xd->mi_col &&
+        entry->bsize == bsize && entry->src == src) {
+      if (entry->num_components == 2) memcpy(seg_mask, entry->mask, bw * bh);
+      return entry->num_components;
+    }
+  }
+
+  // Get segment mask from helper library.
+  Av1SegmentParams params;
+  av1_get_default_segment_params(&params);
+  params.k = 5000;  // TODO(urvang): Temporary hack to get 2 components.
+  int num_components = -1;
+  av1_get_block_segments(src, bw, bh, x->plane[0].src.stride, &params, scratch,
+                         seg_mask, &num_components);
+  if (num_components == 2) {
+    // Convert binary mask with values {0, 1} to one with values {0, 64}.
+    av1_extend_binary_mask_range(seg_mask, bw, bh);
+#if DUMP_SEGMENT_MASKS
+    av1_dump_raw_y_plane(seg_mask, bw, bh, bw, "/tmp/2.binary_mask.yuv");
+#endif  // DUMP_SEGMENT_MASKS
+
+    // Get a smooth mask from the binary mask.
+    av1_apply_box_blur(seg_mask, bw, bh);
+#if DUMP_SEGMENT_MASKS
+    av1_dump_raw_y_plane(seg_mask, bw, bh, bw, "/tmp/3.smooth_mask.yuv");
+#endif  // DUMP_SEGMENT_MASKS
+  }
+
+  Av1SegmentMaskCacheEntry *const entry =
+      &scratch->mask_cache[scratch->mask_cache_next];
+  scratch->mask_cache_next =
+      (scratch->mask_cache_next + 1) % SEGMENT_MASK_CACHE_SIZE;
+  entry->valid = 1;
+  entry->frame_number = frame_number;
+  entry->mi_row = xd->mi_row;
+  entry->mi_col = xd->mi_col;
+  entry->bsize = bsize;
+  entry->src = src;
+  entry->num_components = num_components;
+  if (num_components == 2) memcpy(entry->mask, seg_mask, bw * bh);
+  return num_components;
+}
+
 // Create an arbitrary binary mask using spacial segmentation of this block.
 // This is used for larger blocks, where we don't have pre-defined wedges.
 static int64_t pick_arbitrary_wedge(const AV1_COMP *const cpi,
@@ -9030,29 +9089,10 @@ static int64_t pick_arbitrary_wedge(const AV1_COMP *const cpi,
                        "/tmp/1.source.yuv");
 #endif  // DUMP_SEGMENT_MASKS
 
-  // Get segment mask from helper library.
-  Av1SegmentParams params;
-  av1_get_default_segment_params(&params);
-  params.k = 5000;  // TODO(urvang): Temporary hack to get 2 components.
-  int num_components = -1;
-  av1_get_segments(x->plane[0].src.buf, bw, bh, x->plane[0].src.stride, &params,
-                   seg_mask, &num_components);
-
+  const int num_components = get_arbitrary_wedge_mask(cpi, x, bsize, seg_mask);
   if (num_components >= 2) {
     // TODO(urvang): Convert more than 2 components to 2 components.
     if (num_components == 2) {
-      // Convert binary mask with values {0, 1} to one with values {0, 64}.
-      av1_extend_binary_mask_range(seg_mask, bw, bh);
-#if DUMP_SEGMENT_MASKS
-      av1_dump_raw_y_plane(seg_mask, bw, bh, bw, "/tmp/2.binary_mask.yuv");
-#endif  // DUMP_SEGMENT_MASKS
-
-      // Get a smooth mask from the binary mask.
-      av1_apply_box_blur(seg_mask, bw, bh);
-#if DUMP_SEGMENT_MASKS
-      av1_dump_raw_y_plane(seg_mask, bw, bh, bw, "/tmp/3.smooth_mask.yuv");
-#endif  // DUMP_SEGMENT_MASKS
-
       // Get RDCost
       uint64_t sse =
           av1_wedge_sse_from_residuals(residual1, diff10, seg_mask, N);
@@ -10254,10 +10294,104 @@ static INLINE int find_comp_rd_in_stats(const AV1_COMP *const cpi,
   return 0;  // no match result found
 }
 
+// Returns 1 if the inter predictor of mbmi only depends on the fields keyed
+// by the interpolation filter stats, so that it may be cached across modes.
+static INLINE int is_interp_pred_cacheable(const MB_MODE_INFO *const mbmi) {
+#if CONFIG_DERIVED_MV
+  if (mbmi->derived_mv_allowed && mbmi->use_derived_mv) return 0;
+#endif  // CONFIG_DERIVED_MV
+  if (is_interintra_pred(mbmi)) return 0;
+  if (has_second_ref(mbmi)) {
+    // Masked compound predictors also depend on the mask parameters.
+    if (mbmi->interinter_comp.type > COMPOUND_DISTWTD) return 0;
+#if CONFIG_EXT_COMPOUND
+    // Optical flow refinement derives the MVs from the predictors.
+    if (mbmi->mode > NEW_NEWMV) return 0;
+#endif  // CONFIG_EXT_COMPOUND
+  }
+  return 1;
+}
+
+static INLINE uint8_t *get_interp_pred_buf(const MACROBLOCK *x, int slot,
+                                           int plane) {
+  return x->interp_pred_bufs +
+         (slot * MAX_MB_PLANE + plane) * 2 * MAX_SB_SQUARE;
+}
+
+static void copy_interp_pred(const uint8_t *src, int src_stride, uint8_t *dst,
+                             int dst_stride, int w, int h, int is_hbd) {
+  if (is_hbd) {
+    const uint16_t *src16 = CONVERT_TO_SHORTPTR(src);
+    uint16_t *dst16 = CONVERT_TO_SHORTPTR(dst);
+    for (int r = 0; r < h; ++r) {
+      memcpy(dst16 + r * dst_stride, src16 + r * src_stride,
+             w * sizeof(*src16));
+    }
+  } else {
+    for (int r = 0; r < h; ++r) {
+      memcpy(dst + r * dst_stride, src + r * src_stride, w);
+    }
+  }
+}
+
+// Copies (to_cache = 1) the current predictor of all planes into the given
+// slot, or (to_cache = 0) the predictor in the slot into the dst buffers.
+static void interp_pred_cache_copy(MACROBLOCK *x, int num_planes, int slot,
+                                   int to_cache) {
+  MACROBLOCKD *const xd = &x->e_mbd;
+  const int is_hbd = is_cur_buf_hbd(xd);
+  for (int plane = 0; plane < num_planes; ++plane) {
+    if (plane && !xd->mi[0]->chroma_ref_info.is_chroma_ref) break;
+    struct macroblockd_plane *const pd = &xd->plane[plane];
+    uint8_t *buf = get_interp_pred_buf(x, slot, plane);
+    if (is_hbd) buf = CONVERT_TO_BYTEPTR(buf);
+    if (to_cache) {
+      copy_interp_pred(pd->dst.buf, pd->dst.stride, buf, pd->width, pd->width,
+                       pd->height, is_hbd);
+    } else {
+      copy_interp_pred(buf, pd->width, pd->dst.buf, pd->dst.stride, pd->width,
+                       pd->height, is_hbd);
+    }
+  }
+}
+
+static INLINE void get_interp_pred_is_global(const MACROBLOCKD *const xd,
+                                             const MB_MODE_INFO *const mbmi,
+                                             int8_t *is_global) {
+  for (int i = 0; i < 2; ++i) {
+    is_global[i] = 0;
+    if (mbmi->ref_frame[i] <= INTRA_FRAME) continue;
+    const WarpedMotionParams *const wm =
+        &xd->global_motion[mbmi->ref_frame[i]];
+    is_global[i] = is_global_mv_block(mbmi, wm->wmtype);
+  }
+}
+
+// Restores the predictor saved with stats entry 'idx' into the dst buffers.
+// Returns 0 if it is not available, e.g. because the slot has been recycled.
+static int reuse_interp_pred(MACROBLOCK *x, int num_planes, int idx) {
+  const MB_MODE_INFO *const mbmi = x->e_mbd.mi[0];
+  const int comp_idx = mbmi->compound_idx;
+  const INTERPOLATION_FILTER_STATS *st = &x->interp_filter_stats[comp_idx][idx];
+  const int slot = st->pred_slot;
+  if (slot < 0 ||
+      x->interp_pred_owner[slot] != comp_idx * MAX_INTERP_FILTER_STATS + idx ||
+      !is_interp_pred_cacheable(mbmi))
+    return 0;
+  // Global motion blocks may be warped, even if the mv is the same.
+  int8_t is_global[2];
+  get_interp_pred_is_global(&x->e_mbd, mbmi, is_global);
+  if (is_global[0] != st->is_global[0] || is_global[1] != st->is_global[1])
+    return 0;
+  interp_pred_cache_copy(x, num_planes, slot, 0);
+  return 1;
+}
+
 static INLINE void save_interp_filter_search_stat(MACROBLOCK *x,
                                                   MB_MODE_INFO *const mbmi,
                                                   int64_t rd,
-                                                  unsigned int pred_sse) {
+                                                  unsigned int pred_sse,
+                                                  int num_planes) {
   const int comp_idx = mbmi->compound_idx;
   const int offset = x->interp_filter_stats_idx[comp_idx];
   if (offset < MAX_INTERP_FILTER_STATS) {
@@ -10267,12 +10401,22 @@ static INLINE void save_interp_filter_search_stat(MACROBLOCK *x,
                                           mbmi->ref_frame[1] },
                                         mbmi->interinter_comp.type,
                                         rd,
-                                        pred_sse };
+                                        pred_sse,
+                                        -1,
+                                        { 0, 0 } };
 #if CONFIG_DERIVED_MV
     if (mbmi->derived_mv_allowed && mbmi->use_derived_mv) {
       stat.mv[0].as_mv = mbmi->derived_mv[0];
     }
 #endif  // CONFIG_DERIVED_MV
+    if (is_interp_pred_cacheable(mbmi)) {
+      const int slot = x->interp_pred_next_slot;
+      x->interp_pred_next_slot = (slot + 1) % MAX_INTERP_PRED_SLOTS;
+      x->interp_pred_owner[slot] = comp_idx * MAX_INTERP_FILTER_STATS + offset;
+      stat.pred_slot = slot;
+      get_interp_pred_is_global(&x->e_mbd, mbmi, stat.is_global);
+      interp_pred_cache_copy(x, num_planes, slot, 1);
+    }
     x->interp_filter_stats[comp_idx][offset] = stat;
     x->interp_filter_stats_idx[comp_idx]++;
   }
@@ -10419,6 +10563,8 @@ static int64_t interpolation_filter_search(
     *rd = x->interp_filter_stats[comp_idx][match_found_idx].rd;
     x->pred_sse[ref_frame] =
         x->interp_filter_stats[comp_idx][match_found_idx].pred_sse;
+    if (!*skip_build_pred && reuse_interp_pred(x, num_planes, match_found_idx))
+      *skip_build_pred = 1;
     return 0;
   }
 
@@ -10535,7 +10681,8 @@ static int64_t interpolation_filter_search(
   // save search results
   if (cpi->sf.skip_repeat_interpolation_filter_search) {
     assert(match_found_idx == -1);
-    save_interp_filter_search_stat(x, mbmi, *rd, x->pred_sse[ref_frame]);
+    save_interp_filter_search_stat(x, mbmi, *rd, x->pred_sse[ref_frame],
+                                   num_planes);
   }
   return 0;
 }
@@ -13108,118 +13255,6 @@ static int64_t handle_inter_mode(AV1_COMP *const cpi, TileDataEnc *tile_data,
   return RDCOST(x->rdmult, rd_stats->rate, rd_stats->dist);
 }
 
-#if CONFIG_EXT_IBC_MODES
-static void rd_intrabc_allocate_sb(uint16_t **InputBlock, uint16_t width,
-                                   uint16_t height) {
-  (*InputBlock) = (uint16_t *)aom_malloc(width * height * sizeof(uint16_t));
-}
-
-static void rd_intrabc_extract_source_sb(MACROBLOCK *x, uint16_t *InputBlock,
-                                         uint16_t width, uint16_t height) {
-  uint16_t src_stride = x->plane[0].src.stride;
-
-  uint16_t *pixelStartAddr = CONVERT_TO_SHORTPTR(x->plane[0].src.buf);
-  uint16_t size = (width << 1);
-
-  for (int rows = 0; rows < height; ++rows) {
-    memcpy(InputBlock, pixelStartAddr, size);
-    InputBlock += width;
-    pixelStartAddr += src_stride;
-  }
-}
-
-static void rd_intrabc_copy_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                               uint16_t width, uint16_t height) {
-  uint16_t size = (width << 1);
-
-  // Copy block
-  for (int rows = 0; rows < height; ++rows) {
-    memcpy(DstBlock, SrcBlock, size);
-    DstBlock += 128;
-    SrcBlock += width;
-  }
-}
-
-static void rd_intrabc_rotate90_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                                   uint16_t width, uint16_t height) {
-  // Rotate Block by 90 degrees
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[cols * 128 + (height - 1 - rows)] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-
-static void rd_intrabc_rotate180_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                                    uint16_t width, uint16_t height) {
-  // Rotate Block by 180 degrees
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[(height - 1 - rows) * 128 + (width - 1 - cols)] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-
-static void rd_intrabc_rotate270_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                                    uint16_t width, uint16_t height) {
-  // Rotate Block by 270 degrees
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[(width - 1 - cols) * 128 + rows] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-
-static void rd_intrabc_mirror0_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                                  uint16_t width, uint16_t height) {
-  uint16_t size = (width << 1);
-
-  // Mirror Block across the 0 degree axis
-  DstBlock += (height - 1) * 128;
-  for (int rows = 0; rows < height; ++rows) {
-    memcpy(DstBlock, SrcBlock, size);
-    DstBlock -= 128;
-    SrcBlock += width;
-  }
-}
-
-static void rd_intrabc_mirror45_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                                   uint16_t width, uint16_t height) {
-  // Mirror Block across the 45 degree axis
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[(width - 1 - cols) * 128 + (height - 1 - rows)] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-
-static void rd_intrabc_mirror90_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                                   uint16_t width, uint16_t height) {
-  // Mirror Block across the 90 degree axis
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[rows * 128 + (width - 1 - cols)] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-
-static void rd_intrabc_mirror135_sb(uint16_t *DstBlock, uint16_t *SrcBlock,
-                                    uint16_t width, uint16_t height) {
-  // Mirror Block across the 135 degree axis
-  for (int rows = 0; rows < height; ++rows) {
-    for (int cols = 0; cols < width; ++cols) {
-      DstBlock[cols * 128 + rows] = SrcBlock[cols];
-    }
-    SrcBlock += width;
-  }
-}
-#endif  // CONFIG_EXT_IBC_MODES
-
 static int64_t rd_pick_intrabc_mode_sb(const AV1_COMP *cpi, MACROBLOCK *x,
                                        RD_STATS *rd_stats, BLOCK_SIZE bsize,
                                        int64_t best_rd) {
@@ -13288,46 +13323,22 @@ static int64_t rd_pick_intrabc_mode_sb(const AV1_COMP *cpi, MACROBLOCK *x,
   uint8_t best_blk_skip[MAX_MIB_SIZE * MAX_MIB_SIZE] = { 0 };
 
 #if CONFIG_EXT_IBC_MODES
-  uint16_t *src_block = NULL;
-
-  // Iterate through all IBC & IBC+ Modes
-  // Allocate & Store Source block
-  rd_intrabc_allocate_sb(&src_block, w, h);
-  rd_intrabc_extract_source_sb(x, src_block, w, h);
-
-  for (IBC_MODE ibcMode = ROTATION_0; ibcMode <= cm->max_ibc_mode; ++ibcMode) {
-    // Translate Source Block & Update Source Pointer for search
-    switch (ibcMode) {
-      case ROTATION_0: rd_intrabc_copy_sb(x->ibc_src, src_block, w, h); break;
-
-      case MIRROR_90:
-        rd_intrabc_mirror90_sb(x->ibc_src, src_block, w, h);
-        break;
-
-      case MIRROR_0: rd_intrabc_mirror0_sb(x->ibc_src, src_block, w, h); break;
-
-      case ROTATION_180:
-        rd_intrabc_rotate180_sb(x->ibc_src, src_block, w, h);
-        break;
-
-      case ROTATION_90:
-        rd_intrabc_rotate90_sb(x->ibc_src, src_block, w, h);
-        break;
-
-      case MIRROR_135:
-        rd_intrabc_mirror135_sb(x->ibc_src, src_block, w, h);
-        break;
-
-      case MIRROR_45:
-        rd_intrabc_mirror45_sb(x->ibc_src, src_block, w, h);
-        break;
-
-      case ROTATION_270:
-        rd_intrabc_rotate270_sb(x->ibc_src, src_block, w, h);
-        break;
-
-      default: break;
-    }
+  // Build the source block in every orientation to be searched from a single
+  // read of the source. Blocks larger than MAX_IBC_BLK_SIZE only use IBC.
+  const int num_ibc_modes =
+      (w > MAX_IBC_BLK_SIZE || h > MAX_IBC_BLK_SIZE) ? 1
+                                                     : cm->max_ibc_mode + 1;
+  uint16_t *ibc_src_modes[IBC_MODES];
+  for (int i = 0; i < num_ibc_modes; ++i) {
+    ibc_src_modes[i] = x->ibc_src_buf + i * MAX_SB_SQUARE;
+  }
+  av1_intrabc_transform_all_sb(ibc_src_modes, MAX_SB_SIZE,
+                               CONVERT_TO_SHORTPTR(x->plane[0].src.buf),
+                               x->plane[0].src.stride, w, h, num_ibc_modes);
+
+  for (int mode = ROTATION_0; mode < num_ibc_modes; ++mode) {
+    const IBC_MODE ibcMode = (IBC_MODE)mode;
+    x->ibc_src = ibc_src_modes[ibcMode];
 #endif  // CONFIG_EXT_IBC_MODES
 
     for (enum IntrabcMotionDirection dir = IBC_MOTION_ABOVE;
@@ -13497,13 +13508,7 @@ static int64_t rd_pick_intrabc_mode_sb(const AV1_COMP *cpi, MACROBLOCK *x,
     }
 
 #if CONFIG_EXT_IBC_MODES
-    // Disable IBC+ Mode Search for Shapes > MaxIBCBlockSize
-    if (ibcMode == ROTATION_0 && (w > MAX_IBC_BLK_SIZE || h > MAX_IBC_BLK_SIZE))
-      break;
   }
-
-  // DeAllocate source block
-  aom_free(src_block);
 #endif  // CONFIG_EXT_IBC_MODES
 
   *mbmi = best_mbmi;
@@ -14351,6 +14356,7 @@ static void set_params_rd_pick_inter_mode(
   if (cpi->sf.skip_repeat_interpolation_filter_search) {
     x->interp_filter_stats_idx[0] = 0;
     x->interp_filter_stats_idx[1] = 0;
+    x->interp_pred_next_slot = 0;
   }
   x->comp_rd_stats_idx = 0;
 }
@@ -16328,6 +16334,7 @@ static void set_params_nonrd_pick_inter_mode(
   if (cpi->sf.skip_repeat_interpolation_filter_search) {
     x->interp_filter_stats_idx[0] = 0;
     x->interp_filter_stats_idx[1] = 0;
+    x->interp_pred_next_slot = 0;
   }
 }
 
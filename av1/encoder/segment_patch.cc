@@ -1,6 +1,9 @@
 #include <assert.h>
+#include <math.h>
+#include <stdlib.h>
 #include <unordered_map>
 
+#include "aom_dsp/aom_dsp_common.h"
 #include "aom_mem/aom_mem.h"
 #include "av1/common/enums.h"
 #include "av1/encoder/segment_patch.h"
@@ -64,8 +67,214 @@ extern "C" void av1_get_segments(const uint8_t *input, int width, int height,
       segment_image(input_rgb, seg_params->sigma, seg_params->k,
                     seg_params->min_size, num_components);
   rgb_to_segment_index(output_rgb, output);
+  delete input_rgb;
+  delete output_rgb;
 }
 
+#define SEG_MAX_TAPS 8
+
+// Integer version of the Gaussian kernel of the generic segmenter, in Q8.
+// Returns the number of taps on each side, including the center one.
+static int get_smooth_kernel(float sigma, int *taps) {
+  sigma = AOMMAX(sigma, 0.01f);
+  const int len = AOMMIN((int)ceil(sigma * 4.0) + 1, SEG_MAX_TAPS);
+  double mask[SEG_MAX_TAPS];
+  double sum = 0;
+  for (int i = 0; i < len; ++i) {
+    mask[i] = exp(-0.5 * (i / sigma) * (i / sigma));
+    sum += (i == 0) ? mask[i] : 2 * mask[i];
+  }
+  int side_sum = 0;
+  for (int i = 1; i < len; ++i) {
+    taps[i] = (int)(mask[i] / sum * 256 + 0.5);
+    side_sum += taps[i];
+  }
+  taps[0] = 256 - 2 * side_sum;
+  return len;
+}
+
+// Separable smoothing with replicated borders, from 8-bit to Q8 samples.
+static void smooth_luma(const uint8_t *input, int width, int height,
+                        int stride, float sigma, uint16_t *tmp,
+                        uint16_t *dst) {
+  int taps[SEG_MAX_TAPS];
+  const int len = get_smooth_kernel(sigma, taps);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t *const src = input + y * stride;
+    for (int x = 0; x < width; ++x) {
+      int sum = taps[0] * src[x];
+      for (int i = 1; i < len; ++i) {
+        sum +=
+            taps[i] * (src[AOMMAX(x - i, 0)] + src[AOMMIN(x + i, width - 1)]);
+      }
+      tmp[y * width + x] = (uint16_t)sum;
+    }
+  }
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int sum = taps[0] * tmp[y * width + x];
+      for (int i = 1; i < len; ++i) {
+        sum += taps[i] * (tmp[AOMMAX(y - i, 0) * width + x] +
+                          tmp[AOMMIN(y + i, height - 1) * width + x]);
+      }
+      dst[y * width + x] = (uint16_t)((sum + 128) >> 8);
+    }
+  }
+}
+
+// Edge directions, from the vertex packed in an edge to its other end.
+enum { EDGE_RIGHT, EDGE_DOWN, EDGE_DOWN_RIGHT, EDGE_UP_RIGHT };
+
+static INLINE uint32_t pack_edge(const uint16_t *smooth, int a, int b,
+                                 int dir) {
+  const int w = abs(smooth[a] - smooth[b]);
+  return ((uint32_t)w << 16) | ((uint32_t)a << 2) | (uint32_t)dir;
+}
+
+static INLINE int edge_end(uint32_t edge, int width) {
+  const int a = (edge >> 2) & 0x3fff;
+  static const int kDx[4] = { 1, 0, 1, 1 };
+  static const int kDy[4] = { 0, 1, 1, -1 };
+  return a + kDy[edge & 3] * width + kDx[edge & 3];
+}
+
+// Builds the 8-connected pixel graph, with the same edges as the generic
+// segmenter, and returns the number of edges.
+static int build_edges(const uint16_t *smooth, int width, int height,
+                       uint32_t *edges) {
+  int num = 0;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const int a = y * width + x;
+      if (x < width - 1) {
+        edges[num++] = pack_edge(smooth, a, a + 1, EDGE_RIGHT);
+      }
+      if (y < height - 1) {
+        edges[num++] = pack_edge(smooth, a, a + width, EDGE_DOWN);
+      }
+      if (x < width - 1 && y < height - 1) {
+        edges[num++] = pack_edge(smooth, a, a + width + 1, EDGE_DOWN_RIGHT);
+      }
+      if (x < width - 1 && y > 0) {
+        edges[num++] = pack_edge(smooth, a, a - width + 1, EDGE_UP_RIGHT);
+      }
+    }
+  }
+  return num;
+}
+
+// Stable LSD radix sort of the edges on their 16-bit weights. Returns the
+// array holding the sorted edges, which is either 'edges' or 'tmp'.
+static uint32_t *sort_edges(uint32_t *edges, uint32_t *tmp, int num) {
+  uint32_t max_edge = 0;
+  for (int i = 0; i < num; ++i) max_edge = AOMMAX(max_edge, edges[i]);
+  const int passes = (max_edge >> 24) ? 2 : 1;
+  uint32_t *src = edges;
+  uint32_t *dst = tmp;
+  for (int pass = 0; pass < passes; ++pass) {
+    const int shift = 16 + 8 * pass;
+    int offsets[256] = { 0 };
+    for (int i = 0; i < num; ++i) ++offsets[(src[i] >> shift) & 0xff];
+    int total = 0;
+    for (int k = 0; k < 256; ++k) {
+      const int count = offsets[k];
+      offsets[k] = total;
+      total += count;
+    }
+    for (int i = 0; i < num; ++i) {
+      dst[offsets[(src[i] >> shift) & 0xff]++] = src[i];
+    }
+    uint32_t *const swap = src;
+    src = dst;
+    dst = swap;
+  }
+  return src;
+}
+
+static INLINE int uf_find(int32_t *parent, int x) {
+  int root = x;
+  while (parent[root] != root) root = parent[root];
+  while (parent[x] != root) {
+    const int next = parent[x];
+    parent[x] = root;
+    x = next;
+  }
+  return root;
+}
+
+// Joins the sets with roots x and y, and returns the root of the union.
+static INLINE int uf_join(Av1SegmentScratch *scratch, int x, int y) {
+  if (scratch->rank[x] > scratch->rank[y]) {
+    const int swap = x;
+    x = y;
+    y = swap;
+  } else if (scratch->rank[x] == scratch->rank[y]) {
+    ++scratch->rank[y];
+  }
+  scratch->parent[x] = y;
+  scratch->size[y] += scratch->size[x];
+  return y;
+}
+
+extern "C" void av1_get_block_segments(const uint8_t *input, int width,
+                                       int height, int stride,
+                                       const Av1SegmentParams *seg_params,
+                                       Av1SegmentScratch *scratch,
+                                       uint8_t *output, int *num_components) {
+  const int num_vertices = width * height;
+  assert(num_vertices <= MAX_SB_SQUARE);
+  smooth_luma(input, width, height, stride, seg_params->sigma,
+              scratch->smooth_tmp, scratch->smooth);
+  const int num_edges =
+      build_edges(scratch->smooth, width, height, scratch->edges);
+  const uint32_t *const edges =
+      sort_edges(scratch->edges, scratch->sorted_edges, num_edges);
+
+  // Weights are in Q8 luma steps, while the generic segmenter measures color
+  // distances over 3 equal channels, i.e. sqrt(3) times the luma step.
+  const double k_scaled = seg_params->k * 256.0 / sqrt(3.0);
+  const uint32_t k = (uint32_t)AOMMIN(k_scaled + 0.5, (double)(1u << 30));
+  for (int i = 0; i < num_vertices; ++i) {
+    scratch->parent[i] = i;
+    scratch->size[i] = 1;
+    scratch->rank[i] = 0;
+    scratch->threshold[i] = k;
+  }
+  int num_sets = num_vertices;
+  for (int i = 0; i < num_edges; ++i) {
+    const uint32_t w = edges[i] >> 16;
+    const int a = uf_find(scratch->parent, (edges[i] >> 2) & 0x3fff);
+    const int b = uf_find(scratch->parent, edge_end(edges[i], width));
+    if (a != b && w <= scratch->threshold[a] && w <= scratch->threshold[b]) {
+      const int root = uf_join(scratch, a, b);
+      scratch->threshold[root] = w + k / scratch->size[root];
+      --num_sets;
+    }
+  }
+
+  // Merge components smaller than min_size with their neighbors.
+  for (int i = 0; i < num_edges; ++i) {
+    const int a = uf_find(scratch->parent, (edges[i] >> 2) & 0x3fff);
+    const int b = uf_find(scratch->parent, edge_end(edges[i], width));
+    if (a != b && (scratch->size[a] < seg_params->min_size ||
+                   scratch->size[b] < seg_params->min_size)) {
+      uf_join(scratch, a, b);
+      --num_sets;
+    }
+  }
+  *num_components = num_sets;
+
+  // Number the segments in raster order of their first pixel.
+  for (int i = 0; i < num_vertices; ++i) scratch->label[i] = -1;
+  int next_label = 0;
+  for (int i = 0; i < num_vertices; ++i) {
+    const int root = uf_find(scratch->parent, i);
+    if (scratch->label[root] < 0) scratch->label[root] = next_label++;
+    output[i] = (uint8_t)scratch->label[root];
+  }
+}
+#undef SEG_MAX_TAPS
+
 // Amend mask with values {0,1} to one with values {0,64}.
 extern "C" void av1_extend_binary_mask_range(uint8_t *const mask, int w,
                                              int h) {
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include "aom/aom_integer.h"
+#include "av1/common/enums.h"
 
 // Struct for parameters related to segmentation.
 typedef struct {
@@ -32,6 +33,49 @@ void av1_get_segments(const uint8_t *input, int width, int height, int stride,
                       const Av1SegmentParams *seg_params, uint8_t *output,
                       int *num_components);
 
+// Number of blocks whose final masks are kept in Av1SegmentScratch.
+#define SEGMENT_MASK_CACHE_SIZE 4
+
+// Final compound mask of one source block, see Av1SegmentScratch.
+typedef struct {
+  int valid;
+  unsigned int frame_number;
+  int mi_row;
+  int mi_col;
+  int bsize;
+  const uint8_t *src;
+  int num_components;
+  uint8_t mask[MAX_SB_SQUARE];
+} Av1SegmentMaskCacheEntry;
+
+// Per-thread working memory of av1_get_block_segments(), sized for the
+// largest superblock so that segmenting a block needs no allocation.
+typedef struct Av1SegmentScratch {
+  uint16_t smooth_tmp[MAX_SB_SQUARE];  // Horizontally smoothed luma (Q8).
+  uint16_t smooth[MAX_SB_SQUARE];      // Smoothed luma (Q8).
+  // Graph edges, each packed as (weight << 16) | (vertex << 2) | direction.
+  uint32_t edges[4 * MAX_SB_SQUARE];
+  uint32_t sorted_edges[4 * MAX_SB_SQUARE];
+  // Union-find forest over the pixels of the block.
+  int32_t parent[MAX_SB_SQUARE];
+  int32_t size[MAX_SB_SQUARE];
+  uint32_t threshold[MAX_SB_SQUARE];
+  uint8_t rank[MAX_SB_SQUARE];
+  int16_t label[MAX_SB_SQUARE];
+  // Masks of the blocks segmented last, as the compound search segments the
+  // same source block once per reference pair and partition path.
+  Av1SegmentMaskCacheEntry mask_cache[SEGMENT_MASK_CACHE_SIZE];
+  int mask_cache_next;
+} Av1SegmentScratch;
+
+// Same as av1_get_segments(), for a luma block of at most MAX_SB_SQUARE
+// pixels. Uses integer edge weights and the pre-allocated 'scratch', so the
+// result may differ slightly from that of av1_get_segments().
+void av1_get_block_segments(const uint8_t *input, int width, int height,
+                            int stride, const Av1SegmentParams *seg_params,
+                            Av1SegmentScratch *scratch, uint8_t *output,
+                            int *num_components);
+
 // Amend mask with values {0,1} to one with values {0,64}.
 // Input/output:
 // - mask: Binary mask that is modified in-place.
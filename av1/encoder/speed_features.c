@@ -898,7 +898,11 @@ void av1_set_speed_features_framesize_independent(AV1_COMP *cpi, int speed) {
   sf->use_fast_interpolation_filter_search = 0;
   sf->disable_dual_filter = 0;
   sf->skip_repeat_interpolation_filter_search = 0;
+#if CONFIG_HTB_TRELLIS
+  sf->use_hash_based_trellis = oxcf->hash_trellis_size > 0;
+#else
   sf->use_hash_based_trellis = 0;
+#endif  // CONFIG_HTB_TRELLIS
   sf->prune_comp_search_by_single_result = 0;
   sf->skip_repeated_newmv = 0;
   // TODO(any) Cleanup this speed feature
@@ -500,3 +500,173 @@ void av1_get_nz_map_contexts_sse2(const uint8_t *const levels,
   else
     coeff_contexts[pos] = 3;
 }
+
+static INLINE __m128i get_br_contexts_kernel_sse2(const __m128i *const level) {
+  // levels[] may sum past 255: saturate, since any sum above 11 gives 6.
+  __m128i mag = _mm_adds_epu8(level[0], level[1]);
+  mag = _mm_adds_epu8(mag, level[2]);
+  mag = _mm_avg_epu8(mag, _mm_setzero_si128());
+  return _mm_min_epu8(mag, _mm_set1_epi8(6));
+}
+
+static INLINE void get_4_br_contexts(const uint8_t *levels, const int height,
+                                     const ptrdiff_t *const offsets,
+                                     const __m128i *const pos_to_offset,
+                                     int8_t *br_contexts) {
+  const int stride = 4 + TX_PAD_HOR;
+  __m128i offset = pos_to_offset[0];
+  __m128i level[3];
+  int row = height;
+
+  do {
+    level[0] = load_8bit_4x4_to_1_reg_sse2(levels + offsets[0], stride);
+    level[1] = load_8bit_4x4_to_1_reg_sse2(levels + offsets[1], stride);
+    level[2] = load_8bit_4x4_to_1_reg_sse2(levels + offsets[2], stride);
+    _mm_store_si128((__m128i *)br_contexts,
+                    _mm_add_epi8(get_br_contexts_kernel_sse2(level), offset));
+    offset = pos_to_offset[1];
+    levels += 4 * stride;
+    br_contexts += 16;
+    row -= 4;
+  } while (row);
+}
+
+static INLINE void get_8_br_contexts(const uint8_t *levels, const int height,
+                                     const ptrdiff_t *const offsets,
+                                     const __m128i *const pos_to_offset,
+                                     int8_t *br_contexts) {
+  const int stride = 8 + TX_PAD_HOR;
+  __m128i offset = pos_to_offset[0];
+  __m128i level[3];
+  int row = height;
+
+  do {
+    level[0] = load_8bit_8x2_to_1_reg_sse2(levels + offsets[0], stride);
+    level[1] = load_8bit_8x2_to_1_reg_sse2(levels + offsets[1], stride);
+    level[2] = load_8bit_8x2_to_1_reg_sse2(levels + offsets[2], stride);
+    _mm_store_si128((__m128i *)br_contexts,
+                    _mm_add_epi8(get_br_contexts_kernel_sse2(level), offset));
+    offset = pos_to_offset[1];
+    levels += 2 * stride;
+    br_contexts += 16;
+    row -= 2;
+  } while (row);
+}
+
+// pos_to_offset[] holds the offsets of the first 16 columns of row 0, of the
+// other columns of row 0, of the first 16 columns of row 1 and of the first 16
+// columns of the rows below. The other columns of rows 1 and below are all 14.
+static INLINE void get_16n_br_contexts(const uint8_t *levels, const int width,
+                                       const int height,
+                                       const ptrdiff_t *const offsets,
+                                       const __m128i *const pos_to_offset,
+                                       int8_t *br_contexts) {
+  const __m128i const_14 = _mm_set1_epi8(14);
+  __m128i offset[2] = { pos_to_offset[0], pos_to_offset[1] };
+  __m128i level[3];
+  int row = 0;
+
+  assert(!(width % 16));
+
+  do {
+    int w = 0;
+
+    do {
+      level[0] = _mm_loadu_si128((__m128i *)(levels + w + offsets[0]));
+      level[1] = _mm_loadu_si128((__m128i *)(levels + w + offsets[1]));
+      level[2] = _mm_loadu_si128((__m128i *)(levels + w + offsets[2]));
+      _mm_store_si128(
+          (__m128i *)(br_contexts + w),
+          _mm_add_epi8(get_br_contexts_kernel_sse2(level), offset[w != 0]));
+      w += 16;
+    } while (w < width);
+
+    offset[0] = pos_to_offset[row ? 3 : 2];
+    offset[1] = const_14;
+    levels += width + TX_PAD_HOR;
+    br_contexts += width;
+  } while (++row < height);
+}
+
+// Note: computes the contexts of the whole block, whatever the eob.
+void av1_get_br_contexts_sse2(const uint8_t *const levels,
+                              const int16_t *const scan, const uint16_t eob,
+                              const TX_SIZE tx_size, const TX_CLASS tx_class,
+                              int8_t *const br_contexts) {
+  const int width = get_txb_wide(tx_size);
+  const int height = get_txb_high(tx_size);
+  const int stride = width + TX_PAD_HOR;
+  ptrdiff_t offsets[3];
+  __m128i pos_to_offset[4];
+
+  (void)scan;
+  (void)eob;
+  /* br_contexts must be 16 byte aligned. */
+  assert(!((intptr_t)br_contexts & 0xf));
+
+  offsets[0] = 1;
+  offsets[1] = stride;
+  if (tx_class == TX_CLASS_2D) {
+    offsets[2] = stride + 1;
+    pos_to_offset[1] = _mm_set1_epi8(14);
+    if (width == 4) {
+      pos_to_offset[0] = _mm_setr_epi8(0, 7, 14, 14, 7, 7, 14, 14, 14, 14, 14,
+                                       14, 14, 14, 14, 14);
+    } else if (width == 8) {
+      pos_to_offset[0] = _mm_setr_epi8(0, 7, 14, 14, 14, 14, 14, 14, 7, 7, 14,
+                                       14, 14, 14, 14, 14);
+    } else {
+      pos_to_offset[0] = _mm_setr_epi8(0, 7, 14, 14, 14, 14, 14, 14, 14, 14,
+                                       14, 14, 14, 14, 14, 14);
+      pos_to_offset[2] = _mm_setr_epi8(7, 7, 14, 14, 14, 14, 14, 14, 14, 14,
+                                       14, 14, 14, 14, 14, 14);
+      pos_to_offset[3] = pos_to_offset[1];
+    }
+  } else if (tx_class == TX_CLASS_HORIZ) {
+    offsets[2] = 2;
+    if (width == 4) {
+      pos_to_offset[0] = _mm_setr_epi8(0, 14, 14, 14, 7, 14, 14, 14, 7, 14,
+                                       14, 14, 7, 14, 14, 14);
+      pos_to_offset[1] = _mm_setr_epi8(7, 14, 14, 14, 7, 14, 14, 14, 7, 14,
+                                       14, 14, 7, 14, 14, 14);
+    } else if (width == 8) {
+      pos_to_offset[0] = _mm_setr_epi8(0, 14, 14, 14, 14, 14, 14, 14, 7, 14,
+                                       14, 14, 14, 14, 14, 14);
+      pos_to_offset[1] = _mm_setr_epi8(7, 14, 14, 14, 14, 14, 14, 14, 7, 14,
+                                       14, 14, 14, 14, 14, 14);
+    } else {
+      pos_to_offset[0] = _mm_setr_epi8(0, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+                                       14, 14, 14, 14, 14, 14);
+      pos_to_offset[1] = _mm_set1_epi8(14);
+      pos_to_offset[2] = _mm_setr_epi8(7, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+                                       14, 14, 14, 14, 14, 14);
+      pos_to_offset[3] = pos_to_offset[2];
+    }
+  } else {  // TX_CLASS_VERT
+    offsets[2] = 2 * stride;
+    if (width == 4) {
+      pos_to_offset[0] = _mm_setr_epi8(0, 7, 7, 7, 14, 14, 14, 14, 14, 14, 14,
+                                       14, 14, 14, 14, 14);
+      pos_to_offset[1] = _mm_set1_epi8(14);
+    } else if (width == 8) {
+      pos_to_offset[0] = _mm_setr_epi8(0, 7, 7, 7, 7, 7, 7, 7, 14, 14, 14, 14,
+                                       14, 14, 14, 14);
+      pos_to_offset[1] = _mm_set1_epi8(14);
+    } else {
+      pos_to_offset[0] =
+          _mm_setr_epi8(0, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7);
+      pos_to_offset[1] = _mm_set1_epi8(7);
+      pos_to_offset[2] = _mm_set1_epi8(14);
+      pos_to_offset[3] = pos_to_offset[2];
+    }
+  }
+
+  if (width == 4) {
+    get_4_br_contexts(levels, height, offsets, pos_to_offset, br_contexts);
+  } else if (width == 8) {
+    get_8_br_contexts(levels, height, offsets, pos_to_offset, br_contexts);
+  } else {
+    get_16n_br_contexts(levels, width, height, offsets, pos_to_offset,
+                        br_contexts);
+  }
+}
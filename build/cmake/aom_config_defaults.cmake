@@ -94,6 +94,8 @@ set_aom_config_var(CONFIG_ACCOUNTING 0 "Enables bit accounting.")
 set_aom_config_var(CONFIG_ANALYZER 0 "Enables bit stream analyzer.")
 set_aom_config_var(CONFIG_COEFFICIENT_RANGE_CHECKING 0
                    "Coefficient range check.")
+set_aom_config_var(CONFIG_EC_WINDOW_64 0
+                   "Use a 64-bit entropy decoder window.")
 set_aom_config_var(CONFIG_DENOISE 1
                    "Denoise/noise modeling support in encoder.")
 set_aom_config_var(CONFIG_FILEOPTIONS 1 "Enables encoder config file support.")
@@ -108,3 +108,35 @@ int ivf_read_frame(FILE *infile, uint8_t **buffer, size_t *bytes_read,
 
   return 1;
 }
+
+int ivf_read_frame_mapped(struct AvxInputContext *input_ctx,
+                          const uint8_t **buffer, size_t *bytes_read,
+                          aom_codec_pts_t *pts) {
+  const uint8_t *const header =
+      input_ctx->mapped_data + input_ctx->mapped_offset;
+  const size_t bytes_left = input_ctx->mapped_size - input_ctx->mapped_offset;
+  size_t frame_size;
+
+  if (bytes_left < IVF_FRAME_HDR_SZ) {
+    if (bytes_left > 0) warn("Failed to read frame size");
+    return 1;
+  }
+  frame_size = mem_get_le32(header);
+  if (frame_size > 256 * 1024 * 1024) {
+    warn("Read invalid frame size (%u)", (unsigned int)frame_size);
+    frame_size = 0;
+  }
+  if (frame_size > bytes_left - IVF_FRAME_HDR_SZ) {
+    warn("Failed to read full frame");
+    return 1;
+  }
+  if (pts) {
+    *pts = mem_get_le32(header + 4);
+    *pts += ((aom_codec_pts_t)mem_get_le32(header + 8) << 32);
+  }
+
+  *buffer = header + IVF_FRAME_HDR_SZ;
+  *bytes_read = frame_size;
+  input_ctx->mapped_offset += IVF_FRAME_HDR_SZ + frame_size;
+  return 0;
+}
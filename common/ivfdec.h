@@ -21,6 +21,12 @@ int file_is_ivf(struct AvxInputContext *input);
 int ivf_read_frame(FILE *infile, uint8_t **buffer, size_t *bytes_read,
                    size_t *buffer_size, aom_codec_pts_t *pts);
 
+// Like ivf_read_frame(), but for a file mapped by aom_map_input_file(): points
+// buffer at the frame in the mapping, without copying it.
+int ivf_read_frame_mapped(struct AvxInputContext *input_ctx,
+                          const uint8_t **buffer, size_t *bytes_read,
+                          aom_codec_pts_t *pts);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
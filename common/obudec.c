@@ -482,4 +482,61 @@ int obudec_read_temporal_unit(struct ObuDecInputContext *obu_ctx,
   return 0;
 }
 
+int obudec_read_temporal_unit_mapped(struct ObuDecInputContext *obu_ctx,
+                                     const uint8_t **buffer,
+                                     size_t *bytes_read) {
+  struct AvxInputContext *avx_ctx = obu_ctx->avx_ctx;
+
+  // The bytes that file_is_obu() buffered start the first temporal unit.
+  if (obu_ctx->bytes_buffered > 0) {
+    assert(avx_ctx->mapped_offset >= obu_ctx->bytes_buffered);
+    avx_ctx->mapped_offset -= obu_ctx->bytes_buffered;
+    obu_ctx->bytes_buffered = 0;
+  }
+
+  const uint8_t *const data = avx_ctx->mapped_data + avx_ctx->mapped_offset;
+  const size_t bytes_left = avx_ctx->mapped_size - avx_ctx->mapped_offset;
+  size_t tu_size = 0;
+
+  *bytes_read = 0;
+  if (bytes_left == 0) return 1;
+
+  if (obu_ctx->is_annexb) {
+    uint64_t size = 0;
+    size_t length_of_temporal_unit_size = 0;
+    if (aom_uleb_decode(data, bytes_left, &size,
+                        &length_of_temporal_unit_size) != 0) {
+      fprintf(stderr, "obudec: Failure reading temporal unit header\n");
+      return -1;
+    }
+    if (size > bytes_left - length_of_temporal_unit_size) {
+      fprintf(stderr, "obudec: Failed to read full temporal unit\n");
+      return -1;
+    }
+    tu_size = length_of_temporal_unit_size + (size_t)size;
+  } else {
+    // The temporal unit runs up to the next temporal delimiter.
+    while (tu_size < bytes_left) {
+      ObuHeader obu_header;
+      size_t payload_length = 0;
+      size_t header_size = 0;
+      memset(&obu_header, 0, sizeof(obu_header));
+      if (aom_read_obu_header_and_size(data + tu_size, bytes_left - tu_size, 0,
+                                       &obu_header, &payload_length,
+                                       &header_size) != AOM_CODEC_OK ||
+          payload_length > bytes_left - tu_size - header_size) {
+        fprintf(stderr, "obudec: read_one_obu failed in TU loop\n");
+        return -1;
+      }
+      if (obu_header.type == OBU_TEMPORAL_DELIMITER && tu_size > 0) break;
+      tu_size += header_size + payload_length;
+    }
+  }
+
+  *buffer = data;
+  *bytes_read = tu_size;
+  avx_ctx->mapped_offset += tu_size;
+  return 0;
+}
+
 void obudec_free(struct ObuDecInputContext *obu_ctx) { free(obu_ctx->buffer); }
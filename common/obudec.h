@@ -39,6 +39,13 @@ int obudec_read_temporal_unit(struct ObuDecInputContext *obu_ctx,
                               uint8_t **buffer, size_t *bytes_read,
                               size_t *buffer_size);
 
+// Like obudec_read_temporal_unit(), but for a file mapped by
+// aom_map_input_file(): points 'buffer' at the Temporal Unit in the mapping,
+// without copying it.
+int obudec_read_temporal_unit_mapped(struct ObuDecInputContext *obu_ctx,
+                                     const uint8_t **buffer,
+                                     size_t *bytes_read);
+
 void obudec_free(struct ObuDecInputContext *obu_ctx);
 
 #ifdef __cplusplus
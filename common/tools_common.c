@@ -9,6 +9,12 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+// Enable POSIX extensions in glibc so that we can call fileno() and
+// posix_madvise(). This must be before any #include statements.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "common/tools_common.h"
 
 #include <math.h>
@@ -25,6 +31,12 @@
 #include "aom/aomdx.h"
 #endif
 
+#if CONFIG_OS_SUPPORT && HAVE_UNISTD_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #if defined(_WIN32) || defined(__OS2__)
 #include <io.h>
 #include <fcntl.h>
@@ -55,6 +67,42 @@ FILE *set_binary_mode(FILE *stream) {
   return stream;
 }
 
+int aom_map_input_file(struct AvxInputContext *input_ctx) {
+#if CONFIG_OS_SUPPORT && HAVE_UNISTD_H
+  const int fd = fileno(input_ctx->file);
+  struct stat st;
+  const long offset = ftell(input_ctx->file);
+  if (offset < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size < offset || (uint64_t)st.st_size > SIZE_MAX) {
+    return -1;
+  }
+  void *const data =
+      mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) return -1;
+#if defined(POSIX_MADV_SEQUENTIAL)
+  posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+  input_ctx->mapped_data = (const uint8_t *)data;
+  input_ctx->mapped_size = (size_t)st.st_size;
+  input_ctx->mapped_offset = (size_t)offset;
+  return 0;
+#else
+  (void)input_ctx;
+  return -1;
+#endif
+}
+
+void aom_unmap_input_file(struct AvxInputContext *input_ctx) {
+#if CONFIG_OS_SUPPORT && HAVE_UNISTD_H
+  if (input_ctx->mapped_data != NULL) {
+    munmap((void *)input_ctx->mapped_data, input_ctx->mapped_size);
+  }
+#endif
+  input_ctx->mapped_data = NULL;
+  input_ctx->mapped_size = 0;
+  input_ctx->mapped_offset = 0;
+}
+
 void die(const char *fmt, ...) {
   LOG_ERROR(NULL);
   usage_exit();
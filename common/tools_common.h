@@ -116,6 +116,12 @@ struct AvxInputContext {
 #if CONFIG_AV1_ENCODER
   y4m_input y4m;
 #endif
+  // The whole file, once mapped by aom_map_input_file(). The readers then
+  // return pointers into it instead of copying the frames, and mapped_offset
+  // is their read position.
+  const uint8_t *mapped_data;
+  size_t mapped_size;
+  size_t mapped_offset;
 };
 
 #ifdef __cplusplus
@@ -144,6 +150,12 @@ void usage_exit(void) AOM_NO_RETURN;
 
 int read_yuv_frame(struct AvxInputContext *input_ctx, aom_image_t *yuv_frame);
 
+// Maps the input file read-only into memory, with mapped_offset at the current
+// position of input_ctx->file. Returns 0 on success, or -1 if the file cannot
+// be mapped (stdin, pipes, or no mmap() on this platform).
+int aom_map_input_file(struct AvxInputContext *input_ctx);
+void aom_unmap_input_file(struct AvxInputContext *input_ctx);
+
 typedef struct AvxInterface {
   const char *const name;
   const uint32_t fourcc;
@@ -118,9 +118,10 @@ int file_is_webm(struct WebmInputContext *webm_ctx,
   return 1;
 }
 
-int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
-                    size_t *bytes_read, size_t *buffer_size) {
-  assert(webm_ctx->buffer == *buffer);
+// Advances to the next frame of the video track.
+// Returns 0 on success, 1 at the end of the stream and -1 on error.
+static int next_frame(struct WebmInputContext *webm_ctx,
+                      const mkvparser::Block::Frame **frame) {
   // This check is needed for frame parallel decoding, in which case this
   // function could be called even after it has reached end of input stream.
   if (webm_ctx->reached_eos) {
@@ -144,7 +145,6 @@ int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
     } else if (block_entry_eos || block_entry->EOS()) {
       cluster = segment->GetNext(cluster);
       if (cluster == NULL || cluster->EOS()) {
-        *bytes_read = 0;
         webm_ctx->reached_eos = 1;
         return 1;
       }
@@ -176,25 +176,54 @@ int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
   webm_ctx->block_entry = block_entry;
   webm_ctx->block = block;
 
-  const mkvparser::Block::Frame &frame =
-      block->GetFrame(webm_ctx->block_frame_index);
+  *frame = &block->GetFrame(webm_ctx->block_frame_index);
   ++webm_ctx->block_frame_index;
-  if (frame.len > static_cast<long>(*buffer_size)) {
+  webm_ctx->timestamp_ns = block->GetTime(cluster);
+  webm_ctx->is_key_frame = block->IsKey();
+  return 0;
+}
+
+int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
+                    size_t *bytes_read, size_t *buffer_size) {
+  assert(webm_ctx->buffer == *buffer);
+  const mkvparser::Block::Frame *frame = NULL;
+  const int status = next_frame(webm_ctx, &frame);
+  if (status) {
+    if (status == 1) *bytes_read = 0;
+    return status;
+  }
+  if (frame->len > static_cast<long>(*buffer_size)) {
     delete[] * buffer;
-    *buffer = new uint8_t[frame.len];
+    *buffer = new uint8_t[frame->len];
     webm_ctx->buffer = *buffer;
     if (*buffer == NULL) {
       return -1;
     }
-    *buffer_size = frame.len;
+    *buffer_size = frame->len;
   }
-  *bytes_read = frame.len;
-  webm_ctx->timestamp_ns = block->GetTime(cluster);
-  webm_ctx->is_key_frame = block->IsKey();
+  *bytes_read = frame->len;
 
   mkvparser::MkvReader *const reader =
       reinterpret_cast<mkvparser::MkvReader *>(webm_ctx->reader);
-  return frame.Read(reader, *buffer) ? -1 : 0;
+  return frame->Read(reader, *buffer) ? -1 : 0;
+}
+
+int webm_read_frame_mapped(struct WebmInputContext *webm_ctx,
+                           const struct AvxInputContext *aom_ctx,
+                           const uint8_t **buffer, size_t *bytes_read) {
+  const mkvparser::Block::Frame *frame = NULL;
+  *bytes_read = 0;
+  const int status = next_frame(webm_ctx, &frame);
+  if (status) return status;
+  if (frame->pos < 0 || frame->len < 0 ||
+      static_cast<uint64_t>(frame->pos) > aom_ctx->mapped_size ||
+      static_cast<uint64_t>(frame->len) >
+          aom_ctx->mapped_size - static_cast<size_t>(frame->pos)) {
+    return -1;
+  }
+  *buffer = aom_ctx->mapped_data + frame->pos;
+  *bytes_read = frame->len;
+  return 0;
 }
 
 int webm_guess_framerate(struct WebmInputContext *webm_ctx,
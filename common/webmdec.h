@@ -57,6 +57,12 @@ int file_is_webm(struct WebmInputContext *webm_ctx,
 int webm_read_frame(struct WebmInputContext *webm_ctx, uint8_t **buffer,
                     size_t *bytes_read, size_t *buffer_size);
 
+// Like webm_read_frame(), but for a file mapped by aom_map_input_file():
+// points |buffer| at the frame in the mapping, without copying it.
+int webm_read_frame_mapped(struct WebmInputContext *webm_ctx,
+                           const struct AvxInputContext *aom_ctx,
+                           const uint8_t **buffer, size_t *bytes_read);
+
 // Guesses the frame rate of the input file based on the container timestamps.
 int webm_guess_framerate(struct WebmInputContext *webm_ctx,
                          struct AvxInputContext *aom_ctx);
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+#include "config/av1_rtcd.h"
+
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "av1/common/common_data.h"
+
+#if CONFIG_ADAPT_FILTER_INTRA && HAVE_SSE2
+namespace {
+
+using libaom_test::ACMRandom;
+
+const int kBorder = 16;
+const int kStride = 160;
+const int kRows = 160;
+const int kNumStats = 14;
+
+template <typename Pixel>
+void FillRandom(ACMRandom *rnd, Pixel *buf, int n, int bd) {
+  for (int i = 0; i < n; ++i) buf[i] = rnd->Rand16() & ((1 << bd) - 1);
+}
+
+// Picks a region that has at least one valid pixel around it, like the
+// training regions of the predictor.
+template <typename Pixel, typename AccumFunc>
+void RunAccumTest(AccumFunc ref_func, AccumFunc test_func, int bd) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  Pixel *buf = new Pixel[kStride * kRows];
+  for (int iter = 0; iter < 2000; ++iter) {
+    FillRandom(&rnd, buf, kStride * kRows, bd);
+    const int narrow = iter & 1;
+    const int w = narrow ? rnd.PseudoUniform(9) - 1 : rnd.PseudoUniform(100);
+    const int h = narrow ? rnd.PseudoUniform(100) : rnd.PseudoUniform(9) - 1;
+    const int mode = rnd.PseudoUniform(ADAPT_FILTER_INTRA_MODES);
+    const Pixel *src = buf + kBorder * kStride + kBorder;
+    int64_t ref_stats[kNumStats] = { 0 };
+    int64_t test_stats[kNumStats] = { 0 };
+    ref_func(src, kStride, w, h, mode, ref_stats);
+    test_func(src, kStride, w, h, mode, test_stats);
+    for (int k = 0; k < kNumStats; ++k) {
+      ASSERT_EQ(ref_stats[k], test_stats[k])
+          << "stat " << k << " mode " << mode << " " << w << "x" << h;
+    }
+  }
+  delete[] buf;
+  libaom_test::ClearSystemState();
+}
+
+TEST(AdaptFilterIntraTest, AccumSse2MatchesC) {
+  RunAccumTest<uint8_t>(av1_adapt_filter_intra_accum_c,
+                        av1_adapt_filter_intra_accum_sse2, 8);
+}
+
+TEST(AdaptFilterIntraTest, AccumHbdSse2MatchesC) {
+  RunAccumTest<uint16_t>(av1_adapt_filter_intra_accum_hbd_c,
+                         av1_adapt_filter_intra_accum_hbd_sse2, 12);
+}
+
+template <typename Pixel, typename PredFunc>
+void RunPredTest(PredFunc ref_func, PredFunc test_func, int bd) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  Pixel edge[2 * (2 * MAX_TX_SIZE + 1)];
+  Pixel *const above = edge + 1;
+  Pixel *const left = edge + 2 * MAX_TX_SIZE + 2;
+  Pixel ref_dst[MAX_TX_SIZE * MAX_TX_SIZE];
+  Pixel test_dst[MAX_TX_SIZE * MAX_TX_SIZE];
+  for (int tx_size = 0; tx_size < TX_SIZES_ALL; ++tx_size) {
+    const int bw = tx_size_wide[tx_size];
+    const int bh = tx_size_high[tx_size];
+    for (int mode = 0; mode < ADAPT_FILTER_INTRA_MODES; ++mode) {
+      for (int iter = 0; iter < 20; ++iter) {
+        FillRandom(&rnd, edge, 2 * (2 * MAX_TX_SIZE + 1), bd);
+        // Coefficients roughly summing up to 1, as fitted ones do.
+        double filt[4];
+        double sum = 0;
+        for (int k = 0; k < 4; ++k) {
+          filt[k] = (rnd.PseudoUniform(2001) - 500) / 1000.0;
+          sum += filt[k];
+        }
+        for (int k = 0; k < 4; ++k) filt[k] /= sum;
+        ref_func(ref_dst, bw, (TX_SIZE)tx_size, filt, above, left, mode);
+        test_func(test_dst, bw, (TX_SIZE)tx_size, filt, above, left, mode);
+        for (int i = 0; i < bw * bh; ++i) {
+          ASSERT_EQ(ref_dst[i], test_dst[i])
+              << "pixel " << i << " mode " << mode << " " << bw << "x" << bh;
+        }
+      }
+    }
+  }
+  libaom_test::ClearSystemState();
+}
+
+TEST(AdaptFilterIntraTest, PredSse2MatchesC) {
+  RunPredTest<uint8_t>(av1_adapt_filter_intra_pred_c,
+                       av1_adapt_filter_intra_pred_sse2, 8);
+}
+
+TEST(AdaptFilterIntraTest, PredHbdSse2MatchesC) {
+  RunPredTest<uint16_t>(av1_adapt_filter_intra_pred_hbd_c,
+                        av1_adapt_filter_intra_pred_hbd_sse2, 10);
+}
+
+}  // namespace
+#endif  // CONFIG_ADAPT_FILTER_INTRA && HAVE_SSE2
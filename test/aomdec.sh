@@ -57,6 +57,39 @@ aomdec() {
   eval "${AOM_TEST_PREFIX}" "${decoder}" "$input" "$@" ${devnull}
 }
 
+# Runs aomdec on $1 and prints the MD5 sum of the decoded frames. All remaining
+# parameters are passed through to aomdec.
+aomdec_md5() {
+  local decoder="$(aom_tool_path aomdec)"
+  local input="$1"
+  shift
+  eval "${AOM_TEST_PREFIX}" "${decoder}" "$input" --md5 "$@" 2> /dev/null \
+      | awk '{print $1}'
+}
+
+# Decodes $1 with and without --mmap, and checks that the decoded frames are
+# the same. All remaining parameters are passed through to aomdec. An input of
+# - is read from the file named by $file, through a pipe.
+aomdec_mmap_matches() {
+  local input="$1"
+  shift
+  local expected_md5
+  local actual_md5
+  if [ "${input}" = "-" ]; then
+    expected_md5="$(cat "${file}" | aomdec_md5 - "$@")"
+    actual_md5="$(cat "${file}" | aomdec_md5 - --mmap "$@")"
+  else
+    expected_md5="$(aomdec_md5 "${input}" "$@")"
+    actual_md5="$(aomdec_md5 "${input}" --mmap "$@")"
+  fi
+  if [ -z "${expected_md5}" ] || [ "${actual_md5}" != "${expected_md5}" ]; then
+    elog "MD5 mismatch with --mmap:"
+    elog "Expected: ${expected_md5}"
+    elog "Actual: ${actual_md5}"
+    return 1
+  fi
+}
+
 aomdec_can_decode_av1() {
   if [ "$(av1_decode_available)" = "yes" ]; then
     echo yes
@@ -136,12 +169,69 @@ aomdec_av1_webm() {
   fi
 }
 
+aomdec_av1_ivf_mmap() {
+  if [ "$(aomdec_can_decode_av1)" = "yes" ]; then
+    local file="${AV1_IVF_FILE}"
+    if [ ! -e "${file}" ]; then
+      encode_yuv_raw_input_av1 "${file}" --ivf
+    fi
+    aomdec_mmap_matches "${file}"
+  fi
+}
+
+# --mmap cannot map a pipe, and falls back to reading it.
+aomdec_av1_ivf_mmap_pipe_input() {
+  if [ "$(aomdec_can_decode_av1)" = "yes" ]; then
+    local file="${AV1_IVF_FILE}"
+    if [ ! -e "${file}" ]; then
+      encode_yuv_raw_input_av1 "${file}" --ivf
+    fi
+    aomdec_mmap_matches -
+  fi
+}
+
+aomdec_av1_obu_annexb_mmap() {
+  if [ "$(aomdec_can_decode_av1)" = "yes" ]; then
+    local file="${AV1_OBU_ANNEXB_FILE}"
+    if [ ! -e "${file}" ]; then
+      encode_yuv_raw_input_av1 "${file}" --obu --annexb=1
+    fi
+    aomdec_mmap_matches "${file}" --annexb
+  fi
+}
+
+aomdec_av1_obu_section5_mmap() {
+  if [ "$(aomdec_can_decode_av1)" = "yes" ]; then
+    local file="${AV1_OBU_SEC5_FILE}"
+    if [ ! -e "${file}" ]; then
+      encode_yuv_raw_input_av1 "${file}" --obu
+    fi
+    aomdec_mmap_matches "${file}"
+  fi
+}
+
+aomdec_av1_webm_mmap() {
+  if [ "$(aomdec_can_decode_av1)" = "yes" ] && \
+     [ "$(webm_io_available)" = "yes" ]; then
+    local file="${AV1_WEBM_FILE}"
+    if [ ! -e "${file}" ]; then
+      encode_yuv_raw_input_av1 "${file}"
+    fi
+    aomdec_mmap_matches "${file}"
+  fi
+}
+
 aomdec_tests="aomdec_av1_ivf
               aomdec_av1_ivf_error_resilient
               aomdec_av1_ivf_multithread
               aomdec_aom_ivf_pipe_input
               aomdec_av1_obu_annexb
               aomdec_av1_obu_section5
-              aomdec_av1_webm"
+              aomdec_av1_webm
+              aomdec_av1_ivf_mmap
+              aomdec_av1_ivf_mmap_pipe_input
+              aomdec_av1_obu_annexb_mmap
+              aomdec_av1_obu_section5_mmap
+              aomdec_av1_webm_mmap"
 
 run_tests aomdec_verify_environment "${aomdec_tests}"
@@ -10,15 +10,19 @@
  */
 
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <vector>
+
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "test/acm_random.h"
 #include "aom/aom_integer.h"
 #include "aom_dsp/bitreader.h"
 #include "aom_dsp/bitwriter.h"
+#include "aom_ports/aom_timer.h"
 
 using libaom_test::ACMRandom;
 
@@ -171,3 +175,46 @@ TEST(AV1, TestHasOverflowed) {
     ASSERT_TRUE(aom_reader_has_overflowed(&br));
   }
 }
+
+// Measures the decoder symbol throughput on a mix of bools and 8-ary symbols.
+TEST(AV1, DISABLED_ReaderSpeed) {
+  const int kSymbols = 1 << 20;
+  const int kRuns = 20;
+  static const aom_cdf_prob kCdf[CDF_SIZE(8)] = { AOM_CDF8(
+      8192, 14336, 19456, 23552, 26624, 29696, 31744) };
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  std::vector<int> symbols(kSymbols);
+  std::vector<int> probas(kSymbols);
+  for (int i = 0; i < kSymbols; ++i) {
+    probas[i] = (i & 1) ? -1 : 1 + rnd(255);
+    symbols[i] = (i & 1) ? rnd(8) : rnd(256) >= probas[i];
+  }
+
+  std::vector<uint8_t> buffer(kSymbols * 2);
+  aom_writer bw;
+  aom_start_encode(&bw, &buffer[0]);
+  for (int i = 0; i < kSymbols; ++i) {
+    if (probas[i] < 0) {
+      aom_write_cdf(&bw, symbols[i], kCdf, 8);
+    } else {
+      aom_write(&bw, symbols[i], probas[i]);
+    }
+  }
+  aom_stop_encode(&bw);
+
+  aom_usec_timer timer;
+  aom_usec_timer_start(&timer);
+  for (int run = 0; run < kRuns; ++run) {
+    aom_reader br;
+    aom_reader_init(&br, &buffer[0], bw.pos);
+    for (int i = 0; i < kSymbols; ++i) {
+      const int symbol = probas[i] < 0 ? aom_read_cdf(&br, kCdf, 8, NULL)
+                                       : aom_read(&br, probas[i], NULL);
+      GTEST_ASSERT_EQ(symbol, symbols[i]) << "pos: " << i;
+    }
+  }
+  aom_usec_timer_mark(&timer);
+  const int64_t elapsed = aom_usec_timer_elapsed(&timer);
+  printf("%d symbols from %u bytes: %.2f Msymbols/s\n", kSymbols, bw.pos,
+         static_cast<double>(kSymbols) * kRuns / AOMMAX(elapsed, 1));
+}
@@ -310,7 +310,7 @@ TEST_F(CNNTest, TestMultilayerConvolution) {
   // of the offset.
   AssignLayerWeightsBiases(&cnn_config, weights, bias);
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected_same, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -387,7 +387,7 @@ TEST_F(CNNTest, TestRELUSingleLayer) {
                                 0,                  // output_num
                             } } };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected_same, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -469,7 +469,7 @@ TEST_F(CNNTest, TestVaryingStridesVaryingDimImages) {
     41, -26, 5, 76, 13, 83, -21, 53, -54, -14, 21, 121,
   };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected_1, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -553,7 +553,7 @@ TEST_F(CNNTest, TestMaxPool) {
                                 0,                  // output_num
                             } } };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -633,7 +633,7 @@ TEST_F(CNNTest, TestDeconvolveNonActivationSingleLayerSingleKernel) {
                                 0,                  // output_num
                             } } };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected_1_same, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -909,7 +909,7 @@ TEST_F(CNNTest, TestLargeKernelsAndStrides) {
   int image_height = 10;
   int image_width = 11;
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input_10x11, expected_10x11,
              &cnn_config, image_width, &thread_data, MSE_INT_TOL);
@@ -1058,7 +1058,7 @@ TEST_F(CNNTest, TestSoftsignSingleLayer) {
                                 0,                  // output_num
                             } } };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected_same, &cnn_config,
              image_width, &thread_data, MSE_FLOAT_TOL);
@@ -1244,7 +1244,7 @@ TEST_F(CNNTest, TestBranchTensorAdd) {
   // of the offset.
   AssignLayerWeightsBiases(&cnn_config, weights, bias);
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -1420,7 +1420,7 @@ TEST_F(CNNTest, TestBranchTensorConcatenation) {
   // of the offset.
   AssignLayerWeightsBiases(&cnn_config, weights, bias);
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -1697,10 +1697,27 @@ TEST_F(CNNTest, TestBranchCombinations) {
   // of the offset.
   AssignLayerWeightsBiases(&cnn_config, weights, bias);
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
+
+  // Keep the tensors in a restoration scratch. The second run must reuse the
+  // buffers of the first one.
+  RestorationScratch scratch;
+  av1_rst_scratch_init(&scratch);
+  thread_data.scratch = &scratch;
+
+  RunCNNTest(image_width, image_height, input, expected, &cnn_config,
+             image_width, &thread_data, MSE_INT_TOL);
+  const int num_allocs = scratch.num_allocs;
+  EXPECT_GT(num_allocs, 0);
+
+  RunCNNTest(image_width, image_height, input, expected, &cnn_config,
+             image_width, &thread_data, MSE_INT_TOL);
+  EXPECT_EQ(num_allocs, scratch.num_allocs);
+
+  av1_rst_scratch_free(&scratch);
 }
 
 TEST_F(CNNTest, TestSplittingTensors) {
@@ -1812,7 +1829,7 @@ TEST_F(CNNTest, TestSplittingTensors) {
   // of the offset.
   AssignLayerWeightsBiases(&cnn_config, weights, bias);
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_INT_TOL);
@@ -1920,7 +1937,7 @@ TEST_F(CNNTest, TestOutputChannelsCount) {
   // of the offset.
   AssignLayerWeightsBiases(&cnn_config, weights, bias);
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_FLOAT_TOL);
@@ -2150,7 +2167,7 @@ TEST_F(CNNTest, TestBatchNorm) {
     },
   };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_FLOAT_TOL);
@@ -2215,7 +2232,7 @@ TEST_F(CNNTest, TestMultithreading) {
     },
   };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_FLOAT_TOL);
@@ -2227,7 +2244,7 @@ TEST_F(CNNTest, TestMultithreading) {
     winterface->init(&workers[i]);
   }
 
-  thread_data = { 4, workers };
+  thread_data = { 4, workers, NULL };
 
   RunCNNTest(image_width, image_height, input, expected, &cnn_config,
              image_width, &thread_data, MSE_FLOAT_TOL);
@@ -2462,7 +2479,7 @@ TEST_F(CNNTest, TestMultiOutput) {
     },
   };
 
-  CNN_THREAD_DATA thread_data = { 1, NULL };
+  CNN_THREAD_DATA thread_data = { 1, NULL, NULL };
 
   const int num_outputs = 4;
   const int output_chs[4] = { filter_dim, filter_dim, filter_dim,
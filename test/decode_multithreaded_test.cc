@@ -13,6 +13,8 @@
 #include <cstdlib>
 #include <string>
 
+#include "config/aom_config.h"
+
 #include "aom_mem/aom_mem.h"
 #include "test/codec_factory.h"
 #include "test/encode_test_driver.h"
@@ -157,8 +159,10 @@ TEST_P(AV1DecodeMultiThreadedTestLarge, MD5Match) {
 }
 
 // TODO(ranjit): More tests have to be added using pre-generated MD5.
-AV1_INSTANTIATE_TEST_CASE(AV1DecodeMultiThreadedTest, ::testing::Values(1, 2),
-                          ::testing::Values(1, 2), ::testing::Values(1),
+// 0 tile columns and rows give a single tile, decoded by several row workers.
+AV1_INSTANTIATE_TEST_CASE(AV1DecodeMultiThreadedTest,
+                          ::testing::Values(0, 1, 2),
+                          ::testing::Values(0, 1, 2), ::testing::Values(1),
                           ::testing::Values(3), ::testing::Values(0, 1));
 AV1_INSTANTIATE_TEST_CASE(AV1DecodeMultiThreadedTestLarge,
                           ::testing::Values(0, 1, 2, 6),
@@ -182,4 +186,209 @@ AV1_INSTANTIATE_TEST_CASE(AV1DecodeMultiThreadedLSTestLarge,
                           ::testing::Values(1), ::testing::Values(0, 3),
                           ::testing::Values(0, 1));
 
+#if CONFIG_CNN_RESTORATION
+// On one thread the CNN restores the planes of a frame in turn. With more
+// threads, U and V are restored as one batch on a tile worker while the main
+// thread restores Y. Both must give the same frames. The CNN is in the loop,
+// so the encoder, which restores the frames on as many threads, must also
+// match the single thread decoder of the test driver.
+class AV1DecodeCnnRestorationTest
+    : public ::libaom_test::CodecTestWithParam<int>,
+      public ::libaom_test::EncoderTest {
+ protected:
+  AV1DecodeCnnRestorationTest()
+      : EncoderTest(GET_PARAM(0)), num_threads_(GET_PARAM(1)) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.allow_lowbitdepth = 1;
+    cfg.threads = 1;
+    single_thread_dec_ = codec_->CreateDecoder(cfg, 0);
+    cfg.threads = num_threads_;
+    multi_thread_dec_ = codec_->CreateDecoder(cfg, 0);
+  }
+
+  virtual ~AV1DecodeCnnRestorationTest() {
+    delete single_thread_dec_;
+    delete multi_thread_dec_;
+  }
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(libaom_test::kOnePassGood);
+  }
+
+  virtual void PreEncodeFrameHook(libaom_test::VideoSource *video,
+                                  libaom_test::Encoder *encoder) {
+    if (video->frame() == 0) {
+      encoder->Control(AOME_SET_CPUUSED, 4);
+      // Above MIN_CNN_Q_INDEX, where the frames may use the CNN.
+      encoder->Control(AOME_SET_CQ_LEVEL, 40);
+    }
+  }
+
+  void UpdateMD5(::libaom_test::Decoder *dec, const aom_codec_cx_pkt_t *pkt,
+                 ::libaom_test::MD5 *md5) {
+    const aom_codec_err_t res = dec->DecodeFrame(
+        reinterpret_cast<uint8_t *>(pkt->data.frame.buf), pkt->data.frame.sz);
+    if (res != AOM_CODEC_OK) {
+      abort_ = true;
+      ASSERT_EQ(AOM_CODEC_OK, res);
+    }
+    const aom_image_t *img = dec->GetDxData().Next();
+    if (img) md5->Add(img);
+  }
+
+  virtual void FramePktHook(const aom_codec_cx_pkt_t *pkt) {
+    UpdateMD5(single_thread_dec_, pkt, &md5_single_thread_);
+    UpdateMD5(multi_thread_dec_, pkt, &md5_multi_thread_);
+  }
+
+  ::libaom_test::MD5 md5_single_thread_;
+  ::libaom_test::MD5 md5_multi_thread_;
+  ::libaom_test::Decoder *single_thread_dec_;
+  ::libaom_test::Decoder *multi_thread_dec_;
+  int num_threads_;
+};
+
+TEST_P(AV1DecodeCnnRestorationTest, MD5Match) {
+  cfg_.rc_end_usage = AOM_Q;
+  cfg_.g_lag_in_frames = 0;
+  cfg_.g_threads = num_threads_;
+  libaom_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288,
+                                     30, 1, 0, 5);
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  ASSERT_STREQ(md5_single_thread_.Get(), md5_multi_thread_.Get());
+}
+
+AV1_INSTANTIATE_TEST_CASE(AV1DecodeCnnRestorationTest, ::testing::Values(2, 4));
+#endif  // CONFIG_CNN_RESTORATION
+
+// Frame parallel decoding outputs the frames a few temporal units later, so the
+// decoders are flushed and all the frames of the stream are compared.
+class AV1DecodeFrameParallelTest
+    : public ::libaom_test::CodecTestWith2Params<int, int>,
+      public ::libaom_test::EncoderTest {
+ protected:
+  AV1DecodeFrameParallelTest()
+      : EncoderTest(GET_PARAM(0)), film_grain_test_vector_(0),
+        n_tile_cols_(GET_PARAM(1)), lag_in_frames_(GET_PARAM(2)) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.w = 352;
+    cfg.h = 288;
+    cfg.threads = 1;
+    cfg.allow_lowbitdepth = 1;
+    single_thread_dec_ = codec_->CreateDecoder(cfg, 0);
+
+    // Test cfg.threads == powers of 2, the last one above the number of frame
+    // workers.
+    for (int i = 0; i < kNumMultiThreadDecoders; ++i) {
+      cfg.threads <<= 1;
+      frame_parallel_dec_[i] = codec_->CreateDecoder(cfg, 0);
+      frame_parallel_dec_[i]->Control(AV1D_SET_FRAME_PARALLEL, 1);
+    }
+  }
+
+  virtual ~AV1DecodeFrameParallelTest() {
+    delete single_thread_dec_;
+    for (int i = 0; i < kNumMultiThreadDecoders; ++i)
+      delete frame_parallel_dec_[i];
+  }
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(libaom_test::kTwoPassGood);
+  }
+
+  virtual void PreEncodeFrameHook(libaom_test::VideoSource *video,
+                                  libaom_test::Encoder *encoder) {
+    if (video->frame() == 0) {
+      encoder->Control(AV1E_SET_TILE_COLUMNS, n_tile_cols_);
+      encoder->Control(AOME_SET_CPUUSED, 5);
+      encoder->Control(AV1E_SET_FILM_GRAIN_TEST_VECTOR,
+                       film_grain_test_vector_);
+    }
+  }
+
+  void Decode(::libaom_test::Decoder *dec, const uint8_t *data, size_t size,
+              ::libaom_test::MD5 *md5, int *num_frames) {
+    const aom_codec_err_t res = dec->DecodeFrame(data, size);
+    if (res != AOM_CODEC_OK) {
+      abort_ = true;
+      ASSERT_EQ(AOM_CODEC_OK, res);
+    }
+    ::libaom_test::DxDataIterator dec_iter = dec->GetDxData();
+    const aom_image_t *img;
+    while ((img = dec_iter.Next()) != NULL) {
+      md5->Add(img);
+      ++*num_frames;
+    }
+  }
+
+  virtual void FramePktHook(const aom_codec_cx_pkt_t *pkt) {
+    const uint8_t *const data = static_cast<uint8_t *>(pkt->data.frame.buf);
+    Decode(single_thread_dec_, data, pkt->data.frame.sz, &md5_single_thread_,
+           &num_frames_single_thread_);
+    for (int i = 0; i < kNumMultiThreadDecoders; ++i) {
+      Decode(frame_parallel_dec_[i], data, pkt->data.frame.sz,
+             &md5_frame_parallel_[i], &num_frames_frame_parallel_[i]);
+    }
+  }
+
+  void DoTest() {
+    const aom_rational timebase = { 33333333, 1000000000 };
+    cfg_.g_timebase = timebase;
+    cfg_.rc_target_bitrate = 500;
+    cfg_.g_lag_in_frames = lag_in_frames_;
+    cfg_.rc_end_usage = AOM_VBR;
+
+    libaom_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288,
+                                       timebase.den, timebase.num, 0, 20);
+    ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+    for (int i = 0; i < kNumMultiThreadDecoders; ++i) {
+      // With film grain, a flush may not return all the frames at once.
+      int num_frames;
+      do {
+        num_frames = num_frames_frame_parallel_[i];
+        ASSERT_NO_FATAL_FAILURE(Decode(frame_parallel_dec_[i], NULL, 0,
+                                       &md5_frame_parallel_[i],
+                                       &num_frames_frame_parallel_[i]));
+      } while (num_frames_frame_parallel_[i] != num_frames);
+      EXPECT_EQ(num_frames_single_thread_, num_frames_frame_parallel_[i]);
+      ASSERT_STREQ(md5_single_thread_.Get(), md5_frame_parallel_[i].Get());
+    }
+  }
+
+  ::libaom_test::MD5 md5_single_thread_;
+  ::libaom_test::MD5 md5_frame_parallel_[kNumMultiThreadDecoders];
+  int num_frames_single_thread_ = 0;
+  int num_frames_frame_parallel_[kNumMultiThreadDecoders] = {};
+  ::libaom_test::Decoder *single_thread_dec_;
+  ::libaom_test::Decoder *frame_parallel_dec_[kNumMultiThreadDecoders];
+  int film_grain_test_vector_;
+
+ private:
+  int n_tile_cols_;
+  int lag_in_frames_;
+};
+
+TEST_P(AV1DecodeFrameParallelTest, MD5Match) { DoTest(); }
+
+AV1_INSTANTIATE_TEST_CASE(AV1DecodeFrameParallelTest, ::testing::Values(0, 1),
+                          ::testing::Values(0, 19));
+
+// The film grain images of the queued output frames come from the same frame
+// buffer pool as the frames in flight.
+class AV1DecodeFrameParallelFilmGrainTest : public AV1DecodeFrameParallelTest {
+ protected:
+  AV1DecodeFrameParallelFilmGrainTest() { film_grain_test_vector_ = 1; }
+
+  // The output frames have film grain, unlike the frames of the encoder.
+  virtual bool DoDecode() const { return false; }
+};
+
+TEST_P(AV1DecodeFrameParallelFilmGrainTest, MD5Match) { DoTest(); }
+
+AV1_INSTANTIATE_TEST_CASE(AV1DecodeFrameParallelFilmGrainTest,
+                          ::testing::Values(0), ::testing::Values(0, 19));
+
 }  // namespace
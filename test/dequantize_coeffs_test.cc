@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+#include "config/av1_rtcd.h"
+
+#include "aom_ports/aom_timer.h"
+#include "av1/common/enums.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/util.h"
+
+namespace {
+using libaom_test::ACMRandom;
+
+typedef void (*DequantizeCoeffsFunc)(tran_low_t *coeffs, int n_coeffs,
+                                     int dqv_dc, int dqv_ac, int shift, int bd);
+
+// The dequantization of av1_read_coeffs_txb(), one coefficient at a time.
+tran_low_t DequantizeRef(tran_low_t qcoeff, int dqv, int shift, int bd) {
+  const int32_t max_value = (1 << (7 + bd)) - 1;
+  const int32_t min_value = -(1 << (7 + bd));
+  if (qcoeff == 0) return 0;
+  const int64_t level = qcoeff < 0 ? -qcoeff : qcoeff;
+  int64_t dq_coeff = level * dqv & 0xffffff;
+#if QUANT_TABLE_BITS
+  dq_coeff = (dq_coeff + (1 << (QUANT_TABLE_BITS - 1))) >> QUANT_TABLE_BITS;
+#endif
+  dq_coeff >>= shift;
+  if (qcoeff < 0) dq_coeff = -dq_coeff;
+  if (dq_coeff < min_value) return min_value;
+  if (dq_coeff > max_value) return max_value;
+  return static_cast<tran_low_t>(dq_coeff);
+}
+
+class DequantizeCoeffsTest
+    : public ::testing::TestWithParam<DequantizeCoeffsFunc> {
+ public:
+  DequantizeCoeffsTest() : func_(GetParam()) {}
+  virtual ~DequantizeCoeffsTest() {}
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void FillCoeffs(int n_coeffs, int max_level) {
+    memset(coeffs_, 0, sizeof(coeffs_));
+    for (int i = 0; i < n_coeffs; ++i) {
+      // Mostly zeros and small levels, as in real blocks.
+      if (rnd_(3)) continue;
+      const int level = rnd_(4) ? rnd_(16) : rnd_(max_level + 1);
+      coeffs_[i] = rnd_(2) ? -level : level;
+    }
+  }
+
+  DequantizeCoeffsFunc func_;
+  ACMRandom rnd_;
+  tran_low_t coeffs_[MAX_TX_SQUARE];
+};
+
+TEST_P(DequantizeCoeffsTest, MatchesReference) {
+  const int kBitDepths[] = { 8, 10, 12 };
+  tran_low_t ref[MAX_TX_SQUARE];
+  for (int bd : kBitDepths) {
+    for (int shift = 0; shift <= 2; ++shift) {
+      for (int n_coeffs = 1; n_coeffs <= MAX_TX_SQUARE; n_coeffs += 7) {
+        // Levels up to 20 bits, and a quantizer large enough to overflow 24
+        // bits and the clamping range.
+        FillCoeffs(n_coeffs, 0xfffff);
+        const int dqv_dc = 1 + rnd_(1 << (bd + 3));
+        const int dqv_ac = 1 + rnd_(1 << (bd + 3));
+        for (int i = 0; i < n_coeffs; ++i) {
+          ref[i] = DequantizeRef(coeffs_[i], i ? dqv_ac : dqv_dc, shift, bd);
+        }
+        func_(coeffs_, n_coeffs, dqv_dc, dqv_ac, shift, bd);
+        for (int i = 0; i < n_coeffs; ++i) {
+          ASSERT_EQ(ref[i], coeffs_[i])
+              << "bd " << bd << " shift " << shift << " n_coeffs " << n_coeffs
+              << " i " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST_P(DequantizeCoeffsTest, DISABLED_Speed) {
+  const int kNumBlocks = 100000;
+  const int kSizes[] = { 16, 64, 256, 1024 };
+  aom_usec_timer timer;
+  for (int n_coeffs : kSizes) {
+    const int num_runs = kNumBlocks * 1024 / n_coeffs;
+    tran_low_t src[MAX_TX_SQUARE];
+    FillCoeffs(n_coeffs, 255);
+    memcpy(src, coeffs_, sizeof(src));
+
+    aom_usec_timer_start(&timer);
+    for (int i = 0; i < num_runs; ++i) {
+      memcpy(coeffs_, src, n_coeffs * sizeof(coeffs_[0]));
+      av1_dequantize_coeffs_c(coeffs_, n_coeffs, 40, 48, 0, 8);
+    }
+    const double t1 = get_time_mark(&timer);
+    aom_usec_timer_start(&timer);
+    for (int i = 0; i < num_runs; ++i) {
+      memcpy(coeffs_, src, n_coeffs * sizeof(coeffs_[0]));
+      func_(coeffs_, n_coeffs, 40, 48, 0, 8);
+    }
+    const double t2 = get_time_mark(&timer);
+    printf("dequantize %4d:%7.2f/%7.2fus", n_coeffs, t1, t2);
+    printf("(%3.2f)\n", t1 / t2);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(C, DequantizeCoeffsTest,
+                        ::testing::Values(av1_dequantize_coeffs_c));
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_CASE_P(SSE4_1, DequantizeCoeffsTest,
+                        ::testing::Values(av1_dequantize_coeffs_sse4_1));
+#endif
+
+}  // namespace
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+#include "config/av1_rtcd.h"
+
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "av1/common/blockd.h"
+
+#if CONFIG_DERIVED_INTRA_MODE && HAVE_SSE4_1
+namespace {
+
+using libaom_test::ACMRandom;
+
+const int kBorder = 8;
+const int kStride = 160;
+const int kRows = 160;
+
+// Fills the buffer with random noise or with a random linear ramp, which
+// exercises gradient directions close to the histogram bin boundaries.
+template <typename Pixel>
+void FillBuffer(ACMRandom *rnd, Pixel *buf, int bd, int iter) {
+  const int max = (1 << bd) - 1;
+  if (iter & 1) {
+    for (int i = 0; i < kStride * kRows; ++i) buf[i] = rnd->Rand16() & max;
+    return;
+  }
+  const int gx = rnd->PseudoUniform(33) - 16;
+  const int gy = rnd->PseudoUniform(33) - 16;
+  const int offset = rnd->PseudoUniform(max + 1);
+  for (int r = 0; r < kRows; ++r) {
+    for (int c = 0; c < kStride; ++c) {
+      const int noise = rnd->PseudoUniform(3) - 1;
+      const int v = offset + (gx * c + gy * r) / 4 + noise;
+      buf[r * kStride + c] = (Pixel)(v < 0 ? 0 : v > max ? max : v);
+    }
+  }
+}
+
+// Uses the shapes of the regions the derived intra mode is computed from:
+// three rows above the block or three columns left of it.
+template <typename Pixel, typename HistFunc>
+void RunHistTest(HistFunc ref_func, HistFunc test_func, int bd) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  Pixel *buf = new Pixel[kStride * kRows];
+  for (int iter = 0; iter < 4000; ++iter) {
+    FillBuffer(&rnd, buf, bd, iter);
+    const int len = 3 + rnd.PseudoUniform(kStride - 2 * kBorder - 3);
+    int rows = 3, cols = 3;
+    switch ((iter >> 1) % 3) {
+      case 0: cols = len; break;
+      case 1: rows = len; break;
+      default:
+        rows = 3 + rnd.PseudoUniform(8);
+        cols = 3 + rnd.PseudoUniform(8);
+        break;
+    }
+    const Pixel *src = buf + kBorder * kStride + kBorder;
+    int ref_hist[DERIVED_INTRA_HIST_BINS] = { 0 };
+    int test_hist[DERIVED_INTRA_HIST_BINS] = { 0 };
+    ref_func(src, kStride, rows, cols, ref_hist);
+    test_func(src, kStride, rows, cols, test_hist);
+    for (int k = 0; k < DERIVED_INTRA_HIST_BINS; ++k) {
+      ASSERT_EQ(ref_hist[k], test_hist[k])
+          << "bin " << k << " " << cols << "x" << rows << " iter " << iter;
+    }
+  }
+  delete[] buf;
+  libaom_test::ClearSystemState();
+}
+
+TEST(DerivedIntraModeTest, GradHistSse4MatchesC) {
+  RunHistTest<uint8_t>(av1_derived_intra_grad_hist_c,
+                       av1_derived_intra_grad_hist_sse4_1, 8);
+}
+
+TEST(DerivedIntraModeTest, GradHistHbdSse4MatchesC) {
+  RunHistTest<uint16_t>(av1_derived_intra_grad_hist_hbd_c,
+                        av1_derived_intra_grad_hist_hbd_sse4_1, 12);
+}
+
+}  // namespace
+#endif  // CONFIG_DERIVED_INTRA_MODE && HAVE_SSE4_1
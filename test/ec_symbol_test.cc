@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string.h>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+#include "test/acm_random.h"
+#include "test/function_equivalence_test.h"
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom_dsp/prob.h"
+
+using libaom_test::ACMRandom;
+using libaom_test::FuncParam;
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+const int kMaxSymbols = 16;
+
+// Fills icdf[0..nsyms] with a random inverse CDF and update count. Both ends
+// of the probability range are picked often.
+void RandomCdf(ACMRandom *rng, int nsyms, uint16_t *icdf) {
+  int cdf = 0;
+  for (int i = 0; i < nsyms - 1; ++i) {
+    switch (rng->Rand8() & 3) {
+      case 0: break;
+      case 1: cdf = CDF_PROB_TOP - (nsyms - 1 - i); break;
+      default: cdf += rng->PseudoUniform(CDF_PROB_TOP - (nsyms - 1 - i) - cdf);
+    }
+    icdf[i] = AOM_ICDF(cdf);
+  }
+  icdf[nsyms - 1] = AOM_ICDF(CDF_PROB_TOP);
+  icdf[nsyms] = rng->PseudoUniform(33);
+}
+
+typedef int (*FindSymbolFunc)(const uint16_t *icdf, int nsyms, unsigned rng,
+                              unsigned c);
+
+class FindSymbolTest : public FunctionEquivalenceTest<FindSymbolFunc> {
+ protected:
+  static const int kIterations = 100000;
+};
+
+TEST_P(FindSymbolTest, RandomValues) {
+  uint16_t icdf[kMaxSymbols + 1];
+  for (int iter = 0; iter < kIterations; ++iter) {
+    const int nsyms = 2 + iter % (kMaxSymbols - 1);
+    RandomCdf(&rng_, nsyms, icdf);
+    const unsigned rng = 32768 + rng_.PseudoUniform(32768);
+    const unsigned c = (iter & 1) ? rng_.PseudoUniform(rng) : rng - 1;
+    ASSERT_EQ(params_.ref_func(icdf, nsyms, rng, c),
+              params_.tst_func(icdf, nsyms, rng, c))
+        << "iteration " << iter << " nsyms " << nsyms;
+  }
+}
+
+typedef void (*UpdateCdfFunc)(uint16_t *cdf, int val, int nsymbs);
+
+class UpdateCdfTest : public FunctionEquivalenceTest<UpdateCdfFunc> {
+ protected:
+  static const int kIterations = 100000;
+};
+
+TEST_P(UpdateCdfTest, RandomValues) {
+  // One spare entry after the update count checks for stray writes.
+  uint16_t cdf_ref[kMaxSymbols + 2];
+  uint16_t cdf_tst[kMaxSymbols + 2];
+  for (int iter = 0; iter < kIterations; ++iter) {
+    const int nsymbs = 2 + iter % (kMaxSymbols - 1);
+    const int val = rng_.PseudoUniform(nsymbs);
+    RandomCdf(&rng_, nsymbs, cdf_ref);
+    cdf_ref[nsymbs + 1] = rng_.Rand16();
+    memcpy(cdf_tst, cdf_ref, sizeof(cdf_ref));
+
+    params_.ref_func(cdf_ref, val, nsymbs);
+    params_.tst_func(cdf_tst, val, nsymbs);
+    ASSERT_EQ(0, memcmp(cdf_ref, cdf_tst, sizeof(cdf_ref)))
+        << "iteration " << iter << " nsymbs " << nsymbs << " val " << val;
+  }
+}
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, FindSymbolTest,
+                        ::testing::Values(FuncParam<FindSymbolFunc>(
+                            aom_ec_find_symbol_c, aom_ec_find_symbol_sse2)));
+
+INSTANTIATE_TEST_CASE_P(SSE2, UpdateCdfTest,
+                        ::testing::Values(FuncParam<UpdateCdfFunc>(
+                            aom_update_cdf_c, aom_update_cdf_sse2)));
+#endif  // HAVE_SSE2
+
+}  // namespace
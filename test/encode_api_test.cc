@@ -9,6 +9,11 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "config/aom_config.h"
@@ -70,4 +75,122 @@ TEST(EncodeAPI, InvalidParams) {
   }
 }
 
+#if CONFIG_AV1_ENCODER
+const int kZeroCopyWidth = 96;
+const int kZeroCopyHeight = 64;
+const int kZeroCopyFrames = 10;
+
+struct ZeroCopyState {
+  std::vector<aom_image_t> images;
+  std::vector<int> released;
+};
+
+void ReleaseSource(void *cb_priv, void *user_priv) {
+  ZeroCopyState *const state = static_cast<ZeroCopyState *>(cb_priv);
+  const int index = static_cast<int>(reinterpret_cast<intptr_t>(user_priv));
+  state->released.push_back(index);
+  // Poison the frame, so that any later use changes the encoded stream.
+  aom_image_t *const img = &state->images[index];
+  memset(img->img_data, 0, img->sz);
+}
+
+void FillFrame(aom_image_t *img, int frame) {
+  for (int plane = 0; plane < 3; ++plane) {
+    const int w = plane ? (img->d_w + 1) >> 1 : img->d_w;
+    const int h = plane ? (img->d_h + 1) >> 1 : img->d_h;
+    for (int r = 0; r < h; ++r) {
+      for (int c = 0; c < w; ++c) {
+        img->planes[plane][r * img->stride[plane] + c] =
+            static_cast<uint8_t>((r * 3 + (c + frame * 2) * 5 + plane * 40) &
+                                 0xff);
+      }
+    }
+  }
+}
+
+// Encodes a short clip and returns the compressed data. If use_release_cb is
+// set, frames are handed to the encoder with a release callback, and must
+// outlive the encode call until they are released.
+std::string EncodeClip(bool use_release_cb, bool with_border,
+                       ZeroCopyState *state) {
+  aom_codec_iface_t *const iface = aom_codec_av1_cx();
+  aom_codec_enc_cfg_t cfg;
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_enc_config_default(iface, &cfg, 0));
+  cfg.g_w = kZeroCopyWidth;
+  cfg.g_h = kZeroCopyHeight;
+  cfg.g_lag_in_frames = 4;
+  cfg.rc_end_usage = AOM_Q;
+  aom_codec_ctx_t enc;
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_enc_init(&enc, iface, &cfg, 0));
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CPUUSED, 5));
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CQ_LEVEL, 40));
+  if (use_release_cb) {
+    aom_source_release_cb_t cb = { ReleaseSource, state };
+    EXPECT_EQ(AOM_CODEC_OK,
+              aom_codec_control(&enc, AV1E_SET_SOURCE_RELEASE_CB, &cb));
+  }
+
+  state->images.resize(kZeroCopyFrames);
+  std::string stream;
+  for (int i = 0; i <= kZeroCopyFrames; ++i) {
+    aom_image_t *img = NULL;
+    if (i < kZeroCopyFrames) {
+      img = &state->images[i];
+      if (with_border) {
+        EXPECT_EQ(img, aom_img_alloc_with_border(
+                           img, AOM_IMG_FMT_I420, kZeroCopyWidth,
+                           kZeroCopyHeight, 32, 128, AOM_ENC_ZERO_COPY_BORDER));
+      } else {
+        EXPECT_EQ(img, aom_img_alloc(img, AOM_IMG_FMT_I420, kZeroCopyWidth,
+                                     kZeroCopyHeight, 32));
+      }
+      img->user_priv = reinterpret_cast<void *>(static_cast<intptr_t>(i));
+      FillFrame(img, i);
+    }
+    // Flush the encoder after the last frame.
+    bool got_data;
+    do {
+      EXPECT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, img, i, 1, 0));
+      got_data = false;
+      aom_codec_iter_t iter = NULL;
+      const aom_codec_cx_pkt_t *pkt;
+      while ((pkt = aom_codec_get_cx_data(&enc, &iter)) != NULL) {
+        if (pkt->kind != AOM_CODEC_CX_FRAME_PKT) continue;
+        stream.append(static_cast<const char *>(pkt->data.frame.buf),
+                      pkt->data.frame.sz);
+        got_data = true;
+      }
+    } while (img == NULL && got_data);
+    if (use_release_cb && i < kZeroCopyFrames) {
+      if (with_border) {
+        // The lookahead keeps the most recent frames.
+        EXPECT_LE(static_cast<int>(state->released.size()), i);
+      } else {
+        // Frames without a border are copied.
+        EXPECT_EQ(static_cast<int>(state->released.size()), i + 1);
+      }
+    }
+  }
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&enc));
+  for (aom_image_t &img : state->images) aom_img_free(&img);
+  return stream;
+}
+
+TEST(EncodeAPI, ZeroCopySource) {
+  ZeroCopyState copied;
+  const std::string ref = EncodeClip(false, true, &copied);
+  ASSERT_FALSE(ref.empty());
+  EXPECT_TRUE(copied.released.empty());
+
+  for (int with_border = 0; with_border <= 1; ++with_border) {
+    SCOPED_TRACE(with_border);
+    ZeroCopyState state;
+    EXPECT_TRUE(ref == EncodeClip(true, with_border != 0, &state));
+    // Every frame is released exactly once, in order.
+    ASSERT_EQ(kZeroCopyFrames, static_cast<int>(state.released.size()));
+    for (int i = 0; i < kZeroCopyFrames; ++i) EXPECT_EQ(i, state.released[i]);
+  }
+}
+#endif  // CONFIG_AV1_ENCODER
+
 }  // namespace
@@ -181,6 +181,84 @@ INSTANTIATE_TEST_CASE_P(SSE2, EncodeTxbTest,
                         ::testing::Values(av1_get_nz_map_contexts_sse2));
 #endif
 
+class EncodeTxbBrContextsTest
+    : public ::testing::TestWithParam<GetNzMapContextsFunc> {
+ public:
+  EncodeTxbBrContextsTest() : get_br_contexts_func_(GetParam()) {}
+  virtual ~EncodeTxbBrContextsTest() {}
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+  void RunTest(int is_speed);
+
+ private:
+  GetNzMapContextsFunc get_br_contexts_func_;
+  ACMRandom rnd_;
+};
+
+void EncodeTxbBrContextsTest::RunTest(int is_speed) {
+  DECLARE_ALIGNED(16, int8_t, br_contexts_ref[MAX_TX_SQUARE]);
+  DECLARE_ALIGNED(16, int8_t, br_contexts[MAX_TX_SQUARE]);
+  uint8_t levels_buf[TX_PAD_2D];
+  aom_usec_timer timer;
+
+  for (int tx_type = DCT_DCT; tx_type < TX_TYPES; ++tx_type) {
+    const TX_CLASS tx_class = tx_type_to_class[tx_type];
+    for (int tx_size = TX_4X4; tx_size < TX_SIZES_ALL; ++tx_size) {
+      const int bwl = get_txb_bwl((TX_SIZE)tx_size);
+      const int width = get_txb_wide((TX_SIZE)tx_size);
+      const int height = get_txb_high((TX_SIZE)tx_size);
+      const int16_t *const scan = av1_scan_orders[tx_size][tx_type].scan;
+      uint8_t *const levels = set_levels(levels_buf, width);
+      const int max_eob = width * height;
+      // The speed test only runs the largest eob, with DCT_DCT.
+      if (is_speed && tx_type != DCT_DCT) continue;
+
+      for (int eob = is_speed ? max_eob : 1; eob <= max_eob; ++eob) {
+        memset(levels_buf, 0, sizeof(levels_buf));
+        // Mostly small levels, as in real blocks, but up to the maximum.
+        for (int c = 0; c < eob; ++c) {
+          const int level = rnd_(4) ? rnd_(16) : rnd_(INT8_MAX + 1);
+          levels[get_padded_idx(scan[c], bwl)] = static_cast<uint8_t>(level);
+        }
+        const int run_times = is_speed ? 100000000 / max_eob : 1;
+
+        aom_usec_timer_start(&timer);
+        for (int i = 0; i < run_times; ++i) {
+          av1_get_br_contexts_c(levels, scan, eob, (TX_SIZE)tx_size, tx_class,
+                                br_contexts_ref);
+        }
+        const double t1 = get_time_mark(&timer);
+        aom_usec_timer_start(&timer);
+        for (int i = 0; i < run_times; ++i) {
+          get_br_contexts_func_(levels, scan, eob, (TX_SIZE)tx_size, tx_class,
+                                br_contexts);
+        }
+        const double t2 = get_time_mark(&timer);
+        if (is_speed) {
+          printf("br_contexts %3dx%-3d:%7.2f/%7.2fns", width, height, t1, t2);
+          printf("(%3.2f)\n", t1 / t2);
+        }
+
+        // Only the contexts of the coefficients up to eob are defined.
+        for (int c = 0; c < eob; ++c) {
+          const int pos = scan[c];
+          ASSERT_EQ(br_contexts_ref[pos], br_contexts[pos])
+              << "tx_class " << tx_class << " width " << width << " height "
+              << height << " eob " << eob << " pos " << pos;
+        }
+      }
+    }
+  }
+}
+
+TEST_P(EncodeTxbBrContextsTest, match) { RunTest(0); }
+
+TEST_P(EncodeTxbBrContextsTest, DISABLED_Speed) { RunTest(1); }
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, EncodeTxbBrContextsTest,
+                        ::testing::Values(av1_get_br_contexts_sse2));
+#endif
+
 typedef void (*av1_txb_init_levels_func)(const tran_low_t *const coeff,
                                          const int width, const int height,
                                          uint8_t *const levels);
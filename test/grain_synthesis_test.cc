@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string.h>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+#include "test/acm_random.h"
+#include "test/function_equivalence_test.h"
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom_dsp/grain_synthesis.h"
+#include "aom_util/aom_thread.h"
+#include "av1/encoder/grain_test_vectors.h"
+
+using libaom_test::ACMRandom;
+using libaom_test::FuncParam;
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+// Fills the visible part of img with random samples.
+void FillImage(ACMRandom *rng, aom_image_t *img) {
+  const int hbd = (img->fmt & AOM_IMG_FMT_HIGHBITDEPTH) != 0;
+  const int max_value = (1 << img->bit_depth) - 1;
+  for (int plane = 0; plane < 3; ++plane) {
+    const int w =
+        plane ? (img->d_w + img->x_chroma_shift) >> img->x_chroma_shift
+              : img->d_w;
+    const int h =
+        plane ? (img->d_h + img->y_chroma_shift) >> img->y_chroma_shift
+              : img->d_h;
+    for (int i = 0; i < h; ++i) {
+      uint8_t *row = img->planes[plane] + i * img->stride[plane];
+      for (int j = 0; j < w; ++j) {
+        if (hbd)
+          reinterpret_cast<uint16_t *>(row)[j] = rng->Rand16() & max_value;
+        else
+          row[j] = rng->Rand8();
+      }
+    }
+  }
+}
+
+bool ImagesEqual(const aom_image_t *a, const aom_image_t *b) {
+  const int bytes = (a->fmt & AOM_IMG_FMT_HIGHBITDEPTH) ? 2 : 1;
+  for (int plane = 0; plane < 3; ++plane) {
+    const int w = plane ? (a->d_w + a->x_chroma_shift) >> a->x_chroma_shift
+                        : a->d_w;
+    const int h = plane ? (a->d_h + a->y_chroma_shift) >> a->y_chroma_shift
+                        : a->d_h;
+    for (int i = 0; i < h; ++i) {
+      if (memcmp(a->planes[plane] + i * a->stride[plane],
+                 b->planes[plane] + i * b->stride[plane], w * bytes))
+        return false;
+    }
+  }
+  return true;
+}
+
+class GrainSynthesisMtTest : public ::testing::Test {
+ protected:
+  static const int kNumWorkers = 4;
+
+  virtual void SetUp() {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < kNumWorkers; ++i) {
+      winterface->init(&workers_[i]);
+      // The last worker runs on the calling thread.
+      if (i < kNumWorkers - 1) {
+        ASSERT_TRUE(winterface->reset(&workers_[i]));
+      }
+    }
+  }
+
+  virtual void TearDown() {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < kNumWorkers; ++i) winterface->end(&workers_[i]);
+  }
+
+  void RunTest(aom_img_fmt_t fmt, int bit_depth, int width, int height) {
+    ACMRandom rng(ACMRandom::DeterministicSeed());
+    aom_image_t src, ref, dst;
+    ASSERT_EQ(&src, aom_img_alloc(&src, fmt, width, height, 32));
+    ASSERT_EQ(&ref, aom_img_alloc(&ref, fmt, width + 1, height + 1, 32));
+    ASSERT_EQ(&dst, aom_img_alloc(&dst, fmt, width + 1, height + 1, 32));
+    src.bit_depth = bit_depth;
+    FillImage(&rng, &src);
+
+    for (int i = 0; i < 16; ++i) {
+      aom_film_grain_t params = film_grain_test_vectors[i];
+      params.bit_depth = bit_depth;
+      params.random_seed += i;
+      ASSERT_EQ(0, av1_add_film_grain(&params, &src, &ref));
+      ASSERT_FALSE(ImagesEqual(&src, &ref)) << "test vector " << i;
+      for (int num_workers = 1; num_workers <= kNumWorkers; ++num_workers) {
+        ASSERT_EQ(0, av1_add_film_grain_mt(&params, &src, &dst, workers_,
+                                           num_workers));
+        ASSERT_TRUE(ImagesEqual(&ref, &dst))
+            << "test vector " << i << " workers " << num_workers;
+      }
+    }
+
+    aom_img_free(&src);
+    aom_img_free(&ref);
+    aom_img_free(&dst);
+  }
+
+  AVxWorker workers_[kNumWorkers];
+};
+
+TEST_F(GrainSynthesisMtTest, I420) {
+  RunTest(AOM_IMG_FMT_I420, 8, 357, 263);
+}
+
+TEST_F(GrainSynthesisMtTest, I422) { RunTest(AOM_IMG_FMT_I422, 8, 200, 198); }
+
+TEST_F(GrainSynthesisMtTest, I444) { RunTest(AOM_IMG_FMT_I444, 8, 130, 257); }
+
+TEST_F(GrainSynthesisMtTest, I42016) {
+  RunTest(AOM_IMG_FMT_I42016, 10, 357, 263);
+}
+
+TEST_F(GrainSynthesisMtTest, I44416) {
+  RunTest(AOM_IMG_FMT_I44416, 12, 130, 257);
+}
+
+typedef void (*AddGrainNoiseFunc)(uint8_t *dst, int dst_stride,
+                                  const uint8_t *luma, int luma_stride,
+                                  const int *grain, int grain_stride, int width,
+                                  int height,
+                                  const aom_grain_noise_params_t *p);
+typedef void (*HighbdAddGrainNoiseFunc)(uint16_t *dst, int dst_stride,
+                                        const uint16_t *luma, int luma_stride,
+                                        const int *grain, int grain_stride,
+                                        int width, int height,
+                                        const aom_grain_noise_params_t *p);
+
+const int kMaxBlockWidth = 40;
+const int kMaxBlockHeight = 34;
+const int kStride = 2 * kMaxBlockWidth + 16;
+
+// Draws random noise parameters, as av1_add_film_grain() sets them up.
+void RandomNoiseParams(ACMRandom *rng, int bit_depth, int *lut,
+                       aom_grain_noise_params_t *p) {
+  for (int i = 0; i < 256; ++i) lut[i] = rng->Rand8();
+  lut[256] = lut[255];
+  p->scaling_lut = lut;
+  if (rng->Rand8() & 1) {
+    p->luma_mult = 64;
+    p->mult = 0;
+    p->offset = 0;
+  } else {
+    p->luma_mult = rng->Rand8() - 128;
+    p->mult = rng->Rand8() - 128;
+    p->offset = (rng->Rand8() << (bit_depth - 8)) - (1 << bit_depth);
+  }
+  p->scaling_shift = 8 + rng->PseudoUniform(4);
+  if (rng->Rand8() & 1) {
+    p->min_value = 16 << (bit_depth - 8);
+    p->max_value = 235 << (bit_depth - 8);
+  } else {
+    p->min_value = 0;
+    p->max_value = (256 << (bit_depth - 8)) - 1;
+  }
+  p->bit_depth = bit_depth;
+  p->subsamp_x = rng->Rand8() & 1;
+  p->subsamp_y = rng->Rand8() & 1;
+}
+
+class AddGrainNoiseTest : public FunctionEquivalenceTest<AddGrainNoiseFunc> {
+ protected:
+  static const int kIterations = 10000;
+};
+
+TEST_P(AddGrainNoiseTest, RandomValues) {
+  DECLARE_ALIGNED(32, uint8_t, luma[kMaxBlockHeight * 2 * kStride]);
+  DECLARE_ALIGNED(32, uint8_t, dst_ref[kMaxBlockHeight * kStride]);
+  DECLARE_ALIGNED(32, uint8_t, dst_tst[kMaxBlockHeight * kStride]);
+  DECLARE_ALIGNED(32, int, grain[kMaxBlockHeight * kStride]);
+  int lut[257];
+  aom_grain_noise_params_t p;
+
+  for (int iter = 0; iter < kIterations; ++iter) {
+    RandomNoiseParams(&rng_, 8, lut, &p);
+    const int width = 1 + rng_.PseudoUniform(kMaxBlockWidth);
+    const int height = 1 + rng_.PseudoUniform(kMaxBlockHeight);
+    for (size_t i = 0; i < sizeof(luma); ++i) luma[i] = rng_.Rand8();
+    for (size_t i = 0; i < sizeof(dst_ref); ++i) dst_ref[i] = rng_.Rand8();
+    for (size_t i = 0; i < sizeof(grain) / sizeof(*grain); ++i)
+      grain[i] = rng_.Rand8() - 128;
+    memcpy(dst_tst, dst_ref, sizeof(dst_ref));
+
+    params_.ref_func(dst_ref, kStride, luma, kStride, grain, kStride, width,
+                     height, &p);
+    params_.tst_func(dst_tst, kStride, luma, kStride, grain, kStride, width,
+                     height, &p);
+    ASSERT_EQ(0, memcmp(dst_ref, dst_tst, sizeof(dst_ref)))
+        << "iteration " << iter << " " << width << "x" << height;
+  }
+}
+
+class HighbdAddGrainNoiseTest
+    : public FunctionEquivalenceTest<HighbdAddGrainNoiseFunc> {
+ protected:
+  static const int kIterations = 10000;
+};
+
+TEST_P(HighbdAddGrainNoiseTest, RandomValues) {
+  DECLARE_ALIGNED(32, uint16_t, luma[kMaxBlockHeight * 2 * kStride]);
+  DECLARE_ALIGNED(32, uint16_t, dst_ref[kMaxBlockHeight * kStride]);
+  DECLARE_ALIGNED(32, uint16_t, dst_tst[kMaxBlockHeight * kStride]);
+  DECLARE_ALIGNED(32, int, grain[kMaxBlockHeight * kStride]);
+  int lut[257];
+  aom_grain_noise_params_t p;
+  const int bd = params_.bit_depth;
+  const int mask = (1 << bd) - 1;
+  const int grain_center = 128 << (bd - 8);
+
+  for (int iter = 0; iter < kIterations; ++iter) {
+    RandomNoiseParams(&rng_, bd, lut, &p);
+    const int width = 1 + rng_.PseudoUniform(kMaxBlockWidth);
+    const int height = 1 + rng_.PseudoUniform(kMaxBlockHeight);
+    for (size_t i = 0; i < sizeof(luma) / sizeof(*luma); ++i)
+      luma[i] = rng_.Rand16() & mask;
+    for (size_t i = 0; i < sizeof(dst_ref) / sizeof(*dst_ref); ++i)
+      dst_ref[i] = rng_.Rand16() & mask;
+    for (size_t i = 0; i < sizeof(grain) / sizeof(*grain); ++i)
+      grain[i] = rng_.PseudoUniform(2 * grain_center) - grain_center;
+    memcpy(dst_tst, dst_ref, sizeof(dst_ref));
+
+    params_.ref_func(dst_ref, kStride, luma, kStride, grain, kStride, width,
+                     height, &p);
+    params_.tst_func(dst_tst, kStride, luma, kStride, grain, kStride, width,
+                     height, &p);
+    ASSERT_EQ(0, memcmp(dst_ref, dst_tst, sizeof(dst_ref)))
+        << "iteration " << iter << " " << width << "x" << height;
+  }
+}
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, AddGrainNoiseTest,
+    ::testing::Values(FuncParam<AddGrainNoiseFunc>(aom_add_grain_noise_c,
+                                                   aom_add_grain_noise_avx2,
+                                                   8)));
+
+INSTANTIATE_TEST_CASE_P(
+    AVX2, HighbdAddGrainNoiseTest,
+    ::testing::Values(FuncParam<HighbdAddGrainNoiseFunc>(
+                          aom_highbd_add_grain_noise_c,
+                          aom_highbd_add_grain_noise_avx2, 8),
+                      FuncParam<HighbdAddGrainNoiseFunc>(
+                          aom_highbd_add_grain_noise_c,
+                          aom_highbd_add_grain_noise_avx2, 10),
+                      FuncParam<HighbdAddGrainNoiseFunc>(
+                          aom_highbd_add_grain_noise_c,
+                          aom_highbd_add_grain_noise_avx2, 12)));
+#endif  // HAVE_AVX2
+
+}  // namespace
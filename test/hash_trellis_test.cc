@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cstring>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+
+#include "aom/aomcx.h"
+#include "aom/aom_encoder.h"
+#include "av1/encoder/hash_trellis.h"
+#include "test/acm_random.h"
+
+namespace {
+
+class HashTrellisCacheTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() { memset(&cache_, 0, sizeof(cache_)); }
+  virtual void TearDown() { av1_hbt_cache_free(&cache_); }
+
+  // Inserts an entry whose deltas and rate identify it.
+  void Insert(uint32_t ctx_hash, uint32_t qc_hash, int rate) {
+    HbtEntry *const entry = av1_hbt_cache_insert(&cache_, ctx_hash, qc_hash);
+    memset(entry->deltas, -1, sizeof(entry->deltas));
+    entry->rate_cost = rate;
+  }
+
+  HbtCache cache_;
+};
+
+TEST_F(HashTrellisCacheTest, LookupAfterInsert) {
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, 8));
+  EXPECT_EQ(NULL, av1_hbt_cache_lookup(&cache_, 1, 2));
+  Insert(1, 2, 100);
+  const HbtEntry *const entry = av1_hbt_cache_lookup(&cache_, 1, 2);
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_EQ(100, entry->rate_cost);
+  EXPECT_EQ(-1, entry->deltas[HBT_EOB - 1]);
+  // Both hashes must match.
+  EXPECT_EQ(NULL, av1_hbt_cache_lookup(&cache_, 2, 2));
+  EXPECT_EQ(NULL, av1_hbt_cache_lookup(&cache_, 1, 1));
+  EXPECT_EQ(1u, cache_.stats.hits);
+  EXPECT_EQ(3u, cache_.stats.misses);
+  EXPECT_EQ(0u, cache_.stats.evictions);
+}
+
+TEST_F(HashTrellisCacheTest, ResetInvalidates) {
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, 8));
+  Insert(1, 2, 100);
+  av1_hbt_cache_reset(&cache_);
+  EXPECT_EQ(NULL, av1_hbt_cache_lookup(&cache_, 1, 2));
+
+  // A wrapping epoch clears the entries for real.
+  Insert(1, 2, 100);
+  cache_.epoch = UINT32_MAX;
+  av1_hbt_cache_reset(&cache_);
+  EXPECT_EQ(1u, cache_.epoch);
+  EXPECT_EQ(NULL, av1_hbt_cache_lookup(&cache_, 1, 2));
+}
+
+TEST_F(HashTrellisCacheTest, ResizeEmpties) {
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, 8));
+  Insert(1, 2, 100);
+  // Keeping the size keeps the entries.
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, 8));
+  EXPECT_TRUE(av1_hbt_cache_lookup(&cache_, 1, 2) != NULL);
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, 10));
+  EXPECT_EQ(NULL, av1_hbt_cache_lookup(&cache_, 1, 2));
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, 0));
+  EXPECT_EQ(NULL, cache_.entries);
+  // The statistics survive.
+  EXPECT_EQ(1u, cache_.stats.hits);
+  EXPECT_EQ(1u, cache_.stats.misses);
+}
+
+TEST_F(HashTrellisCacheTest, ClockEviction) {
+  // A single set, so every entry competes for the same ways.
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, HBT_WAYS_LOG2));
+  for (int i = 0; i < HBT_WAYS; ++i) Insert(i, i, i);
+  EXPECT_EQ(0u, cache_.stats.evictions);
+  // Entries that were hit survive the next eviction.
+  for (int i = 1; i < HBT_WAYS; ++i) {
+    ASSERT_TRUE(av1_hbt_cache_lookup(&cache_, i, i) != NULL);
+  }
+  Insert(HBT_WAYS, HBT_WAYS, HBT_WAYS);
+  EXPECT_EQ(1u, cache_.stats.evictions);
+  EXPECT_EQ(NULL, av1_hbt_cache_lookup(&cache_, 0, 0));
+  for (int i = 1; i <= HBT_WAYS; ++i) {
+    const HbtEntry *const entry = av1_hbt_cache_lookup(&cache_, i, i);
+    ASSERT_TRUE(entry != NULL) << "entry " << i;
+    EXPECT_EQ(i, entry->rate_cost);
+  }
+}
+
+TEST_F(HashTrellisCacheTest, Bounded) {
+  const int kSizeLog2 = 6;
+  ASSERT_EQ(0, av1_hbt_cache_resize(&cache_, kSizeLog2));
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  const int kInserts = 1000;
+  for (int i = 0; i < kInserts; ++i) Insert(rnd.Rand31(), rnd.Rand31(), i);
+  // Each insert beyond the capacity replaces exactly one entry.
+  EXPECT_GE(cache_.stats.evictions, kInserts - (1u << kSizeLog2));
+  EXPECT_LT(cache_.stats.evictions, static_cast<uint64_t>(kInserts));
+}
+
+TEST(HashTrellisEncodeTest, Stats) {
+  const int kWidth = 64;
+  const int kHeight = 64;
+  aom_codec_iface_t *const iface = aom_codec_av1_cx();
+  aom_codec_enc_cfg_t cfg;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_config_default(iface, &cfg, 0));
+  cfg.g_w = kWidth;
+  cfg.g_h = kHeight;
+  cfg.g_lag_in_frames = 0;
+  cfg.g_threads = 2;
+  cfg.g_pass = AOM_RC_ONE_PASS;
+  aom_codec_ctx_t enc;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_init(&enc, iface, &cfg, 0));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CPUUSED, 5));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AV1E_SET_ROW_MT, 1));
+  EXPECT_EQ(AOM_CODEC_INVALID_PARAM,
+            aom_codec_control(&enc, AV1E_SET_HASH_TRELLIS_SIZE, 1));
+  EXPECT_EQ(AOM_CODEC_INVALID_PARAM,
+            aom_codec_control(&enc, AV1E_SET_HASH_TRELLIS_SIZE,
+                              HBT_MAX_SIZE_LOG2 + 1));
+  ASSERT_EQ(AOM_CODEC_OK,
+            aom_codec_control(&enc, AV1E_SET_HASH_TRELLIS_SIZE, 10));
+
+  aom_image_t img;
+  ASSERT_EQ(&img, aom_img_alloc(&img, AOM_IMG_FMT_I420, kWidth, kHeight, 1));
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  const int kFrames = 2;
+  for (int frame = 0; frame < kFrames; ++frame) {
+    // Small noise on a flat frame gives many short transform blocks.
+    for (int plane = 0; plane < 3; ++plane) {
+      const int w = plane ? kWidth / 2 : kWidth;
+      const int h = plane ? kHeight / 2 : kHeight;
+      for (int r = 0; r < h; ++r) {
+        uint8_t *const row = img.planes[plane] + r * img.stride[plane];
+        for (int c = 0; c < w; ++c) row[c] = 128 + (rnd.Rand8() & 7);
+      }
+    }
+    ASSERT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, &img, frame, 1, 0));
+    aom_codec_iter_t iter = NULL;
+    while (aom_codec_get_cx_data(&enc, &iter) != NULL) {
+    }
+  }
+  aom_img_free(&img);
+
+  aom_hash_trellis_stats_t stats;
+  EXPECT_EQ(AOM_CODEC_INVALID_PARAM,
+            aom_codec_control(&enc, AV1E_GET_HASH_TRELLIS_STATS,
+                              static_cast<aom_hash_trellis_stats_t *>(NULL)));
+  ASSERT_EQ(AOM_CODEC_OK,
+            aom_codec_control(&enc, AV1E_GET_HASH_TRELLIS_STATS, &stats));
+  EXPECT_GT(stats.misses, 0u);
+  EXPECT_GT(stats.hits, 0u);
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&enc));
+}
+
+}  // namespace
@@ -12,12 +12,15 @@
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "config/aom_config.h"
+#include "config/av1_rtcd.h"
 
+#include "test/acm_random.h"
 #include "av1/common/blockd.h"
 #include "av1/common/enums.h"
 #include "av1/common/mv.h"
 #include "av1/common/mvref_common.h"
 #include "av1/common/onyxc_int.h"
+#include "av1/common/reconinter.h"
 #include "av1/common/tile_common.h"
 
 namespace {
@@ -174,4 +177,89 @@ TEST(IntrabcTest, DvValidation) {
         << "DvCases[" << i << "]";
   }
 }
+
+#if CONFIG_EXT_IBC_MODES
+const int kIbcStride = MAX_SB_SIZE;
+
+// Fills a MAX_SB_SIZE x MAX_SB_SIZE block with random 12-bit samples.
+void FillRandom(libaom_test::ACMRandom *rnd, uint16_t *buf) {
+  for (int i = 0; i < MAX_SB_SQUARE; ++i) buf[i] = rnd->Rand16() & 0xfff;
+}
+
+TEST(IntrabcTest, TransformRoundTrip) {
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  DECLARE_ALIGNED(16, uint16_t, src[MAX_SB_SQUARE]);
+  DECLARE_ALIGNED(16, uint16_t, fwd[MAX_SB_SQUARE]);
+  DECLARE_ALIGNED(16, uint16_t, inv[MAX_SB_SQUARE]);
+  FillRandom(&rnd, src);
+
+  for (int mode = ROTATION_0; mode < IBC_MODES; ++mode) {
+    const IBC_MODE m = static_cast<IBC_MODE>(mode);
+    const int w = 16, h = 8;
+    const int tw = av1_intrabc_mode_transposes(m) ? h : w;
+    const int th = av1_intrabc_mode_transposes(m) ? w : h;
+    av1_intrabc_transform_sb_c(fwd, kIbcStride, src, kIbcStride, w, h, m);
+    av1_intrabc_transform_sb_c(inv, kIbcStride, fwd, kIbcStride, tw, th,
+                               av1_intrabc_inverse_mode(m));
+    for (int r = 0; r < h; ++r) {
+      for (int c = 0; c < w; ++c) {
+        ASSERT_EQ(src[r * kIbcStride + c], inv[r * kIbcStride + c])
+            << "mode " << mode << " at (" << r << ", " << c << ")";
+      }
+    }
+  }
+}
+
+#if HAVE_SSE2
+TEST(IntrabcTest, TransformSse2MatchesC) {
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  DECLARE_ALIGNED(16, uint16_t, src[MAX_SB_SQUARE]);
+  DECLARE_ALIGNED(16, uint16_t, ref[MAX_SB_SQUARE]);
+  DECLARE_ALIGNED(16, uint16_t, tst[MAX_SB_SQUARE]);
+  const int kSizes[] = { 4, 8, 16, 32, 64, 128 };
+
+  for (int wi = 0; wi < static_cast<int>(GTEST_ARRAY_SIZE_(kSizes)); ++wi) {
+    for (int hi = 0; hi < static_cast<int>(GTEST_ARRAY_SIZE_(kSizes)); ++hi) {
+      const int w = kSizes[wi], h = kSizes[hi];
+      FillRandom(&rnd, src);
+      for (int mode = ROTATION_0; mode < IBC_MODES; ++mode) {
+        const IBC_MODE m = static_cast<IBC_MODE>(mode);
+        memset(ref, 0, sizeof(ref));
+        memset(tst, 0, sizeof(tst));
+        av1_intrabc_transform_sb_c(ref, kIbcStride, src, kIbcStride, w, h, m);
+        av1_intrabc_transform_sb_sse2(tst, kIbcStride, src, kIbcStride, w, h,
+                                      m);
+        ASSERT_EQ(0, memcmp(ref, tst, sizeof(ref)))
+            << w << "x" << h << " mode " << mode;
+      }
+    }
+  }
+}
+
+TEST(IntrabcTest, TransformAllSse2MatchesC) {
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  DECLARE_ALIGNED(16, uint16_t, src[MAX_SB_SQUARE]);
+  static uint16_t ref[IBC_MODES][MAX_SB_SQUARE];
+  static uint16_t tst[IBC_MODES][MAX_SB_SQUARE];
+  uint16_t *ref_ptrs[IBC_MODES], *tst_ptrs[IBC_MODES];
+  for (int mode = 0; mode < IBC_MODES; ++mode) {
+    ref_ptrs[mode] = ref[mode];
+    tst_ptrs[mode] = tst[mode];
+  }
+  const int kSizes[][2] = { { 8, 8 }, { 16, 32 }, { 64, 16 }, { 128, 128 } };
+
+  for (int i = 0; i < static_cast<int>(GTEST_ARRAY_SIZE_(kSizes)); ++i) {
+    const int w = kSizes[i][0], h = kSizes[i][1];
+    FillRandom(&rnd, src);
+    memset(ref, 0, sizeof(ref));
+    memset(tst, 0, sizeof(tst));
+    av1_intrabc_transform_all_sb_c(ref_ptrs, kIbcStride, src, kIbcStride, w,
+                                   h, IBC_MODES);
+    av1_intrabc_transform_all_sb_sse2(tst_ptrs, kIbcStride, src, kIbcStride,
+                                      w, h, IBC_MODES);
+    ASSERT_EQ(0, memcmp(ref, tst, sizeof(ref))) << w << "x" << h;
+  }
+}
+#endif  // HAVE_SSE2
+#endif  // CONFIG_EXT_IBC_MODES
 }  // namespace
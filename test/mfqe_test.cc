@@ -9,6 +9,9 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <algorithm>
+#include <vector>
+
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "av1/common/mfqe.h"
@@ -23,6 +26,7 @@ class MFQETest : public ::testing::Test {
  protected:
   // Sets up current frame and reference frames as 0-filled data.
   void SetUp() override {
+    av1_rst_scratch_init(&scratch_);
     tmp_.stride = MFQE_TEST_STRIDE;
     tmp_.height = MFQE_TEST_HEIGHT;
     tmp_.width = MFQE_TEST_WIDTH;
@@ -62,6 +66,7 @@ class MFQETest : public ::testing::Test {
   }
 
   void TearDown() override {
+    av1_rst_scratch_free(&scratch_);
     aom_free(tmp_.buffer_orig);
     for (int i = 0; i < MFQE_NUM_REFS; i++) {
       uint8_t *buffer =
@@ -74,6 +79,7 @@ class MFQETest : public ::testing::Test {
 
   Y_BUFFER_CONFIG tmp_;
   RefCntBuffer **ref_frames_;
+  RestorationScratch scratch_;
 };
 
 }  // namespace
@@ -83,8 +89,9 @@ TEST_F(MFQETest, TestLowBdAllZero) {
   const int buf_size = tmp_.stride * tmp_.height;
   const int high_bd = 0;
   const int bitdepth = 8;
-  av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
-                      high_bd, bitdepth);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
   for (int i = 0; i < buf_size; i++) {
     ASSERT_EQ(0, tmp_.buffer[i]);
   }
@@ -102,8 +109,9 @@ TEST_F(MFQETest, TestLowBdSomeOnes) {
       tmp_.buffer[i] = 1;
     }
   }
-  av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
-                      high_bd, bitdepth);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
   for (int i = 0; i < buf_size; i++) {
     ASSERT_LE(tmp_.buffer[i], 1);
   }
@@ -119,8 +127,9 @@ TEST_F(MFQETest, TestLowBdZeroToSix) {
   for (int i = 0; i < buf_size; i++) {
     tmp_.buffer[i] = (i % 7);
   }
-  av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
-                      high_bd, bitdepth);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
   for (int i = 0; i < buf_size; i++) {
     ASSERT_LE(tmp_.buffer[i], 7);
   }
@@ -135,8 +144,9 @@ TEST_F(MFQETest, TestLowBdTenToEighteen) {
   for (int i = 0; i < buf_size; i++) {
     tmp_.buffer[i] = (i % 9) + 10;
   }
-  av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
-                      high_bd, bitdepth);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
   for (int i = 0; i < buf_size; i++) {
     ASSERT_GE(tmp_.buffer[i], 10);
   }
@@ -151,8 +161,9 @@ TEST_F(MFQETest, TestLowBdFifty) {
   for (int i = 0; i < buf_size; i++) {
     tmp_.buffer[i] = 50;
   }
-  av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
-                      high_bd, bitdepth);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
   for (int i = 0; i < buf_size; i++) {
     ASSERT_EQ(50, tmp_.buffer[i]);
   }
@@ -165,9 +176,42 @@ TEST_F(MFQETest, TestLowBdHundred) {
   for (int i = 0; i < buf_size; i++) {
     tmp_.buffer[i] = 100;
   }
-  av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE, MFQE_SCALE_SIZE,
-                      high_bd, bitdepth);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
   for (int i = 0; i < buf_size; i++) {
     ASSERT_EQ(100, tmp_.buffer[i]);
   }
 }
+
+// With a limit on the scratch, as set by AV1D_SET_RESTORATION_SCRATCH_LIMIT,
+// the upsampled planes MFQE needs are released once it is done with a frame,
+// and taken again for the next one without changing the result.
+TEST_F(MFQETest, TestScratchLimit) {
+  const int buf_size = tmp_.stride * tmp_.height;
+  const int high_bd = 0;
+  const int bitdepth = 8;
+  const size_t limit = 64 * 1024;
+  scratch_.limit = limit;
+  for (int i = 0; i < buf_size; i++) {
+    tmp_.buffer[i] = (i % 9) + 10;
+  }
+  std::vector<uint8_t> orig(tmp_.buffer, tmp_.buffer + buf_size);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
+  EXPECT_GT(scratch_.total_size, limit);
+  av1_rst_scratch_trim(&scratch_);
+  EXPECT_GT(scratch_.total_size, 0u);
+  EXPECT_LE(scratch_.total_size, limit);
+  EXPECT_GT(scratch_.peak_size, limit);
+  std::vector<uint8_t> first(tmp_.buffer, tmp_.buffer + buf_size);
+
+  std::copy(orig.begin(), orig.end(), tmp_.buffer);
+  ASSERT_TRUE(av1_apply_loop_mfqe(&tmp_, ref_frames_, MFQE_BLOCK_SIZE,
+                                  MFQE_SCALE_SIZE, high_bd, bitdepth,
+                                  &scratch_));
+  av1_rst_scratch_trim(&scratch_);
+  EXPECT_LE(scratch_.total_size, limit);
+  EXPECT_TRUE(std::equal(first.begin(), first.end(), tmp_.buffer));
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+#include "config/av1_rtcd.h"
+
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+
+#if CONFIG_INTRA_ENTROPY && HAVE_AVX2
+namespace {
+
+using libaom_test::ACMRandom;
+
+const int kSparseSize = 14;
+
+float RandFloat(ACMRandom *rnd) {
+  return (rnd->PseudoUniform(2001) - 1000) / 1000.0f;
+}
+
+void FillRandom(ACMRandom *rnd, std::vector<float> *v) {
+  for (size_t i = 0; i < v->size(); ++i) (*v)[i] = RandFloat(rnd);
+}
+
+// Gradient buffers of one input layer, so that the C and SIMD versions can
+// accumulate into separate copies.
+struct InputLayerGrads {
+  InputLayerGrads(int num_out, int num_dense)
+      : db(num_out), dw_dense(num_out * num_dense) {
+    for (int s = 0; s < EM_MAX_SPARSE_FEATURES; ++s)
+      dw_sparse[s].resize(kSparseSize * num_out);
+  }
+  void Attach(FC_INPUT_LAYER_EM *layer) {
+    layer->db = &db[0];
+    layer->dw_dense = dw_dense.empty() ? NULL : &dw_dense[0];
+    for (int s = 0; s < EM_MAX_SPARSE_FEATURES; ++s)
+      layer->dw_sparse[s] = &dw_sparse[s][0];
+  }
+  std::vector<float> db;
+  std::vector<float> dw_dense;
+  std::vector<float> dw_sparse[EM_MAX_SPARSE_FEATURES];
+};
+
+void ExpectEqual(const std::vector<float> &ref, const std::vector<float> &test,
+                 const char *name) {
+  for (size_t i = 0; i < ref.size(); ++i) {
+    ASSERT_EQ(ref[i], test[i]) << name << " " << i;
+  }
+}
+
+void RunInputBackwardTest(int num_out, int num_dense, int num_sparse) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  FC_INPUT_LAYER_EM layer = {};
+  layer.num_sparse_inputs = num_sparse;
+  layer.num_dense_inputs = num_dense;
+  layer.num_outputs = num_out;
+  for (int s = 0; s < num_sparse; ++s) layer.sparse_input_size[s] = kSparseSize;
+
+  InputLayerGrads ref(num_out, num_dense);
+  InputLayerGrads test(num_out, num_dense);
+  std::vector<float> dy(num_out);
+  std::vector<float> dense(num_dense);
+  int sparse[EM_MAX_SPARSE_FEATURES] = { 0 };
+  // Several blocks accumulate into the same gradients, as over a superblock.
+  for (int iter = 0; iter < 64; ++iter) {
+    FillRandom(&rnd, &dy);
+    FillRandom(&rnd, &dense);
+    for (int s = 0; s < num_sparse; ++s)
+      sparse[s] = rnd.PseudoUniform(kSparseSize);
+    ref.Attach(&layer);
+    av1_nn_input_backward_em_c(&layer, &dy[0], sparse,
+                               dense.empty() ? NULL : &dense[0]);
+    test.Attach(&layer);
+    av1_nn_input_backward_em_avx2(&layer, &dy[0], sparse,
+                                  dense.empty() ? NULL : &dense[0]);
+  }
+  ExpectEqual(ref.db, test.db, "db");
+  ExpectEqual(ref.dw_dense, test.dw_dense, "dw_dense");
+  for (int s = 0; s < num_sparse; ++s)
+    ExpectEqual(ref.dw_sparse[s], test.dw_sparse[s], "dw_sparse");
+  libaom_test::ClearSystemState();
+}
+
+TEST(NnEmTest, InputBackwardAvx2MatchesC) {
+  // The luma and chroma intra mode models, plus odd sizes for the tails.
+  RunInputBackwardTest(13, 72, 2);
+  RunInputBackwardTest(14, 0, 2);
+  RunInputBackwardTest(5, 3, 1);
+  RunInputBackwardTest(17, 9, 0);
+}
+
+TEST(NnEmTest, AdaptAvx2MatchesC) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  for (int n = 1; n <= 13 * 72 + 7; n += (n < 40) ? 1 : 37) {
+    std::vector<float> ref_w(n), ref_dw(n);
+    FillRandom(&rnd, &ref_w);
+    FillRandom(&rnd, &ref_dw);
+    std::vector<float> test_w(ref_w), test_dw(ref_dw);
+    const float mu = 0.001f * (1 + rnd.PseudoUniform(100));
+    av1_nn_adapt_em_c(&ref_w[0], &ref_dw[0], mu, n);
+    av1_nn_adapt_em_avx2(&test_w[0], &test_dw[0], mu, n);
+    ExpectEqual(ref_w, test_w, "w");
+    ExpectEqual(ref_dw, test_dw, "dw");
+    for (int i = 0; i < n; ++i) ASSERT_EQ(test_dw[i], 0.0f);
+  }
+  libaom_test::ClearSystemState();
+}
+
+}  // namespace
+#endif  // CONFIG_INTRA_ENTROPY && HAVE_AVX2
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string>
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "test/codec_factory.h"
+#include "test/encode_test_driver.h"
+#include "test/i420_video_source.h"
+#include "test/md5_helper.h"
+#include "test/util.h"
+
+namespace {
+
+// The NN reconstruction keeps its TFlite interpreters in the thread data of the
+// decoder. Two decoders on the same thread, and a decoder created after they
+// are destroyed, must each decode the stream the same way. The interpreters
+// are freed with the decoder, which the memory checker runs of the tests
+// report otherwise.
+class NnReconDecodeTest
+    : public ::libaom_test::CodecTestWithParam<libaom_test::TestMode>,
+      public ::libaom_test::EncoderTest {
+ protected:
+  NnReconDecodeTest() : EncoderTest(GET_PARAM(0)) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.allow_lowbitdepth = 1;
+    first_dec_ = codec_->CreateDecoder(cfg, 0);
+    second_dec_ = codec_->CreateDecoder(cfg, 0);
+  }
+
+  ~NnReconDecodeTest() override {
+    delete first_dec_;
+    delete second_dec_;
+  }
+
+  void SetUp() override {
+    InitializeConfig();
+    SetMode(GET_PARAM(1));
+  }
+
+  void UpdateMD5(::libaom_test::Decoder *dec, const uint8_t *data, size_t size,
+                 ::libaom_test::MD5 *md5) {
+    const aom_codec_err_t res = dec->DecodeFrame(data, size);
+    if (res != AOM_CODEC_OK) {
+      abort_ = true;
+      ASSERT_EQ(AOM_CODEC_OK, res);
+    }
+    const aom_image_t *img = dec->GetDxData().Next();
+    if (img) md5->Add(img);
+  }
+
+  void FramePktHook(const aom_codec_cx_pkt_t *pkt) override {
+    const uint8_t *const data = static_cast<uint8_t *>(pkt->data.frame.buf);
+    frames_.push_back(std::string(reinterpret_cast<const char *>(data),
+                                  pkt->data.frame.sz));
+    UpdateMD5(first_dec_, data, pkt->data.frame.sz, &md5_first_);
+    UpdateMD5(second_dec_, data, pkt->data.frame.sz, &md5_second_);
+  }
+
+  ::libaom_test::Decoder *first_dec_;
+  ::libaom_test::Decoder *second_dec_;
+  ::libaom_test::MD5 md5_first_;
+  ::libaom_test::MD5 md5_second_;
+  std::vector<std::string> frames_;
+};
+
+TEST_P(NnReconDecodeTest, DecodeAfterDestroy) {
+  ::libaom_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288,
+                                       30, 1, 0, 3);
+  // The NN reconstruction is only used by intra frames.
+  cfg_.kf_max_dist = 0;
+  cfg_.g_lag_in_frames = 0;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  ASSERT_EQ(3u, frames_.size());
+  EXPECT_STREQ(md5_first_.Get(), md5_second_.Get());
+
+  delete first_dec_;
+  first_dec_ = nullptr;
+  delete second_dec_;
+  second_dec_ = nullptr;
+
+  // Decode again with tile workers, which have interpreters of their own.
+  aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+  cfg.allow_lowbitdepth = 1;
+  cfg.threads = 2;
+  ::libaom_test::Decoder *const dec = codec_->CreateDecoder(cfg, 0);
+  ::libaom_test::MD5 md5;
+  for (const std::string &frame : frames_) {
+    ASSERT_NO_FATAL_FAILURE(
+        UpdateMD5(dec, reinterpret_cast<const uint8_t *>(frame.data()),
+                  frame.size(), &md5));
+  }
+  delete dec;
+  EXPECT_STREQ(md5_first_.Get(), md5.Get());
+}
+
+AV1_INSTANTIATE_TEST_CASE(NnReconDecodeTest,
+                          ::testing::Values(::libaom_test::kOnePassGood));
+
+}  // namespace
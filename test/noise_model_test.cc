@@ -17,6 +17,7 @@
 #include "aom_dsp/noise_util.h"
 #include "config/aom_dsp_rtcd.h"
 #include "test/acm_random.h"
+#include "test/function_equivalence_test.h"
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 namespace {
@@ -1336,8 +1337,176 @@ TYPED_TEST_P(WienerDenoiseTest, GradientTest) {
   }
 }
 
+TYPED_TEST_P(WienerDenoiseTest, MultiThreaded) {
+  const int kNumWorkers = 4;
+  const int kWidth = this->kWidth;
+  const int kHeight = this->kHeight;
+  const uint8_t *const data_ptrs[3] = {
+    reinterpret_cast<uint8_t *>(&this->data_[0][0]),
+    reinterpret_cast<uint8_t *>(&this->data_[1][0]),
+    reinterpret_cast<uint8_t *>(&this->data_[2][0]),
+  };
+  uint8_t *denoised_ptrs[3] = {
+    reinterpret_cast<uint8_t *>(&this->denoised_[0][0]),
+    reinterpret_cast<uint8_t *>(&this->denoised_[1][0]),
+    reinterpret_cast<uint8_t *>(&this->denoised_[2][0]),
+  };
+  const int num_blocks_w = kWidth / this->kBlockSize;
+  const int num_blocks_h = kHeight / this->kBlockSize;
+  std::vector<uint8_t> flat_blocks(num_blocks_w * num_blocks_h);
+  std::vector<uint8_t> flat_blocks_mt(num_blocks_w * num_blocks_h);
+  aom_flat_block_finder_t flat_block_finder;
+  ASSERT_EQ(1, aom_flat_block_finder_init(&flat_block_finder, this->kBlockSize,
+                                          this->kBitDepth, this->kUseHighBD));
+  const int num_flat =
+      aom_flat_block_finder_run(&flat_block_finder, data_ptrs[0], kWidth,
+                                kHeight, this->stride_[0], &flat_blocks[0]);
+  ASSERT_EQ(1, aom_wiener_denoise_2d(data_ptrs, denoised_ptrs, kWidth, kHeight,
+                                     this->stride_, this->chroma_sub_,
+                                     this->noise_psd_ptrs_, this->kBlockSize,
+                                     this->kBitDepth, this->kUseHighBD));
+  std::vector<typename TypeParam::data_type_t> denoised[3];
+  for (int c = 0; c < 3; ++c) denoised[c] = this->denoised_[c];
+
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  // Either all the workers have threads, or, as in the encoder, the first one
+  // is the calling thread.
+  for (int main_thread = 0; main_thread <= 1; ++main_thread) {
+    AVxWorker workers[kNumWorkers];
+    for (int i = 0; i < kNumWorkers; ++i) {
+      winterface->init(&workers[i]);
+      if (i > 0 || !main_thread) {
+        ASSERT_TRUE(winterface->reset(&workers[i]));
+      }
+    }
+    for (int num_workers = 1; num_workers <= kNumWorkers; ++num_workers) {
+      std::fill(flat_blocks_mt.begin(), flat_blocks_mt.end(), 0);
+      EXPECT_EQ(num_flat, aom_flat_block_finder_run_mt(
+                              &flat_block_finder, data_ptrs[0], kWidth,
+                              kHeight, this->stride_[0], &flat_blocks_mt[0],
+                              workers, num_workers));
+      EXPECT_EQ(flat_blocks, flat_blocks_mt)
+          << "workers " << num_workers << " main thread " << main_thread;
+
+      for (int c = 0; c < 3; ++c) {
+        std::fill(this->denoised_[c].begin(), this->denoised_[c].end(), 0);
+      }
+      EXPECT_EQ(1, aom_wiener_denoise_2d_mt(
+                       data_ptrs, denoised_ptrs, kWidth, kHeight,
+                       this->stride_, this->chroma_sub_, this->noise_psd_ptrs_,
+                       this->kBlockSize, this->kBitDepth, this->kUseHighBD,
+                       workers, num_workers));
+      for (int c = 0; c < 3; ++c) {
+        EXPECT_EQ(denoised[c], this->denoised_[c])
+            << "plane " << c << " workers " << num_workers << " main thread "
+            << main_thread;
+      }
+    }
+    for (int i = 0; i < kNumWorkers; ++i) winterface->end(&workers[i]);
+  }
+  aom_flat_block_finder_free(&flat_block_finder);
+}
+
 REGISTER_TYPED_TEST_CASE_P(WienerDenoiseTest, InvalidBlockSize,
-                           InvalidChromaSubsampling, GradientTest);
+                           InvalidChromaSubsampling, GradientTest,
+                           MultiThreaded);
 
 INSTANTIATE_TYPED_TEST_CASE_P(WienerDenoiseTestInstatiation, WienerDenoiseTest,
                               AllBitDepthParams);
+
+typedef void (*NoiseWindowBlockFunc)(const double *block_d,
+                                     const double *plane_d,
+                                     const float *window, float *block,
+                                     float *plane, int n);
+typedef void (*NoiseAccumulateBlockFunc)(float *result, int result_stride,
+                                         const float *block,
+                                         const float *plane,
+                                         const float *window, int block_size);
+
+// Block sizes supported by the denoiser, at full and chroma resolution.
+const int kNoiseBlockSizes[] = { 2, 4, 8, 16, 32 };
+const int kMaxNoiseBlockSize = 32;
+
+class NoiseWindowBlockTest
+    : public libaom_test::FunctionEquivalenceTest<NoiseWindowBlockFunc> {};
+
+TEST_P(NoiseWindowBlockTest, RandomValues) {
+  const int kMaxPixels = kMaxNoiseBlockSize * kMaxNoiseBlockSize;
+  std::vector<double> block_d(kMaxPixels), plane_d(kMaxPixels);
+  std::vector<float> window(kMaxPixels);
+  std::vector<float> block_ref(kMaxPixels), plane_ref(kMaxPixels);
+  std::vector<float> block_tst(kMaxPixels), plane_tst(kMaxPixels);
+  for (int iter = 0; iter < 100; ++iter) {
+    for (const int block_size : kNoiseBlockSizes) {
+      const int n = block_size * block_size;
+      for (int i = 0; i < n; ++i) {
+        block_d[i] = randn(&rng_, 0.1);
+        plane_d[i] = (double)rng_.Rand16() / 65535;
+        window[i] = (float)rng_.Rand16() / 65535;
+      }
+      params_.ref_func(&block_d[0], &plane_d[0], &window[0], &block_ref[0],
+                       &plane_ref[0], n);
+      params_.tst_func(&block_d[0], &plane_d[0], &window[0], &block_tst[0],
+                       &plane_tst[0], n);
+      ASSERT_EQ(block_ref, block_tst) << "block_size " << block_size;
+      ASSERT_EQ(plane_ref, plane_tst) << "block_size " << block_size;
+    }
+  }
+}
+
+class NoiseAccumulateBlockTest
+    : public libaom_test::FunctionEquivalenceTest<NoiseAccumulateBlockFunc> {};
+
+TEST_P(NoiseAccumulateBlockTest, RandomValues) {
+  const int kMaxPixels = kMaxNoiseBlockSize * kMaxNoiseBlockSize;
+  const int kResultStride = kMaxNoiseBlockSize * 2 + 3;
+  std::vector<float> block(kMaxPixels), plane(kMaxPixels), window(kMaxPixels);
+  std::vector<float> result_ref(kResultStride * kMaxNoiseBlockSize);
+  std::vector<float> result_tst(kResultStride * kMaxNoiseBlockSize);
+  for (int iter = 0; iter < 100; ++iter) {
+    for (const int block_size : kNoiseBlockSizes) {
+      const int n = block_size * block_size;
+      for (int i = 0; i < n; ++i) {
+        block[i] = (float)randn(&rng_, 0.1);
+        plane[i] = (float)rng_.Rand16() / 65535;
+        window[i] = (float)rng_.Rand16() / 65535;
+      }
+      for (size_t i = 0; i < result_ref.size(); ++i) {
+        result_ref[i] = (float)rng_.Rand16() / 65535;
+      }
+      result_tst = result_ref;
+      const int offset = rng_.PseudoUniform(4);
+      params_.ref_func(&result_ref[offset], kResultStride, &block[0],
+                       &plane[0], &window[0], block_size);
+      params_.tst_func(&result_tst[offset], kResultStride, &block[0],
+                       &plane[0], &window[0], block_size);
+      ASSERT_EQ(result_ref, result_tst) << "block_size " << block_size;
+    }
+  }
+}
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, NoiseWindowBlockTest,
+                        ::testing::Values(libaom_test::FuncParam<
+                                          NoiseWindowBlockFunc>(
+                            aom_noise_window_block_c,
+                            aom_noise_window_block_sse2)));
+INSTANTIATE_TEST_CASE_P(SSE2, NoiseAccumulateBlockTest,
+                        ::testing::Values(libaom_test::FuncParam<
+                                          NoiseAccumulateBlockFunc>(
+                            aom_noise_accumulate_block_c,
+                            aom_noise_accumulate_block_sse2)));
+#endif  // HAVE_SSE2
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(AVX2, NoiseWindowBlockTest,
+                        ::testing::Values(libaom_test::FuncParam<
+                                          NoiseWindowBlockFunc>(
+                            aom_noise_window_block_c,
+                            aom_noise_window_block_avx2)));
+INSTANTIATE_TEST_CASE_P(AVX2, NoiseAccumulateBlockTest,
+                        ::testing::Values(libaom_test::FuncParam<
+                                          NoiseAccumulateBlockFunc>(
+                            aom_noise_accumulate_block_c,
+                            aom_noise_accumulate_block_avx2)));
+#endif  // HAVE_AVX2
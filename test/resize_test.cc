@@ -12,11 +12,13 @@
 #include <climits>
 #include <vector>
 #include "aom_dsp/aom_dsp_common.h"
+#include "av1/encoder/encoder.h"
 #include "common/tools_common.h"
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 #include "test/codec_factory.h"
 #include "test/encode_test_driver.h"
 #include "test/i420_video_source.h"
+#include "test/md5_helper.h"
 #include "test/video_source.h"
 #include "test/util.h"
 
@@ -239,6 +241,100 @@ TEST_P(ResizeTest, TestExternalResizeWorks) {
   }
 }
 
+// Decodes the resized stream a second time with a frame pool reserved for the
+// largest frame size, which must not allocate anything after the first frame.
+class ResizeFramePoolTest : public ResizeTest {
+ protected:
+  ResizeFramePoolTest() : ResizeTest(), num_pool_frames_(0) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.allow_lowbitdepth = 1;
+    ref_dec_ = codec_->CreateDecoder(cfg, 0);
+    pool_dec_ = codec_->CreateDecoder(cfg, 0);
+    aom_dec_frame_pool_cfg_t pool_cfg;
+    pool_cfg.max_width = pool_cfg.max_height =
+        AOMMAX(kInitialWidth, kInitialHeight);
+    pool_cfg.max_bit_depth = 8;
+    pool_dec_->Control(AV1D_SET_FRAME_POOL, &pool_cfg);
+  }
+
+  virtual ~ResizeFramePoolTest() {
+    delete ref_dec_;
+    delete pool_dec_;
+  }
+
+  void UpdateMD5(::libaom_test::Decoder *dec, const aom_codec_cx_pkt_t *pkt,
+                 ::libaom_test::MD5 *md5) {
+    const aom_codec_err_t res = dec->DecodeFrame(
+        reinterpret_cast<uint8_t *>(pkt->data.frame.buf), pkt->data.frame.sz);
+    if (res != AOM_CODEC_OK) {
+      abort_ = true;
+      ASSERT_EQ(AOM_CODEC_OK, res);
+    }
+    const aom_image_t *img = dec->GetDxData().Next();
+    if (img) md5->Add(img);
+  }
+
+  virtual void FramePktHook(const aom_codec_cx_pkt_t *pkt) {
+    UpdateMD5(ref_dec_, pkt, &md5_ref_);
+    UpdateMD5(pool_dec_, pkt, &md5_pool_);
+
+    aom_dec_frame_pool_stats_t stats;
+    pool_dec_->Control(AV1D_GET_FRAME_POOL_STATS, &stats);
+    if (num_pool_frames_++ == 0) {
+      first_stats_ = stats;
+    } else {
+      EXPECT_EQ(first_stats_.num_frame_buffer_allocs,
+                stats.num_frame_buffer_allocs)
+          << "Frame " << pkt->data.frame.pts;
+      EXPECT_EQ(first_stats_.num_side_buffer_allocs,
+                stats.num_side_buffer_allocs)
+          << "Frame " << pkt->data.frame.pts;
+      EXPECT_EQ(first_stats_.frame_buffer_size, stats.frame_buffer_size);
+    }
+  }
+
+  ::libaom_test::Decoder *ref_dec_;
+  ::libaom_test::Decoder *pool_dec_;
+  ::libaom_test::MD5 md5_ref_;
+  ::libaom_test::MD5 md5_pool_;
+  aom_dec_frame_pool_stats_t first_stats_;
+  unsigned int num_pool_frames_;
+};
+
+TEST_P(ResizeFramePoolTest, TestExternalResizeDoesNotAllocate) {
+  ResizingVideoSource video;
+  video.flag_codec_ = 0;
+  video.set_limit(30);
+  cfg_.g_lag_in_frames = 0;
+  cfg_.g_forced_max_frame_width = cfg_.g_forced_max_frame_height =
+      AOMMAX(kInitialWidth, kInitialHeight);
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+  ASSERT_EQ(num_pool_frames_, video.limit());
+  EXPECT_STREQ(md5_ref_.Get(), md5_pool_.Get());
+
+  // The pool can no longer be set up once the decoder is initialized.
+  aom_dec_frame_pool_cfg_t pool_cfg;
+  pool_cfg.max_width = pool_cfg.max_height = 2 * kInitialWidth;
+  pool_cfg.max_bit_depth = 8;
+  EXPECT_EQ(AOM_CODEC_ERROR,
+            aom_codec_control_(pool_dec_->GetDecoder(), AV1D_SET_FRAME_POOL,
+                               &pool_cfg));
+}
+
+TEST_P(ResizeFramePoolTest, TestSuperresDoesNotAllocate) {
+  // Only superres changes the coded width of the frames here.
+  ::libaom_test::DummyVideoSource video;
+  video.SetSize(kInitialWidth, kInitialHeight);
+  video.set_limit(30);
+  cfg_.g_lag_in_frames = 0;
+  cfg_.rc_superres_mode = SUPERRES_RANDOM;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+
+  ASSERT_EQ(num_pool_frames_, video.limit());
+  EXPECT_STREQ(md5_ref_.Get(), md5_pool_.Get());
+}
+
 const unsigned int kStepDownFrame = 3;
 const unsigned int kStepUpFrame = 6;
 
@@ -634,6 +730,8 @@ TEST_P(ResizeCspTest, TestResizeCspWorks) {
 
 AV1_INSTANTIATE_TEST_CASE(ResizeTest,
                           ::testing::Values(::libaom_test::kRealTime));
+AV1_INSTANTIATE_TEST_CASE(ResizeFramePoolTest,
+                          ::testing::Values(::libaom_test::kRealTime));
 AV1_INSTANTIATE_TEST_CASE(ResizeInternalTestLarge,
                           ::testing::Values(::libaom_test::kOnePassGood));
 AV1_INSTANTIATE_TEST_CASE(ResizeRealtimeTest,
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdint.h>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "av1/common/restoration_scratch.h"
+#include "test/codec_factory.h"
+#include "test/encode_test_driver.h"
+#include "test/i420_video_source.h"
+#include "test/md5_helper.h"
+#include "test/util.h"
+
+namespace {
+
+class RestorationScratchTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    av1_rst_scratch_init(&scratch_);
+    av1_rst_scratch_set_frame_size(&scratch_, 64, 32);
+  }
+
+  void TearDown() override { av1_rst_scratch_free(&scratch_); }
+
+  RestorationScratch scratch_;
+};
+
+TEST_F(RestorationScratchTest, ReusesBuffers) {
+  void *buf = av1_rst_scratch_get(&scratch_, RST_SCRATCH_MFQE_FRAME, 1000);
+  ASSERT_NE(buf, nullptr);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(buf) % 32);
+  EXPECT_EQ(1, scratch_.num_allocs);
+
+  // Smaller or equal requests are served from the same buffer.
+  EXPECT_EQ(buf, av1_rst_scratch_get(&scratch_, RST_SCRATCH_MFQE_FRAME, 1000));
+  EXPECT_EQ(buf, av1_rst_scratch_get(&scratch_, RST_SCRATCH_MFQE_FRAME, 10));
+  av1_rst_scratch_set_frame_size(&scratch_, 64, 32);
+  EXPECT_EQ(buf, av1_rst_scratch_get(&scratch_, RST_SCRATCH_MFQE_FRAME, 1000));
+  EXPECT_EQ(1, scratch_.num_allocs);
+  EXPECT_EQ(1000u, scratch_.total_size);
+
+  // A larger request grows the slot.
+  ASSERT_NE(av1_rst_scratch_get(&scratch_, RST_SCRATCH_MFQE_FRAME, 2000),
+            nullptr);
+  EXPECT_EQ(2, scratch_.num_allocs);
+  EXPECT_EQ(2000u, scratch_.total_size);
+}
+
+TEST_F(RestorationScratchTest, FrameSizeChangeReleasesBuffers) {
+  ASSERT_NE(av1_rst_scratch_get(&scratch_, RST_SCRATCH_MFQE_FRAME, 1000),
+            nullptr);
+  ASSERT_NE(av1_rst_scratch_get(&scratch_, RST_SCRATCH_CNN_INPUT, 3000),
+            nullptr);
+  EXPECT_EQ(4000u, scratch_.total_size);
+
+  av1_rst_scratch_set_frame_size(&scratch_, 32, 32);
+  EXPECT_EQ(0u, scratch_.total_size);
+  EXPECT_EQ(nullptr, scratch_.buf[RST_SCRATCH_MFQE_FRAME]);
+  EXPECT_EQ(nullptr, scratch_.buf[RST_SCRATCH_CNN_INPUT]);
+  EXPECT_EQ(4000u, scratch_.peak_size);
+}
+
+TEST_F(RestorationScratchTest, TrimToLimit) {
+  ASSERT_NE(av1_rst_scratch_get(&scratch_, RST_SCRATCH_MFQE_FRAME, 1000),
+            nullptr);
+  ASSERT_NE(av1_rst_scratch_get(&scratch_, RST_SCRATCH_CNN_INPUT, 3000),
+            nullptr);
+  ASSERT_NE(av1_rst_scratch_get(&scratch_, RST_SCRATCH_CNN_OUTPUT, 2000),
+            nullptr);
+
+  // Without a limit nothing is released.
+  av1_rst_scratch_trim(&scratch_);
+  EXPECT_EQ(6000u, scratch_.total_size);
+
+  // The largest buffers go first.
+  scratch_.limit = 3500;
+  av1_rst_scratch_trim(&scratch_);
+  EXPECT_EQ(3000u, scratch_.total_size);
+  EXPECT_EQ(nullptr, scratch_.buf[RST_SCRATCH_CNN_INPUT]);
+  EXPECT_NE(nullptr, scratch_.buf[RST_SCRATCH_CNN_OUTPUT]);
+  EXPECT_EQ(6000u, scratch_.peak_size);
+}
+
+const unsigned int kScratchLimit = 64 * 1024;
+
+// Decodes a stream with and without a limit on the restoration scratch, which
+// must hold no more than the limit between frames and not change the output.
+// MFQE is not selected for any frame of this stream, so the scratch is only
+// allocated in MFQETest.TestScratchLimit.
+class RestorationScratchLimitTest
+    : public ::libaom_test::CodecTestWithParam<libaom_test::TestMode>,
+      public ::libaom_test::EncoderTest {
+ protected:
+  RestorationScratchLimitTest() : EncoderTest(GET_PARAM(0)) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.allow_lowbitdepth = 1;
+    ref_dec_ = codec_->CreateDecoder(cfg, 0);
+    limited_dec_ = codec_->CreateDecoder(cfg, 0);
+    limited_dec_->Control(AV1D_SET_RESTORATION_SCRATCH_LIMIT, kScratchLimit);
+  }
+
+  ~RestorationScratchLimitTest() override {
+    delete ref_dec_;
+    delete limited_dec_;
+  }
+
+  void SetUp() override {
+    InitializeConfig();
+    SetMode(GET_PARAM(1));
+  }
+
+  void UpdateMD5(::libaom_test::Decoder *dec, const aom_codec_cx_pkt_t *pkt,
+                 ::libaom_test::MD5 *md5) {
+    const aom_codec_err_t res = dec->DecodeFrame(
+        reinterpret_cast<uint8_t *>(pkt->data.frame.buf), pkt->data.frame.sz);
+    if (res != AOM_CODEC_OK) {
+      abort_ = true;
+      ASSERT_EQ(AOM_CODEC_OK, res);
+    }
+    const aom_image_t *img = dec->GetDxData().Next();
+    if (img) md5->Add(img);
+  }
+
+  void FramePktHook(const aom_codec_cx_pkt_t *pkt) override {
+    UpdateMD5(ref_dec_, pkt, &md5_ref_);
+    UpdateMD5(limited_dec_, pkt, &md5_limited_);
+
+    aom_dec_scratch_stats_t stats;
+    ASSERT_EQ(AOM_CODEC_OK,
+              aom_codec_control(limited_dec_->GetDecoder(),
+                                AV1D_GET_RESTORATION_SCRATCH_STATS, &stats));
+    EXPECT_LE(stats.size, kScratchLimit) << "Frame " << pkt->data.frame.pts;
+    EXPECT_LE(stats.size, stats.peak_size);
+    ASSERT_EQ(AOM_CODEC_OK,
+              aom_codec_control(ref_dec_->GetDecoder(),
+                                AV1D_GET_RESTORATION_SCRATCH_STATS, &stats));
+    EXPECT_LE(stats.size, stats.peak_size);
+  }
+
+  ::libaom_test::Decoder *ref_dec_;
+  ::libaom_test::Decoder *limited_dec_;
+  ::libaom_test::MD5 md5_ref_;
+  ::libaom_test::MD5 md5_limited_;
+};
+
+TEST_P(RestorationScratchLimitTest, KeepsScratchWithinLimit) {
+  ::libaom_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288,
+                                       30, 1, 0, 5);
+  cfg_.g_lag_in_frames = 0;
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  EXPECT_STREQ(md5_ref_.Get(), md5_limited_.Get());
+
+  // The limit can no longer be set once the decoder is initialized.
+  EXPECT_EQ(AOM_CODEC_ERROR,
+            aom_codec_control(limited_dec_->GetDecoder(),
+                              AV1D_SET_RESTORATION_SCRATCH_LIMIT, 0u));
+}
+
+AV1_INSTANTIATE_TEST_CASE(RestorationScratchLimitTest,
+                          ::testing::Values(::libaom_test::kOnePassGood));
+
+}  // namespace
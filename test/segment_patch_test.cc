@@ -9,8 +9,11 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <memory>
+
 #include "av1/encoder/segment_patch.h"
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+#include "test/acm_random.h"
 #include "test/codec_factory.h"
 #include "test/i420_video_source.h"
 
@@ -45,3 +48,74 @@ TEST(SegmentPatchTest, get_segments) {
     video.Next();
   }
 }
+
+// Test av1_get_block_segments() on blocks made of 2 noisy flat regions, which
+// both segmenters should split the same way.
+TEST(SegmentPatchTest, get_block_segments_two_regions) {
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  Av1SegmentParams params;
+  av1_get_default_segment_params(&params);
+  params.k = 5000;
+  std::unique_ptr<Av1SegmentScratch> scratch(new Av1SegmentScratch);
+  const int kSizes[][2] = {
+    { 64, 64 }, { 128, 64 }, { 64, 128 }, { 128, 128 }
+  };
+  uint8_t src[MAX_SB_SQUARE];
+  uint8_t ref_output[MAX_SB_SQUARE];
+  uint8_t output[MAX_SB_SQUARE];
+  for (int iter = 0; iter < 16; ++iter) {
+    const int w = kSizes[iter & 3][0];
+    const int h = kSizes[iter & 3][1];
+    // Region boundary is a random line through the block.
+    const int x0 = rnd.PseudoUniform(w);
+    const int x1 = rnd.PseudoUniform(w);
+    const int lo = 40 + rnd.PseudoUniform(40);
+    const int hi = 160 + rnd.PseudoUniform(40);
+    for (int r = 0; r < h; ++r) {
+      const int edge = x0 + (x1 - x0) * r / h;
+      for (int c = 0; c < w; ++c) {
+        src[r * w + c] = (c < edge ? lo : hi) + rnd.PseudoUniform(3);
+      }
+    }
+    int ref_num_components = -1;
+    av1_get_segments(src, w, h, w, &params, ref_output, &ref_num_components);
+    int num_components = -1;
+    av1_get_block_segments(src, w, h, w, &params, scratch.get(), output,
+                           &num_components);
+    ASSERT_EQ(ref_num_components, num_components) << "iter " << iter;
+    for (int i = 0; i < w * h; ++i) {
+      ASSERT_EQ(ref_output[i], output[i]) << "iter " << iter << " pixel " << i;
+    }
+  }
+}
+
+// Test av1_get_block_segments() on superblocks of a real video.
+TEST(SegmentPatchTest, get_block_segments) {
+  libaom_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288, 1,
+                                     30, 0, 1);
+  Av1SegmentParams params;
+  av1_get_default_segment_params(&params);
+  std::unique_ptr<Av1SegmentScratch> scratch(new Av1SegmentScratch);
+  uint8_t output[MAX_SB_SQUARE];
+
+  ASSERT_NO_FATAL_FAILURE(video.Begin());
+  const aom_image_t *frame = video.img();
+  ASSERT_TRUE(frame != nullptr);
+  for (int r = 0; r + 128 <= (int)frame->h; r += 64) {
+    for (int c = 0; c + 128 <= (int)frame->w; c += 64) {
+      int num_components = -1;
+      av1_get_block_segments(frame->planes[0] + r * frame->stride[0] + c, 128,
+                             128, frame->stride[0], &params, scratch.get(),
+                             output, &num_components);
+      ASSERT_GT(num_components, 0);
+      if (num_components > 256) continue;
+      // Segments are numbered in raster order of their first pixel.
+      int next_label = 0;
+      for (int i = 0; i < 128 * 128; ++i) {
+        ASSERT_LE(output[i], next_label);
+        if (output[i] == next_label) ++next_label;
+      }
+      ASSERT_EQ(num_components, next_label);
+    }
+  }
+}
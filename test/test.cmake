@@ -90,15 +90,19 @@ list(APPEND AOM_TEST_INTRA_PRED_SPEED_SOURCES "${AOM_GEN_SRC_DIR}/usage_exit.c"
 
 if(NOT BUILD_SHARED_LIBS)
   list(APPEND AOM_UNIT_TEST_COMMON_SOURCES
+              "${AOM_ROOT}/test/adapt_filter_intra_test.cc"
               "${AOM_ROOT}/test/cdef_test.cc"
               "${AOM_ROOT}/test/cfl_test.cc"
               "${AOM_ROOT}/test/convolve_test.cc"
+              "${AOM_ROOT}/test/derived_intra_mode_test.cc"
+              "${AOM_ROOT}/test/dequantize_coeffs_test.cc"
               "${AOM_ROOT}/test/hiprec_convolve_test.cc"
               "${AOM_ROOT}/test/hiprec_convolve_test_util.cc"
               "${AOM_ROOT}/test/hiprec_convolve_test_util.h"
               "${AOM_ROOT}/test/intrabc_test.cc"
               "${AOM_ROOT}/test/intrapred_test.cc"
               "${AOM_ROOT}/test/lpf_test.cc"
+              "${AOM_ROOT}/test/nn_em_test.cc"
               "${AOM_ROOT}/test/onyxc_int_test.cc"
               "${AOM_ROOT}/test/scan_test.cc"
               "${AOM_ROOT}/test/selfguided_filter_test.cc"
@@ -121,9 +125,12 @@ if(NOT BUILD_SHARED_LIBS)
                 "${AOM_ROOT}/test/decode_multithreaded_test.cc"
                 "${AOM_ROOT}/test/divu_small_test.cc"
                 "${AOM_ROOT}/test/dr_prediction_test.cc"
+                "${AOM_ROOT}/test/ec_symbol_test.cc"
                 "${AOM_ROOT}/test/ec_test.cc"
                 "${AOM_ROOT}/test/ethread_test.cc"
                 "${AOM_ROOT}/test/film_grain_table_test.cc"
+                "${AOM_ROOT}/test/grain_synthesis_test.cc"
+                "${AOM_ROOT}/test/restoration_scratch_test.cc"
                 "${AOM_ROOT}/test/sb_multipass_test.cc"
                 "${AOM_ROOT}/test/segment_binarization_sync.cc"
                 "${AOM_ROOT}/test/superframe_test.cc"
@@ -142,6 +149,11 @@ if(NOT BUILD_SHARED_LIBS)
     if(CONFIG_MFQE_RESTORATION)
       list(APPEND AOM_UNIT_TEST_COMMON_SOURCES "${AOM_ROOT}/test/mfqe_test.cc")
     endif()
+
+    if(CONFIG_NN_RECON)
+      list(APPEND AOM_UNIT_TEST_COMMON_SOURCES
+                  "${AOM_ROOT}/test/nn_recon_test.cc")
+    endif()
   endif()
 
   list(APPEND AOM_UNIT_TEST_COMMON_INTRIN_NEON
@@ -233,6 +245,11 @@ if(NOT BUILD_SHARED_LIBS)
                 "${AOM_ROOT}/test/segment_patch_test.cc")
   endif()
 
+  if(CONFIG_HTB_TRELLIS)
+    list(APPEND AOM_UNIT_TEST_ENCODER_SOURCES
+                "${AOM_ROOT}/test/hash_trellis_test.cc")
+  endif()
+
   list(APPEND AOM_UNIT_TEST_ENCODER_INTRIN_SSE4_1
               "${AOM_ROOT}/test/av1_highbd_iht_test.cc"
               "${AOM_ROOT}/test/av1_quantize_test.cc"